@@ -2,14 +2,20 @@
  *  @brief benchmarks for the C++ (CPU) API
  *
  * Compares cost of evaluation with and without hardcoding, and with and
- * without normalization
+ * without normalization, finds the number of samples from which parallel
+ * evaluation is faster than serial evaluation, and reports the scaling with
+ * the number of threads with and without NUMA placement of the outputs
  */
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <thread>
 
 #define _SPHERICART_INTERNAL_IMPLEMENTATION
 #include "sphericart.hpp"
@@ -70,6 +76,137 @@ inline void benchmark(std::string context, size_t n_samples, size_t n_tries, Fn
     std::cout << " ± " << std << " ns / sample" << std::endl;
 }
 
+// average time (in ns) taken by one call to `function`
+template <typename Fn> inline double time_per_call(size_t n_tries, Fn function) {
+    for (size_t i_try = 0; i_try < 10; i_try++) {
+        function();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i_try = 0; i_try < n_tries; i_try++) {
+        function();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return duration / n_tries;
+}
+
+// Finds the smallest array for which using all the workers of the default
+// backend is faster than a serial evaluation, for each derivative order. The
+// corresponding work can be used as `ParallelThresholds::serial_below`.
+template <typename DTYPE> void report_crossover(size_t l_max, size_t n_tries) {
+    SphericalHarmonics<DTYPE> serial(l_max);
+    serial.set_parallel_thresholds({SIZE_MAX, 0});
+    SphericalHarmonics<DTYPE> parallel(l_max);
+    parallel.set_parallel_thresholds({0, 0});
+
+    const char* names[3] = {"values", "gradients", "hessians"};
+    const size_t n_outputs[3] = {1, 4, 13};
+    const size_t max_samples = 16384;
+    auto size_y = (l_max + 1) * (l_max + 1);
+    auto sph = std::vector<DTYPE>();
+    auto dsph = std::vector<DTYPE>();
+    auto ddsph = std::vector<DTYPE>();
+
+    std::cout << "Serial/parallel crossover with " << parallel.get_omp_num_threads()
+              << " workers (default: serial below " << ParallelThresholds().serial_below << ")"
+              << std::endl;
+    for (size_t order = 0; order < 3; order++) {
+        size_t crossover = 0;
+        for (size_t n_samples = 2; n_samples <= max_samples; n_samples *= 2) {
+            auto xyz = std::vector<DTYPE>(n_samples * 3, 0.0);
+            for (auto& value : xyz) {
+                value = (DTYPE)rand() / (DTYPE)RAND_MAX * 2.0 - 1.0;
+            }
+
+            auto compute = [&](SphericalHarmonics<DTYPE>& calculator) {
+                if (order == 0) {
+                    calculator.compute(xyz, sph);
+                } else if (order == 1) {
+                    calculator.compute_with_gradients(xyz, sph, dsph);
+                } else {
+                    calculator.compute_with_hessians(xyz, sph, dsph, ddsph);
+                }
+            };
+            auto serial_time = time_per_call(n_tries, [&]() { compute(serial); });
+            auto parallel_time = time_per_call(n_tries, [&]() { compute(parallel); });
+            if (parallel_time < serial_time) {
+                crossover = n_samples;
+                break;
+            }
+        }
+
+        if (crossover == 0) {
+            std::cout << "  " << names[order] << ": serial is faster up to " << max_samples
+                      << " samples" << std::endl;
+        } else {
+            std::cout << "  " << names[order] << ": parallel is faster from " << crossover
+                      << " samples, i.e. a work of " << crossover * size_y * n_outputs[order]
+                      << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
+// Compares the scaling with the number of threads of a thread pool whose
+// outputs are initialized by the calling thread (all pages end up on a single
+// NUMA node) with a pool pinned to sockets, whose outputs are placed with
+// `first_touch`. The outputs are allocated without being initialized, so that
+// the pages are only placed when first written.
+template <typename DTYPE> void report_numa_scaling(size_t l_max, size_t n_samples, size_t n_tries) {
+    auto size_y = (l_max + 1) * (l_max + 1);
+    auto xyz = std::vector<DTYPE>(n_samples * 3, 0.0);
+    for (auto& value : xyz) {
+        value = (DTYPE)rand() / (DTYPE)RAND_MAX * 2.0 - 1.0;
+    }
+
+    size_t n_cpus = std::max(std::thread::hardware_concurrency(), 1u);
+    auto n_threads_list = std::vector<size_t>({1});
+    for (auto n_threads : {n_cpus / 2, n_cpus}) {
+        if (n_threads > n_threads_list.back()) {
+            n_threads_list.push_back(n_threads);
+        }
+    }
+
+    std::cout << "NUMA scaling with " << n_samples << " samples, gradients" << std::endl;
+    for (auto n_threads : n_threads_list) {
+        double times[2];
+        for (size_t numa = 0; numa < 2; numa++) {
+            auto pinning = numa == 1 ? ThreadPinning::SOCKETS : ThreadPinning::NONE;
+            auto calculator = SphericalHarmonics<DTYPE>(
+                l_max, Engine::SAMPLE, Layout::SAMPLE_MAJOR, thread_pool_backend(n_threads, pinning)
+            );
+
+            auto sph = std::unique_ptr<DTYPE[]>(new DTYPE[n_samples * size_y]);
+            auto dsph = std::unique_ptr<DTYPE[]>(new DTYPE[n_samples * 3 * size_y]);
+            if (numa == 1) {
+                calculator.first_touch(n_samples, sph.get(), dsph.get());
+            } else {
+                std::fill(sph.get(), sph.get() + n_samples * size_y, DTYPE(0));
+                std::fill(dsph.get(), dsph.get() + n_samples * 3 * size_y, DTYPE(0));
+            }
+
+            auto workspace = Workspace<DTYPE>();
+            times[numa] = time_per_call(n_tries, [&]() {
+                calculator.compute_array_with_gradients(
+                    xyz.data(),
+                    xyz.size(),
+                    sph.get(),
+                    n_samples * size_y,
+                    dsph.get(),
+                    n_samples * 3 * size_y,
+                    &workspace
+                );
+            });
+        }
+        std::cout << "  " << n_threads << " threads: " << times[0] / n_samples
+                  << " ns / sample, " << times[1] / n_samples
+                  << " ns / sample when pinned to sockets with first touch" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
 template <typename DTYPE> void run_timings(int l_max, int n_tries, int n_samples) {
     auto* buffers = new DTYPE[(l_max + 1) * (l_max + 2) / 2 * 3 * omp_get_max_threads()];
     auto prefactors = std::vector<DTYPE>((l_max + 1) * (l_max + 2), 0.0);
@@ -157,6 +294,20 @@ template <typename DTYPE> void run_timings(int l_max, int n_tries, int n_samples
     }
     std::cout << std::endl;
 
+    {
+        SphericalHarmonics<DTYPE> calculator(l_max, Engine::BATCHED);
+        benchmark("Call without derivatives (normalized, batched)", n_samples, n_tries, [&]() {
+            calculator.compute(xyz, sph1);
+        });
+        benchmark("Call with derivatives (normalized, batched)", n_samples, n_tries, [&]() {
+            calculator.compute_with_gradients(xyz, sph1, dsph1);
+        });
+        benchmark("Call with second derivatives (normalized, batched)", n_samples, n_tries, [&]() {
+            calculator.compute_with_hessians(xyz, sph1, dsph1, ddsph1);
+        });
+    }
+    std::cout << std::endl;
+
     std::cout << "================ Low-l timings ===========" << std::endl;
 
     compute_sph_prefactors(1, prefactors.data());
@@ -389,5 +540,13 @@ int main(int argc, char* argv[]) {
     std::cout << "****************** DOUBLE PRECISION ******************" << std::endl;
     run_timings<double>(l_max, n_tries, n_samples);
 
+    std::cout << "****************** PARALLEL CROSSOVER ******************" << std::endl;
+    report_crossover<float>(l_max, n_tries);
+    report_crossover<double>(l_max, n_tries);
+
+    std::cout << "****************** NUMA SCALING ******************" << std::endl;
+    report_numa_scaling<float>(l_max, n_samples, n_tries);
+    report_numa_scaling<double>(l_max, n_samples, n_tries);
+
     return 0;
 }
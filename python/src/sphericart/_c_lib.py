@@ -221,6 +221,45 @@ def setup_functions(lib):
         sphericart_solid_harmonics_calculator_f_t,
     ]
 
+    setup_array_variants(
+        lib,
+        "sphericart_spherical_harmonics",
+        sphericart_spherical_harmonics_calculator_t,
+        sphericart_spherical_harmonics_calculator_f_t,
+    )
+    setup_array_variants(
+        lib,
+        "sphericart_solid_harmonics",
+        sphericart_solid_harmonics_calculator_t,
+        sphericart_solid_harmonics_calculator_f_t,
+    )
+
+
+def setup_array_variants(lib, prefix, calculator_t, calculator_f_t):
+    # the per-l and strided versions of the compute_array functions, which
+    # take one (array of) pointer(s) for each output
+    functions = ["", "_with_gradients", "_with_hessians"]
+    for suffix, c_type, calculator in [
+        ("", ctypes.c_double, calculator_t),
+        ("_f", ctypes.c_float, calculator_f_t),
+    ]:
+        c_ptr = ctypes.POINTER(c_type)
+        for n_outputs, function in enumerate(functions, start=1):
+            name = prefix + "_compute_array_per_l" + function + suffix
+            getattr(lib, name).restype = None
+            getattr(lib, name).argtypes = (
+                [calculator, c_ptr, ctypes.c_size_t]
+                + [ctypes.POINTER(c_ptr)] * n_outputs
+                + [ctypes.c_size_t]
+            )
+
+            name = prefix + "_compute_array_strided" + function + suffix
+            getattr(lib, name).restype = None
+            getattr(lib, name).argtypes = (
+                [calculator, c_ptr, ctypes.c_size_t, ctypes.c_size_t]
+                + [c_ptr, ctypes.c_size_t] * n_outputs
+            )
+
 
 class LibraryFinder(object):
     def __init__(self):
@@ -65,7 +65,9 @@ class SphericalHarmonics:
             ``TensorMap`` will be the same as those of the ``xyz`` input.
         """
         _check_xyz_tensor_map(xyz)
-        sh_values = self.raw_calculator.compute(xyz.block().values.squeeze(-1))
+        (sh_values,) = self.raw_calculator._compute_per_l(
+            xyz.block().values.squeeze(-1), 1
+        )
         return _wrap_into_tensor_map(
             sh_values,
             self.precomputed_keys,
@@ -91,8 +93,8 @@ class SphericalHarmonics:
             those of the ``xyz`` input.
         """
         _check_xyz_tensor_map(xyz)
-        sh_values, sh_gradients = self.raw_calculator.compute_with_gradients(
-            xyz.block().values.squeeze(-1)
+        sh_values, sh_gradients = self.raw_calculator._compute_per_l(
+            xyz.block().values.squeeze(-1), 2
         )
         return _wrap_into_tensor_map(
             sh_values,
@@ -122,8 +124,8 @@ class SphericalHarmonics:
             those of the ``xyz`` input.
         """
         _check_xyz_tensor_map(xyz)
-        sh_values, sh_gradients, sh_hessians = (
-            self.raw_calculator.compute_with_hessians(xyz.block().values.squeeze(-1))
+        sh_values, sh_gradients, sh_hessians = self.raw_calculator._compute_per_l(
+            xyz.block().values.squeeze(-1), 3
         )
         return _wrap_into_tensor_map(
             sh_values,
@@ -176,7 +178,9 @@ class SolidHarmonics:
         See :py:meth:`sphericart.metatensor.SphericalHarmonics.compute`.
         """
         _check_xyz_tensor_map(xyz)
-        sh_values = self.raw_calculator.compute(xyz.block().values.squeeze(-1))
+        (sh_values,) = self.raw_calculator._compute_per_l(
+            xyz.block().values.squeeze(-1), 1
+        )
         return _wrap_into_tensor_map(
             sh_values,
             self.precomputed_keys,
@@ -192,8 +196,8 @@ class SolidHarmonics:
         See :py:meth:`sphericart.metatensor.SphericalHarmonics.compute_with_gradients`.
         """
         _check_xyz_tensor_map(xyz)
-        sh_values, sh_gradients = self.raw_calculator.compute_with_gradients(
-            xyz.block().values.squeeze(-1)
+        sh_values, sh_gradients = self.raw_calculator._compute_per_l(
+            xyz.block().values.squeeze(-1), 2
         )
         return _wrap_into_tensor_map(
             sh_values,
@@ -211,8 +215,8 @@ class SolidHarmonics:
         See :py:meth:`sphericart.metatensor.SphericalHarmonics.compute_with_hessians`.
         """
         _check_xyz_tensor_map(xyz)
-        sh_values, sh_gradients, sh_hessians = (
-            self.raw_calculator.compute_with_hessians(xyz.block().values.squeeze(-1))
+        sh_values, sh_gradients, sh_hessians = self.raw_calculator._compute_per_l(
+            xyz.block().values.squeeze(-1), 3
         )
         return _wrap_into_tensor_map(
             sh_values,
@@ -247,39 +251,39 @@ def _check_xyz_tensor_map(xyz: TensorMap):
 
 
 def _wrap_into_tensor_map(
-    sh_values: np.ndarray,
+    sh_values: List[np.ndarray],
     keys: Labels,
     samples: Labels,
     components: List[Labels],
     xyz_components: Labels,
     xyz_2_components: Labels,
     properties: Labels,
-    sh_gradients: Optional[np.ndarray] = None,
-    sh_hessians: Optional[np.ndarray] = None,
+    sh_gradients: Optional[List[np.ndarray]] = None,
+    sh_hessians: Optional[List[np.ndarray]] = None,
 ) -> TensorMap:
     # infer l_max
     l_max = len(components) - 1
 
+    # the raw calculators store the outputs of each l in a separate array, so
+    # that the blocks can use them without copies
     blocks = []
     for l in range(l_max + 1):  # noqa E741
-        l_start = l**2
-        l_end = (l + 1) ** 2
         sh_values_block = TensorBlock(
-            values=sh_values[:, l_start:l_end, None],
+            values=sh_values[l][..., None],
             samples=samples,
             components=[components[l]],
             properties=properties,
         )
         if sh_gradients is not None:
             sh_gradients_block = TensorBlock(
-                values=sh_gradients[:, :, l_start:l_end, None],
+                values=sh_gradients[l][..., None],
                 samples=samples,
                 components=[xyz_components, components[l]],
                 properties=properties,
             )
             if sh_hessians is not None:
                 sh_hessians_block = TensorBlock(
-                    values=sh_hessians[:, :, :, l_start:l_end, None],
+                    values=sh_hessians[l][..., None],
                     samples=samples,
                     components=[
                         xyz_2_components,
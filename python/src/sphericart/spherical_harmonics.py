@@ -1,5 +1,5 @@
 import ctypes
-from typing import Tuple
+from typing import List, Optional, Tuple
 
 import numpy as np
 
@@ -36,6 +36,14 @@ class SphericalHarmonics:
     which returns the gradient as a tensor with size
     ``(n_samples, 3, (l_max+1)**2)``.
 
+    All the ``compute*`` methods can also write into existing arrays, given with
+    ``out``. When computing the spherical harmonics of the same number of
+    points many times (e.g. in a molecular dynamics loop), this avoids
+    allocating new arrays for every call
+
+    >>> sh_values = np.empty((10, 81))
+    >>> _ = sh.compute(xyz, out=sh_values)
+
     :param l_max: the maximum degree of the spherical harmonics to be calculated
 
     :return: a calculator, in the form of a ``SphericalHarmonics`` object
@@ -66,7 +74,7 @@ class SphericalHarmonics:
             self._lib.sphericart_spherical_harmonics_delete_f(self._calculator_f)
             self._calculator_f = None
 
-    def compute(self, xyz: np.ndarray) -> np.ndarray:
+    def compute(self, xyz: np.ndarray, out: Optional[np.ndarray] = None) -> np.ndarray:
         """
         Calculates the spherical harmonics for a set of 3D points, whose
         coordinates are given by the ``xyz`` array.
@@ -82,6 +90,11 @@ class SphericalHarmonics:
         :param xyz:
             The Cartesian coordinates of the 3D points, as an array with
             shape ``(n_samples, 3)``
+        :param out:
+            Optional array in which to store the spherical harmonics, with the
+            shape and dtype of the output. The entries of each sample must be
+            contiguous, but the array can be e.g. a slice of a larger array. If
+            ``None``, a new array is allocated.
 
         :return:
             An array of shape ``(n_samples, (l_max+1)**2)`` containing all the
@@ -93,42 +106,20 @@ class SphericalHarmonics:
         if self._calculator is None or self._calculator_f is None:
             raise ValueError("can not use a deleted calculator")
 
-        if not isinstance(xyz, np.ndarray):
-            raise TypeError("xyz must be a numpy array")
-
-        if not (xyz.dtype == np.float32 or xyz.dtype == np.float64):
-            raise TypeError("xyz must be a numpy array of 32 or 64-bit floats")
-
-        if len(xyz.shape) != 2 or xyz.shape[1] != 3:
-            raise ValueError("xyz array must be a `N x 3` array")
-
-        # make xyz contiguous before taking a pointer to it
-        xyz = np.ascontiguousarray(xyz)
-
-        n_samples = xyz.shape[0]
-        xyz_length = n_samples * 3
-
-        sph = np.empty((n_samples, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        sph_length = n_samples * (self._l_max + 1) ** 2
-
-        if xyz.dtype == np.float64:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-
-            self._lib.sphericart_spherical_harmonics_compute_array(
-                self._calculator, xyz_ptr, xyz_length, sph_ptr, sph_length
-            )
-        elif xyz.dtype == np.float32:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-
-            self._lib.sphericart_spherical_harmonics_compute_array_f(
-                self._calculator_f, xyz_ptr, xyz_length, sph_ptr, sph_length
-            )
-
-        return sph
-
-    def compute_with_gradients(self, xyz: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+        return _compute_array(
+            self._lib,
+            "sphericart_spherical_harmonics",
+            self._calculator,
+            self._calculator_f,
+            self._l_max,
+            xyz,
+            1,
+            out,
+        )[0]
+
+    def compute_with_gradients(
+        self, xyz: np.ndarray, out: Optional[Tuple[np.ndarray, np.ndarray]] = None
+    ) -> Tuple[np.ndarray, np.ndarray]:
         """
         Calculates the spherical harmonics for a set of 3D points, whose
         coordinates are in the ``xyz`` array, together with their Cartesian
@@ -144,6 +135,8 @@ class SphericalHarmonics:
 
         :param xyz: The Cartesian coordinates of the 3D points, as an array with
             shape ``(n_samples, 3)``.
+        :param out: Optional tuple of two arrays in which to store the outputs,
+            see :py:meth:`compute`.
 
         :return: A tuple containing:
 
@@ -162,59 +155,23 @@ class SphericalHarmonics:
         if self._calculator is None or self._calculator_f is None:
             raise ValueError("can not use a deleted calculator")
 
-        if not isinstance(xyz, np.ndarray):
-            raise TypeError("xyz must be a numpy array")
-
-        if not (xyz.dtype == np.float32 or xyz.dtype == np.float64):
-            raise TypeError("xyz must be a numpy array of 32 or 64-bit floats")
-
-        if len(xyz.shape) != 2 or xyz.shape[1] != 3:
-            raise ValueError("xyz array must be a `N x 3` array")
-
-        # make xyz contiguous before taking a pointer to it
-        xyz = np.ascontiguousarray(xyz)
-
-        n_samples = xyz.shape[0]
-        xyz_length = n_samples * 3
-
-        sph = np.empty((n_samples, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        sph_length = n_samples * (self._l_max + 1) ** 2
-        dsph = np.empty((n_samples, 3, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        dsph_length = n_samples * 3 * (self._l_max + 1) ** 2
-
-        if xyz.dtype == np.float64:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            dsph_ptr = dsph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-
-            self._lib.sphericart_spherical_harmonics_compute_array_with_gradients(
+        return tuple(
+            _compute_array(
+                self._lib,
+                "sphericart_spherical_harmonics",
                 self._calculator,
-                xyz_ptr,
-                xyz_length,
-                sph_ptr,
-                sph_length,
-                dsph_ptr,
-                dsph_length,
-            )
-        elif xyz.dtype == np.float32:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            dsph_ptr = dsph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-
-            self._lib.sphericart_spherical_harmonics_compute_array_with_gradients_f(
                 self._calculator_f,
-                xyz_ptr,
-                xyz_length,
-                sph_ptr,
-                sph_length,
-                dsph_ptr,
-                dsph_length,
+                self._l_max,
+                xyz,
+                2,
+                out,
             )
-
-        return sph, dsph
+        )
 
     def compute_with_hessians(
-        self, xyz: np.ndarray
+        self,
+        xyz: np.ndarray,
+        out: Optional[Tuple[np.ndarray, np.ndarray, np.ndarray]] = None,
     ) -> Tuple[np.ndarray, np.ndarray, np.ndarray]:
         """
         Calculates the spherical harmonics for a set of 3D points, whose
@@ -235,6 +192,8 @@ class SphericalHarmonics:
 
         :param xyz: The Cartesian coordinates of the 3D points, as an array with
             shape ``(n_samples, 3)``.
+        :param out: Optional tuple of three arrays in which to store the outputs,
+            see :py:meth:`compute`.
 
         :return: A tuple containing:
 
@@ -258,64 +217,39 @@ class SphericalHarmonics:
         if self._calculator is None or self._calculator_f is None:
             raise ValueError("can not use a deleted calculator")
 
-        if not isinstance(xyz, np.ndarray):
-            raise TypeError("xyz must be a numpy array")
-
-        if not (xyz.dtype == np.float32 or xyz.dtype == np.float64):
-            raise TypeError("xyz must be a numpy array of 32 or 64-bit floats")
-
-        if len(xyz.shape) != 2 or xyz.shape[1] != 3:
-            raise ValueError("xyz array must be a `N x 3` array")
-
-        # make xyz contiguous before taking a pointer to it
-        xyz = np.ascontiguousarray(xyz)
-
-        n_samples = xyz.shape[0]
-        xyz_length = n_samples * 3
-
-        sph = np.empty((n_samples, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        sph_length = n_samples * (self._l_max + 1) ** 2
-        dsph = np.empty((n_samples, 3, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        dsph_length = n_samples * 3 * (self._l_max + 1) ** 2
-        ddsph = np.empty((n_samples, 3, 3, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        ddsph_length = n_samples * 9 * (self._l_max + 1) ** 2
-
-        if xyz.dtype == np.float64:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            dsph_ptr = dsph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            ddsph_ptr = ddsph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-
-            self._lib.sphericart_spherical_harmonics_compute_array_with_hessians(
+        return tuple(
+            _compute_array(
+                self._lib,
+                "sphericart_spherical_harmonics",
                 self._calculator,
-                xyz_ptr,
-                xyz_length,
-                sph_ptr,
-                sph_length,
-                dsph_ptr,
-                dsph_length,
-                ddsph_ptr,
-                ddsph_length,
-            )
-        elif xyz.dtype == np.float32:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            dsph_ptr = dsph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            ddsph_ptr = ddsph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-
-            self._lib.sphericart_spherical_harmonics_compute_array_with_gradients_f(
                 self._calculator_f,
-                xyz_ptr,
-                xyz_length,
-                sph_ptr,
-                sph_length,
-                dsph_ptr,
-                dsph_length,
-                ddsph_ptr,
-                ddsph_length,
+                self._l_max,
+                xyz,
+                3,
+                out,
             )
+        )
 
-        return sph, dsph, ddsph
+    def _compute_per_l(self, xyz: np.ndarray, n_outputs: int) -> List[List[np.ndarray]]:
+        """
+        Computes the spherical harmonics (``n_outputs=1``), together with their
+        gradients (``n_outputs=2``) and Hessians (``n_outputs=3``), storing the
+        outputs of each degree ``l`` in a separate array. Returns one list of
+        ``l_max + 1`` arrays for each output, with shapes ``(n_samples, 2*l+1)``,
+        ``(n_samples, 3, 2*l+1)`` and ``(n_samples, 3, 3, 2*l+1)``.
+        """
+        if self._calculator is None or self._calculator_f is None:
+            raise ValueError("can not use a deleted calculator")
+
+        return _compute_per_l(
+            self._lib,
+            "sphericart_spherical_harmonics",
+            self._calculator,
+            self._calculator_f,
+            self._l_max,
+            xyz,
+            n_outputs,
+        )
 
 
 class SolidHarmonics:
@@ -357,49 +291,27 @@ class SolidHarmonics:
             self._lib.sphericart_solid_harmonics_delete_f(self._calculator_f)
             self._calculator_f = None
 
-    def compute(self, xyz: np.ndarray) -> np.ndarray:
+    def compute(self, xyz: np.ndarray, out: Optional[np.ndarray] = None) -> np.ndarray:
         """
         Same as ``SphericalHarmonics.compute``, but for the solid harmonics.
         """
         if self._calculator is None or self._calculator_f is None:
             raise ValueError("can not use a deleted calculator")
 
-        if not isinstance(xyz, np.ndarray):
-            raise TypeError("xyz must be a numpy array")
-
-        if not (xyz.dtype == np.float32 or xyz.dtype == np.float64):
-            raise TypeError("xyz must be a numpy array of 32 or 64-bit floats")
-
-        if len(xyz.shape) != 2 or xyz.shape[1] != 3:
-            raise ValueError("xyz array must be a `N x 3` array")
-
-        # make xyz contiguous before taking a pointer to it
-        xyz = np.ascontiguousarray(xyz)
-
-        n_samples = xyz.shape[0]
-        xyz_length = n_samples * 3
-
-        sph = np.empty((n_samples, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        sph_length = n_samples * (self._l_max + 1) ** 2
-
-        if xyz.dtype == np.float64:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-
-            self._lib.sphericart_solid_harmonics_compute_array(
-                self._calculator, xyz_ptr, xyz_length, sph_ptr, sph_length
-            )
-        elif xyz.dtype == np.float32:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-
-            self._lib.sphericart_solid_harmonics_compute_array_f(
-                self._calculator_f, xyz_ptr, xyz_length, sph_ptr, sph_length
-            )
-
-        return sph
-
-    def compute_with_gradients(self, xyz: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+        return _compute_array(
+            self._lib,
+            "sphericart_solid_harmonics",
+            self._calculator,
+            self._calculator_f,
+            self._l_max,
+            xyz,
+            1,
+            out,
+        )[0]
+
+    def compute_with_gradients(
+        self, xyz: np.ndarray, out: Optional[Tuple[np.ndarray, np.ndarray]] = None
+    ) -> Tuple[np.ndarray, np.ndarray]:
         """
         Same as ``SphericalHarmonics.compute_with_gradients``, but for the solid
         harmonics.
@@ -407,59 +319,23 @@ class SolidHarmonics:
         if self._calculator is None or self._calculator_f is None:
             raise ValueError("can not use a deleted calculator")
 
-        if not isinstance(xyz, np.ndarray):
-            raise TypeError("xyz must be a numpy array")
-
-        if not (xyz.dtype == np.float32 or xyz.dtype == np.float64):
-            raise TypeError("xyz must be a numpy array of 32 or 64-bit floats")
-
-        if len(xyz.shape) != 2 or xyz.shape[1] != 3:
-            raise ValueError("xyz array must be a `N x 3` array")
-
-        # make xyz contiguous before taking a pointer to it
-        xyz = np.ascontiguousarray(xyz)
-
-        n_samples = xyz.shape[0]
-        xyz_length = n_samples * 3
-
-        sph = np.empty((n_samples, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        sph_length = n_samples * (self._l_max + 1) ** 2
-        dsph = np.empty((n_samples, 3, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        dsph_length = n_samples * 3 * (self._l_max + 1) ** 2
-
-        if xyz.dtype == np.float64:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            dsph_ptr = dsph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-
-            self._lib.sphericart_solid_harmonics_compute_array_with_gradients(
+        return tuple(
+            _compute_array(
+                self._lib,
+                "sphericart_solid_harmonics",
                 self._calculator,
-                xyz_ptr,
-                xyz_length,
-                sph_ptr,
-                sph_length,
-                dsph_ptr,
-                dsph_length,
-            )
-        elif xyz.dtype == np.float32:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            dsph_ptr = dsph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-
-            self._lib.sphericart_solid_harmonics_compute_array_with_gradients_f(
                 self._calculator_f,
-                xyz_ptr,
-                xyz_length,
-                sph_ptr,
-                sph_length,
-                dsph_ptr,
-                dsph_length,
+                self._l_max,
+                xyz,
+                2,
+                out,
             )
-
-        return sph, dsph
+        )
 
     def compute_with_hessians(
-        self, xyz: np.ndarray
+        self,
+        xyz: np.ndarray,
+        out: Optional[Tuple[np.ndarray, np.ndarray, np.ndarray]] = None,
     ) -> Tuple[np.ndarray, np.ndarray, np.ndarray]:
         """
         Same as ``SphericalHarmonics.compute_with_hessians``, but for the solid
@@ -468,61 +344,174 @@ class SolidHarmonics:
         if self._calculator is None or self._calculator_f is None:
             raise ValueError("can not use a deleted calculator")
 
-        if not isinstance(xyz, np.ndarray):
-            raise TypeError("xyz must be a numpy array")
+        return tuple(
+            _compute_array(
+                self._lib,
+                "sphericart_solid_harmonics",
+                self._calculator,
+                self._calculator_f,
+                self._l_max,
+                xyz,
+                3,
+                out,
+            )
+        )
 
-        if not (xyz.dtype == np.float32 or xyz.dtype == np.float64):
-            raise TypeError("xyz must be a numpy array of 32 or 64-bit floats")
+    def _compute_per_l(self, xyz: np.ndarray, n_outputs: int) -> List[List[np.ndarray]]:
+        """
+        Computes the solid harmonics (``n_outputs=1``), together with their
+        gradients (``n_outputs=2``) and Hessians (``n_outputs=3``), storing the
+        outputs of each degree ``l`` in a separate array. Returns one list of
+        ``l_max + 1`` arrays for each output, with shapes ``(n_samples, 2*l+1)``,
+        ``(n_samples, 3, 2*l+1)`` and ``(n_samples, 3, 3, 2*l+1)``.
+        """
+        if self._calculator is None or self._calculator_f is None:
+            raise ValueError("can not use a deleted calculator")
 
-        if len(xyz.shape) != 2 or xyz.shape[1] != 3:
-            raise ValueError("xyz array must be a `N x 3` array")
+        return _compute_per_l(
+            self._lib,
+            "sphericart_solid_harmonics",
+            self._calculator,
+            self._calculator_f,
+            self._l_max,
+            xyz,
+            n_outputs,
+        )
 
-        # make xyz contiguous before taking a pointer to it
-        xyz = np.ascontiguousarray(xyz)
 
-        n_samples = xyz.shape[0]
-        xyz_length = n_samples * 3
+def _check_xyz(xyz):
+    if not isinstance(xyz, np.ndarray):
+        raise TypeError("xyz must be a numpy array")
 
-        sph = np.empty((n_samples, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        sph_length = n_samples * (self._l_max + 1) ** 2
-        dsph = np.empty((n_samples, 3, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        dsph_length = n_samples * 3 * (self._l_max + 1) ** 2
-        ddsph = np.empty((n_samples, 3, 3, (self._l_max + 1) ** 2), dtype=xyz.dtype)
-        ddsph_length = n_samples * 9 * (self._l_max + 1) ** 2
+    if not (xyz.dtype == np.float32 or xyz.dtype == np.float64):
+        raise TypeError("xyz must be a numpy array of 32 or 64-bit floats")
 
-        if xyz.dtype == np.float64:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            dsph_ptr = dsph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
-            ddsph_ptr = ddsph.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
+    if len(xyz.shape) != 2 or xyz.shape[1] != 3:
+        raise ValueError("xyz array must be a `N x 3` array")
 
-            self._lib.sphericart_solid_harmonics_compute_array_with_hessians(
-                self._calculator,
-                xyz_ptr,
-                xyz_length,
-                sph_ptr,
-                sph_length,
-                dsph_ptr,
-                dsph_length,
-                ddsph_ptr,
-                ddsph_length,
-            )
-        elif xyz.dtype == np.float32:
-            xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            sph_ptr = sph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            dsph_ptr = dsph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
-            ddsph_ptr = ddsph.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
 
-            self._lib.sphericart_solid_harmonics_compute_array_with_gradients_f(
-                self._calculator_f,
-                xyz_ptr,
-                xyz_length,
-                sph_ptr,
-                sph_length,
-                dsph_ptr,
-                dsph_length,
-                ddsph_ptr,
-                ddsph_length,
-            )
+def _check_output(output, shape, dtype):
+    if not isinstance(output, np.ndarray):
+        raise TypeError("out must contain numpy arrays")
+
+    if output.dtype != dtype:
+        raise TypeError(f"out arrays must have the same dtype as xyz ({dtype})")
+
+    if output.shape != shape:
+        raise ValueError(
+            f"expected an out array with shape {shape}, got {output.shape}"
+        )
+
+    if not output.flags.writeable:
+        raise ValueError("out arrays must be writeable")
+
+    # the outputs of each sample are written contiguously, and the distance
+    # between samples is given to the C API as a number of elements
+    itemsize = output.itemsize
+    sample_size = int(np.prod(shape[1:]))
+    sample_strides = tuple(
+        itemsize * int(np.prod(shape[i + 1 :])) for i in range(1, len(shape))
+    )
+    if (
+        output.strides[1:] != sample_strides
+        or output.strides[0] % itemsize != 0
+        or output.strides[0] < sample_size * itemsize
+    ):
+        raise ValueError(
+            "out arrays must store the outputs of each sample contiguously, "
+            "without overlap between samples"
+        )
+
+
+def _compute_array(
+    lib, prefix, calculator, calculator_f, l_max, xyz, n_outputs, out=None
+):
+    _check_xyz(xyz)
+
+    # arrays where the x, y, z of each sample are contiguous (e.g. column
+    # slices of a larger array) are used in place, others are copied
+    itemsize = xyz.itemsize
+    if (
+        xyz.strides[1] != itemsize
+        or xyz.strides[0] < 3 * itemsize
+        or xyz.strides[0] % itemsize != 0
+    ):
+        xyz = np.ascontiguousarray(xyz)
+    xyz_stride = xyz.strides[0] // itemsize
+
+    n_samples = xyz.shape[0]
+    shapes = [(n_samples,), (n_samples, 3), (n_samples, 3, 3)][:n_outputs]
+    shapes = [shape + ((l_max + 1) ** 2,) for shape in shapes]
+    if out is None:
+        outputs = [np.empty(shape, dtype=xyz.dtype) for shape in shapes]
+    else:
+        if n_outputs == 1:
+            out = (out,)
+        if not isinstance(out, (tuple, list)) or len(out) != n_outputs:
+            raise TypeError(f"out must be a tuple of {n_outputs} numpy arrays")
+        for output, shape in zip(out, shapes):
+            _check_output(output, shape, xyz.dtype)
+        outputs = list(out)
+
+    if xyz.dtype == np.float64:
+        c_type = ctypes.c_double
+        suffix = ""
+    elif xyz.dtype == np.float32:
+        c_type = ctypes.c_float
+        calculator = calculator_f
+        suffix = "_f"
+
+    xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(c_type))
+    # pointer to each output, followed by the distance between its rows
+    outputs_args = []
+    for output in outputs:
+        outputs_args.append(output.ctypes.data_as(ctypes.POINTER(c_type)))
+        outputs_args.append(output.strides[0] // itemsize)
+
+    function = ["", "_with_gradients", "_with_hessians"][n_outputs - 1]
+    compute = getattr(lib, prefix + "_compute_array_strided" + function + suffix)
+    compute(calculator, xyz_ptr, n_samples, xyz_stride, *outputs_args)
+
+    return outputs
+
+
+def _compute_per_l(lib, prefix, calculator, calculator_f, l_max, xyz, n_outputs):
+    _check_xyz(xyz)
+
+    # make xyz contiguous before taking a pointer to it
+    xyz = np.ascontiguousarray(xyz)
+
+    n_samples = xyz.shape[0]
+    xyz_length = n_samples * 3
+
+    shapes = [(n_samples,), (n_samples, 3), (n_samples, 3, 3)][:n_outputs]
+    outputs = [
+        [
+            np.empty(shape + (2 * l + 1,), dtype=xyz.dtype)
+            for l in range(l_max + 1)  # noqa E741
+        ]
+        for shape in shapes
+    ]
+
+    if xyz.dtype == np.float64:
+        c_type = ctypes.c_double
+        suffix = ""
+    elif xyz.dtype == np.float32:
+        c_type = ctypes.c_float
+        calculator = calculator_f
+        suffix = "_f"
+
+    xyz_ptr = xyz.ctypes.data_as(ctypes.POINTER(c_type))
+    # one array of l_max + 1 pointers for each output
+    blocks_ptrs = [
+        (ctypes.POINTER(c_type) * (l_max + 1))(
+            *[block.ctypes.data_as(ctypes.POINTER(c_type)) for block in blocks]
+        )
+        for blocks in outputs
+    ]
+
+    function = ["", "_with_gradients", "_with_hessians"][n_outputs - 1]
+    compute = getattr(lib, prefix + "_compute_array_per_l" + function + suffix)
+    compute(calculator, xyz_ptr, xyz_length, *blocks_ptrs, l_max + 1)
 
-        return sph, dsph, ddsph
+    return outputs
@@ -30,3 +30,45 @@ def test_double_del():
     xyz = np.zeros((5, 3))
     with pytest.raises(ValueError, match=message):
         calculator.compute(xyz)
+
+
+@pytest.mark.parametrize("normalized", [False, True], ids=["solid", "spherical"])
+def test_out(normalized):
+    l_max = 5
+    if normalized:
+        calculator = sphericart.SphericalHarmonics(l_max)
+    else:
+        calculator = sphericart.SolidHarmonics(l_max)
+
+    xyz = np.random.normal(size=(12, 3))
+    sph, dsph, ddsph = calculator.compute_with_hessians(xyz)
+
+    out = np.empty_like(sph)
+    result = calculator.compute(xyz, out=out)
+    assert result is out
+    assert np.allclose(out, sph)
+
+    # the outputs can be slices of larger arrays
+    buffer = np.zeros((12, 3, 2 * sph.shape[1]))
+    out = (np.empty_like(sph), buffer[:, :, : sph.shape[1]])
+    result = calculator.compute_with_gradients(xyz, out=out)
+    assert result[1] is out[1]
+    assert np.allclose(out[0], sph)
+    assert np.allclose(buffer[:, :, : sph.shape[1]], dsph)
+    assert np.all(buffer[:, :, sph.shape[1] :] == 0.0)
+
+    out = (np.empty_like(sph), np.empty_like(dsph), np.empty_like(ddsph))
+    calculator.compute_with_hessians(xyz, out=out)
+    assert np.allclose(out[2], ddsph)
+
+    with pytest.raises(ValueError, match="expected an out array with shape"):
+        calculator.compute(xyz, out=np.empty((11, sph.shape[1])))
+
+    with pytest.raises(TypeError, match="same dtype as xyz"):
+        calculator.compute(xyz, out=np.empty(sph.shape, dtype=np.float32))
+
+    with pytest.raises(ValueError, match="contiguously"):
+        calculator.compute(xyz, out=np.empty(sph.shape[::-1]).T)
+
+    with pytest.raises(TypeError, match="tuple of 2 numpy arrays"):
+        calculator.compute_with_gradients(xyz, out=np.empty_like(sph))
@@ -0,0 +1,521 @@
+#!/usr/bin/env python3
+"""
+This script generates the hard-coded macros for the Cartesian spherical
+harmonics with l > 6 in `sphericart/include/macros.hpp`, and updates
+SPHERICART_LMAX_HARDCODED and the macros that combine all the hard-coded l
+channels accordingly. Everything else in the calculators (the selection of
+the hard-coded kernels in the constructors, the tests) follows from
+SPHERICART_LMAX_HARDCODED.
+
+The macros for l <= 6 are optimized by hand and left untouched. For higher l,
+the generated expressions reuse the harmonics that have already been computed:
+
+- Y_lm is obtained from Y_(l-1)m and Y_(l-2)m with the three-term recursion
+  in z (or from Y_(l-1)(+-(l-1)) for |m| = l);
+- the first derivatives of the (unnormalized) Y_lm are harmonic polynomials
+  of degree l-1, and are written as linear combinations of the Y_(l-1)m';
+- in the same way, the second derivatives are linear combinations of the
+  Y_(l-2)m'.
+
+All the coefficients are computed exactly with rational arithmetic, so that
+each output requires at most three multiplications and additions.
+
+Usage:
+
+    ./scripts/generate-hardcoded-macros.py --lmax 10
+
+Running the script with `--lmax 6` removes all generated macros.
+"""
+import argparse
+import os
+import re
+from decimal import Decimal, getcontext
+from fractions import Fraction
+from math import comb, factorial
+
+getcontext().prec = 40
+
+ROOT = os.path.realpath(os.path.join(os.path.dirname(__file__), ".."))
+MACROS_HPP = os.path.join(ROOT, "sphericart", "include", "macros.hpp")
+
+# the macros up to this l are written by hand
+LMAX_HANDWRITTEN = 6
+
+BEGIN_MARKER = "// BEGIN GENERATED CODE"
+END_MARKER = "// END GENERATED CODE"
+
+# line width used by clang-format, the trailing backslash of macros is in
+# the last column
+COLUMN_LIMIT = 100
+
+
+# ============================================================================ #
+# polynomials in x, y, z, stored as {(a, b, c): coefficient of x^a y^b z^c}   #
+# ============================================================================ #
+
+
+def poly_add(a, b, scale=1):
+    result = dict(a)
+    for key, value in b.items():
+        result[key] = result.get(key, 0) + scale * value
+        if result[key] == 0:
+            del result[key]
+    return result
+
+
+def poly_mul(a, b):
+    result = {}
+    for key_a, value_a in a.items():
+        for key_b, value_b in b.items():
+            key = (key_a[0] + key_b[0], key_a[1] + key_b[1], key_a[2] + key_b[2])
+            result[key] = result.get(key, 0) + value_a * value_b
+            if result[key] == 0:
+                del result[key]
+    return result
+
+
+def poly_pow(a, n):
+    result = ONE
+    for _ in range(n):
+        result = poly_mul(result, a)
+    return result
+
+
+def poly_derivative(a, direction):
+    result = {}
+    for key, value in a.items():
+        if key[direction] > 0:
+            new_key = list(key)
+            new_key[direction] -= 1
+            new_key = tuple(new_key)
+            result[new_key] = result.get(new_key, 0) + value * key[direction]
+    return {key: value for key, value in result.items() if value != 0}
+
+
+ONE = {(0, 0, 0): Fraction(1)}
+X = {(1, 0, 0): Fraction(1)}
+Y = {(0, 1, 0): Fraction(1)}
+Z = {(0, 0, 1): Fraction(1)}
+R2 = poly_add(poly_add(poly_mul(X, X), poly_mul(Y, Y)), poly_mul(Z, Z))
+
+
+def solve(target, basis):
+    """
+    Find the coefficients c_i such that target = sum_i c_i basis_i, with exact
+    Gauss-Jordan elimination. The basis must be linearly independent, and the
+    target must belong to the space it spans.
+    """
+    monomials = sorted(set(target).union(*basis))
+    n_basis = len(basis)
+    rows = [
+        [b.get(monomial, Fraction(0)) for b in basis] + [target.get(monomial, Fraction(0))]
+        for monomial in monomials
+    ]
+
+    for column in range(n_basis):
+        pivot = next(r for r in range(column, len(rows)) if rows[r][column] != 0)
+        rows[column], rows[pivot] = rows[pivot], rows[column]
+        rows[column] = [value / rows[column][column] for value in rows[column]]
+        for r in range(len(rows)):
+            if r != column and rows[r][column] != 0:
+                factor = rows[r][column]
+                rows[r] = [a - factor * b for a, b in zip(rows[r], rows[column])]
+
+    if any(row[n_basis] != 0 for row in rows[n_basis:]):
+        raise ValueError("the target polynomial is not in the span of the basis")
+
+    return [rows[i][n_basis] for i in range(n_basis)]
+
+
+# ============================================================================ #
+# real solid harmonics                                                         #
+# ============================================================================ #
+
+
+def cos_sin_polynomials(m):
+    """r_xy^m cos(m phi) and r_xy^m sin(m phi) as polynomials in x, y"""
+    c, s = ONE, {}
+    for _ in range(m):
+        c, s = poly_add(poly_mul(c, X), poly_mul(s, Y), -1), poly_add(poly_mul(c, Y), poly_mul(s, X))
+    return c, s
+
+
+def legendre_polynomial(l, m):
+    """r^l P_l^m(z/r) / r_xy^m, without the Condon-Shortley phase, m >= 0"""
+    result = {}
+    for k in range((l - m) // 2 + 1):
+        coefficient = Fraction(
+            (-1) ** k * comb(l, k) * comb(2 * l - 2 * k, l) * factorial(l - 2 * k),
+            2**l * factorial(l - 2 * k - m),
+        )
+        term = poly_mul(poly_pow(R2, k), poly_pow(Z, l - 2 * k - m))
+        result = poly_add(result, {key: coefficient * v for key, v in term.items()})
+    return result
+
+
+def solid_harmonic(l, m):
+    """unnormalized real solid harmonic, as a polynomial"""
+    c, s = cos_sin_polynomials(abs(m))
+    return poly_mul(legendre_polynomial(l, abs(m)), s if m < 0 else c)
+
+
+def normalization(l, m):
+    """normalization of the real solid harmonics, without the 1/sqrt(4 pi)"""
+    squared = Fraction(2 * l + 1) * Fraction(factorial(l - abs(m)), factorial(l + abs(m)))
+    if m != 0:
+        squared *= 2
+    return (Decimal(squared.numerator) / Decimal(squared.denominator)).sqrt()
+
+
+def to_decimal(fraction):
+    return Decimal(fraction.numerator) / Decimal(fraction.denominator)
+
+
+def index(l, m):
+    return l * l + l + m
+
+
+def linear_combination(target, l_target, m_target, terms):
+    """
+    Write the normalized version of `target` (a polynomial derived from the
+    solid harmonic l_target, m_target) as a combination of `terms`, a list of
+    (factor, l, m) tuples that stand for the polynomial `factor` times the
+    solid harmonic (l, m). Returns a list of (coefficient, factor name, index)
+    """
+    if len(target) == 0:
+        return []
+
+    basis = [poly_mul(factor, solid_harmonic(l, m)) for (_, factor, l, m) in terms]
+    coefficients = solve(target, basis)
+
+    result = []
+    for coefficient, (name, _, l, m) in zip(coefficients, terms):
+        if coefficient != 0:
+            value = to_decimal(coefficient) * normalization(l_target, m_target) / normalization(l, m)
+            result.append((value, name, index(l, m)))
+    return result
+
+
+def values(l):
+    """Y_lm from the harmonics with degree l-1 and l-2"""
+    result = {}
+    for m in range(-l, l + 1):
+        if m == l:
+            terms = [("x", X, l - 1, l - 1), ("y", Y, l - 1, -(l - 1))]
+        elif m == -l:
+            terms = [("x", X, l - 1, -(l - 1)), ("y", Y, l - 1, l - 1)]
+        elif abs(m) == l - 1:
+            terms = [("z", Z, l - 1, m)]
+        else:
+            terms = [("z", Z, l - 1, m), ("r2", R2, l - 2, m)]
+        result[index(l, m)] = linear_combination(solid_harmonic(l, m), l, m, terms)
+    return result
+
+
+def first_derivatives(l):
+    """dY_lm/dx, dY_lm/dy and dY_lm/dz from the harmonics with degree l-1"""
+    result = {}
+    for m in range(-l, l + 1):
+        harmonic = solid_harmonic(l, m)
+        for direction, name in enumerate(["dx", "dy", "dz"]):
+            derivative = poly_derivative(harmonic, direction)
+            terms = [(None, ONE, l - 1, mm) for mm in range(-(l - 1), l)]
+            result[(name, index(l, m))] = linear_combination(derivative, l, m, terms)
+    return result
+
+
+SECOND_DERIVATIVES = [
+    ("dxdx", 0, 0),
+    ("dxdy", 0, 1),
+    ("dxdz", 0, 2),
+    ("dydy", 1, 1),
+    ("dydz", 1, 2),
+    ("dzdz", 2, 2),
+]
+
+# the other second derivatives are equal to these by symmetry
+SYMMETRIC = {"dxdy": "dydx", "dxdz": "dzdx", "dydz": "dzdy"}
+
+
+def second_derivatives(l):
+    """the second derivatives of Y_lm from the harmonics with degree l-2"""
+    result = {}
+    for m in range(-l, l + 1):
+        harmonic = solid_harmonic(l, m)
+        for name, alpha, beta in SECOND_DERIVATIVES:
+            derivative = poly_derivative(poly_derivative(harmonic, alpha), beta)
+            terms = [(None, ONE, l - 2, mm) for mm in range(-(l - 2), l - 1)]
+            result[(name, index(l, m))] = linear_combination(derivative, l, m, terms)
+    return result
+
+
+# ============================================================================ #
+# code generation                                                              #
+# ============================================================================ #
+
+
+def format_number(value):
+    formatted = f"{float(value):.16g}"
+    if "." not in formatted and "e" not in formatted:
+        formatted += ".0"
+    return formatted
+
+
+def format_operand(coefficient, factor, index):
+    operand = f"(sph_i)[SPH_IDX({index})]"
+    if factor is not None:
+        operand = f"{factor} * {operand}"
+    if abs(abs(coefficient) - 1) > Decimal("1e-30"):
+        operand = f"cast(sph_i, {format_number(abs(coefficient))}) * {operand}"
+    return operand
+
+
+def format_statement(lhs, combination, indent):
+    """
+    Format `lhs = combination;` the same way clang-format would, returning
+    a list of lines
+    """
+    if len(combination) == 0:
+        operands = ["cast(sph_i, 0.0)"]
+        operators = []
+    else:
+        operands = []
+        operators = []
+        for i, (coefficient, factor, index) in enumerate(combination):
+            operand = format_operand(coefficient, factor, index)
+            if i == 0:
+                operands.append(("-" if coefficient < 0 else "") + operand)
+            else:
+                operators.append("-" if coefficient < 0 else "+")
+                operands.append(operand)
+
+    # leave space for the trailing " \"
+    width = COLUMN_LIMIT - 1
+    head = " " * indent + lhs + " = "
+    single_line = head + " ".join(
+        [operands[0]] + [f"{op} {operand}" for op, operand in zip(operators, operands[1:])]
+    )
+    if len(single_line) + 1 <= width:
+        return [single_line + ";"]
+
+    if len(head) + len(operands[0]) + 2 > width or lhs.count("=") > 0:
+        # break after the assignment
+        lines = [head.rstrip()]
+        current = " " * (indent + 4) + operands[0]
+        align = indent + 4
+    else:
+        lines = []
+        current = head + operands[0]
+        align = len(head)
+
+    for op, operand in zip(operators, operands[1:]):
+        if len(current) + len(op) + len(operand) + 3 <= width:
+            current += f" {op} {operand}"
+        else:
+            lines.append(f"{current} {op}")
+            current = " " * align + operand
+    lines.append(current + ";")
+    return lines
+
+
+def macro(lines):
+    """join lines with a backslash in the last column"""
+    width = COLUMN_LIMIT - 1
+    result = [line.ljust(width) + "\\" for line in lines[:-1]]
+    result.append(lines[-1])
+    return "\n".join(result)
+
+
+def multiline_call(name, arguments, indent):
+    lines = [" " * indent + name + "("]
+    for i, argument in enumerate(arguments):
+        separator = "," if i < len(arguments) - 1 else ""
+        lines.append(" " * (indent + 4) + argument + separator)
+    lines.append(" " * indent + ")")
+    return lines
+
+
+VALUE_ARGUMENTS = ["x", "y", "z", "x2", "y2", "z2", "sph_i", "SPH_IDX"]
+DERIVATIVE_ARGUMENTS = [
+    "x",
+    "y",
+    "z",
+    "x2",
+    "y2",
+    "z2",
+    "sph_i",
+    "dx_sph_i",
+    "dy_sph_i",
+    "dz_sph_i",
+    "SPH_IDX",
+]
+SECOND_DERIVATIVE_ARGUMENTS = [
+    "sph_i",
+    "dxdx_sph_i",
+    "dxdy_sph_i",
+    "dxdz_sph_i",
+    "dydx_sph_i",
+    "dydy_sph_i",
+    "dydz_sph_i",
+    "dzdx_sph_i",
+    "dzdy_sph_i",
+    "dzdz_sph_i",
+    "SPH_IDX",
+]
+
+
+def value_macro(l):
+    lines = [f"#define COMPUTE_SPH_L{l}({', '.join(VALUE_ARGUMENTS)})", "    {"]
+    lines.append("        auto r2 = x2 + y2 + z2;")
+    for i, combination in values(l).items():
+        lines += format_statement(f"(sph_i)[SPH_IDX({i})]", combination, 8)
+    lines.append("    }")
+    return macro(lines)
+
+
+def derivative_macro(l):
+    lines = multiline_call(f"#define COMPUTE_SPH_DERIVATIVE_L{l}", DERIVATIVE_ARGUMENTS, 0)
+    lines[0] = lines[0].lstrip()
+    derivatives = first_derivatives(l)
+    for name in ["dx", "dy", "dz"]:
+        for m in range(-l, l + 1):
+            combination = derivatives[(name, index(l, m))]
+            lhs = f"({name}_sph_i)[SPH_IDX({index(l, m)})]"
+            lines += format_statement(lhs, combination, 4)
+        lines.append("")
+    lines.pop()
+    return macro(lines)
+
+
+def second_derivative_macro(l):
+    lines = multiline_call(
+        f"#define COMPUTE_SPH_SECOND_DERIVATIVE_L{l}", SECOND_DERIVATIVE_ARGUMENTS, 0
+    )
+    derivatives = second_derivatives(l)
+    for name, _, _ in SECOND_DERIVATIVES:
+        for m in range(-l, l + 1):
+            combination = derivatives[(name, index(l, m))]
+            lhs = f"({name}_sph_i)[SPH_IDX({index(l, m)})]"
+            if name in SYMMETRIC:
+                lhs += f" = ({SYMMETRIC[name]}_sph_i)[SPH_IDX({index(l, m)})]"
+            lines += format_statement(lhs, combination, 4)
+        lines.append("")
+    lines.pop()
+    return macro(lines)
+
+
+def combined_macros(lmax):
+    # values
+    lines = [
+        "#define HARDCODED_SPH_MACRO(HARDCODED_LMAX, x, y, z, x2, y2, z2, sph_i, SPH_IDX)",
+        "    static_assert(",
+        "        HARDCODED_LMAX <= SPHERICART_LMAX_HARDCODED,",
+        '        "Computing hardcoded sph beyond what is currently implemented."',
+        "    );",
+        "",
+        "    COMPUTE_SPH_L0(sph_i, SPH_IDX);",
+        "    if constexpr (HARDCODED_LMAX > 0) {",
+        "        COMPUTE_SPH_L1(x, y, z, sph_i, SPH_IDX);",
+        "    }",
+    ]
+    for l in range(2, lmax + 1):
+        lines += [
+            f"    if constexpr (HARDCODED_LMAX > {l - 1}) {{",
+            f"        COMPUTE_SPH_L{l}(x, y, z, x2, y2, z2, sph_i, SPH_IDX);",
+            "    }",
+        ]
+    output = [macro(lines)]
+
+    # first derivatives
+    lines = [
+        "#define HARDCODED_SPH_DERIVATIVE_MACRO(",
+        "    HARDCODED_LMAX, x, y, z, x2, y2, z2, sph_i, dx_sph_i, dy_sph_i, dz_sph_i, SPH_IDX",
+        ")",
+        "    COMPUTE_SPH_DERIVATIVE_L0(sph_i, dx_sph_i, dy_sph_i, dz_sph_i, SPH_IDX);",
+        "    if constexpr (HARDCODED_LMAX > 0) {",
+        "        COMPUTE_SPH_DERIVATIVE_L1(sph_i, dx_sph_i, dy_sph_i, dz_sph_i, SPH_IDX);",
+        "    }",
+    ]
+    for l in range(2, lmax + 1):
+        lines += [
+            f"    if constexpr (HARDCODED_LMAX > {l - 1}) {{",
+            f"        COMPUTE_SPH_DERIVATIVE_L{l}(",
+            "            x, y, z, x2, y2, z2, sph_i, dx_sph_i, dy_sph_i, dz_sph_i, SPH_IDX",
+            "        );",
+            "    }",
+        ]
+    output.append(macro(lines))
+
+    # second derivatives
+    lines = multiline_call(
+        "#define HARDCODED_SPH_SECOND_DERIVATIVE_MACRO",
+        ["HARDCODED_LMAX"] + SECOND_DERIVATIVE_ARGUMENTS,
+        0,
+    )
+    lines += multiline_call("COMPUTE_SPH_SECOND_DERIVATIVE_L0", SECOND_DERIVATIVE_ARGUMENTS, 4)
+    lines[-1] += ";"
+    for l in range(1, lmax + 1):
+        lines.append(f"    if constexpr (HARDCODED_LMAX > {l - 1}) {{")
+        lines += multiline_call(
+            f"COMPUTE_SPH_SECOND_DERIVATIVE_L{l}", SECOND_DERIVATIVE_ARGUMENTS, 8
+        )
+        lines[-1] += ";"
+        lines.append("    }")
+    output.append(macro(lines))
+
+    return "\n\n".join(output)
+
+
+def generate(lmax):
+    sections = [
+        BEGIN_MARKER
+        + "\n// The code below is generated by scripts/generate-hardcoded-macros.py, do not"
+        + "\n// modify it by hand."
+    ]
+    for l in range(LMAX_HANDWRITTEN + 1, lmax + 1):
+        sections.append(value_macro(l))
+        sections.append(derivative_macro(l))
+        sections.append(second_derivative_macro(l))
+
+    sections.append(
+        """/*
+Combines the macro hard-coded Ylm calculators to get all the terms up to a
+given value. Macro version. This uses if constexpr to decide at compile time
+which macro(s) should be called
+*/
+"""
+        + combined_macros(lmax)
+    )
+    sections.append(END_MARKER)
+    return "\n\n".join(sections)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument(
+        "--lmax",
+        type=int,
+        required=True,
+        help=f"maximal l for the hard-coded macros (at least {LMAX_HANDWRITTEN})",
+    )
+    args = parser.parse_args()
+
+    if args.lmax < LMAX_HANDWRITTEN:
+        raise ValueError(f"--lmax must be at least {LMAX_HANDWRITTEN}")
+
+    with open(MACROS_HPP) as fd:
+        content = fd.read()
+
+    start = content.index(BEGIN_MARKER)
+    stop = content.index(END_MARKER) + len(END_MARKER)
+    content = content[:start] + generate(args.lmax) + content[stop:]
+
+    content, count = re.subn(
+        r"#define SPHERICART_LMAX_HARDCODED \d+",
+        f"#define SPHERICART_LMAX_HARDCODED {args.lmax}",
+        content,
+    )
+    assert count == 1
+
+    with open(MACROS_HPP, "w") as fd:
+        fd.write(content)
@@ -4,10 +4,15 @@
 // following the JAX FFI tutorial:
 // https://docs.jax.dev/en/latest/ffi.html
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <utility>
 
 #include "sphericart.hpp"
@@ -19,6 +24,134 @@ namespace ffi = xla::ffi;
 
 namespace {
 
+// thread pool of the XLA computation calling the current handler, if any
+thread_local ffi::ThreadPool* CURRENT_THREAD_POOL = nullptr;
+
+// sets CURRENT_THREAD_POOL for the duration of a handler
+class ThreadPoolGuard {
+  public:
+    explicit ThreadPoolGuard(ffi::ThreadPool* thread_pool) : previous(CURRENT_THREAD_POOL) {
+        CURRENT_THREAD_POOL = thread_pool;
+    }
+    ~ThreadPoolGuard() { CURRENT_THREAD_POOL = this->previous; }
+
+    ThreadPoolGuard(const ThreadPoolGuard&) = delete;
+    ThreadPoolGuard& operator=(const ThreadPoolGuard&) = delete;
+
+  private:
+    ffi::ThreadPool* previous;
+};
+
+// Runs the workers of the cached calculators on the intra-op thread pool of
+// the XLA execution context, instead of starting an OpenMP team inside of
+// XLA's executor. The calling thread takes part in the work, and runs all
+// the workers that no thread of the pool has started yet, so that the
+// handlers make progress even when all the threads of the pool are busy
+// (e.g. running other handlers).
+class XLABackend final : public sphericart::ParallelBackend {
+  public:
+    size_t max_workers() const override {
+        // the calculators are cached for all computations, so this can not
+        // depend on the thread pool of a given computation
+        return std::max(static_cast<size_t>(std::thread::hardware_concurrency()), size_t(1));
+    }
+
+    void run(size_t max_workers, sphericart::ParallelTask task) override {
+        auto* thread_pool = CURRENT_THREAD_POOL;
+        auto n_workers = max_workers;
+        if (thread_pool != nullptr) {
+            auto pool_threads = std::max(thread_pool->num_threads(), int64_t(0));
+            n_workers = std::min(n_workers, static_cast<size_t>(pool_threads) + 1);
+        }
+        if (thread_pool == nullptr || n_workers <= 1) {
+            task(0, 1);
+            return;
+        }
+
+        // the scheduled closures can start after this function returned, so
+        // they share the state instead of referencing the stack
+        auto state = std::make_shared<State>();
+        state->task = &task;
+        state->n_workers = n_workers;
+        {
+            // the workers reference `task`, so this waits for all of them
+            // before leaving, even if scheduling them failed
+            WaitGuard wait_guard(*state);
+            for (size_t i = 1; i < n_workers; i++) {
+                thread_pool->Schedule([state]() { state->work(); });
+            }
+        }
+
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+  private:
+    struct State {
+        // runs workers until all of them have been started
+        void work() {
+            while (true) {
+                auto worker = this->next.fetch_add(1);
+                if (worker >= this->n_workers) {
+                    return;
+                }
+                auto error = std::exception_ptr();
+                try {
+                    (*this->task)(worker, this->n_workers);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> guard(this->mutex);
+                // only the first error is given back to the caller of run()
+                if (error && !this->error) {
+                    this->error = error;
+                }
+                this->done += 1;
+                if (this->done == this->n_workers) {
+                    this->all_done.notify_one();
+                }
+            }
+        }
+
+        // only used by the threads which started a worker, i.e. before the
+        // call to run() returns
+        const sphericart::ParallelTask* task = nullptr;
+        size_t n_workers = 0;
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable all_done;
+        size_t done = 0;
+        std::exception_ptr error;
+    };
+
+    // runs the workers that did not start yet on the calling thread, and
+    // then waits for the ones running on the thread pool
+    class WaitGuard {
+      public:
+        explicit WaitGuard(State& state) : state(state) {}
+        ~WaitGuard() {
+            this->state.work();
+            std::unique_lock<std::mutex> lock(this->state.mutex);
+            this->state.all_done.wait(lock, [this]() {
+                return this->state.done == this->state.n_workers;
+            });
+        }
+
+        WaitGuard(const WaitGuard&) = delete;
+        WaitGuard& operator=(const WaitGuard&) = delete;
+
+      private:
+        State& state;
+    };
+};
+
+std::shared_ptr<sphericart::ParallelBackend> GetXLABackend() {
+    static auto backend = std::make_shared<XLABackend>();
+    return backend;
+}
+
 template <template <typename> class C, typename T>
 using CacheMapCPU = std::map<size_t, std::unique_ptr<C<T>>>;
 
@@ -30,11 +163,21 @@ std::unique_ptr<C<T>>& GetOrCreateCPU(size_t l_max) {
     std::lock_guard<std::mutex> lock(cache_mutex);
     auto it = cache.find(l_max);
     if (it == cache.end()) {
-        it = cache.insert({l_max, std::make_unique<C<T>>(l_max)}).first;
+        auto calculator = std::make_unique<C<T>>(
+            l_max, sphericart::Engine::SAMPLE, sphericart::Layout::SAMPLE_MAJOR, GetXLABackend()
+        );
+        it = cache.insert({l_max, std::move(calculator)}).first;
     }
     return it->second;
 }
 
+// scratch memory for the calls made by the current thread, so that the cached
+// calculators can be used by several XLA threads at the same time
+template <typename T> sphericart::Workspace<T>* GetThreadWorkspaceCPU() {
+    static thread_local sphericart::Workspace<T> workspace;
+    return &workspace;
+}
+
 template <ffi::DataType DT>
 ffi::Error GetNSamples(const ffi::Buffer<DT>& xyz, int64_t* n_samples_out) {
     auto dims = xyz.dimensions();
@@ -53,7 +196,9 @@ ffi::Error GetNSamples(const ffi::Buffer<DT>& xyz, int64_t* n_samples_out) {
 }
 
 template <template <typename> class C, typename T, ffi::DataType DT>
-ffi::Error CpuSphImpl(int64_t l_max_i64, ffi::Buffer<DT> xyz, ffi::ResultBuffer<DT> sph) {
+ffi::Error CpuSphImpl(
+    ffi::ThreadPool thread_pool, int64_t l_max_i64, ffi::Buffer<DT> xyz, ffi::ResultBuffer<DT> sph
+) {
     if (l_max_i64 < 0) {
         return ffi::Error::InvalidArgument("l_max must be non-negative");
     }
@@ -77,13 +222,18 @@ ffi::Error CpuSphImpl(int64_t l_max_i64, ffi::Buffer<DT> xyz, ffi::ResultBuffer<
     const size_t sph_len = sph->element_count();
 
     auto& calculator = GetOrCreateCPU<C, T>(l_max);
-    calculator->compute_array(xyz_ptr, xyz_len, sph_ptr, sph_len);
+    auto guard = ThreadPoolGuard(&thread_pool);
+    calculator->compute_array(xyz_ptr, xyz_len, sph_ptr, sph_len, GetThreadWorkspaceCPU<T>());
     return ffi::Error::Success();
 }
 
 template <template <typename> class C, typename T, ffi::DataType DT>
 ffi::Error CpuSphGradImpl(
-    int64_t l_max_i64, ffi::Buffer<DT> xyz, ffi::ResultBuffer<DT> sph, ffi::ResultBuffer<DT> dsph
+    ffi::ThreadPool thread_pool,
+    int64_t l_max_i64,
+    ffi::Buffer<DT> xyz,
+    ffi::ResultBuffer<DT> sph,
+    ffi::ResultBuffer<DT> dsph
 ) {
     if (l_max_i64 < 0) {
         return ffi::Error::InvalidArgument("l_max must be non-negative");
@@ -115,12 +265,16 @@ ffi::Error CpuSphGradImpl(
     const size_t dsph_len = dsph->element_count();
 
     auto& calculator = GetOrCreateCPU<C, T>(l_max);
-    calculator->compute_array_with_gradients(xyz_ptr, xyz_len, sph_ptr, sph_len, dsph_ptr, dsph_len);
+    auto guard = ThreadPoolGuard(&thread_pool);
+    calculator->compute_array_with_gradients(
+        xyz_ptr, xyz_len, sph_ptr, sph_len, dsph_ptr, dsph_len, GetThreadWorkspaceCPU<T>()
+    );
     return ffi::Error::Success();
 }
 
 template <template <typename> class C, typename T, ffi::DataType DT>
 ffi::Error CpuSphHessImpl(
+    ffi::ThreadPool thread_pool,
     int64_t l_max_i64,
     ffi::Buffer<DT> xyz,
     ffi::ResultBuffer<DT> sph,
@@ -163,8 +317,17 @@ ffi::Error CpuSphHessImpl(
     const size_t ddsph_len = ddsph->element_count();
 
     auto& calculator = GetOrCreateCPU<C, T>(l_max);
+    auto guard = ThreadPoolGuard(&thread_pool);
     calculator->compute_array_with_hessians(
-        xyz_ptr, xyz_len, sph_ptr, sph_len, dsph_ptr, dsph_len, ddsph_ptr, ddsph_len
+        xyz_ptr,
+        xyz_len,
+        sph_ptr,
+        sph_len,
+        dsph_ptr,
+        dsph_len,
+        ddsph_ptr,
+        ddsph_len,
+        GetThreadWorkspaceCPU<T>()
     );
     return ffi::Error::Success();
 }
@@ -178,6 +341,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_spherical_f32,
     (CpuSphImpl<sphericart::SphericalHarmonics, float, ffi::F32>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F32>>() // xyz
         .Ret<ffi::Buffer<ffi::F32>>() // sph
@@ -187,6 +351,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_spherical_f64,
     (CpuSphImpl<sphericart::SphericalHarmonics, double, ffi::F64>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F64>>() // xyz
         .Ret<ffi::Buffer<ffi::F64>>() // sph
@@ -196,6 +361,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_solid_f32,
     (CpuSphImpl<sphericart::SolidHarmonics, float, ffi::F32>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F32>>() // xyz
         .Ret<ffi::Buffer<ffi::F32>>() // sph
@@ -205,6 +371,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_solid_f64,
     (CpuSphImpl<sphericart::SolidHarmonics, double, ffi::F64>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F64>>() // xyz
         .Ret<ffi::Buffer<ffi::F64>>() // sph
@@ -215,6 +382,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_dspherical_f32,
     (CpuSphGradImpl<sphericart::SphericalHarmonics, float, ffi::F32>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F32>>() // xyz
         .Ret<ffi::Buffer<ffi::F32>>() // sph
@@ -225,6 +393,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_dspherical_f64,
     (CpuSphGradImpl<sphericart::SphericalHarmonics, double, ffi::F64>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F64>>() // xyz
         .Ret<ffi::Buffer<ffi::F64>>() // sph
@@ -235,6 +404,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_dsolid_f32,
     (CpuSphGradImpl<sphericart::SolidHarmonics, float, ffi::F32>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F32>>() // xyz
         .Ret<ffi::Buffer<ffi::F32>>() // sph
@@ -245,6 +415,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_dsolid_f64,
     (CpuSphGradImpl<sphericart::SolidHarmonics, double, ffi::F64>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F64>>() // xyz
         .Ret<ffi::Buffer<ffi::F64>>() // sph
@@ -256,6 +427,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_ddspherical_f32,
     (CpuSphHessImpl<sphericart::SphericalHarmonics, float, ffi::F32>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F32>>() // xyz
         .Ret<ffi::Buffer<ffi::F32>>() // sph
@@ -267,6 +439,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_ddspherical_f64,
     (CpuSphHessImpl<sphericart::SphericalHarmonics, double, ffi::F64>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F64>>() // xyz
         .Ret<ffi::Buffer<ffi::F64>>() // sph
@@ -278,6 +451,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_ddsolid_f32,
     (CpuSphHessImpl<sphericart::SolidHarmonics, float, ffi::F32>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F32>>() // xyz
         .Ret<ffi::Buffer<ffi::F32>>() // sph
@@ -289,6 +463,7 @@ XLA_FFI_DEFINE_HANDLER_SYMBOL(
     cpu_ddsolid_f64,
     (CpuSphHessImpl<sphericart::SolidHarmonics, double, ffi::F64>),
     ffi::Ffi::Bind()
+        .Ctx<ffi::ThreadPool>()
         .Attr<int64_t>("l_max")
         .Arg<ffi::Buffer<ffi::F64>>() // xyz
         .Ret<ffi::Buffer<ffi::F64>>() // sph
@@ -6,9 +6,28 @@
 
 namespace sphericart_torch {
 
-class SphericartAutograd : public torch::autograd::Function<SphericartAutograd> {
+/// Calculator of type `C` (`SphericalHarmonics` or `SolidHarmonics`) with the
+/// given parameters, created on first use and shared by all the callers. The
+/// autograd functions and operators keep this calculator alive instead of the
+/// one used in the forward pass, which might not be owned by an
+/// `intrusive_ptr` (e.g. when it is created on the stack from C++).
+///
+/// The calculators are kept until the end of the process. There is one of
+/// them for each set of parameters used, which are few in practice (typically
+/// one or two values of `l_max`). Each of them only holds the prefactors
+/// (and the CUDA calculators when CUDA is available): the scratch buffers of
+/// the CPU calculators are never allocated, since the torch code always
+/// gives them a thread-local `Workspace`.
+template <class C>
+c10::intrusive_ptr<C> shared_calculator(
+    int64_t l_max, bool backward_second_derivatives = false, bool checkpoint = false
+);
+
+/// Autograd function for the spherical harmonics computed by the calculator
+/// `C`, either `SphericalHarmonics` or `SolidHarmonics`
+template <class C>
+class SphericartAutograd : public torch::autograd::Function<SphericartAutograd<C>> {
   public:
-    template <typename C>
     static std::vector<torch::Tensor> forward(
         torch::autograd::AutogradContext* ctx,
         C& calculator,
@@ -22,13 +41,17 @@ class SphericartAutograd : public torch::autograd::Function<SphericartAutograd>
     );
 };
 
-class SphericartAutogradBackward : public torch::autograd::Function<SphericartAutogradBackward> {
+/// Backward pass of `SphericartAutograd`, as a separate autograd function to
+/// support double backward
+template <class C>
+class SphericartAutogradBackward : public torch::autograd::Function<SphericartAutogradBackward<C>> {
   public:
     static torch::Tensor forward(
         torch::autograd::AutogradContext* ctx,
         torch::Tensor grad_outputs,
         torch::Tensor xyz,
-        std::vector<torch::Tensor> saved_variables
+        std::vector<torch::Tensor> saved_variables,
+        c10::intrusive_ptr<C> calculator
     );
 
     static std::vector<torch::Tensor> backward(
@@ -0,0 +1,60 @@
+#ifndef SPHERICART_TORCH_OPERATORS_HPP
+#define SPHERICART_TORCH_OPERATORS_HPP
+
+#include <string>
+#include <tuple>
+
+#include <torch/torch.h>
+
+namespace sphericart_torch {
+
+/// Kernels of the dispatcher operators computing the spherical harmonics of
+/// the calculator `C`, either `SphericalHarmonics` (`spherical_harmonics`
+/// operators) or `SolidHarmonics` (`solid_harmonics` operators). The
+/// operators use one calculator for each value of `l_max`, created on first
+/// use and shared by all the calls.
+///
+/// For a name `N`, the following operators are registered in the
+/// `sphericart_torch` namespace:
+///
+/// - `N(Tensor xyz, int l_max) -> Tensor`, with CPU, CUDA, Meta and Autograd
+///   kernels. It supports a single backward pass with respect to `xyz`;
+/// - `N_with_gradients(Tensor xyz, int l_max) -> (Tensor, Tensor)`, returning
+///   the spherical harmonics and their gradients;
+/// - `N_backward(Tensor grad_output, Tensor xyz, Tensor dsph, int l_max)`,
+///   contracting `grad_output` with the gradients in `dsph`.
+///
+/// The last two are used by the Autograd kernel of the first one, and are
+/// not differentiable.
+template <class C> class SphericartOperators {
+  public:
+    /// Name of the operators for this calculator
+    static const std::string& name();
+
+    /// CPU and CUDA kernels
+    static torch::Tensor compute(torch::Tensor xyz, int64_t l_max);
+    static std::tuple<torch::Tensor, torch::Tensor> compute_with_gradients(
+        torch::Tensor xyz, int64_t l_max
+    );
+    static torch::Tensor backward(
+        torch::Tensor grad_output, torch::Tensor xyz, torch::Tensor dsph, int64_t l_max
+    );
+
+    /// Meta kernels, only computing the shape of the outputs. These are also
+    /// used for FakeTensor when tracing with `torch.compile`
+    static torch::Tensor compute_meta(torch::Tensor xyz, int64_t l_max);
+    static std::tuple<torch::Tensor, torch::Tensor> compute_with_gradients_meta(
+        torch::Tensor xyz, int64_t l_max
+    );
+    static torch::Tensor backward_meta(
+        torch::Tensor grad_output, torch::Tensor xyz, torch::Tensor dsph, int64_t l_max
+    );
+
+    /// Autograd kernel, recording the backward pass when `xyz` requires
+    /// gradients, and re-dispatching to the kernels above
+    static torch::Tensor compute_autograd(torch::Tensor xyz, int64_t l_max);
+};
+
+} // namespace sphericart_torch
+
+#endif
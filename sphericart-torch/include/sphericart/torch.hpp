@@ -1,6 +1,7 @@
 #ifndef SPHERICART_TORCH_HPP
 #define SPHERICART_TORCH_HPP
 
+#include <ATen/Parallel.h>
 #include <torch/torch.h>
 
 #include <mutex>
@@ -10,35 +11,53 @@
 
 namespace sphericart_torch {
 
-class SphericartAutograd;
-class SphericartAutogradBackward;
+template <class C> class SphericartAutograd;
+template <class C> class SphericartAutogradBackward;
+template <class C> class SphericartOperators;
 
 class SphericalHarmonics : public torch::CustomClassHolder {
   public:
-    SphericalHarmonics(int64_t l_max, bool backward_second_derivatives = false);
+    SphericalHarmonics(
+        int64_t l_max, bool backward_second_derivatives = false, bool checkpoint = false
+    );
 
     // Actual calculation, with autograd support
     torch::Tensor compute(torch::Tensor xyz);
     std::vector<torch::Tensor> compute_with_gradients(torch::Tensor xyz);
     std::vector<torch::Tensor> compute_with_hessians(torch::Tensor xyz);
+    // Calculation without autograd support, writing into the given tensors.
+    // `out` contains 1, 2 or 3 tensors, for the spherical harmonics and
+    // optionally their gradients and hessians
+    std::vector<torch::Tensor> compute_into(torch::Tensor xyz, std::vector<torch::Tensor> out);
 
     int64_t get_l_max() const { return this->l_max_; }
     bool get_backward_second_derivative_flag() const { return this->backward_second_derivatives_; }
-    int64_t get_omp_num_threads() const { return this->omp_num_threads_; }
+    bool get_checkpoint_flag() const { return this->checkpoint_; }
+    int64_t get_omp_num_threads() const { return at::get_num_threads(); }
 
   private:
-    friend class SphericartAutograd;
-
-    // Raw calculation, without autograd support, running on CPU
-    std::vector<torch::Tensor> compute_raw_cpu(torch::Tensor xyz, bool do_gradients, bool do_hessians);
+    template <class C> friend class SphericartAutograd;
+    template <class C> friend class SphericartAutogradBackward;
+    template <class C> friend class SphericartOperators;
+
+    // Raw calculation, without autograd support, running on CPU. The outputs
+    // are allocated, unless they are given in `out`
+    std::vector<torch::Tensor> compute_raw_cpu(
+        torch::Tensor xyz, bool do_gradients, bool do_hessians, std::vector<torch::Tensor> out = {}
+    );
     // Raw calculation, without autograd support, running on CUDA
     std::vector<torch::Tensor> compute_raw_cuda(
-        torch::Tensor xyz, bool do_gradients, bool do_hessians, void* stream = nullptr
+        torch::Tensor xyz,
+        bool do_gradients,
+        bool do_hessians,
+        void* stream = nullptr,
+        std::vector<torch::Tensor> out = {}
     );
 
-    int64_t omp_num_threads_;
     int64_t l_max_;
     bool backward_second_derivatives_;
+    // only save xyz for the backward pass, and recompute the derivatives
+    bool checkpoint_;
 
     // CPU implementation
     sphericart::SphericalHarmonics<double> calculator_double_;
@@ -51,30 +70,47 @@ class SphericalHarmonics : public torch::CustomClassHolder {
 
 class SolidHarmonics : public torch::CustomClassHolder {
   public:
-    SolidHarmonics(int64_t l_max, bool backward_second_derivatives = false);
+    SolidHarmonics(
+        int64_t l_max, bool backward_second_derivatives = false, bool checkpoint = false
+    );
 
     // Actual calculation, with autograd support
     torch::Tensor compute(torch::Tensor xyz);
     std::vector<torch::Tensor> compute_with_gradients(torch::Tensor xyz);
     std::vector<torch::Tensor> compute_with_hessians(torch::Tensor xyz);
+    // Calculation without autograd support, writing into the given tensors.
+    // `out` contains 1, 2 or 3 tensors, for the spherical harmonics and
+    // optionally their gradients and hessians
+    std::vector<torch::Tensor> compute_into(torch::Tensor xyz, std::vector<torch::Tensor> out);
 
     int64_t get_l_max() const { return this->l_max_; }
     bool get_backward_second_derivative_flag() const { return this->backward_second_derivatives_; }
-    int64_t get_omp_num_threads() const { return this->omp_num_threads_; }
+    bool get_checkpoint_flag() const { return this->checkpoint_; }
+    int64_t get_omp_num_threads() const { return at::get_num_threads(); }
 
   private:
-    friend class SphericartAutograd;
-
-    // Raw calculation, without autograd support, running on CPU
-    std::vector<torch::Tensor> compute_raw_cpu(torch::Tensor xyz, bool do_gradients, bool do_hessians);
+    template <class C> friend class SphericartAutograd;
+    template <class C> friend class SphericartAutogradBackward;
+    template <class C> friend class SphericartOperators;
+
+    // Raw calculation, without autograd support, running on CPU. The outputs
+    // are allocated, unless they are given in `out`
+    std::vector<torch::Tensor> compute_raw_cpu(
+        torch::Tensor xyz, bool do_gradients, bool do_hessians, std::vector<torch::Tensor> out = {}
+    );
     // Raw calculation, without autograd support, running on CUDA
     std::vector<torch::Tensor> compute_raw_cuda(
-        torch::Tensor xyz, bool do_gradients, bool do_hessians, void* stream = nullptr
+        torch::Tensor xyz,
+        bool do_gradients,
+        bool do_hessians,
+        void* stream = nullptr,
+        std::vector<torch::Tensor> out = {}
     );
 
-    int64_t omp_num_threads_;
     int64_t l_max_;
     bool backward_second_derivatives_;
+    // only save xyz for the backward pass, and recompute the derivatives
+    bool checkpoint_;
 
     // CPU implementation
     sphericart::SolidHarmonics<double> calculator_double_;
@@ -7,7 +7,12 @@ from collections import namedtuple
 import torch
 
 from .e3nn import e3nn_spherical_harmonics, patch_e3nn, unpatch_e3nn  # noqa: F401
-from .spherical_hamonics import SolidHarmonics, SphericalHarmonics  # noqa: F401
+from .spherical_hamonics import (  # noqa: F401
+    SolidHarmonics,
+    SphericalHarmonics,
+    solid_harmonics,
+    spherical_harmonics,
+)
 
 
 Version = namedtuple("Version", ["major", "minor", "patch"])
@@ -1,4 +1,4 @@
-from typing import Tuple
+from typing import Optional, Tuple
 
 import torch
 from torch import Tensor
@@ -64,6 +64,14 @@ class SphericalHarmonics(torch.nn.Module):
         double reverse-mode differentiation with respect to ``xyz``. If ``False``, only
         the first derivatives will be computed and only a single reverse-mode
         differentiation step will be possible with respect to ``xyz``.
+    :param checkpoint:
+        if this parameter is set to ``True``, only ``xyz`` is stored during forward
+        calls to ``compute``, and the derivatives of the spherical harmonics are
+        recomputed in the backward pass. On CPU, they are recomputed one point at a
+        time and contracted immediately. The stored derivatives are 3 times (12
+        times with ``backward_second_derivatives=True``) larger than the spherical
+        harmonics, so this allows larger batches during training, at the cost of
+        computing the derivatives again in the backward pass.
 
     :return: a calculator, in the form of a SphericalHarmonics object
     """
@@ -72,10 +80,11 @@ class SphericalHarmonics(torch.nn.Module):
         self,
         l_max: int,
         backward_second_derivatives: bool = False,
+        checkpoint: bool = False,
     ):
         super().__init__()
         self.calculator = torch.classes.sphericart_torch.SphericalHarmonics(
-            l_max, backward_second_derivatives
+            l_max, backward_second_derivatives, checkpoint
         )
 
     def forward(self, xyz: Tensor) -> Tensor:
@@ -105,11 +114,26 @@ class SphericalHarmonics(torch.nn.Module):
         """
         return self.calculator.compute(xyz)
 
-    def compute(self, xyz: Tensor) -> Tensor:
-        """Equivalent to ``forward``"""
-        return self.calculator.compute(xyz)
+    def compute(self, xyz: Tensor, out: Optional[Tensor] = None) -> Tensor:
+        """
+        Equivalent to ``forward``. If ``out`` is given, the spherical harmonics
+        are written into it instead of a new tensor, and ``out`` is returned.
+
+        ``out`` must be on the same device and have the same dtype as ``xyz``,
+        with shape ``(n_samples, (l_max+1)**2)``. On CPU, the entries of each
+        sample must be contiguous (e.g. a slice of a larger tensor); on CUDA,
+        ``out`` must be contiguous. When computing the spherical harmonics of
+        the same number of points many times, e.g. in a molecular dynamics
+        loop, this avoids allocating new tensors for every call. Calls with
+        ``out`` do not support automatic differentiation.
+        """
+        if out is None:
+            return self.calculator.compute(xyz)
+        return self.calculator.compute_into(xyz, [out])[0]
 
-    def compute_with_gradients(self, xyz: Tensor) -> Tuple[Tensor, Tensor]:
+    def compute_with_gradients(
+        self, xyz: Tensor, out: Optional[Tuple[Tensor, Tensor]] = None
+    ) -> Tuple[Tensor, Tensor]:
         """
         Calculates the spherical harmonics for a set of 3D points,
         and also returns the forward-mode derivatives.
@@ -123,6 +147,9 @@ class SphericalHarmonics(torch.nn.Module):
         :param xyz:
             The Cartesian coordinates of the 3D points, as a `torch.Tensor` with
             shape ``(n_samples, 3)``.
+        :param out:
+            Optional tuple of tensors in which to write the outputs, see
+            :py:meth:`compute`.
 
         :return:
             A tuple that contains:
@@ -139,9 +166,15 @@ class SphericalHarmonics(torch.nn.Module):
               derivatives in the the x, y, and z directions, respectively.
 
         """
-        return self.calculator.compute_with_gradients(xyz)
-
-    def compute_with_hessians(self, xyz: Tensor) -> Tuple[Tensor, Tensor, Tensor]:
+        if out is None:
+            outputs = self.calculator.compute_with_gradients(xyz)
+        else:
+            outputs = self.calculator.compute_into(xyz, [out[0], out[1]])
+        return outputs[0], outputs[1]
+
+    def compute_with_hessians(
+        self, xyz: Tensor, out: Optional[Tuple[Tensor, Tensor, Tensor]] = None
+    ) -> Tuple[Tensor, Tensor, Tensor]:
         """
         Calculates the spherical harmonics for a set of 3D points,
         and also returns the forward derivatives and second derivatives.
@@ -155,6 +188,9 @@ class SphericalHarmonics(torch.nn.Module):
         :param xyz:
             The Cartesian coordinates of the 3D points, as a ``torch.Tensor`` with
             shape ``(n_samples, 3)``.
+        :param out:
+            Optional tuple of tensors in which to write the outputs, see
+            :py:meth:`compute`.
 
         :return:
             A tuple that contains:
@@ -176,10 +212,17 @@ class SphericalHarmonics(torch.nn.Module):
               hessian dimensions.
 
         """
-        return self.calculator.compute_with_hessians(xyz)
+        if out is None:
+            outputs = self.calculator.compute_with_hessians(xyz)
+        else:
+            outputs = self.calculator.compute_into(xyz, [out[0], out[1], out[2]])
+        return outputs[0], outputs[1], outputs[2]
 
     def omp_num_threads(self):
-        """Returns the number of threads available for calculations on the CPU."""
+        """
+        Returns the number of threads available for calculations on the CPU, i.e.
+        the size of the intra-op thread pool of torch (``torch.get_num_threads()``).
+        """
         return self.calculator.omp_num_threads()
 
     def l_max(self):
@@ -206,6 +249,14 @@ class SolidHarmonics(torch.nn.Module):
         double reverse-mode differentiation with respect to ``xyz``. If ``False``, only
         the first derivatives will be computed and only a single reverse-mode
         differentiation step will be possible with respect to ``xyz``.
+    :param checkpoint:
+        if this parameter is set to ``True``, only ``xyz`` is stored during forward
+        calls to ``compute``, and the derivatives of the spherical harmonics are
+        recomputed in the backward pass. On CPU, they are recomputed one point at a
+        time and contracted immediately. The stored derivatives are 3 times (12
+        times with ``backward_second_derivatives=True``) larger than the spherical
+        harmonics, so this allows larger batches during training, at the cost of
+        computing the derivatives again in the backward pass.
 
     :return: a calculator, in the form of a SolidHarmonics object
     """
@@ -214,32 +265,99 @@ class SolidHarmonics(torch.nn.Module):
         self,
         l_max: int,
         backward_second_derivatives: bool = False,
+        checkpoint: bool = False,
     ):
         super().__init__()
         self.calculator = torch.classes.sphericart_torch.SolidHarmonics(
-            l_max, backward_second_derivatives
+            l_max, backward_second_derivatives, checkpoint
         )
 
     def forward(self, xyz: Tensor) -> Tensor:
         """See :py:meth:`SphericalHarmonics.forward`"""
         return self.calculator.compute(xyz)
 
-    def compute(self, xyz: Tensor) -> Tensor:
-        """Equivalent to ``forward``"""
-        return self.calculator.compute(xyz)
+    def compute(self, xyz: Tensor, out: Optional[Tensor] = None) -> Tensor:
+        """See :py:meth:`SphericalHarmonics.compute`"""
+        if out is None:
+            return self.calculator.compute(xyz)
+        return self.calculator.compute_into(xyz, [out])[0]
 
-    def compute_with_gradients(self, xyz: Tensor) -> Tuple[Tensor, Tensor]:
+    def compute_with_gradients(
+        self, xyz: Tensor, out: Optional[Tuple[Tensor, Tensor]] = None
+    ) -> Tuple[Tensor, Tensor]:
         """See :py:meth:`SphericalHarmonics.compute_with_gradients`"""
-        return self.calculator.compute_with_gradients(xyz)
-
-    def compute_with_hessians(self, xyz: Tensor) -> Tuple[Tensor, Tensor, Tensor]:
+        if out is None:
+            outputs = self.calculator.compute_with_gradients(xyz)
+        else:
+            outputs = self.calculator.compute_into(xyz, [out[0], out[1]])
+        return outputs[0], outputs[1]
+
+    def compute_with_hessians(
+        self, xyz: Tensor, out: Optional[Tuple[Tensor, Tensor, Tensor]] = None
+    ) -> Tuple[Tensor, Tensor, Tensor]:
         """See :py:meth:`SphericalHarmonics.compute_with_hessians`"""
-        return self.calculator.compute_with_hessians(xyz)
+        if out is None:
+            outputs = self.calculator.compute_with_hessians(xyz)
+        else:
+            outputs = self.calculator.compute_into(xyz, [out[0], out[1], out[2]])
+        return outputs[0], outputs[1], outputs[2]
 
     def omp_num_threads(self):
-        """Returns the number of threads available for calculations on the CPU."""
+        """
+        Returns the number of threads available for calculations on the CPU, i.e.
+        the size of the intra-op thread pool of torch (``torch.get_num_threads()``).
+        """
         return self.calculator.omp_num_threads()
 
     def l_max(self):
         """Returns the maximum angular momentum setting for this calculator."""
         return self.calculator.l_max()
+
+
+def spherical_harmonics(xyz: Tensor, l_max: int) -> Tensor:
+    """
+    Computes the spherical harmonics up to degree ``l_max`` for a set of 3D
+    points, with the same outputs as :py:meth:`SphericalHarmonics.forward`.
+
+    Unlike the class, this function is a dispatcher operator
+    (``torch.ops.sphericart_torch.spherical_harmonics``), with separate
+    kernels for CPU, CUDA, autograd and meta tensors. Calls made under
+    ``torch.inference_mode()`` go directly to the CPU or CUDA kernel, and the
+    function can be traced by ``torch.compile`` without graph breaks. The
+    calculators are created on first use for each ``l_max``, and shared by all
+    calls.
+
+    The outputs support a single backward pass with respect to ``xyz``; use
+    :py:class:`SphericalHarmonics` for double backward.
+
+    :param xyz:
+        The Cartesian coordinates of the 3D points, as a `torch.Tensor` with
+        shape ``(n_samples, 3)``.
+    :param l_max:
+        the maximum degree of the spherical harmonics to be calculated
+
+    :return:
+        A tensor of shape ``(n_samples, (l_max+1)**2)`` containing all the
+        spherical harmonics up to degree ``l_max`` in lexicographic order.
+    """
+    return torch.ops.sphericart_torch.spherical_harmonics(xyz, l_max)
+
+
+def solid_harmonics(xyz: Tensor, l_max: int) -> Tensor:
+    """
+    Computes the solid harmonics up to degree ``l_max`` for a set of 3D points,
+    with the same outputs as :py:meth:`SolidHarmonics.forward`.
+
+    The usage of this function is identical to :py:func:`spherical_harmonics`.
+
+    :param xyz:
+        The Cartesian coordinates of the 3D points, as a `torch.Tensor` with
+        shape ``(n_samples, 3)``.
+    :param l_max:
+        the maximum degree of the solid harmonics to be calculated
+
+    :return:
+        A tensor of shape ``(n_samples, (l_max+1)**2)`` containing all the
+        solid harmonics up to degree ``l_max`` in lexicographic order.
+    """
+    return torch.ops.sphericart_torch.solid_harmonics(xyz, l_max)
@@ -209,3 +209,35 @@ def test_third_derivative_error(xyz):
         match="element 0 of tensors does not require grad and does not have a grad_fn",
     ):
         s2.backward()
+
+
+@pytest.mark.parametrize("backward_second_derivatives", [False, True])
+def test_checkpoint(xyz, backward_second_derivatives):
+    # recomputing the derivatives in the backward pass gives the same gradients
+    # as storing them in the forward pass
+    reference = sphericart.torch.SphericalHarmonics(
+        l_max=6, backward_second_derivatives=backward_second_derivatives
+    )
+    calculator = sphericart.torch.SphericalHarmonics(
+        l_max=6,
+        backward_second_derivatives=backward_second_derivatives,
+        checkpoint=True,
+    )
+
+    weights = torch.randn(49, dtype=torch.float64)
+
+    def loss(calculator, xyz_in):
+        return (calculator.compute(xyz_in) * weights).sum()
+
+    expected = torch.autograd.grad(loss(reference, xyz), xyz, create_graph=True)[0]
+    actual = torch.autograd.grad(loss(calculator, xyz), xyz, create_graph=True)[0]
+    assert torch.allclose(expected, actual)
+
+    if backward_second_derivatives:
+        expected = torch.autograd.grad(expected.square().sum(), xyz)[0]
+        actual = torch.autograd.grad(actual.square().sum(), xyz)[0]
+        assert torch.allclose(expected, actual)
+
+        assert torch.autograd.gradgradcheck(
+            lambda xyz_in: calculator.compute(xyz_in), xyz, fast_mode=True
+        )
@@ -0,0 +1,87 @@
+import pytest
+import torch
+
+import sphericart.torch
+
+
+torch.manual_seed(0)
+
+
+@pytest.fixture
+def xyz():
+    torch.manual_seed(0)
+    return 6 * torch.randn(20, 3, dtype=torch.float64, requires_grad=True)
+
+
+@pytest.mark.parametrize("normalized", [False, True], ids=["solid", "spherical"])
+def test_same_as_class(xyz, normalized):
+    l_max = 6
+    if normalized:
+        calculator = sphericart.torch.SphericalHarmonics(l_max=l_max)
+        function = sphericart.torch.spherical_harmonics
+    else:
+        calculator = sphericart.torch.SolidHarmonics(l_max=l_max)
+        function = sphericart.torch.solid_harmonics
+
+    sph = function(xyz, l_max)
+    assert torch.allclose(sph, calculator.compute(xyz))
+
+    sph.sum().backward()
+    grad = xyz.grad.clone()
+    xyz.grad = None
+    calculator.compute(xyz).sum().backward()
+    assert torch.allclose(grad, xyz.grad)
+
+    assert torch.autograd.gradcheck(lambda x: function(x, l_max), xyz, fast_mode=True)
+
+    with torch.inference_mode():
+        sph = function(xyz.detach(), l_max)
+    assert torch.allclose(sph, calculator.compute(xyz.detach()))
+
+    if torch.cuda.is_available():
+        xyz_cuda = xyz.detach().cuda().requires_grad_(True)
+        sph = function(xyz_cuda, l_max)
+        assert torch.allclose(sph.cpu(), calculator.compute(xyz.detach()))
+        assert torch.autograd.gradcheck(
+            lambda x: function(x, l_max), xyz_cuda, fast_mode=True
+        )
+
+
+def test_no_double_backward(xyz):
+    sph = sphericart.torch.spherical_harmonics(xyz, 4)
+    (grad,) = torch.autograd.grad(sph.sum(), xyz, create_graph=True)
+
+    with pytest.raises(RuntimeError):
+        grad.sum().backward()
+
+
+def test_meta():
+    xyz = torch.empty(12, 3, device="meta")
+    sph = sphericart.torch.spherical_harmonics(xyz, 3)
+    assert sph.device.type == "meta"
+    assert sph.shape == (12, 16)
+
+    sph, dsph = torch.ops.sphericart_torch.solid_harmonics_with_gradients(xyz, 3)
+    assert sph.shape == (12, 16)
+    assert dsph.shape == (12, 3, 16)
+
+
+def test_compile(xyz):
+    def function(xyz):
+        return sphericart.torch.spherical_harmonics(2.0 * xyz, 5).sum()
+
+    compiled = torch.compile(function, fullgraph=True)
+
+    value = compiled(xyz)
+    (grad,) = torch.autograd.grad(value, xyz)
+
+    reference = function(xyz)
+    (reference_grad,) = torch.autograd.grad(reference, xyz)
+    assert torch.allclose(value, reference)
+    assert torch.allclose(grad, reference_grad)
+
+
+def test_script(xyz):
+    scripted = torch.jit.script(sphericart.torch.spherical_harmonics)
+    reference = sphericart.torch.spherical_harmonics(xyz, 4)
+    assert torch.allclose(scripted(xyz, 4), reference)
@@ -0,0 +1,82 @@
+import pytest
+import torch
+
+import sphericart.torch
+
+
+torch.manual_seed(0)
+
+
+@pytest.fixture
+def xyz():
+    torch.manual_seed(0)
+    return 6 * torch.randn(20, 3, dtype=torch.float64)
+
+
+@pytest.mark.parametrize("normalized", [False, True], ids=["solid", "spherical"])
+def test_out(xyz, normalized):
+    l_max = 5
+    if normalized:
+        calculator = sphericart.torch.SphericalHarmonics(l_max=l_max)
+    else:
+        calculator = sphericart.torch.SolidHarmonics(l_max=l_max)
+
+    sph, dsph, ddsph = calculator.compute_with_hessians(xyz)
+
+    out = torch.empty_like(sph)
+    result = calculator.compute(xyz, out=out)
+    assert result.data_ptr() == out.data_ptr()
+    assert torch.allclose(out, sph)
+
+    # on CPU, the outputs can be slices of larger tensors
+    buffer = torch.zeros(20, 3, 2 * sph.shape[1], dtype=xyz.dtype)
+    out = (torch.empty_like(sph), buffer[:, :, : sph.shape[1]])
+    calculator.compute_with_gradients(xyz, out=out)
+    assert torch.allclose(out[0], sph)
+    assert torch.allclose(buffer[:, :, : sph.shape[1]], dsph)
+    assert torch.all(buffer[:, :, sph.shape[1] :] == 0.0)
+
+    out = (torch.empty_like(sph), torch.empty_like(dsph), torch.empty_like(ddsph))
+    calculator.compute_with_hessians(xyz, out=out)
+    assert torch.allclose(out[2], ddsph)
+
+    if torch.cuda.is_available():
+        xyz_cuda = xyz.to("cuda")
+        out = (torch.empty_like(sph.cuda()), torch.empty_like(dsph.cuda()))
+        calculator.compute_with_gradients(xyz_cuda, out=out)
+        assert torch.allclose(out[0].cpu(), sph)
+        assert torch.allclose(out[1].cpu(), dsph)
+
+
+def test_out_errors(xyz):
+    calculator = sphericart.torch.SphericalHarmonics(l_max=3)
+
+    with pytest.raises(RuntimeError, match="expected output tensor 0 with shape"):
+        calculator.compute(xyz, out=torch.empty(19, 16, dtype=xyz.dtype))
+
+    with pytest.raises(RuntimeError, match="same device and dtype as xyz"):
+        calculator.compute(xyz, out=torch.empty(20, 16, dtype=torch.float32))
+
+    with pytest.raises(RuntimeError, match="each sample contiguously"):
+        calculator.compute(xyz, out=torch.empty(16, 20, dtype=xyz.dtype).T)
+
+    message = "does not support automatic differentiation"
+    with pytest.raises(RuntimeError, match=message):
+        calculator.compute(
+            xyz.clone().requires_grad_(True), out=torch.empty(20, 16, dtype=xyz.dtype)
+        )
+
+
+def test_script(xyz):
+    class Module(torch.nn.Module):
+        def __init__(self):
+            super().__init__()
+            self.calculator = sphericart.torch.SphericalHarmonics(l_max=3)
+            self.out = torch.empty(20, 16, dtype=torch.float64)
+
+        def forward(self, xyz):
+            return self.calculator.compute(xyz, out=self.out)
+
+    module = torch.jit.script(Module())
+    sph = module(xyz)
+    assert sph.data_ptr() == module.out.data_ptr()
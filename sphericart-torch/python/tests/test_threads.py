@@ -0,0 +1,40 @@
+import pytest
+import torch
+
+import sphericart.torch
+
+
+torch.manual_seed(0)
+
+
+@pytest.fixture
+def restore_num_threads():
+    num_threads = torch.get_num_threads()
+    yield
+    torch.set_num_threads(num_threads)
+
+
+@pytest.mark.parametrize("normalized", [False, True], ids=["solid", "spherical"])
+def test_num_threads(normalized, restore_num_threads):
+    # enough points for the calculations to use several threads
+    xyz = torch.randn(20000, 3, dtype=torch.float64, requires_grad=True)
+
+    if normalized:
+        calculator = sphericart.torch.SphericalHarmonics(l_max=8)
+    else:
+        calculator = sphericart.torch.SolidHarmonics(l_max=8)
+
+    results = []
+    for num_threads in [1, 2, 4]:
+        torch.set_num_threads(num_threads)
+        assert calculator.omp_num_threads() == num_threads
+
+        xyz.grad = None
+        sph, grad_sph = calculator.compute_with_gradients(xyz)
+        (sph**2).sum().backward()
+        results.append((sph.detach(), grad_sph, xyz.grad.clone()))
+
+    for sph, grad_sph, xyz_grad in results[1:]:
+        assert torch.allclose(sph, results[0][0])
+        assert torch.allclose(grad_sph, results[0][1])
+        assert torch.allclose(xyz_grad, results[0][2])
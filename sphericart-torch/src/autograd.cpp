@@ -1,74 +1,51 @@
+#include <algorithm>
 #include <cstdint> // For intptr_t
-
-#ifdef __linux__
-#include <dlfcn.h>
-#endif
+#include <map>
+#include <mutex>
+#include <tuple>
 
 #include "sphericart/autograd.hpp"
 
 #include "sphericart.hpp"
 #include "sphericart/torch.hpp"
 #include "sphericart/torch_cuda_wrapper.hpp"
+#include <torch/custom_class.h>
 #include <torch/torch.h>
 
-/// Dynamically load `get_current_cuda_stream`, see `streams.cpp` for more
-/// information
-class CUDAStream {
-  public:
-    static CUDAStream& instance() {
-        static CUDAStream instance;
-        return instance;
-    }
-
-    bool loaded() { return handle != nullptr; }
-
-    using get_stream_t = void* (*)(uint8_t);
-    get_stream_t get_stream = nullptr;
-
-    CUDAStream() {
-#ifdef __linux__
-        handle = dlopen("libsphericart_torch_cuda_stream.so", RTLD_NOW);
-        if (!handle) {
-            throw std::runtime_error(
-                std::string("Failed to load libsphericart_torch_cuda_stream.so: ") + dlerror()
-            );
-        }
+#include "cuda_stream.hpp"
 
-        auto get_stream = reinterpret_cast<get_stream_t>(dlsym(handle, "get_current_cuda_stream"));
-        if (!get_stream) {
-            throw std::runtime_error(
-                std::string("Failed to load get_current_cuda_stream: ") + dlerror()
-            );
-        }
-        this->get_stream = get_stream;
-#else
-        throw std::runtime_error("Platform not supported for dynamic loading of CUDA streams");
-#endif
-    }
+using namespace sphericart_torch;
 
-    ~CUDAStream() {
-#ifdef __linux__
-        if (handle) {
-            dlclose(handle);
-        }
-#endif
+template <class C>
+c10::intrusive_ptr<C> sphericart_torch::shared_calculator(
+    int64_t l_max, bool backward_second_derivatives, bool checkpoint
+) {
+    static std::mutex mutex;
+    static std::map<std::tuple<int64_t, bool, bool>, c10::intrusive_ptr<C>> calculators;
+
+    auto key = std::make_tuple(l_max, backward_second_derivatives, checkpoint);
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = calculators.find(key);
+    if (it == calculators.end()) {
+        auto calculator = c10::make_intrusive<C>(l_max, backward_second_derivatives, checkpoint);
+        it = calculators.emplace(key, std::move(calculator)).first;
     }
-
-    // Prevent copying
-    CUDAStream(const CUDAStream&) = delete;
-    CUDAStream& operator=(const CUDAStream&) = delete;
-
-    void* handle = nullptr;
-};
-
-using namespace sphericart_torch;
+    return it->second;
+}
 
 template <template <typename> class C, typename scalar_t>
 std::vector<torch::Tensor> _compute_raw_cpu(
-    C<scalar_t>& calculator, torch::Tensor xyz, int64_t l_max, bool do_gradients, bool do_hessians
+    C<scalar_t>& calculator,
+    torch::Tensor xyz,
+    int64_t l_max,
+    bool do_gradients,
+    bool do_hessians,
+    std::vector<torch::Tensor> out
 ) {
-    if (!xyz.is_contiguous()) {
-        throw std::runtime_error("this code only runs with contiguous tensors");
+    // the calculator can read xyz in place as long as the coordinates of each
+    // sample are contiguous, e.g. for a column slice of a larger tensor
+    if (xyz.stride(1) != 1 || xyz.stride(0) < 3) {
+        xyz = xyz.contiguous();
     }
 
     if (!xyz.device().is_cpu()) {
@@ -82,39 +59,59 @@ std::vector<torch::Tensor> _compute_raw_cpu(
     auto n_samples = xyz.sizes()[0];
     auto options = torch::TensorOptions().device(xyz.device()).dtype(xyz.dtype());
 
-    auto sph_length = n_samples * (l_max + 1) * (l_max + 1);
-    auto dsph_length = n_samples * 3 * (l_max + 1) * (l_max + 1);
-    auto ddsph_length = n_samples * 9 * (l_max + 1) * (l_max + 1);
-    auto sph = torch::empty({n_samples, (l_max + 1) * (l_max + 1)}, options);
+    auto xyz_stride = static_cast<size_t>(xyz.stride(0));
+    // the outputs given by the caller have been checked in `compute_into`
+    auto sph = out.size() > 0 ? out[0]
+                              : torch::empty({n_samples, (l_max + 1) * (l_max + 1)}, options);
+
+    // each thread uses its own scratch memory, so that the same module can
+    // run in several inference threads at the same time. The workspace holds
+    // one slice for each chunk of at::parallel_for used by the calculator
+    static thread_local sphericart::Workspace<scalar_t> workspace;
 
     if (do_hessians) {
-        auto dsph = torch::empty({n_samples, 3, (l_max + 1) * (l_max + 1)}, options);
-        auto ddsph = torch::empty({n_samples, 3, 3, (l_max + 1) * (l_max + 1)}, options);
-        calculator.compute_array_with_hessians(
+        auto dsph = out.size() > 1
+                        ? out[1]
+                        : torch::empty({n_samples, 3, (l_max + 1) * (l_max + 1)}, options);
+        auto ddsph = out.size() > 2
+                         ? out[2]
+                         : torch::empty({n_samples, 3, 3, (l_max + 1) * (l_max + 1)}, options);
+        calculator.compute_array_strided_with_hessians(
             xyz.data_ptr<scalar_t>(),
-            n_samples * 3,
+            n_samples,
+            xyz_stride,
             sph.data_ptr<scalar_t>(),
-            sph_length,
+            sph.stride(0),
             dsph.data_ptr<scalar_t>(),
-            dsph_length,
+            dsph.stride(0),
             ddsph.data_ptr<scalar_t>(),
-            ddsph_length
+            ddsph.stride(0),
+            &workspace
         );
         return {sph, dsph, ddsph};
     } else if (do_gradients) {
-        auto dsph = torch::empty({n_samples, 3, (l_max + 1) * (l_max + 1)}, options);
-        calculator.compute_array_with_gradients(
+        auto dsph = out.size() > 1
+                        ? out[1]
+                        : torch::empty({n_samples, 3, (l_max + 1) * (l_max + 1)}, options);
+        calculator.compute_array_strided_with_gradients(
             xyz.data_ptr<scalar_t>(),
-            n_samples * 3,
+            n_samples,
+            xyz_stride,
             sph.data_ptr<scalar_t>(),
-            sph_length,
+            sph.stride(0),
             dsph.data_ptr<scalar_t>(),
-            dsph_length
+            dsph.stride(0),
+            &workspace
         );
         return {sph, dsph, torch::Tensor()};
     } else {
-        calculator.compute_array(
-            xyz.data_ptr<scalar_t>(), n_samples * 3, sph.data_ptr<scalar_t>(), sph_length
+        calculator.compute_array_strided(
+            xyz.data_ptr<scalar_t>(),
+            n_samples,
+            xyz_stride,
+            sph.data_ptr<scalar_t>(),
+            sph.stride(0),
+            &workspace
         );
         return {sph, torch::Tensor(), torch::Tensor()};
     }
@@ -127,7 +124,8 @@ std::vector<torch::Tensor> _compute_raw_cuda(
     int64_t l_max,
     bool do_gradients,
     bool do_hessians,
-    void* stream
+    void* stream,
+    std::vector<torch::Tensor> out
 ) {
     if (!xyz.is_contiguous()) {
         throw std::runtime_error("this code only runs with contiguous tensors");
@@ -145,11 +143,12 @@ std::vector<torch::Tensor> _compute_raw_cuda(
     auto lmtotal = (l_max + 1) * (l_max + 1);
     auto options = torch::TensorOptions().device(xyz.device()).dtype(xyz.dtype());
 
-    auto sph = torch::empty({n_samples, lmtotal}, options);
+    // the outputs given by the caller have been checked in `compute_into`
+    auto sph = out.size() > 0 ? out[0] : torch::empty({n_samples, lmtotal}, options);
 
     if (do_hessians) {
-        auto dsph = torch::empty({n_samples, 3, lmtotal}, options);
-        auto ddsph = torch::empty({n_samples, 3, 3, lmtotal}, options);
+        auto dsph = out.size() > 1 ? out[1] : torch::empty({n_samples, 3, lmtotal}, options);
+        auto ddsph = out.size() > 2 ? out[2] : torch::empty({n_samples, 3, 3, lmtotal}, options);
         calculator->compute_with_hessians(
             xyz.data_ptr<scalar_t>(),
             n_samples,
@@ -160,7 +159,7 @@ std::vector<torch::Tensor> _compute_raw_cuda(
         );
         return {sph, dsph, ddsph};
     } else if (do_gradients) {
-        auto dsph = torch::empty({n_samples, 3, lmtotal}, options);
+        auto dsph = out.size() > 1 ? out[1] : torch::empty({n_samples, 3, lmtotal}, options);
         calculator->compute_with_gradients(
             xyz.data_ptr<scalar_t>(),
             n_samples,
@@ -181,15 +180,15 @@ std::vector<torch::Tensor> _compute_raw_cuda(
 }
 
 std::vector<torch::Tensor> SphericalHarmonics::compute_raw_cpu(
-    torch::Tensor xyz, bool do_gradients, bool do_hessians
+    torch::Tensor xyz, bool do_gradients, bool do_hessians, std::vector<torch::Tensor> out
 ) {
     if (xyz.dtype() == c10::kDouble) {
         return _compute_raw_cpu<sphericart::SphericalHarmonics, double>(
-            calculator_double_, xyz, l_max_, do_gradients, do_hessians
+            calculator_double_, xyz, l_max_, do_gradients, do_hessians, out
         );
     } else if (xyz.dtype() == c10::kFloat) {
         return _compute_raw_cpu<sphericart::SphericalHarmonics, float>(
-            calculator_float_, xyz, l_max_, do_gradients, do_hessians
+            calculator_float_, xyz, l_max_, do_gradients, do_hessians, out
         );
     } else {
         throw std::runtime_error("this code only runs on float64 and float32 arrays");
@@ -197,15 +196,19 @@ std::vector<torch::Tensor> SphericalHarmonics::compute_raw_cpu(
 }
 
 std::vector<torch::Tensor> SphericalHarmonics::compute_raw_cuda(
-    torch::Tensor xyz, bool do_gradients, bool do_hessians, void* stream
+    torch::Tensor xyz,
+    bool do_gradients,
+    bool do_hessians,
+    void* stream,
+    std::vector<torch::Tensor> out
 ) {
     if (xyz.dtype() == c10::kDouble) {
         return _compute_raw_cuda<sphericart::cuda::SphericalHarmonics, double>(
-            calculator_cuda_double_ptr.get(), xyz, l_max_, do_gradients, do_hessians, stream
+            calculator_cuda_double_ptr.get(), xyz, l_max_, do_gradients, do_hessians, stream, out
         );
     } else if (xyz.dtype() == c10::kFloat) {
         return _compute_raw_cuda<sphericart::cuda::SphericalHarmonics, float>(
-            calculator_cuda_float_ptr.get(), xyz, l_max_, do_gradients, do_hessians, stream
+            calculator_cuda_float_ptr.get(), xyz, l_max_, do_gradients, do_hessians, stream, out
         );
     } else {
         throw std::runtime_error("this code only runs on float64 and float32 arrays");
@@ -213,15 +216,15 @@ std::vector<torch::Tensor> SphericalHarmonics::compute_raw_cuda(
 }
 
 std::vector<torch::Tensor> SolidHarmonics::compute_raw_cpu(
-    torch::Tensor xyz, bool do_gradients, bool do_hessians
+    torch::Tensor xyz, bool do_gradients, bool do_hessians, std::vector<torch::Tensor> out
 ) {
     if (xyz.dtype() == c10::kDouble) {
         return _compute_raw_cpu<sphericart::SolidHarmonics, double>(
-            calculator_double_, xyz, l_max_, do_gradients, do_hessians
+            calculator_double_, xyz, l_max_, do_gradients, do_hessians, out
         );
     } else if (xyz.dtype() == c10::kFloat) {
         return _compute_raw_cpu<sphericart::SolidHarmonics, float>(
-            calculator_float_, xyz, l_max_, do_gradients, do_hessians
+            calculator_float_, xyz, l_max_, do_gradients, do_hessians, out
         );
     } else {
         throw std::runtime_error("this code only runs on float64 and float32 arrays");
@@ -229,79 +232,78 @@ std::vector<torch::Tensor> SolidHarmonics::compute_raw_cpu(
 }
 
 std::vector<torch::Tensor> SolidHarmonics::compute_raw_cuda(
-    torch::Tensor xyz, bool do_gradients, bool do_hessians, void* stream
+    torch::Tensor xyz,
+    bool do_gradients,
+    bool do_hessians,
+    void* stream,
+    std::vector<torch::Tensor> out
 ) {
     if (xyz.dtype() == c10::kDouble) {
         return _compute_raw_cuda<sphericart::cuda::SolidHarmonics, double>(
-            calculator_cuda_double_ptr.get(), xyz, l_max_, do_gradients, do_hessians, stream
+            calculator_cuda_double_ptr.get(), xyz, l_max_, do_gradients, do_hessians, stream, out
         );
     } else if (xyz.dtype() == c10::kFloat) {
         return _compute_raw_cuda<sphericart::cuda::SolidHarmonics, float>(
-            calculator_cuda_float_ptr.get(), xyz, l_max_, do_gradients, do_hessians, stream
+            calculator_cuda_float_ptr.get(), xyz, l_max_, do_gradients, do_hessians, stream, out
         );
     } else {
         throw std::runtime_error("this code only runs on float64 and float32 arrays");
     }
 }
 
-static torch::Tensor backward_cpu(torch::Tensor xyz, torch::Tensor dsph, torch::Tensor sph_grad) {
-    auto xyz_grad = torch::empty_like(xyz);
-
-    if (!sph_grad.device().is_cpu() || !xyz.device().is_cpu() || !dsph.device().is_cpu()) {
+// Computes the gradient with respect to xyz on CPU, either by contracting the
+// gradients of the spherical harmonics saved in the forward pass, or (in
+// checkpoint mode, when `dsph` is undefined) by recomputing them one point at
+// a time, fused with the contraction. Both run on the intra-op thread pool of
+// torch, like the forward pass
+template <typename scalar_t>
+static torch::Tensor backward_cpu(
+    sphericart::SphericalHarmonics<scalar_t>& calculator,
+    torch::Tensor xyz,
+    torch::Tensor dsph,
+    torch::Tensor sph_grad
+) {
+    if (!sph_grad.device().is_cpu() || !xyz.device().is_cpu()) {
         throw std::runtime_error("internal error: called CPU version on non-CPU tensor");
     }
 
     // we need contiguous data to take pointers below
     sph_grad = sph_grad.contiguous();
+    auto xyz_grad = torch::empty_like(xyz, torch::MemoryFormat::Contiguous);
 
-    if (!xyz_grad.is_contiguous() || !dsph.is_contiguous()) {
-        // we created these, they should always be contiguous
-        throw std::runtime_error("internal error: xyz_grad or dsph are not contiguous");
-    }
-
-    auto n_samples = xyz.sizes()[0];
-    auto n_sph = sph_grad.sizes()[1];
-    if (xyz.dtype() == c10::kDouble) {
-        auto xyz_grad_p = xyz_grad.data_ptr<double>();
-        auto sph_grad_p = sph_grad.data_ptr<double>();
-        auto dsph_p = dsph.data_ptr<double>();
-
-#pragma omp parallel for
-        for (int64_t i_sample = 0; i_sample < n_samples; i_sample++) {
-            for (size_t spatial = 0; spatial < 3; spatial++) {
-                double accumulated_value = 0.0;
-                for (int i_sph = 0; i_sph < n_sph; i_sph++) {
-                    accumulated_value += sph_grad_p[n_sph * i_sample + i_sph] *
-                                         dsph_p[n_sph * 3 * i_sample + n_sph * spatial + i_sph];
-                }
-                xyz_grad_p[3 * i_sample + spatial] = accumulated_value;
-            }
-        }
-    } else if (xyz.dtype() == c10::kFloat) {
-        auto xyz_grad_p = xyz_grad.data_ptr<float>();
-        auto sph_grad_p = sph_grad.data_ptr<float>();
-        auto dsph_p = dsph.data_ptr<float>();
-
-#pragma omp parallel for
-        for (int64_t i_sample = 0; i_sample < n_samples; i_sample++) {
-            for (size_t spatial = 0; spatial < 3; spatial++) {
-                float accumulated_value = 0.0f;
-                for (int i_sph = 0; i_sph < n_sph; i_sph++) {
-                    accumulated_value += sph_grad_p[n_sph * i_sample + i_sph] *
-                                         dsph_p[n_sph * 3 * i_sample + n_sph * spatial + i_sph];
-                }
-                xyz_grad_p[3 * i_sample + spatial] = accumulated_value;
-            }
+    if (dsph.defined()) {
+        if (!dsph.is_contiguous()) {
+            // we created this, it should always be contiguous
+            throw std::runtime_error("internal error: dsph is not contiguous");
         }
+        calculator.contract_gradients(
+            sph_grad.data_ptr<scalar_t>(),
+            static_cast<size_t>(sph_grad.numel()),
+            dsph.data_ptr<scalar_t>(),
+            static_cast<size_t>(dsph.numel()),
+            xyz_grad.data_ptr<scalar_t>(),
+            static_cast<size_t>(xyz_grad.numel())
+        );
     } else {
-        throw std::runtime_error("this code only runs on float64 and float32 arrays");
+        xyz = xyz.contiguous();
+        // see _compute_raw_cpu
+        static thread_local sphericart::Workspace<scalar_t> workspace;
+        calculator.compute_vjp(
+            xyz.data_ptr<scalar_t>(),
+            static_cast<size_t>(xyz.numel()),
+            sph_grad.data_ptr<scalar_t>(),
+            static_cast<size_t>(sph_grad.numel()),
+            xyz_grad.data_ptr<scalar_t>(),
+            static_cast<size_t>(xyz_grad.numel()),
+            &workspace
+        );
     }
 
     return xyz_grad;
 }
 
 template <class C>
-std::vector<torch::Tensor> SphericartAutograd::forward(
+std::vector<torch::Tensor> SphericartAutograd<C>::forward(
     torch::autograd::AutogradContext* ctx,
     C& calculator,
     torch::Tensor xyz,
@@ -322,10 +324,14 @@ std::vector<torch::Tensor> SphericartAutograd::forward(
     auto dsph = torch::Tensor();
     auto ddsph = torch::Tensor();
 
-    bool requires_grad = do_gradients || xyz.requires_grad();
+    // in checkpoint mode, the derivatives are only computed here if they are
+    // returned, and are otherwise recomputed in the backward pass
+    bool store_derivatives = xyz.requires_grad() && !calculator.checkpoint_;
+
+    bool requires_grad = do_gradients || store_derivatives;
 
     bool requires_hessian =
-        do_hessians || (xyz.requires_grad() && calculator.backward_second_derivatives_);
+        do_hessians || (store_derivatives && calculator.backward_second_derivatives_);
 
     if (xyz.device().is_cpu()) {
         auto results = calculator.compute_raw_cpu(xyz, requires_grad, requires_hessian);
@@ -346,6 +352,11 @@ std::vector<torch::Tensor> SphericartAutograd::forward(
     if (xyz.requires_grad()) {
         ctx->save_for_backward({xyz, dsph, ddsph});
         ctx->saved_data["stream"] = torch::IValue((int64_t)(intptr_t)stream);
+        // the backward pass uses a shared calculator with the same parameters,
+        // which is kept alive together with the autograd graph
+        ctx->saved_data["calculator"] = torch::IValue(shared_calculator<C>(
+            calculator.l_max_, calculator.backward_second_derivatives_, calculator.checkpoint_
+        ));
     }
 
     if (do_hessians) {
@@ -357,7 +368,8 @@ std::vector<torch::Tensor> SphericartAutograd::forward(
     }
 }
 
-std::vector<torch::Tensor> SphericartAutograd::backward(
+template <class C>
+std::vector<torch::Tensor> SphericartAutograd<C>::backward(
     torch::autograd::AutogradContext* ctx, std::vector<torch::Tensor> grad_outputs
 ) {
 
@@ -372,16 +384,20 @@ std::vector<torch::Tensor> SphericartAutograd::backward(
     // We extract xyz and pass it as a separate variable because we will need
     // gradients with respect to it
     auto xyz = saved_variables[0];
-    torch::Tensor xyz_grad =
-        SphericartAutogradBackward::apply(grad_outputs[0].contiguous(), xyz, saved_variables);
+    auto calculator = ctx->saved_data["calculator"].toCustomClass<C>();
+    torch::Tensor xyz_grad = SphericartAutogradBackward<C>::apply(
+        grad_outputs[0].contiguous(), xyz, saved_variables, calculator
+    );
     return {torch::Tensor(), xyz_grad, torch::Tensor(), torch::Tensor(), torch::Tensor()};
 }
 
-torch::Tensor SphericartAutogradBackward::forward(
+template <class C>
+torch::Tensor SphericartAutogradBackward<C>::forward(
     torch::autograd::AutogradContext* ctx,
     torch::Tensor grad_outputs,
     torch::Tensor xyz,
-    std::vector<torch::Tensor> saved_variables
+    std::vector<torch::Tensor> saved_variables,
+    c10::intrusive_ptr<C> calculator
 ) {
 
     void* stream = nullptr;
@@ -391,9 +407,19 @@ torch::Tensor SphericartAutogradBackward::forward(
     auto xyz_grad = torch::Tensor();
     if (xyz.requires_grad()) {
         if (xyz.device().is_cpu()) {
-            xyz_grad = backward_cpu(xyz, dsph, grad_outputs);
+            if (xyz.dtype() == c10::kDouble) {
+                xyz_grad = backward_cpu(calculator->calculator_double_, xyz, dsph, grad_outputs);
+            } else if (xyz.dtype() == c10::kFloat) {
+                xyz_grad = backward_cpu(calculator->calculator_float_, xyz, dsph, grad_outputs);
+            } else {
+                throw std::runtime_error("this code only runs on float64 and float32 arrays");
+            }
         } else if (xyz.device().is_cuda()) {
             stream = CUDAStream::instance().get_stream(xyz.device().index());
+            if (!dsph.defined()) {
+                // checkpoint mode, there is no fused CUDA kernel for this
+                dsph = calculator->compute_raw_cuda(xyz, true, false, stream)[1];
+            }
             xyz_grad =
                 sphericart_torch::spherical_harmonics_backward_cuda(xyz, dsph, grad_outputs, stream);
         } else {
@@ -402,11 +428,67 @@ torch::Tensor SphericartAutogradBackward::forward(
     }
 
     ctx->save_for_backward({xyz, grad_outputs, dsph, ddsph});
+    ctx->saved_data["calculator"] = torch::IValue(calculator);
 
     return xyz_grad;
 }
 
-std::vector<torch::Tensor> SphericartAutogradBackward::backward(
+// Computes both outputs of the double backward from the stored derivatives,
+// in a single sweep over the samples. The outputs are not differentiable, so
+// this is only used when no graph is being created for higher derivatives
+template <typename scalar_t>
+static std::vector<torch::Tensor> double_backward_cpu(
+    sphericart::SphericalHarmonics<scalar_t>& calculator,
+    torch::Tensor grad_out,
+    torch::Tensor grad_2_out,
+    torch::Tensor dsph,
+    torch::Tensor ddsph,
+    bool needs_dsph,
+    bool needs_ddsph
+) {
+    // we need contiguous data to take pointers below
+    grad_out = grad_out.contiguous();
+    grad_2_out = grad_2_out.contiguous();
+
+    auto gradgrad_wrt_grad_out = torch::Tensor();
+    auto gradgrad_wrt_xyz = torch::Tensor();
+    scalar_t* sph_jvp = nullptr;
+    scalar_t* xyz_hvp = nullptr;
+    const scalar_t* dsph_ptr = nullptr;
+    const scalar_t* ddsph_ptr = nullptr;
+    if (needs_dsph) {
+        dsph = dsph.contiguous();
+        dsph_ptr = dsph.data_ptr<scalar_t>();
+        gradgrad_wrt_grad_out = torch::empty_like(grad_out, torch::MemoryFormat::Contiguous);
+        sph_jvp = gradgrad_wrt_grad_out.data_ptr<scalar_t>();
+    }
+    if (needs_ddsph) {
+        ddsph = ddsph.contiguous();
+        ddsph_ptr = ddsph.data_ptr<scalar_t>();
+        gradgrad_wrt_xyz = torch::empty_like(grad_2_out, torch::MemoryFormat::Contiguous);
+        xyz_hvp = gradgrad_wrt_xyz.data_ptr<scalar_t>();
+    }
+
+    calculator.contract_gradients_backward(
+        grad_out.data_ptr<scalar_t>(),
+        static_cast<size_t>(grad_out.numel()),
+        grad_2_out.data_ptr<scalar_t>(),
+        static_cast<size_t>(grad_2_out.numel()),
+        dsph_ptr,
+        needs_dsph ? static_cast<size_t>(dsph.numel()) : 0,
+        ddsph_ptr,
+        needs_ddsph ? static_cast<size_t>(ddsph.numel()) : 0,
+        sph_jvp,
+        needs_dsph ? static_cast<size_t>(gradgrad_wrt_grad_out.numel()) : 0,
+        xyz_hvp,
+        needs_ddsph ? static_cast<size_t>(gradgrad_wrt_xyz.numel()) : 0
+    );
+
+    return {gradgrad_wrt_grad_out, gradgrad_wrt_xyz};
+}
+
+template <class C>
+std::vector<torch::Tensor> SphericartAutogradBackward<C>::backward(
     torch::autograd::AutogradContext* ctx, std::vector<torch::Tensor> grad_2_outputs
 ) {
 
@@ -415,14 +497,17 @@ std::vector<torch::Tensor> SphericartAutogradBackward::backward(
     auto grad_out = saved_variables[1];
     auto dsph = saved_variables[2];
     auto ddsph = saved_variables[3];
+    auto calculator = ctx->saved_data["calculator"].toCustomClass<C>();
 
     auto grad_2_out = grad_2_outputs[0];
 
     auto gradgrad_wrt_grad_out = torch::Tensor();
     auto gradgrad_wrt_xyz = torch::Tensor();
 
-    bool double_backward = ddsph.defined(); // If the double backward was not requested in
-                                            // advance, this tensor will be uninitialized
+    // If the double backward was not requested in advance, ddsph will be
+    // uninitialized. In checkpoint mode, it is recomputed below instead
+    bool double_backward = ddsph.defined() ||
+                           (calculator->checkpoint_ && calculator->backward_second_derivatives_);
 
     if (!double_backward) {
         TORCH_WARN_ONCE(
@@ -436,7 +521,53 @@ std::vector<torch::Tensor> SphericartAutogradBackward::backward(
         );
     }
 
-    if (grad_out.requires_grad()) {
+    bool needs_dsph = grad_out.requires_grad();
+    bool needs_ddsph = xyz.requires_grad() && double_backward;
+    if ((needs_dsph && !dsph.defined()) || (needs_ddsph && !ddsph.defined())) {
+        // checkpoint mode: the derivatives only live until the end of this
+        // function
+        auto detached = xyz.detach();
+        auto results = std::vector<torch::Tensor>();
+        if (xyz.device().is_cpu()) {
+            results = calculator->compute_raw_cpu(detached, true, needs_ddsph);
+        } else {
+            auto stream = CUDAStream::instance().get_stream(xyz.device().index());
+            results = calculator->compute_raw_cuda(detached, true, needs_ddsph, stream);
+        }
+        dsph = results[1];
+        ddsph = results[2];
+    }
+
+    if (xyz.device().is_cpu() && !torch::GradMode::is_enabled() && (needs_dsph || needs_ddsph)) {
+        // no third derivative will be taken, the fused kernel can be used
+        auto results = std::vector<torch::Tensor>();
+        if (xyz.dtype() == c10::kDouble) {
+            results = double_backward_cpu(
+                calculator->calculator_double_,
+                grad_out,
+                grad_2_out,
+                dsph,
+                ddsph,
+                needs_dsph,
+                needs_ddsph
+            );
+        } else if (xyz.dtype() == c10::kFloat) {
+            results = double_backward_cpu(
+                calculator->calculator_float_,
+                grad_out,
+                grad_2_out,
+                dsph,
+                ddsph,
+                needs_dsph,
+                needs_ddsph
+            );
+        } else {
+            throw std::runtime_error("this code only runs on float64 and float32 arrays");
+        }
+        return {results[0], results[1], torch::Tensor(), torch::Tensor(), torch::Tensor()};
+    }
+
+    if (needs_dsph) {
         // gradgrad_wrt_grad_out, unlike gradgrad_wrt_xyz, is needed for mixed
         // second derivatives
         int n_samples = xyz.sizes()[0];
@@ -461,8 +592,8 @@ std::vector<torch::Tensor> SphericartAutogradBackward::backward(
             // the above does the same as the following (but faster):
             // gradgrad_wrt_xyz = torch::einsum("sa, sk, sabk -> sb",
             // {grad_2_out, grad_out, ddsph});
-            // note that, unlike in the single backward case, we do not provide
-            // specific CPU and CUDA kernels for this contraction
+            // this path keeps the graph for higher derivatives, and is the
+            // only one available on CUDA
         }
         // if double_backward is false, xyz requires a gradient, but the user
         // did not request second derivatives with respect to xyz (and therefore
@@ -472,21 +603,17 @@ std::vector<torch::Tensor> SphericartAutogradBackward::backward(
         // not be updated
     }
 
-    return {gradgrad_wrt_grad_out, gradgrad_wrt_xyz, torch::Tensor(), torch::Tensor()};
+    return {
+        gradgrad_wrt_grad_out, gradgrad_wrt_xyz, torch::Tensor(), torch::Tensor(), torch::Tensor()
+    };
 }
 
-// Explicit instantiation of SphericartAutograd::forward
-template std::vector<torch::Tensor> SphericartAutograd::forward<SphericalHarmonics>(
-    torch::autograd::AutogradContext* ctx,
-    SphericalHarmonics& calculator,
-    torch::Tensor xyz,
-    bool do_gradients,
-    bool do_hessians
-);
-template std::vector<torch::Tensor> SphericartAutograd::forward<SolidHarmonics>(
-    torch::autograd::AutogradContext* ctx,
-    SolidHarmonics& calculator,
-    torch::Tensor xyz,
-    bool do_gradients,
-    bool do_hessians
-);
+// Explicit instantiation of the autograd functions for both calculators
+template c10::intrusive_ptr<SphericalHarmonics>
+sphericart_torch::shared_calculator<SphericalHarmonics>(int64_t, bool, bool);
+template c10::intrusive_ptr<SolidHarmonics>
+sphericart_torch::shared_calculator<SolidHarmonics>(int64_t, bool, bool);
+template class sphericart_torch::SphericartAutograd<SphericalHarmonics>;
+template class sphericart_torch::SphericartAutogradBackward<SphericalHarmonics>;
+template class sphericart_torch::SphericartAutograd<SolidHarmonics>;
+template class sphericart_torch::SphericartAutogradBackward<SolidHarmonics>;
@@ -0,0 +1,62 @@
+#ifndef SPHERICART_TORCH_CUDA_STREAM_HPP
+#define SPHERICART_TORCH_CUDA_STREAM_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#endif
+
+/// Dynamically load `get_current_cuda_stream`, see `streams.cpp` for more
+/// information
+class CUDAStream {
+  public:
+    static CUDAStream& instance() {
+        static CUDAStream instance;
+        return instance;
+    }
+
+    bool loaded() { return handle != nullptr; }
+
+    using get_stream_t = void* (*)(uint8_t);
+    get_stream_t get_stream = nullptr;
+
+    CUDAStream() {
+#ifdef __linux__
+        handle = dlopen("libsphericart_torch_cuda_stream.so", RTLD_NOW);
+        if (!handle) {
+            throw std::runtime_error(
+                std::string("Failed to load libsphericart_torch_cuda_stream.so: ") + dlerror()
+            );
+        }
+
+        auto get_stream = reinterpret_cast<get_stream_t>(dlsym(handle, "get_current_cuda_stream"));
+        if (!get_stream) {
+            throw std::runtime_error(
+                std::string("Failed to load get_current_cuda_stream: ") + dlerror()
+            );
+        }
+        this->get_stream = get_stream;
+#else
+        throw std::runtime_error("Platform not supported for dynamic loading of CUDA streams");
+#endif
+    }
+
+    ~CUDAStream() {
+#ifdef __linux__
+        if (handle) {
+            dlclose(handle);
+        }
+#endif
+    }
+
+    // Prevent copying
+    CUDAStream(const CUDAStream&) = delete;
+    CUDAStream& operator=(const CUDAStream&) = delete;
+
+    void* handle = nullptr;
+};
+
+#endif
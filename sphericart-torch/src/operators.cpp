@@ -0,0 +1,266 @@
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <torch/csrc/autograd/autograd_not_implemented_fallback.h>
+#include <torch/torch.h>
+
+#include "sphericart/autograd.hpp"
+#include "sphericart/operators.hpp"
+#include "sphericart/torch.hpp"
+#include "sphericart/torch_cuda_wrapper.hpp"
+
+#include "cuda_stream.hpp"
+
+using namespace sphericart_torch;
+
+namespace {
+
+void check_inputs(const torch::Tensor& xyz, int64_t l_max) {
+    if (l_max < 0) {
+        throw std::runtime_error("l_max must be a positive integer");
+    }
+
+    if (xyz.dim() != 2) {
+        throw std::runtime_error("xyz tensor must be a 2D array");
+    }
+
+    if (xyz.sym_size(1) != 3) {
+        throw std::runtime_error("xyz tensor must be an `n_samples x 3` array");
+    }
+}
+
+c10::OperatorHandle find_operator(const std::string& name) {
+    auto full_name = "sphericart_torch::" + name;
+    return c10::Dispatcher::singleton().findSchemaOrThrow(full_name.c_str(), "");
+}
+
+template <typename scalar_t, typename Calculator>
+torch::Tensor contract_cpu(
+    Calculator& calculator, torch::Tensor grad_output, torch::Tensor xyz, torch::Tensor dsph
+) {
+    // we need contiguous data to take pointers below
+    grad_output = grad_output.contiguous();
+    dsph = dsph.contiguous();
+    auto xyz_grad = torch::empty_like(xyz, torch::MemoryFormat::Contiguous);
+    calculator.contract_gradients(
+        grad_output.data_ptr<scalar_t>(),
+        static_cast<size_t>(grad_output.numel()),
+        dsph.data_ptr<scalar_t>(),
+        static_cast<size_t>(dsph.numel()),
+        xyz_grad.data_ptr<scalar_t>(),
+        static_cast<size_t>(xyz_grad.numel())
+    );
+    return xyz_grad;
+}
+
+/// Autograd function used by the Autograd kernel of the operators, calling
+/// the operators below autograd in both passes, so that they can be traced
+/// by `torch.compile`
+template <class C>
+class OperatorAutograd : public torch::autograd::Function<OperatorAutograd<C>> {
+  public:
+    static torch::Tensor forward(
+        torch::autograd::AutogradContext* ctx, torch::Tensor xyz, int64_t l_max
+    ) {
+        using compute_t = torch::Tensor(torch::Tensor, int64_t);
+        using compute_with_gradients_t = std::tuple<torch::Tensor, torch::Tensor>(
+            torch::Tensor, int64_t
+        );
+        static auto compute =
+            find_operator(SphericartOperators<C>::name()).template typed<compute_t>();
+        static auto compute_with_gradients =
+            find_operator(SphericartOperators<C>::name() + "_with_gradients")
+                .template typed<compute_with_gradients_t>();
+
+        at::AutoDispatchBelowADInplaceOrView guard;
+        if (!xyz.requires_grad()) {
+            return compute.call(xyz, l_max);
+        }
+
+        auto [sph, dsph] = compute_with_gradients.call(xyz, l_max);
+        ctx->save_for_backward({xyz, dsph});
+        ctx->saved_data["l_max"] = l_max;
+        return sph;
+    }
+
+    static std::vector<torch::Tensor> backward(
+        torch::autograd::AutogradContext* ctx, std::vector<torch::Tensor> grad_outputs
+    ) {
+        using backward_t = torch::Tensor(torch::Tensor, torch::Tensor, torch::Tensor, int64_t);
+        static auto backward = find_operator(SphericartOperators<C>::name() + "_backward")
+                                   .template typed<backward_t>();
+
+        auto saved_variables = ctx->get_saved_variables();
+        auto xyz = saved_variables[0];
+        auto dsph = saved_variables[1];
+        auto l_max = ctx->saved_data["l_max"].toInt();
+
+        // the backward operator is not differentiable, so double backward
+        // raises an error
+        auto xyz_grad = backward.call(grad_outputs[0], xyz, dsph, l_max);
+        return {xyz_grad, torch::Tensor()};
+    }
+};
+
+} // namespace
+
+template <> const std::string& SphericartOperators<SphericalHarmonics>::name() {
+    static auto name = std::string("spherical_harmonics");
+    return name;
+}
+
+template <> const std::string& SphericartOperators<SolidHarmonics>::name() {
+    static auto name = std::string("solid_harmonics");
+    return name;
+}
+
+template <class C>
+torch::Tensor SphericartOperators<C>::compute(torch::Tensor xyz, int64_t l_max) {
+    check_inputs(xyz, l_max);
+    auto calculator = shared_calculator<C>(l_max);
+    if (xyz.device().is_cpu()) {
+        return calculator->compute_raw_cpu(xyz, false, false)[0];
+    } else if (xyz.device().is_cuda()) {
+        auto stream = CUDAStream::instance().get_stream(xyz.device().index());
+        return calculator->compute_raw_cuda(xyz, false, false, stream)[0];
+    } else {
+        throw std::runtime_error("Spherical harmonics are only implemented for CPU and CUDA");
+    }
+}
+
+template <class C>
+std::tuple<torch::Tensor, torch::Tensor> SphericartOperators<C>::compute_with_gradients(
+    torch::Tensor xyz, int64_t l_max
+) {
+    check_inputs(xyz, l_max);
+    auto calculator = shared_calculator<C>(l_max);
+    auto results = std::vector<torch::Tensor>();
+    if (xyz.device().is_cpu()) {
+        results = calculator->compute_raw_cpu(xyz, true, false);
+    } else if (xyz.device().is_cuda()) {
+        auto stream = CUDAStream::instance().get_stream(xyz.device().index());
+        results = calculator->compute_raw_cuda(xyz, true, false, stream);
+    } else {
+        throw std::runtime_error("Spherical harmonics are only implemented for CPU and CUDA");
+    }
+    return {results[0], results[1]};
+}
+
+template <class C>
+torch::Tensor SphericartOperators<C>::backward(
+    torch::Tensor grad_output, torch::Tensor xyz, torch::Tensor dsph, int64_t l_max
+) {
+    check_inputs(xyz, l_max);
+    auto calculator = shared_calculator<C>(l_max);
+    if (xyz.device().is_cpu()) {
+        if (xyz.dtype() == c10::kDouble) {
+            return contract_cpu<double>(calculator->calculator_double_, grad_output, xyz, dsph);
+        } else if (xyz.dtype() == c10::kFloat) {
+            return contract_cpu<float>(calculator->calculator_float_, grad_output, xyz, dsph);
+        } else {
+            throw std::runtime_error("this code only runs on float64 and float32 arrays");
+        }
+    } else if (xyz.device().is_cuda()) {
+        auto stream = CUDAStream::instance().get_stream(xyz.device().index());
+        return spherical_harmonics_backward_cuda(xyz, dsph, grad_output.contiguous(), stream);
+    } else {
+        throw std::runtime_error("Spherical harmonics are only implemented for CPU and CUDA");
+    }
+}
+
+template <class C>
+torch::Tensor SphericartOperators<C>::compute_meta(torch::Tensor xyz, int64_t l_max) {
+    check_inputs(xyz, l_max);
+    auto n_sph = c10::SymInt((l_max + 1) * (l_max + 1));
+    return at::empty_symint({xyz.sym_size(0), n_sph}, xyz.options());
+}
+
+template <class C>
+std::tuple<torch::Tensor, torch::Tensor> SphericartOperators<C>::compute_with_gradients_meta(
+    torch::Tensor xyz, int64_t l_max
+) {
+    check_inputs(xyz, l_max);
+    auto n_sph = c10::SymInt((l_max + 1) * (l_max + 1));
+    return {
+        at::empty_symint({xyz.sym_size(0), n_sph}, xyz.options()),
+        at::empty_symint({xyz.sym_size(0), c10::SymInt(3), n_sph}, xyz.options())
+    };
+}
+
+template <class C>
+torch::Tensor SphericartOperators<C>::backward_meta(
+    [[maybe_unused]] torch::Tensor grad_output,
+    torch::Tensor xyz,
+    [[maybe_unused]] torch::Tensor dsph,
+    int64_t l_max
+) {
+    check_inputs(xyz, l_max);
+    return torch::empty_like(xyz, torch::MemoryFormat::Contiguous);
+}
+
+template <class C>
+torch::Tensor SphericartOperators<C>::compute_autograd(torch::Tensor xyz, int64_t l_max) {
+    return OperatorAutograd<C>::apply(xyz, l_max);
+}
+
+// Explicit instantiation of the operators for both calculators
+template class sphericart_torch::SphericartOperators<SphericalHarmonics>;
+template class sphericart_torch::SphericartOperators<SolidHarmonics>;
+
+namespace {
+
+template <class C> void register_device_kernels(torch::Library& m) {
+    const auto& name = SphericartOperators<C>::name();
+    m.impl(name.c_str(), &SphericartOperators<C>::compute);
+    m.impl((name + "_with_gradients").c_str(), &SphericartOperators<C>::compute_with_gradients);
+    m.impl((name + "_backward").c_str(), &SphericartOperators<C>::backward);
+}
+
+template <class C> void register_meta_kernels(torch::Library& m) {
+    const auto& name = SphericartOperators<C>::name();
+    m.impl(name.c_str(), &SphericartOperators<C>::compute_meta);
+    m.impl(
+        (name + "_with_gradients").c_str(), &SphericartOperators<C>::compute_with_gradients_meta
+    );
+    m.impl((name + "_backward").c_str(), &SphericartOperators<C>::backward_meta);
+}
+
+template <class C> void register_autograd_kernels(torch::Library& m) {
+    const auto& name = SphericartOperators<C>::name();
+    m.impl(name.c_str(), &SphericartOperators<C>::compute_autograd);
+    m.impl((name + "_with_gradients").c_str(), torch::autograd::autogradNotImplementedFallback());
+    m.impl((name + "_backward").c_str(), torch::autograd::autogradNotImplementedFallback());
+}
+
+} // namespace
+
+TORCH_LIBRARY_FRAGMENT(sphericart_torch, m) {
+    for (const auto& name : {std::string("spherical_harmonics"), std::string("solid_harmonics")}) {
+        m.def((name + "(Tensor xyz, int l_max) -> Tensor").c_str());
+        m.def((name + "_with_gradients(Tensor xyz, int l_max) -> (Tensor, Tensor)").c_str());
+        m.def(
+            (name + "_backward(Tensor grad_output, Tensor xyz, Tensor dsph, int l_max) -> Tensor")
+                .c_str()
+        );
+    }
+}
+
+// the same kernels run on CPU and CUDA, and select the implementation from
+// the device of xyz
+TORCH_LIBRARY_IMPL(sphericart_torch, CPU, m) {
+    register_device_kernels<SphericalHarmonics>(m);
+    register_device_kernels<SolidHarmonics>(m);
+}
+
+TORCH_LIBRARY_IMPL(sphericart_torch, CUDA, m) {
+    register_device_kernels<SphericalHarmonics>(m);
+    register_device_kernels<SolidHarmonics>(m);
+}
+
+TORCH_LIBRARY_IMPL(sphericart_torch, Meta, m) {
+    register_meta_kernels<SphericalHarmonics>(m);
+    register_meta_kernels<SolidHarmonics>(m);
+}
+
+TORCH_LIBRARY_IMPL(sphericart_torch, Autograd, m) {
+    register_autograd_kernels<SphericalHarmonics>(m);
+    register_autograd_kernels<SolidHarmonics>(m);
+}
@@ -1,15 +1,132 @@
+#include <algorithm>
+#include <thread>
+
+#include <ATen/Parallel.h>
 #include <torch/torch.h>
 
 #include "sphericart/torch.hpp"
 #include "sphericart/autograd.hpp"
 
+#include "cuda_stream.hpp"
+
 using namespace torch;
 using namespace sphericart_torch;
 
-SphericalHarmonics::SphericalHarmonics(int64_t l_max, bool backward_second_derivatives)
+namespace {
+
+// Runs the workers of the CPU calculators as the chunks of an
+// `at::parallel_for`, so that they share the intra-op thread pool of torch
+// with the other operations, and follow `torch.set_num_threads()`
+class ATenBackend final : public sphericart::ParallelBackend {
+  public:
+    size_t max_workers() const override {
+        // the calculators allocate memory for this many workers when they are
+        // created, which leaves room to increase the number of threads later
+        auto hardware = static_cast<size_t>(std::thread::hardware_concurrency());
+        return std::max(hardware, static_cast<size_t>(at::get_num_threads()));
+    }
+
+    void run(size_t max_workers, sphericart::ParallelTask task) override {
+        auto n_workers = std::min(max_workers, static_cast<size_t>(at::get_num_threads()));
+        if (n_workers <= 1 || at::in_parallel_region()) {
+            task(0, 1);
+            return;
+        }
+        at::parallel_for(0, static_cast<int64_t>(n_workers), 1, [&](int64_t start, int64_t end) {
+            for (auto worker = start; worker < end; worker++) {
+                task(static_cast<size_t>(worker), n_workers);
+            }
+        });
+    }
+};
+
+std::shared_ptr<sphericart::ParallelBackend> aten_backend() {
+    static auto backend = std::make_shared<ATenBackend>();
+    return backend;
+}
+
+// Checks the tensors given to `compute_into`, which are filled directly by the
+// calculators. On CPU, the outputs of each sample must be contiguous, but
+// there can be gaps between samples; on CUDA, the outputs must be contiguous
+void check_outputs(torch::Tensor xyz, int64_t l_max, const std::vector<torch::Tensor>& out) {
+    if (out.empty() || out.size() > 3) {
+        throw std::runtime_error(
+            "compute_into: expected 1, 2 or 3 output tensors, got " + std::to_string(out.size())
+        );
+    }
+
+    if (xyz.dim() != 2 || xyz.size(1) != 3) {
+        throw std::runtime_error("xyz tensor must be an `n_samples x 3` array");
+    }
+
+    if (!xyz.device().is_cpu() && !xyz.device().is_cuda()) {
+        throw std::runtime_error("Spherical harmonics are only implemented for CPU and CUDA");
+    }
+
+    bool requires_grad = xyz.requires_grad();
+    for (const auto& output : out) {
+        requires_grad = requires_grad || output.requires_grad();
+    }
+    if (requires_grad && torch::GradMode::is_enabled()) {
+        throw std::runtime_error(
+            "compute_into does not support automatic differentiation, but one of the "
+            "arguments requires grad"
+        );
+    }
+
+    auto n_samples = xyz.size(0);
+    auto n_sph = (l_max + 1) * (l_max + 1);
+    auto shapes = std::vector<std::vector<int64_t>>{
+        {n_samples, n_sph}, {n_samples, 3, n_sph}, {n_samples, 3, 3, n_sph}
+    };
+    for (size_t i = 0; i < out.size(); i++) {
+        const auto& output = out[i];
+        if (output.device() != xyz.device() || output.scalar_type() != xyz.scalar_type()) {
+            throw std::runtime_error(
+                "compute_into: output tensors must have the same device and dtype as xyz"
+            );
+        }
+
+        if (output.sizes() != torch::IntArrayRef(shapes[i])) {
+            throw std::runtime_error(
+                "compute_into: expected output tensor " + std::to_string(i) + " with shape " +
+                c10::str(torch::IntArrayRef(shapes[i])) + ", got " + c10::str(output.sizes())
+            );
+        }
+
+        auto sample_size = int64_t(1);
+        bool valid = true;
+        for (auto dim = output.dim() - 1; dim > 0; dim--) {
+            // the stride of dimensions with a single entry is never used
+            valid = valid && (output.size(dim) == 1 || output.stride(dim) == sample_size);
+            sample_size *= output.size(dim);
+        }
+        valid = valid && (output.size(0) == 0 || output.stride(0) >= sample_size);
+        if (xyz.device().is_cuda()) {
+            valid = output.is_contiguous();
+        }
+        if (!valid) {
+            throw std::runtime_error(
+                "compute_into: output tensor " + std::to_string(i) +
+                " must store the outputs of each sample contiguously"
+            );
+        }
+    }
+}
+
+} // namespace
+
+SphericalHarmonics::SphericalHarmonics(
+    int64_t l_max, bool backward_second_derivatives, bool checkpoint
+)
     : l_max_(l_max), backward_second_derivatives_(backward_second_derivatives),
-      calculator_double_(l_max_), calculator_float_(l_max_) {
-    this->omp_num_threads_ = calculator_double_.get_omp_num_threads();
+      checkpoint_(checkpoint),
+      calculator_double_(
+          l_max_, sphericart::Engine::SAMPLE, sphericart::Layout::SAMPLE_MAJOR, aten_backend()
+      ),
+      calculator_float_(
+          l_max_, sphericart::Engine::SAMPLE, sphericart::Layout::SAMPLE_MAJOR, aten_backend()
+      ) {
 
     if (torch::cuda::is_available()) {
         this->calculator_cuda_double_ptr =
@@ -21,21 +138,41 @@ SphericalHarmonics::SphericalHarmonics(int64_t l_max, bool backward_second_deriv
 }
 
 torch::Tensor SphericalHarmonics::compute(torch::Tensor xyz) {
-    return SphericartAutograd::apply(*this, xyz, false, false)[0];
+    return SphericartAutograd<SphericalHarmonics>::apply(*this, xyz, false, false)[0];
 }
 
 std::vector<torch::Tensor> SphericalHarmonics::compute_with_gradients(torch::Tensor xyz) {
-    return SphericartAutograd::apply(*this, xyz, true, false);
+    return SphericartAutograd<SphericalHarmonics>::apply(*this, xyz, true, false);
 }
 
 std::vector<torch::Tensor> SphericalHarmonics::compute_with_hessians(torch::Tensor xyz) {
-    return SphericartAutograd::apply(*this, xyz, true, true);
+    return SphericartAutograd<SphericalHarmonics>::apply(*this, xyz, true, true);
+}
+
+std::vector<torch::Tensor> SphericalHarmonics::compute_into(
+    torch::Tensor xyz, std::vector<torch::Tensor> out
+) {
+    check_outputs(xyz, this->l_max_, out);
+    if (xyz.device().is_cpu()) {
+        this->compute_raw_cpu(xyz, out.size() > 1, out.size() > 2, out);
+    } else {
+        auto stream = CUDAStream::instance().get_stream(xyz.device().index());
+        this->compute_raw_cuda(xyz, out.size() > 1, out.size() > 2, stream, out);
+    }
+    return out;
 }
 
-SolidHarmonics::SolidHarmonics(int64_t l_max, bool backward_second_derivatives)
+SolidHarmonics::SolidHarmonics(
+    int64_t l_max, bool backward_second_derivatives, bool checkpoint
+)
     : l_max_(l_max), backward_second_derivatives_(backward_second_derivatives),
-      calculator_double_(l_max_), calculator_float_(l_max_) {
-    this->omp_num_threads_ = calculator_double_.get_omp_num_threads();
+      checkpoint_(checkpoint),
+      calculator_double_(
+          l_max_, sphericart::Engine::SAMPLE, sphericart::Layout::SAMPLE_MAJOR, aten_backend()
+      ),
+      calculator_float_(
+          l_max_, sphericart::Engine::SAMPLE, sphericart::Layout::SAMPLE_MAJOR, aten_backend()
+      ) {
 
     if (torch::cuda::is_available()) {
         this->calculator_cuda_double_ptr =
@@ -47,23 +184,38 @@ SolidHarmonics::SolidHarmonics(int64_t l_max, bool backward_second_derivatives)
 }
 
 torch::Tensor SolidHarmonics::compute(torch::Tensor xyz) {
-    return SphericartAutograd::apply(*this, xyz, false, false)[0];
+    return SphericartAutograd<SolidHarmonics>::apply(*this, xyz, false, false)[0];
 }
 
 std::vector<torch::Tensor> SolidHarmonics::compute_with_gradients(torch::Tensor xyz) {
-    return SphericartAutograd::apply(*this, xyz, true, false);
+    return SphericartAutograd<SolidHarmonics>::apply(*this, xyz, true, false);
 }
 
 std::vector<torch::Tensor> SolidHarmonics::compute_with_hessians(torch::Tensor xyz) {
-    return SphericartAutograd::apply(*this, xyz, true, true);
+    return SphericartAutograd<SolidHarmonics>::apply(*this, xyz, true, true);
+}
+
+std::vector<torch::Tensor> SolidHarmonics::compute_into(
+    torch::Tensor xyz, std::vector<torch::Tensor> out
+) {
+    check_outputs(xyz, this->l_max_, out);
+    if (xyz.device().is_cpu()) {
+        this->compute_raw_cpu(xyz, out.size() > 1, out.size() > 2, out);
+    } else {
+        auto stream = CUDAStream::instance().get_stream(xyz.device().index());
+        this->compute_raw_cuda(xyz, out.size() > 1, out.size() > 2, stream, out);
+    }
+    return out;
 }
 
 TORCH_LIBRARY(sphericart_torch, m) {
     m.class_<SphericalHarmonics>("SphericalHarmonics")
         .def(
-            torch::init<int64_t, bool>(),
+            torch::init<int64_t, bool, bool>(),
             "",
-            {torch::arg("l_max"), torch::arg("backward_second_derivatives") = false}
+            {torch::arg("l_max"),
+             torch::arg("backward_second_derivatives") = false,
+             torch::arg("checkpoint") = false}
         )
         .def("compute", &SphericalHarmonics::compute, "", {torch::arg("xyz")})
         .def(
@@ -78,44 +230,74 @@ TORCH_LIBRARY(sphericart_torch, m) {
             "",
             {torch::arg("xyz")}
         )
+        .def(
+            "compute_into",
+            &SphericalHarmonics::compute_into,
+            "",
+            {torch::arg("xyz"), torch::arg("out")}
+        )
         .def("omp_num_threads", &SphericalHarmonics::get_omp_num_threads)
         .def("l_max", &SphericalHarmonics::get_l_max)
         .def_pickle(
             // __getstate__
-            [](const c10::intrusive_ptr<SphericalHarmonics>& self) -> std::tuple<int64_t, bool> {
-                return {self->get_l_max(), self->get_backward_second_derivative_flag()};
+            [](const c10::intrusive_ptr<SphericalHarmonics>& self
+            ) -> std::tuple<int64_t, bool, bool> {
+                return {
+                    self->get_l_max(),
+                    self->get_backward_second_derivative_flag(),
+                    self->get_checkpoint_flag()
+                };
             },
             // __setstate__
-            [](std::tuple<int64_t, bool> state) -> c10::intrusive_ptr<SphericalHarmonics> {
+            [](std::tuple<int64_t, bool, bool> state) -> c10::intrusive_ptr<SphericalHarmonics> {
                 const auto l_max = std::get<0>(state);
                 const auto backward_second_derivatives = std::get<1>(state);
-                return c10::make_intrusive<SphericalHarmonics>(l_max, backward_second_derivatives);
+                const auto checkpoint = std::get<2>(state);
+                return c10::make_intrusive<SphericalHarmonics>(
+                    l_max, backward_second_derivatives, checkpoint
+                );
             }
         );
 
     m.class_<SolidHarmonics>("SolidHarmonics")
         .def(
-            torch::init<int64_t, bool>(),
+            torch::init<int64_t, bool, bool>(),
             "",
-            {torch::arg("l_max"), torch::arg("backward_second_derivatives") = false}
+            {torch::arg("l_max"),
+             torch::arg("backward_second_derivatives") = false,
+             torch::arg("checkpoint") = false}
         )
         .def("compute", &SolidHarmonics::compute, "", {torch::arg("xyz")})
         .def(
             "compute_with_gradients", &SolidHarmonics::compute_with_gradients, "", {torch::arg("xyz")}
         )
         .def("compute_with_hessians", &SolidHarmonics::compute_with_hessians, "", {torch::arg("xyz")})
+        .def(
+            "compute_into",
+            &SolidHarmonics::compute_into,
+            "",
+            {torch::arg("xyz"), torch::arg("out")}
+        )
         .def("omp_num_threads", &SolidHarmonics::get_omp_num_threads)
         .def("l_max", &SolidHarmonics::get_l_max)
         .def_pickle(
             // __getstate__
-            [](const c10::intrusive_ptr<SolidHarmonics>& self) -> std::tuple<int64_t, bool> {
-                return {self->get_l_max(), self->get_backward_second_derivative_flag()};
+            [](const c10::intrusive_ptr<SolidHarmonics>& self
+            ) -> std::tuple<int64_t, bool, bool> {
+                return {
+                    self->get_l_max(),
+                    self->get_backward_second_derivative_flag(),
+                    self->get_checkpoint_flag()
+                };
             },
             // __setstate__
-            [](std::tuple<int64_t, bool> state) -> c10::intrusive_ptr<SolidHarmonics> {
+            [](std::tuple<int64_t, bool, bool> state) -> c10::intrusive_ptr<SolidHarmonics> {
                 const auto l_max = std::get<0>(state);
                 const auto backward_second_derivatives = std::get<1>(state);
-                return c10::make_intrusive<SolidHarmonics>(l_max, backward_second_derivatives);
+                const auto checkpoint = std::get<2>(state);
+                return c10::make_intrusive<SolidHarmonics>(
+                    l_max, backward_second_derivatives, checkpoint
+                );
             }
         );
 }
@@ -26,23 +26,20 @@ torch::Tensor sphericart_torch::spherical_harmonics_backward_cuda(
         throw std::runtime_error("internal error: CUDA version called on non-CUDA tensor");
     }
 
-    auto xyz_grad = torch::Tensor();
-    if (xyz.requires_grad()) {
-        xyz_grad = torch::empty_like(xyz);
+    auto xyz_grad = torch::empty_like(xyz);
 
-        AT_DISPATCH_FLOATING_TYPES(
-            xyz.scalar_type(), "spherical_harmonics_backward_cuda", ([&] {
-                sphericart::cuda::spherical_harmonics_backward_cuda_base<scalar_t>(
-                    dsph.data_ptr<scalar_t>(),
-                    sph_grad.data_ptr<scalar_t>(),
-                    dsph.size(0),
-                    sph_grad.size(1),
-                    xyz_grad.data_ptr<scalar_t>(),
-                    stream
-                );
-            })
-        );
-    }
+    AT_DISPATCH_FLOATING_TYPES(
+        xyz.scalar_type(), "spherical_harmonics_backward_cuda", ([&] {
+            sphericart::cuda::spherical_harmonics_backward_cuda_base<scalar_t>(
+                dsph.data_ptr<scalar_t>(),
+                sph_grad.data_ptr<scalar_t>(),
+                dsph.size(0),
+                sph_grad.size(1),
+                xyz_grad.data_ptr<scalar_t>(),
+                stream
+            );
+        })
+    );
     // synchronization happens within spherical_harmonics_backward_cuda_base
     return xyz_grad;
 }
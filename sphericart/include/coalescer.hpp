@@ -0,0 +1,144 @@
+/** \file coalescer.hpp
+ *  Defines `Coalescer`, a front-end gathering many small and independent
+ *  calls to the CPU calculators into larger ones.
+ */
+
+#ifndef SPHERICART_COALESCER_HPP
+#define SPHERICART_COALESCER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sphericart.hpp"
+
+namespace sphericart {
+
+/**
+ * Controls how long a `Coalescer` waits for more calls before running them.
+ */
+struct CoalescerOptions {
+    /** Longest time a call waits for other calls to be submitted before the
+     * batch containing it starts running. Larger values give larger batches,
+     * at the cost of a higher latency for each call. */
+    std::chrono::microseconds max_delay = std::chrono::microseconds(100);
+    /** A batch starts running as soon as it contains this many points, without
+     * waiting for `max_delay`. */
+    size_t max_batch_samples = 65536;
+};
+
+/**
+ * Gathers many small calls, e.g. coming from the threads of an inference
+ * server evaluating one structure each, into a single large call to a
+ * calculator, which can then use all the workers of its parallel backend.
+ *
+ * Calls are submitted with the points and the outputs of each of them, and
+ * return a `std::future` that is ready once the outputs have been filled.
+ * A background thread waits up to `CoalescerOptions::max_delay` for more
+ * calls after the first one, concatenates the points of all the pending calls
+ * and evaluates them at once, before copying the results back to the outputs
+ * of each call.
+ *
+ * The points and the outputs must stay valid until the corresponding future
+ * is ready. The calls running in the same batch use the same layout as the
+ * calculator, which can not be `Layout::LM_MAJOR`.
+ */
+template <typename T> class Coalescer {
+  public:
+    /**
+     * Creates a coalescer running the calls on a clone of `calculator` (see
+     * `SphericalHarmonics::clone()`), which can be a `SphericalHarmonics` or a
+     * `SolidHarmonics` calculator.
+     *
+     *  @param calculator
+     *      The calculator used to evaluate the batches.
+     *  @param options
+     *      How long calls can wait for others, see `CoalescerOptions`.
+     */
+    Coalescer(const SphericalHarmonics<T>& calculator, CoalescerOptions options = {});
+
+    /** Runs all the pending calls and stops the background thread. */
+    ~Coalescer();
+
+    Coalescer(const Coalescer&) = delete;
+    Coalescer& operator=(const Coalescer&) = delete;
+
+    /**
+     * Submits a call computing the spherical harmonics of the points in
+     * `xyz`, as `SphericalHarmonics::compute_array()`.
+     *
+     * @param xyz A pointer to an array of size `n_samples x 3`.
+     * @param xyz_length Total length of the `xyz` array: `n_samples * 3`.
+     * @param sph On output, the spherical harmonics, as in `compute_array()`.
+     * @param sph_length Total length of the `sph` array.
+     *
+     * @return A future that becomes ready once `sph` has been filled, and
+     *     that re-throws the errors of the calculator, if any.
+     */
+    std::future<void> submit(const T* xyz, size_t xyz_length, T* sph, size_t sph_length);
+
+    /**
+     * Submits a call computing the spherical harmonics and their gradients,
+     * as `SphericalHarmonics::compute_array_with_gradients()`.
+     *
+     * @param xyz A pointer to an array of size `n_samples x 3`.
+     * @param xyz_length Total length of the `xyz` array: `n_samples * 3`.
+     * @param sph On output, the spherical harmonics.
+     * @param sph_length Total length of the `sph` array.
+     * @param dsph On output, the gradients of the spherical harmonics.
+     * @param dsph_length Total length of the `dsph` array.
+     *
+     * @return A future that becomes ready once `sph` and `dsph` have been
+     *     filled, and that re-throws the errors of the calculator, if any.
+     */
+    std::future<void> submit_with_gradients(
+        const T* xyz, size_t xyz_length, T* sph, size_t sph_length, T* dsph, size_t dsph_length
+    );
+
+    /* @cond */
+  private:
+    struct Call {
+        const T* xyz;
+        size_t n_samples;
+        T* sph;
+        T* dsph;
+        std::chrono::steady_clock::time_point submitted;
+        std::promise<void> promise;
+    };
+
+    // adds `call` to the pending ones, and returns its future
+    std::future<void> enqueue(Call call);
+    // main loop of the background thread
+    void dispatch();
+    // evaluates all the `calls`, either with or without gradients
+    void run_batch(std::vector<Call>& calls, bool gradients);
+
+    SphericalHarmonics<T> calculator;
+    CoalescerOptions options;
+    size_t size_y;
+
+    // only used by the background thread
+    Workspace<T> workspace;
+    std::vector<T> xyz_batch;
+    std::vector<T> sph_batch;
+    std::vector<T> dsph_batch;
+
+    // protects the members below
+    std::mutex mutex;
+    std::condition_variable submitted;
+    std::vector<Call> pending;
+    size_t pending_samples = 0;
+    bool stop = false;
+
+    // started last in the constructor, once all the other members exist
+    std::thread dispatcher;
+    /* @endcond */
+};
+
+} // namespace sphericart
+
+#endif
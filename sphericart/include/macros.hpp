@@ -21,14 +21,19 @@
    depending on whether only Ylm are needed or if one also want to evbaluate
    Cartesian derivatives
 
+    The second derivatives of the (unnormalized) solid harmonics of degree l
+   are harmonic polynomials of degree l-2, so COMPUTE_SPH_SECOND_DERIVATIVE_L*
+   expresses them as linear combinations of the Ylm of degree l-2, which must
+   have been computed beforehand
+
     Every macro takes an agument SPH_IDX that is an indexing function, that can
    be used to map the consecutive indices of the Ylm to a different memory
    layout (this is e.g. used to optimize threads in CUDA code)
 */
 
 // this is used thoughout to indicate the maximum l channel for which we
-// provide a hard-coded macro. this should be modified if further macros are
-// added
+// provide a hard-coded macro. Macros for l > 6 can be added by running
+// scripts/generate-hardcoded-macros.py, which also updates this value
 #define SPHERICART_LMAX_HARDCODED 6
 
 // we need this monstruosity to make sure that literals are not treated as
@@ -158,6 +163,55 @@ template <typename T> using remove_pointer_t = typename remove_pointer<T>::type;
     (dz_sph_i)[SPH_IDX(6)] = cast(sph_i, 1.15470053837925) * (dx_sph_i)[SPH_IDX(7)];                 \
     (dz_sph_i)[SPH_IDX(7)] = (dy_sph_i)[SPH_IDX(4)];
 
+#define COMPUTE_SPH_SECOND_DERIVATIVE_L2(                                                          \
+    sph_i,                                                                                         \
+    dxdx_sph_i,                                                                                    \
+    dxdy_sph_i,                                                                                    \
+    dxdz_sph_i,                                                                                    \
+    dydx_sph_i,                                                                                    \
+    dydy_sph_i,                                                                                    \
+    dydz_sph_i,                                                                                    \
+    dzdx_sph_i,                                                                                    \
+    dzdy_sph_i,                                                                                    \
+    dzdz_sph_i,                                                                                    \
+    SPH_IDX                                                                                        \
+)                                                                                                  \
+    (dxdx_sph_i)[SPH_IDX(4)] = cast(sph_i, 0.0);                                                   \
+    (dxdx_sph_i)[SPH_IDX(5)] = cast(sph_i, 0.0);                                                   \
+    (dxdx_sph_i)[SPH_IDX(6)] = -cast(sph_i, 0.6307831305050396);                                   \
+    (dxdx_sph_i)[SPH_IDX(7)] = cast(sph_i, 0.0);                                                   \
+    (dxdx_sph_i)[SPH_IDX(8)] = cast(sph_i, 1.092548430592079);                                     \
+                                                                                                   \
+    (dxdy_sph_i)[SPH_IDX(4)] = (dydx_sph_i)[SPH_IDX(4)] = cast(sph_i, 1.092548430592079);          \
+    (dxdy_sph_i)[SPH_IDX(5)] = (dydx_sph_i)[SPH_IDX(5)] = cast(sph_i, 0.0);                        \
+    (dxdy_sph_i)[SPH_IDX(6)] = (dydx_sph_i)[SPH_IDX(6)] = cast(sph_i, 0.0);                        \
+    (dxdy_sph_i)[SPH_IDX(7)] = (dydx_sph_i)[SPH_IDX(7)] = cast(sph_i, 0.0);                        \
+    (dxdy_sph_i)[SPH_IDX(8)] = (dydx_sph_i)[SPH_IDX(8)] = cast(sph_i, 0.0);                        \
+                                                                                                   \
+    (dxdz_sph_i)[SPH_IDX(4)] = (dzdx_sph_i)[SPH_IDX(4)] = cast(sph_i, 0.0);                        \
+    (dxdz_sph_i)[SPH_IDX(5)] = (dzdx_sph_i)[SPH_IDX(5)] = cast(sph_i, 0.0);                        \
+    (dxdz_sph_i)[SPH_IDX(6)] = (dzdx_sph_i)[SPH_IDX(6)] = cast(sph_i, 0.0);                        \
+    (dxdz_sph_i)[SPH_IDX(7)] = (dzdx_sph_i)[SPH_IDX(7)] = cast(sph_i, 1.092548430592079);          \
+    (dxdz_sph_i)[SPH_IDX(8)] = (dzdx_sph_i)[SPH_IDX(8)] = cast(sph_i, 0.0);                        \
+                                                                                                   \
+    (dydy_sph_i)[SPH_IDX(4)] = cast(sph_i, 0.0);                                                   \
+    (dydy_sph_i)[SPH_IDX(5)] = cast(sph_i, 0.0);                                                   \
+    (dydy_sph_i)[SPH_IDX(6)] = -cast(sph_i, 0.6307831305050396);                                   \
+    (dydy_sph_i)[SPH_IDX(7)] = cast(sph_i, 0.0);                                                   \
+    (dydy_sph_i)[SPH_IDX(8)] = -cast(sph_i, 1.092548430592079);                                    \
+                                                                                                   \
+    (dydz_sph_i)[SPH_IDX(4)] = (dzdy_sph_i)[SPH_IDX(4)] = cast(sph_i, 0.0);                        \
+    (dydz_sph_i)[SPH_IDX(5)] = (dzdy_sph_i)[SPH_IDX(5)] = cast(sph_i, 1.092548430592079);          \
+    (dydz_sph_i)[SPH_IDX(6)] = (dzdy_sph_i)[SPH_IDX(6)] = cast(sph_i, 0.0);                        \
+    (dydz_sph_i)[SPH_IDX(7)] = (dzdy_sph_i)[SPH_IDX(7)] = cast(sph_i, 0.0);                        \
+    (dydz_sph_i)[SPH_IDX(8)] = (dzdy_sph_i)[SPH_IDX(8)] = cast(sph_i, 0.0);                        \
+                                                                                                   \
+    (dzdz_sph_i)[SPH_IDX(4)] = cast(sph_i, 0.0);                                                   \
+    (dzdz_sph_i)[SPH_IDX(5)] = cast(sph_i, 0.0);                                                   \
+    (dzdz_sph_i)[SPH_IDX(6)] = cast(sph_i, 1.261566261010079);                                     \
+    (dzdz_sph_i)[SPH_IDX(7)] = cast(sph_i, 0.0);                                                   \
+    (dzdz_sph_i)[SPH_IDX(8)] = cast(sph_i, 0.0);
+
 #define COMPUTE_SPH_L3(x, y, z, x2, y2, z2, sph_i, SPH_IDX)                                        \
     {                                                                                              \
         sph_i[SPH_IDX(9)] = -cast(sph_i, 0.59004358992664) * y * (y2 - 3 * x2);                    \
@@ -198,6 +252,80 @@ template <typename T> using remove_pointer_t = typename remove_pointer<T>::type;
     dz_sph_i[SPH_IDX(14)] = cast(sph_i, 2.64575131106459) * sph_i[SPH_IDX(8)];                       \
     dz_sph_i[SPH_IDX(15)] = cast(sph_i, 0.0);
 
+#define COMPUTE_SPH_SECOND_DERIVATIVE_L3(                                                          \
+    sph_i,                                                                                         \
+    dxdx_sph_i,                                                                                    \
+    dxdy_sph_i,                                                                                    \
+    dxdz_sph_i,                                                                                    \
+    dydx_sph_i,                                                                                    \
+    dydy_sph_i,                                                                                    \
+    dydz_sph_i,                                                                                    \
+    dzdx_sph_i,                                                                                    \
+    dzdy_sph_i,                                                                                    \
+    dzdz_sph_i,                                                                                    \
+    SPH_IDX                                                                                        \
+)                                                                                                  \
+    (dxdx_sph_i)[SPH_IDX(9)] = cast(sph_i, 7.245688373094719) * (sph_i)[SPH_IDX(1)];               \
+    (dxdx_sph_i)[SPH_IDX(10)] = cast(sph_i, 0.0);                                                  \
+    (dxdx_sph_i)[SPH_IDX(11)] = -cast(sph_i, 1.870828693386971) * (sph_i)[SPH_IDX(1)];             \
+    (dxdx_sph_i)[SPH_IDX(12)] = -cast(sph_i, 4.58257569495584) * (sph_i)[SPH_IDX(2)];              \
+    (dxdx_sph_i)[SPH_IDX(13)] = -cast(sph_i, 5.612486080160912) * (sph_i)[SPH_IDX(3)];             \
+    (dxdx_sph_i)[SPH_IDX(14)] = cast(sph_i, 5.916079783099616) * (sph_i)[SPH_IDX(2)];              \
+    (dxdx_sph_i)[SPH_IDX(15)] = cast(sph_i, 7.245688373094719) * (sph_i)[SPH_IDX(3)];              \
+                                                                                                   \
+    (dxdy_sph_i)[SPH_IDX(9)] = (dydx_sph_i)[SPH_IDX(9)] =                                          \
+        cast(sph_i, 7.245688373094719) * (sph_i)[SPH_IDX(3)];                                      \
+    (dxdy_sph_i)[SPH_IDX(10)] = (dydx_sph_i)[SPH_IDX(10)] =                                        \
+        cast(sph_i, 5.916079783099616) * (sph_i)[SPH_IDX(2)];                                      \
+    (dxdy_sph_i)[SPH_IDX(11)] = (dydx_sph_i)[SPH_IDX(11)] =                                        \
+        -cast(sph_i, 1.870828693386971) * (sph_i)[SPH_IDX(3)];                                     \
+    (dxdy_sph_i)[SPH_IDX(12)] = (dydx_sph_i)[SPH_IDX(12)] = cast(sph_i, 0.0);                      \
+    (dxdy_sph_i)[SPH_IDX(13)] = (dydx_sph_i)[SPH_IDX(13)] =                                        \
+        -cast(sph_i, 1.870828693386971) * (sph_i)[SPH_IDX(1)];                                     \
+    (dxdy_sph_i)[SPH_IDX(14)] = (dydx_sph_i)[SPH_IDX(14)] = cast(sph_i, 0.0);                      \
+    (dxdy_sph_i)[SPH_IDX(15)] = (dydx_sph_i)[SPH_IDX(15)] =                                        \
+        -cast(sph_i, 7.245688373094719) * (sph_i)[SPH_IDX(1)];                                     \
+                                                                                                   \
+    (dxdz_sph_i)[SPH_IDX(9)] = (dzdx_sph_i)[SPH_IDX(9)] = cast(sph_i, 0.0);                        \
+    (dxdz_sph_i)[SPH_IDX(10)] = (dzdx_sph_i)[SPH_IDX(10)] =                                        \
+        cast(sph_i, 5.916079783099616) * (sph_i)[SPH_IDX(1)];                                      \
+    (dxdz_sph_i)[SPH_IDX(11)] = (dzdx_sph_i)[SPH_IDX(11)] = cast(sph_i, 0.0);                      \
+    (dxdz_sph_i)[SPH_IDX(12)] = (dzdx_sph_i)[SPH_IDX(12)] =                                        \
+        -cast(sph_i, 4.58257569495584) * (sph_i)[SPH_IDX(3)];                                      \
+    (dxdz_sph_i)[SPH_IDX(13)] = (dzdx_sph_i)[SPH_IDX(13)] =                                        \
+        cast(sph_i, 7.483314773547883) * (sph_i)[SPH_IDX(2)];                                      \
+    (dxdz_sph_i)[SPH_IDX(14)] = (dzdx_sph_i)[SPH_IDX(14)] =                                        \
+        cast(sph_i, 5.916079783099616) * (sph_i)[SPH_IDX(3)];                                      \
+    (dxdz_sph_i)[SPH_IDX(15)] = (dzdx_sph_i)[SPH_IDX(15)] = cast(sph_i, 0.0);                      \
+                                                                                                   \
+    (dydy_sph_i)[SPH_IDX(9)] = -cast(sph_i, 7.245688373094719) * (sph_i)[SPH_IDX(1)];              \
+    (dydy_sph_i)[SPH_IDX(10)] = cast(sph_i, 0.0);                                                  \
+    (dydy_sph_i)[SPH_IDX(11)] = -cast(sph_i, 5.612486080160912) * (sph_i)[SPH_IDX(1)];             \
+    (dydy_sph_i)[SPH_IDX(12)] = -cast(sph_i, 4.58257569495584) * (sph_i)[SPH_IDX(2)];              \
+    (dydy_sph_i)[SPH_IDX(13)] = -cast(sph_i, 1.870828693386971) * (sph_i)[SPH_IDX(3)];             \
+    (dydy_sph_i)[SPH_IDX(14)] = -cast(sph_i, 5.916079783099616) * (sph_i)[SPH_IDX(2)];             \
+    (dydy_sph_i)[SPH_IDX(15)] = -cast(sph_i, 7.245688373094719) * (sph_i)[SPH_IDX(3)];             \
+                                                                                                   \
+    (dydz_sph_i)[SPH_IDX(9)] = (dzdy_sph_i)[SPH_IDX(9)] = cast(sph_i, 0.0);                        \
+    (dydz_sph_i)[SPH_IDX(10)] = (dzdy_sph_i)[SPH_IDX(10)] =                                        \
+        cast(sph_i, 5.916079783099616) * (sph_i)[SPH_IDX(3)];                                      \
+    (dydz_sph_i)[SPH_IDX(11)] = (dzdy_sph_i)[SPH_IDX(11)] =                                        \
+        cast(sph_i, 7.483314773547883) * (sph_i)[SPH_IDX(2)];                                      \
+    (dydz_sph_i)[SPH_IDX(12)] = (dzdy_sph_i)[SPH_IDX(12)] =                                        \
+        -cast(sph_i, 4.58257569495584) * (sph_i)[SPH_IDX(1)];                                      \
+    (dydz_sph_i)[SPH_IDX(13)] = (dzdy_sph_i)[SPH_IDX(13)] = cast(sph_i, 0.0);                      \
+    (dydz_sph_i)[SPH_IDX(14)] = (dzdy_sph_i)[SPH_IDX(14)] =                                        \
+        -cast(sph_i, 5.916079783099616) * (sph_i)[SPH_IDX(1)];                                     \
+    (dydz_sph_i)[SPH_IDX(15)] = (dzdy_sph_i)[SPH_IDX(15)] = cast(sph_i, 0.0);                      \
+                                                                                                   \
+    (dzdz_sph_i)[SPH_IDX(9)] = cast(sph_i, 0.0);                                                   \
+    (dzdz_sph_i)[SPH_IDX(10)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(11)] = cast(sph_i, 7.483314773547883) * (sph_i)[SPH_IDX(1)];              \
+    (dzdz_sph_i)[SPH_IDX(12)] = cast(sph_i, 9.16515138991168) * (sph_i)[SPH_IDX(2)];               \
+    (dzdz_sph_i)[SPH_IDX(13)] = cast(sph_i, 7.483314773547883) * (sph_i)[SPH_IDX(3)];              \
+    (dzdz_sph_i)[SPH_IDX(14)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(15)] = cast(sph_i, 0.0);
+
 #define COMPUTE_SPH_L4(x, y, z, x2, y2, z2, sph_i, SPH_IDX)                                        \
     {                                                                                              \
         sph_i[SPH_IDX(16)] =                                                                       \
@@ -256,6 +384,106 @@ template <typename T> using remove_pointer_t = typename remove_pointer<T>::type;
     (dz_sph_i)[SPH_IDX(23)] = 3 * (sph_i)[SPH_IDX(15)];                                              \
     (dz_sph_i)[SPH_IDX(24)] = cast(sph_i, 0.0);
 
+#define COMPUTE_SPH_SECOND_DERIVATIVE_L4(                                                          \
+    sph_i,                                                                                         \
+    dxdx_sph_i,                                                                                    \
+    dxdy_sph_i,                                                                                    \
+    dxdz_sph_i,                                                                                    \
+    dydx_sph_i,                                                                                    \
+    dydy_sph_i,                                                                                    \
+    dydz_sph_i,                                                                                    \
+    dzdx_sph_i,                                                                                    \
+    dzdy_sph_i,                                                                                    \
+    dzdz_sph_i,                                                                                    \
+    SPH_IDX                                                                                        \
+)                                                                                                  \
+    (dxdx_sph_i)[SPH_IDX(16)] = cast(sph_i, 13.74772708486752) * (sph_i)[SPH_IDX(4)];              \
+    (dxdx_sph_i)[SPH_IDX(17)] = cast(sph_i, 9.721111047611791) * (sph_i)[SPH_IDX(5)];              \
+    (dxdx_sph_i)[SPH_IDX(18)] = -cast(sph_i, 5.196152422706632) * (sph_i)[SPH_IDX(4)];             \
+    (dxdx_sph_i)[SPH_IDX(19)] = -cast(sph_i, 3.674234614174767) * (sph_i)[SPH_IDX(5)];             \
+    (dxdx_sph_i)[SPH_IDX(20)] = -cast(sph_i, 8.049844718999243) * (sph_i)[SPH_IDX(6)] +            \
+                                cast(sph_i, 2.32379000772445) * (sph_i)[SPH_IDX(8)];               \
+    (dxdx_sph_i)[SPH_IDX(21)] = -cast(sph_i, 11.0227038425243) * (sph_i)[SPH_IDX(7)];              \
+    (dxdx_sph_i)[SPH_IDX(22)] = cast(sph_i, 9.0) * (sph_i)[SPH_IDX(6)] -                           \
+                                cast(sph_i, 5.196152422706632) * (sph_i)[SPH_IDX(8)];              \
+    (dxdx_sph_i)[SPH_IDX(23)] = cast(sph_i, 9.721111047611791) * (sph_i)[SPH_IDX(7)];              \
+    (dxdx_sph_i)[SPH_IDX(24)] = cast(sph_i, 13.74772708486752) * (sph_i)[SPH_IDX(8)];              \
+                                                                                                   \
+    (dxdy_sph_i)[SPH_IDX(16)] = (dydx_sph_i)[SPH_IDX(16)] =                                        \
+        cast(sph_i, 13.74772708486752) * (sph_i)[SPH_IDX(8)];                                      \
+    (dxdy_sph_i)[SPH_IDX(17)] = (dydx_sph_i)[SPH_IDX(17)] =                                        \
+        cast(sph_i, 9.721111047611791) * (sph_i)[SPH_IDX(7)];                                      \
+    (dxdy_sph_i)[SPH_IDX(18)] = (dydx_sph_i)[SPH_IDX(18)] = cast(sph_i, 9.0) * (sph_i)[SPH_IDX(6)];\
+    (dxdy_sph_i)[SPH_IDX(19)] = (dydx_sph_i)[SPH_IDX(19)] =                                        \
+        -cast(sph_i, 3.674234614174767) * (sph_i)[SPH_IDX(7)];                                     \
+    (dxdy_sph_i)[SPH_IDX(20)] = (dydx_sph_i)[SPH_IDX(20)] =                                        \
+        cast(sph_i, 2.32379000772445) * (sph_i)[SPH_IDX(4)];                                       \
+    (dxdy_sph_i)[SPH_IDX(21)] = (dydx_sph_i)[SPH_IDX(21)] =                                        \
+        -cast(sph_i, 3.674234614174767) * (sph_i)[SPH_IDX(5)];                                     \
+    (dxdy_sph_i)[SPH_IDX(22)] = (dydx_sph_i)[SPH_IDX(22)] = cast(sph_i, 0.0);                      \
+    (dxdy_sph_i)[SPH_IDX(23)] = (dydx_sph_i)[SPH_IDX(23)] =                                        \
+        -cast(sph_i, 9.721111047611791) * (sph_i)[SPH_IDX(5)];                                     \
+    (dxdy_sph_i)[SPH_IDX(24)] = (dydx_sph_i)[SPH_IDX(24)] =                                        \
+        -cast(sph_i, 13.74772708486752) * (sph_i)[SPH_IDX(4)];                                     \
+                                                                                                   \
+    (dxdz_sph_i)[SPH_IDX(16)] = (dzdx_sph_i)[SPH_IDX(16)] = cast(sph_i, 0.0);                      \
+    (dxdz_sph_i)[SPH_IDX(17)] = (dzdx_sph_i)[SPH_IDX(17)] =                                        \
+        cast(sph_i, 9.721111047611791) * (sph_i)[SPH_IDX(4)];                                      \
+    (dxdz_sph_i)[SPH_IDX(18)] = (dzdx_sph_i)[SPH_IDX(18)] =                                        \
+        cast(sph_i, 10.39230484541326) * (sph_i)[SPH_IDX(5)];                                      \
+    (dxdz_sph_i)[SPH_IDX(19)] = (dzdx_sph_i)[SPH_IDX(19)] =                                        \
+        -cast(sph_i, 3.674234614174767) * (sph_i)[SPH_IDX(4)];                                     \
+    (dxdz_sph_i)[SPH_IDX(20)] = (dzdx_sph_i)[SPH_IDX(20)] =                                        \
+        -cast(sph_i, 9.295160030897801) * (sph_i)[SPH_IDX(7)];                                     \
+    (dxdz_sph_i)[SPH_IDX(21)] = (dzdx_sph_i)[SPH_IDX(21)] =                                        \
+        cast(sph_i, 12.72792206135786) * (sph_i)[SPH_IDX(6)] -                                     \
+        cast(sph_i, 3.674234614174767) * (sph_i)[SPH_IDX(8)];                                      \
+    (dxdz_sph_i)[SPH_IDX(22)] = (dzdx_sph_i)[SPH_IDX(22)] =                                        \
+        cast(sph_i, 10.39230484541326) * (sph_i)[SPH_IDX(7)];                                      \
+    (dxdz_sph_i)[SPH_IDX(23)] = (dzdx_sph_i)[SPH_IDX(23)] =                                        \
+        cast(sph_i, 9.721111047611791) * (sph_i)[SPH_IDX(8)];                                      \
+    (dxdz_sph_i)[SPH_IDX(24)] = (dzdx_sph_i)[SPH_IDX(24)] = cast(sph_i, 0.0);                      \
+                                                                                                   \
+    (dydy_sph_i)[SPH_IDX(16)] = -cast(sph_i, 13.74772708486752) * (sph_i)[SPH_IDX(4)];             \
+    (dydy_sph_i)[SPH_IDX(17)] = -cast(sph_i, 9.721111047611791) * (sph_i)[SPH_IDX(5)];             \
+    (dydy_sph_i)[SPH_IDX(18)] = -cast(sph_i, 5.196152422706632) * (sph_i)[SPH_IDX(4)];             \
+    (dydy_sph_i)[SPH_IDX(19)] = -cast(sph_i, 11.0227038425243) * (sph_i)[SPH_IDX(5)];              \
+    (dydy_sph_i)[SPH_IDX(20)] = -cast(sph_i, 8.049844718999243) * (sph_i)[SPH_IDX(6)] -            \
+                                cast(sph_i, 2.32379000772445) * (sph_i)[SPH_IDX(8)];               \
+    (dydy_sph_i)[SPH_IDX(21)] = -cast(sph_i, 3.674234614174767) * (sph_i)[SPH_IDX(7)];             \
+    (dydy_sph_i)[SPH_IDX(22)] = -cast(sph_i, 9.0) * (sph_i)[SPH_IDX(6)] -                          \
+                                cast(sph_i, 5.196152422706632) * (sph_i)[SPH_IDX(8)];              \
+    (dydy_sph_i)[SPH_IDX(23)] = -cast(sph_i, 9.721111047611791) * (sph_i)[SPH_IDX(7)];             \
+    (dydy_sph_i)[SPH_IDX(24)] = -cast(sph_i, 13.74772708486752) * (sph_i)[SPH_IDX(8)];             \
+                                                                                                   \
+    (dydz_sph_i)[SPH_IDX(16)] = (dzdy_sph_i)[SPH_IDX(16)] = cast(sph_i, 0.0);                      \
+    (dydz_sph_i)[SPH_IDX(17)] = (dzdy_sph_i)[SPH_IDX(17)] =                                        \
+        cast(sph_i, 9.721111047611791) * (sph_i)[SPH_IDX(8)];                                      \
+    (dydz_sph_i)[SPH_IDX(18)] = (dzdy_sph_i)[SPH_IDX(18)] =                                        \
+        cast(sph_i, 10.39230484541326) * (sph_i)[SPH_IDX(7)];                                      \
+    (dydz_sph_i)[SPH_IDX(19)] = (dzdy_sph_i)[SPH_IDX(19)] =                                        \
+        cast(sph_i, 12.72792206135786) * (sph_i)[SPH_IDX(6)] +                                     \
+        cast(sph_i, 3.674234614174767) * (sph_i)[SPH_IDX(8)];                                      \
+    (dydz_sph_i)[SPH_IDX(20)] = (dzdy_sph_i)[SPH_IDX(20)] =                                        \
+        -cast(sph_i, 9.295160030897801) * (sph_i)[SPH_IDX(5)];                                     \
+    (dydz_sph_i)[SPH_IDX(21)] = (dzdy_sph_i)[SPH_IDX(21)] =                                        \
+        -cast(sph_i, 3.674234614174767) * (sph_i)[SPH_IDX(4)];                                     \
+    (dydz_sph_i)[SPH_IDX(22)] = (dzdy_sph_i)[SPH_IDX(22)] =                                        \
+        -cast(sph_i, 10.39230484541326) * (sph_i)[SPH_IDX(5)];                                     \
+    (dydz_sph_i)[SPH_IDX(23)] = (dzdy_sph_i)[SPH_IDX(23)] =                                        \
+        -cast(sph_i, 9.721111047611791) * (sph_i)[SPH_IDX(4)];                                     \
+    (dydz_sph_i)[SPH_IDX(24)] = (dzdy_sph_i)[SPH_IDX(24)] = cast(sph_i, 0.0);                      \
+                                                                                                   \
+    (dzdz_sph_i)[SPH_IDX(16)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(17)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(18)] = cast(sph_i, 10.39230484541326) * (sph_i)[SPH_IDX(4)];              \
+    (dzdz_sph_i)[SPH_IDX(19)] = cast(sph_i, 14.69693845669907) * (sph_i)[SPH_IDX(5)];              \
+    (dzdz_sph_i)[SPH_IDX(20)] = cast(sph_i, 16.09968943799849) * (sph_i)[SPH_IDX(6)];              \
+    (dzdz_sph_i)[SPH_IDX(21)] = cast(sph_i, 14.69693845669907) * (sph_i)[SPH_IDX(7)];              \
+    (dzdz_sph_i)[SPH_IDX(22)] = cast(sph_i, 10.39230484541326) * (sph_i)[SPH_IDX(8)];              \
+    (dzdz_sph_i)[SPH_IDX(23)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(24)] = cast(sph_i, 0.0);
+
 #define COMPUTE_SPH_L5(x, y, z, x2, y2, z2, sph_i, SPH_IDX)                                          \
     {                                                                                                \
         sph_i[SPH_IDX(25)] = cast(sph_i, 13.12764113680340) * y *                                    \
@@ -341,6 +569,139 @@ template <typename T> using remove_pointer_t = typename remove_pointer<T>::type;
     (dz_sph_i)[SPH_IDX(34)] = cast(sph_i, 3.316624790355400) * (sph_i)[SPH_IDX(24)];                 \
     (dz_sph_i)[SPH_IDX(35)] = cast(sph_i, 0.0);
 
+#define COMPUTE_SPH_SECOND_DERIVATIVE_L5(                                                          \
+    sph_i,                                                                                         \
+    dxdx_sph_i,                                                                                    \
+    dxdy_sph_i,                                                                                    \
+    dxdz_sph_i,                                                                                    \
+    dydx_sph_i,                                                                                    \
+    dydy_sph_i,                                                                                    \
+    dydz_sph_i,                                                                                    \
+    dzdx_sph_i,                                                                                    \
+    dzdy_sph_i,                                                                                    \
+    dzdz_sph_i,                                                                                    \
+    SPH_IDX                                                                                        \
+)                                                                                                  \
+    (dxdx_sph_i)[SPH_IDX(25)] = cast(sph_i, 22.24859546128699) * (sph_i)[SPH_IDX(9)];              \
+    (dxdx_sph_i)[SPH_IDX(26)] = cast(sph_i, 17.23368793961409) * (sph_i)[SPH_IDX(10)];             \
+    (dxdx_sph_i)[SPH_IDX(27)] = -cast(sph_i, 6.6332495807108) * (sph_i)[SPH_IDX(9)] +              \
+                                cast(sph_i, 12.84523257866513) * (sph_i)[SPH_IDX(11)];             \
+    (dxdx_sph_i)[SPH_IDX(28)] = -cast(sph_i, 9.949874371066199) * (sph_i)[SPH_IDX(10)];            \
+    (dxdx_sph_i)[SPH_IDX(29)] = cast(sph_i, 1.535298947157477) * (sph_i)[SPH_IDX(9)] -             \
+                                cast(sph_i, 5.946187253790689) * (sph_i)[SPH_IDX(11)];             \
+    (dxdx_sph_i)[SPH_IDX(30)] = -cast(sph_i, 12.53566341056017) * (sph_i)[SPH_IDX(12)] +           \
+                                cast(sph_i, 4.855041562276122) * (sph_i)[SPH_IDX(14)];             \
+    (dxdx_sph_i)[SPH_IDX(31)] = -cast(sph_i, 17.83856176137207) * (sph_i)[SPH_IDX(13)] +           \
+                                cast(sph_i, 1.535298947157477) * (sph_i)[SPH_IDX(15)];             \
+    (dxdx_sph_i)[SPH_IDX(32)] = cast(sph_i, 12.84523257866513) * (sph_i)[SPH_IDX(12)] -            \
+                                cast(sph_i, 9.949874371066199) * (sph_i)[SPH_IDX(14)];             \
+    (dxdx_sph_i)[SPH_IDX(33)] = cast(sph_i, 12.84523257866513) * (sph_i)[SPH_IDX(13)] -            \
+                                cast(sph_i, 6.6332495807108) * (sph_i)[SPH_IDX(15)];               \
+    (dxdx_sph_i)[SPH_IDX(34)] = cast(sph_i, 17.23368793961409) * (sph_i)[SPH_IDX(14)];             \
+    (dxdx_sph_i)[SPH_IDX(35)] = cast(sph_i, 22.24859546128699) * (sph_i)[SPH_IDX(15)];             \
+                                                                                                   \
+    (dxdy_sph_i)[SPH_IDX(25)] = (dydx_sph_i)[SPH_IDX(25)] =                                        \
+        cast(sph_i, 22.24859546128699) * (sph_i)[SPH_IDX(15)];                                     \
+    (dxdy_sph_i)[SPH_IDX(26)] = (dydx_sph_i)[SPH_IDX(26)] =                                        \
+        cast(sph_i, 17.23368793961409) * (sph_i)[SPH_IDX(14)];                                     \
+    (dxdy_sph_i)[SPH_IDX(27)] = (dydx_sph_i)[SPH_IDX(27)] =                                        \
+        cast(sph_i, 12.84523257866513) * (sph_i)[SPH_IDX(13)];                                     \
+    (dxdy_sph_i)[SPH_IDX(28)] = (dydx_sph_i)[SPH_IDX(28)] =                                        \
+        cast(sph_i, 12.84523257866513) * (sph_i)[SPH_IDX(12)];                                     \
+    (dxdy_sph_i)[SPH_IDX(29)] = (dydx_sph_i)[SPH_IDX(29)] =                                        \
+        -cast(sph_i, 5.946187253790689) * (sph_i)[SPH_IDX(13)] -                                   \
+        cast(sph_i, 1.535298947157477) * (sph_i)[SPH_IDX(15)];                                     \
+    (dxdy_sph_i)[SPH_IDX(30)] = (dydx_sph_i)[SPH_IDX(30)] =                                        \
+        cast(sph_i, 4.855041562276122) * (sph_i)[SPH_IDX(10)];                                     \
+    (dxdy_sph_i)[SPH_IDX(31)] = (dydx_sph_i)[SPH_IDX(31)] =                                        \
+        cast(sph_i, 1.535298947157477) * (sph_i)[SPH_IDX(9)] -                                     \
+        cast(sph_i, 5.946187253790689) * (sph_i)[SPH_IDX(11)];                                     \
+    (dxdy_sph_i)[SPH_IDX(32)] = (dydx_sph_i)[SPH_IDX(32)] = cast(sph_i, 0.0);                      \
+    (dxdy_sph_i)[SPH_IDX(33)] = (dydx_sph_i)[SPH_IDX(33)] =                                        \
+        -cast(sph_i, 12.84523257866513) * (sph_i)[SPH_IDX(11)];                                    \
+    (dxdy_sph_i)[SPH_IDX(34)] = (dydx_sph_i)[SPH_IDX(34)] =                                        \
+        -cast(sph_i, 17.23368793961409) * (sph_i)[SPH_IDX(10)];                                    \
+    (dxdy_sph_i)[SPH_IDX(35)] = (dydx_sph_i)[SPH_IDX(35)] =                                        \
+        -cast(sph_i, 22.24859546128699) * (sph_i)[SPH_IDX(9)];                                     \
+                                                                                                   \
+    (dxdz_sph_i)[SPH_IDX(25)] = (dzdx_sph_i)[SPH_IDX(25)] = cast(sph_i, 0.0);                      \
+    (dxdz_sph_i)[SPH_IDX(26)] = (dzdx_sph_i)[SPH_IDX(26)] =                                        \
+        cast(sph_i, 14.07124727947029) * (sph_i)[SPH_IDX(9)];                                      \
+    (dxdz_sph_i)[SPH_IDX(27)] = (dzdx_sph_i)[SPH_IDX(27)] =                                        \
+        cast(sph_i, 16.24807680927192) * (sph_i)[SPH_IDX(10)];                                     \
+    (dxdz_sph_i)[SPH_IDX(28)] = (dzdx_sph_i)[SPH_IDX(28)] =                                        \
+        -cast(sph_i, 4.06201920231798) * (sph_i)[SPH_IDX(9)] +                                     \
+        cast(sph_i, 15.73213272255227) * (sph_i)[SPH_IDX(11)];                                     \
+    (dxdz_sph_i)[SPH_IDX(29)] = (dzdx_sph_i)[SPH_IDX(29)] =                                        \
+        -cast(sph_i, 7.521398046336104) * (sph_i)[SPH_IDX(10)];                                    \
+    (dxdz_sph_i)[SPH_IDX(30)] = (dzdx_sph_i)[SPH_IDX(30)] =                                        \
+        -cast(sph_i, 15.35298947157477) * (sph_i)[SPH_IDX(13)];                                    \
+    (dxdz_sph_i)[SPH_IDX(31)] = (dzdx_sph_i)[SPH_IDX(31)] =                                        \
+        cast(sph_i, 19.42016624910449) * (sph_i)[SPH_IDX(12)] -                                    \
+        cast(sph_i, 7.521398046336104) * (sph_i)[SPH_IDX(14)];                                     \
+    (dxdz_sph_i)[SPH_IDX(32)] = (dzdx_sph_i)[SPH_IDX(32)] =                                        \
+        cast(sph_i, 15.73213272255227) * (sph_i)[SPH_IDX(13)] -                                    \
+        cast(sph_i, 4.06201920231798) * (sph_i)[SPH_IDX(15)];                                      \
+    (dxdz_sph_i)[SPH_IDX(33)] = (dzdx_sph_i)[SPH_IDX(33)] =                                        \
+        cast(sph_i, 16.24807680927192) * (sph_i)[SPH_IDX(14)];                                     \
+    (dxdz_sph_i)[SPH_IDX(34)] = (dzdx_sph_i)[SPH_IDX(34)] =                                        \
+        cast(sph_i, 14.07124727947029) * (sph_i)[SPH_IDX(15)];                                     \
+    (dxdz_sph_i)[SPH_IDX(35)] = (dzdx_sph_i)[SPH_IDX(35)] = cast(sph_i, 0.0);                      \
+                                                                                                   \
+    (dydy_sph_i)[SPH_IDX(25)] = -cast(sph_i, 22.24859546128699) * (sph_i)[SPH_IDX(9)];             \
+    (dydy_sph_i)[SPH_IDX(26)] = -cast(sph_i, 17.23368793961409) * (sph_i)[SPH_IDX(10)];            \
+    (dydy_sph_i)[SPH_IDX(27)] = -cast(sph_i, 6.6332495807108) * (sph_i)[SPH_IDX(9)] -              \
+                                cast(sph_i, 12.84523257866513) * (sph_i)[SPH_IDX(11)];             \
+    (dydy_sph_i)[SPH_IDX(28)] = -cast(sph_i, 9.949874371066199) * (sph_i)[SPH_IDX(10)];            \
+    (dydy_sph_i)[SPH_IDX(29)] = -cast(sph_i, 1.535298947157477) * (sph_i)[SPH_IDX(9)] -            \
+                                cast(sph_i, 17.83856176137207) * (sph_i)[SPH_IDX(11)];             \
+    (dydy_sph_i)[SPH_IDX(30)] = -cast(sph_i, 12.53566341056017) * (sph_i)[SPH_IDX(12)] -           \
+                                cast(sph_i, 4.855041562276122) * (sph_i)[SPH_IDX(14)];             \
+    (dydy_sph_i)[SPH_IDX(31)] = -cast(sph_i, 5.946187253790689) * (sph_i)[SPH_IDX(13)] -           \
+                                cast(sph_i, 1.535298947157477) * (sph_i)[SPH_IDX(15)];             \
+    (dydy_sph_i)[SPH_IDX(32)] = -cast(sph_i, 12.84523257866513) * (sph_i)[SPH_IDX(12)] -           \
+                                cast(sph_i, 9.949874371066199) * (sph_i)[SPH_IDX(14)];             \
+    (dydy_sph_i)[SPH_IDX(33)] = -cast(sph_i, 12.84523257866513) * (sph_i)[SPH_IDX(13)] -           \
+                                cast(sph_i, 6.6332495807108) * (sph_i)[SPH_IDX(15)];               \
+    (dydy_sph_i)[SPH_IDX(34)] = -cast(sph_i, 17.23368793961409) * (sph_i)[SPH_IDX(14)];            \
+    (dydy_sph_i)[SPH_IDX(35)] = -cast(sph_i, 22.24859546128699) * (sph_i)[SPH_IDX(15)];            \
+                                                                                                   \
+    (dydz_sph_i)[SPH_IDX(25)] = (dzdy_sph_i)[SPH_IDX(25)] = cast(sph_i, 0.0);                      \
+    (dydz_sph_i)[SPH_IDX(26)] = (dzdy_sph_i)[SPH_IDX(26)] =                                        \
+        cast(sph_i, 14.07124727947029) * (sph_i)[SPH_IDX(15)];                                     \
+    (dydz_sph_i)[SPH_IDX(27)] = (dzdy_sph_i)[SPH_IDX(27)] =                                        \
+        cast(sph_i, 16.24807680927192) * (sph_i)[SPH_IDX(14)];                                     \
+    (dydz_sph_i)[SPH_IDX(28)] = (dzdy_sph_i)[SPH_IDX(28)] =                                        \
+        cast(sph_i, 15.73213272255227) * (sph_i)[SPH_IDX(13)] +                                    \
+        cast(sph_i, 4.06201920231798) * (sph_i)[SPH_IDX(15)];                                      \
+    (dydz_sph_i)[SPH_IDX(29)] = (dzdy_sph_i)[SPH_IDX(29)] =                                        \
+        cast(sph_i, 19.42016624910449) * (sph_i)[SPH_IDX(12)] +                                    \
+        cast(sph_i, 7.521398046336104) * (sph_i)[SPH_IDX(14)];                                     \
+    (dydz_sph_i)[SPH_IDX(30)] = (dzdy_sph_i)[SPH_IDX(30)] =                                        \
+        -cast(sph_i, 15.35298947157477) * (sph_i)[SPH_IDX(11)];                                    \
+    (dydz_sph_i)[SPH_IDX(31)] = (dzdy_sph_i)[SPH_IDX(31)] =                                        \
+        -cast(sph_i, 7.521398046336104) * (sph_i)[SPH_IDX(10)];                                    \
+    (dydz_sph_i)[SPH_IDX(32)] = (dzdy_sph_i)[SPH_IDX(32)] =                                        \
+        -cast(sph_i, 4.06201920231798) * (sph_i)[SPH_IDX(9)] -                                     \
+        cast(sph_i, 15.73213272255227) * (sph_i)[SPH_IDX(11)];                                     \
+    (dydz_sph_i)[SPH_IDX(33)] = (dzdy_sph_i)[SPH_IDX(33)] =                                        \
+        -cast(sph_i, 16.24807680927192) * (sph_i)[SPH_IDX(10)];                                    \
+    (dydz_sph_i)[SPH_IDX(34)] = (dzdy_sph_i)[SPH_IDX(34)] =                                        \
+        -cast(sph_i, 14.07124727947029) * (sph_i)[SPH_IDX(9)];                                     \
+    (dydz_sph_i)[SPH_IDX(35)] = (dzdy_sph_i)[SPH_IDX(35)] = cast(sph_i, 0.0);                      \
+                                                                                                   \
+    (dzdz_sph_i)[SPH_IDX(25)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(26)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(27)] = cast(sph_i, 13.2664991614216) * (sph_i)[SPH_IDX(9)];               \
+    (dzdz_sph_i)[SPH_IDX(28)] = cast(sph_i, 19.8997487421324) * (sph_i)[SPH_IDX(10)];              \
+    (dzdz_sph_i)[SPH_IDX(29)] = cast(sph_i, 23.78474901516276) * (sph_i)[SPH_IDX(11)];             \
+    (dzdz_sph_i)[SPH_IDX(30)] = cast(sph_i, 25.07132682112035) * (sph_i)[SPH_IDX(12)];             \
+    (dzdz_sph_i)[SPH_IDX(31)] = cast(sph_i, 23.78474901516276) * (sph_i)[SPH_IDX(13)];             \
+    (dzdz_sph_i)[SPH_IDX(32)] = cast(sph_i, 19.8997487421324) * (sph_i)[SPH_IDX(14)];              \
+    (dzdz_sph_i)[SPH_IDX(33)] = cast(sph_i, 13.2664991614216) * (sph_i)[SPH_IDX(15)];              \
+    (dzdz_sph_i)[SPH_IDX(34)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(35)] = cast(sph_i, 0.0);
+
 #define COMPUTE_SPH_L6(x, y, z, x2, y2, z2, sph_i, SPH_IDX)                                         \
     {                                                                                               \
         (sph_i)[SPH_IDX(36)] =                                                                      \
@@ -463,6 +824,175 @@ template <typename T> using remove_pointer_t = typename remove_pointer<T>::type;
         (dz_sph_i)[SPH_IDX(48)] = cast(sph_i, 0.0);                                                  \
     }
 
+#define COMPUTE_SPH_SECOND_DERIVATIVE_L6(                                                          \
+    sph_i,                                                                                         \
+    dxdx_sph_i,                                                                                    \
+    dxdy_sph_i,                                                                                    \
+    dxdz_sph_i,                                                                                    \
+    dydx_sph_i,                                                                                    \
+    dydy_sph_i,                                                                                    \
+    dydz_sph_i,                                                                                    \
+    dzdx_sph_i,                                                                                    \
+    dzdy_sph_i,                                                                                    \
+    dzdz_sph_i,                                                                                    \
+    SPH_IDX                                                                                        \
+)                                                                                                  \
+    (dxdx_sph_i)[SPH_IDX(36)] = cast(sph_i, 32.74904578762563) * (sph_i)[SPH_IDX(16)];             \
+    (dxdx_sph_i)[SPH_IDX(37)] = cast(sph_i, 26.73948391424188) * (sph_i)[SPH_IDX(17)];             \
+    (dxdx_sph_i)[SPH_IDX(38)] = -cast(sph_i, 8.062257748298549) * (sph_i)[SPH_IDX(16)] +           \
+                                cast(sph_i, 21.33072900770154) * (sph_i)[SPH_IDX(18)];             \
+    (dxdx_sph_i)[SPH_IDX(39)] = -cast(sph_i, 12.4899959967968) * (sph_i)[SPH_IDX(17)] +            \
+                                cast(sph_i, 16.5227116418583) * (sph_i)[SPH_IDX(19)];              \
+    (dxdx_sph_i)[SPH_IDX(40)] = cast(sph_i, 1.471960144387974) * (sph_i)[SPH_IDX(16)] -            \
+                                cast(sph_i, 15.57776192739723) * (sph_i)[SPH_IDX(18)];             \
+    (dxdx_sph_i)[SPH_IDX(41)] = cast(sph_i, 3.291402943021917) * (sph_i)[SPH_IDX(17)] -            \
+                                cast(sph_i, 8.708233651742088) * (sph_i)[SPH_IDX(19)];             \
+    (dxdx_sph_i)[SPH_IDX(42)] = -cast(sph_i, 18.02775637731995) * (sph_i)[SPH_IDX(20)] +           \
+                                cast(sph_i, 8.062257748298549) * (sph_i)[SPH_IDX(22)];             \
+    (dxdx_sph_i)[SPH_IDX(43)] = -cast(sph_i, 26.12470095522626) * (sph_i)[SPH_IDX(21)] +           \
+                                cast(sph_i, 3.291402943021917) * (sph_i)[SPH_IDX(23)];             \
+    (dxdx_sph_i)[SPH_IDX(44)] = cast(sph_i, 17.41646730348418) * (sph_i)[SPH_IDX(20)] -            \
+                                cast(sph_i, 15.57776192739723) * (sph_i)[SPH_IDX(22)] +            \
+                                cast(sph_i, 1.471960144387974) * (sph_i)[SPH_IDX(24)];             \
+    (dxdx_sph_i)[SPH_IDX(45)] = cast(sph_i, 16.5227116418583) * (sph_i)[SPH_IDX(21)] -             \
+                                cast(sph_i, 12.4899959967968) * (sph_i)[SPH_IDX(23)];              \
+    (dxdx_sph_i)[SPH_IDX(46)] = cast(sph_i, 21.33072900770154) * (sph_i)[SPH_IDX(22)] -            \
+                                cast(sph_i, 8.062257748298549) * (sph_i)[SPH_IDX(24)];             \
+    (dxdx_sph_i)[SPH_IDX(47)] = cast(sph_i, 26.73948391424188) * (sph_i)[SPH_IDX(23)];             \
+    (dxdx_sph_i)[SPH_IDX(48)] = cast(sph_i, 32.74904578762563) * (sph_i)[SPH_IDX(24)];             \
+                                                                                                   \
+    (dxdy_sph_i)[SPH_IDX(36)] = (dydx_sph_i)[SPH_IDX(36)] =                                        \
+        cast(sph_i, 32.74904578762563) * (sph_i)[SPH_IDX(24)];                                     \
+    (dxdy_sph_i)[SPH_IDX(37)] = (dydx_sph_i)[SPH_IDX(37)] =                                        \
+        cast(sph_i, 26.73948391424188) * (sph_i)[SPH_IDX(23)];                                     \
+    (dxdy_sph_i)[SPH_IDX(38)] = (dydx_sph_i)[SPH_IDX(38)] =                                        \
+        cast(sph_i, 21.33072900770154) * (sph_i)[SPH_IDX(22)];                                     \
+    (dxdy_sph_i)[SPH_IDX(39)] = (dydx_sph_i)[SPH_IDX(39)] =                                        \
+        cast(sph_i, 16.5227116418583) * (sph_i)[SPH_IDX(21)];                                      \
+    (dxdy_sph_i)[SPH_IDX(40)] = (dydx_sph_i)[SPH_IDX(40)] =                                        \
+        cast(sph_i, 17.41646730348418) * (sph_i)[SPH_IDX(20)] -                                    \
+        cast(sph_i, 1.471960144387974) * (sph_i)[SPH_IDX(24)];                                     \
+    (dxdy_sph_i)[SPH_IDX(41)] = (dydx_sph_i)[SPH_IDX(41)] =                                        \
+        -cast(sph_i, 8.708233651742088) * (sph_i)[SPH_IDX(21)] -                                   \
+        cast(sph_i, 3.291402943021917) * (sph_i)[SPH_IDX(23)];                                     \
+    (dxdy_sph_i)[SPH_IDX(42)] = (dydx_sph_i)[SPH_IDX(42)] =                                        \
+        cast(sph_i, 8.062257748298549) * (sph_i)[SPH_IDX(18)];                                     \
+    (dxdy_sph_i)[SPH_IDX(43)] = (dydx_sph_i)[SPH_IDX(43)] =                                        \
+        cast(sph_i, 3.291402943021917) * (sph_i)[SPH_IDX(17)] -                                    \
+        cast(sph_i, 8.708233651742088) * (sph_i)[SPH_IDX(19)];                                     \
+    (dxdy_sph_i)[SPH_IDX(44)] = (dydx_sph_i)[SPH_IDX(44)] =                                        \
+        cast(sph_i, 1.471960144387974) * (sph_i)[SPH_IDX(16)];                                     \
+    (dxdy_sph_i)[SPH_IDX(45)] = (dydx_sph_i)[SPH_IDX(45)] =                                        \
+        -cast(sph_i, 16.5227116418583) * (sph_i)[SPH_IDX(19)];                                     \
+    (dxdy_sph_i)[SPH_IDX(46)] = (dydx_sph_i)[SPH_IDX(46)] =                                        \
+        -cast(sph_i, 21.33072900770154) * (sph_i)[SPH_IDX(18)];                                    \
+    (dxdy_sph_i)[SPH_IDX(47)] = (dydx_sph_i)[SPH_IDX(47)] =                                        \
+        -cast(sph_i, 26.73948391424188) * (sph_i)[SPH_IDX(17)];                                    \
+    (dxdy_sph_i)[SPH_IDX(48)] = (dydx_sph_i)[SPH_IDX(48)] =                                        \
+        -cast(sph_i, 32.74904578762563) * (sph_i)[SPH_IDX(16)];                                    \
+                                                                                                   \
+    (dxdz_sph_i)[SPH_IDX(36)] = (dzdx_sph_i)[SPH_IDX(36)] = cast(sph_i, 0.0);                      \
+    (dxdz_sph_i)[SPH_IDX(37)] = (dzdx_sph_i)[SPH_IDX(37)] =                                        \
+        cast(sph_i, 18.90767040118904) * (sph_i)[SPH_IDX(16)];                                     \
+    (dxdz_sph_i)[SPH_IDX(38)] = (dzdx_sph_i)[SPH_IDX(38)] =                                        \
+        cast(sph_i, 22.80350850198276) * (sph_i)[SPH_IDX(17)];                                     \
+    (dxdz_sph_i)[SPH_IDX(39)] = (dzdx_sph_i)[SPH_IDX(39)] =                                        \
+        -cast(sph_i, 4.415880433163924) * (sph_i)[SPH_IDX(16)] +                                   \
+        cast(sph_i, 23.36664289109585) * (sph_i)[SPH_IDX(18)];                                     \
+    (dxdz_sph_i)[SPH_IDX(40)] = (dzdx_sph_i)[SPH_IDX(40)] =                                        \
+        -cast(sph_i, 8.32666399786453) * (sph_i)[SPH_IDX(17)] +                                    \
+        cast(sph_i, 22.03028218914441) * (sph_i)[SPH_IDX(19)];                                     \
+    (dxdz_sph_i)[SPH_IDX(41)] = (dzdx_sph_i)[SPH_IDX(41)] =                                        \
+        -cast(sph_i, 12.31530213460744) * (sph_i)[SPH_IDX(18)];                                    \
+    (dxdz_sph_i)[SPH_IDX(42)] = (dzdx_sph_i)[SPH_IDX(42)] =                                        \
+        -cast(sph_i, 22.80350850198276) * (sph_i)[SPH_IDX(21)];                                    \
+    (dxdz_sph_i)[SPH_IDX(43)] = (dzdx_sph_i)[SPH_IDX(43)] =                                        \
+        cast(sph_i, 27.53785273643051) * (sph_i)[SPH_IDX(20)] -                                    \
+        cast(sph_i, 12.31530213460744) * (sph_i)[SPH_IDX(22)];                                     \
+    (dxdz_sph_i)[SPH_IDX(44)] = (dzdx_sph_i)[SPH_IDX(44)] =                                        \
+        cast(sph_i, 22.03028218914441) * (sph_i)[SPH_IDX(21)] -                                    \
+        cast(sph_i, 8.32666399786453) * (sph_i)[SPH_IDX(23)];                                      \
+    (dxdz_sph_i)[SPH_IDX(45)] = (dzdx_sph_i)[SPH_IDX(45)] =                                        \
+        cast(sph_i, 23.36664289109585) * (sph_i)[SPH_IDX(22)] -                                    \
+        cast(sph_i, 4.415880433163924) * (sph_i)[SPH_IDX(24)];                                     \
+    (dxdz_sph_i)[SPH_IDX(46)] = (dzdx_sph_i)[SPH_IDX(46)] =                                        \
+        cast(sph_i, 22.80350850198276) * (sph_i)[SPH_IDX(23)];                                     \
+    (dxdz_sph_i)[SPH_IDX(47)] = (dzdx_sph_i)[SPH_IDX(47)] =                                        \
+        cast(sph_i, 18.90767040118904) * (sph_i)[SPH_IDX(24)];                                     \
+    (dxdz_sph_i)[SPH_IDX(48)] = (dzdx_sph_i)[SPH_IDX(48)] = cast(sph_i, 0.0);                      \
+                                                                                                   \
+    (dydy_sph_i)[SPH_IDX(36)] = -cast(sph_i, 32.74904578762563) * (sph_i)[SPH_IDX(16)];            \
+    (dydy_sph_i)[SPH_IDX(37)] = -cast(sph_i, 26.73948391424188) * (sph_i)[SPH_IDX(17)];            \
+    (dydy_sph_i)[SPH_IDX(38)] = -cast(sph_i, 8.062257748298549) * (sph_i)[SPH_IDX(16)] -           \
+                                cast(sph_i, 21.33072900770154) * (sph_i)[SPH_IDX(18)];             \
+    (dydy_sph_i)[SPH_IDX(39)] = -cast(sph_i, 12.4899959967968) * (sph_i)[SPH_IDX(17)] -            \
+                                cast(sph_i, 16.5227116418583) * (sph_i)[SPH_IDX(19)];              \
+    (dydy_sph_i)[SPH_IDX(40)] = -cast(sph_i, 1.471960144387974) * (sph_i)[SPH_IDX(16)] -           \
+                                cast(sph_i, 15.57776192739723) * (sph_i)[SPH_IDX(18)];             \
+    (dydy_sph_i)[SPH_IDX(41)] = -cast(sph_i, 3.291402943021917) * (sph_i)[SPH_IDX(17)] -           \
+                                cast(sph_i, 26.12470095522626) * (sph_i)[SPH_IDX(19)];             \
+    (dydy_sph_i)[SPH_IDX(42)] = -cast(sph_i, 18.02775637731995) * (sph_i)[SPH_IDX(20)] -           \
+                                cast(sph_i, 8.062257748298549) * (sph_i)[SPH_IDX(22)];             \
+    (dydy_sph_i)[SPH_IDX(43)] = -cast(sph_i, 8.708233651742088) * (sph_i)[SPH_IDX(21)] -           \
+                                cast(sph_i, 3.291402943021917) * (sph_i)[SPH_IDX(23)];             \
+    (dydy_sph_i)[SPH_IDX(44)] = -cast(sph_i, 17.41646730348418) * (sph_i)[SPH_IDX(20)] -           \
+                                cast(sph_i, 15.57776192739723) * (sph_i)[SPH_IDX(22)] -            \
+                                cast(sph_i, 1.471960144387974) * (sph_i)[SPH_IDX(24)];             \
+    (dydy_sph_i)[SPH_IDX(45)] = -cast(sph_i, 16.5227116418583) * (sph_i)[SPH_IDX(21)] -            \
+                                cast(sph_i, 12.4899959967968) * (sph_i)[SPH_IDX(23)];              \
+    (dydy_sph_i)[SPH_IDX(46)] = -cast(sph_i, 21.33072900770154) * (sph_i)[SPH_IDX(22)] -           \
+                                cast(sph_i, 8.062257748298549) * (sph_i)[SPH_IDX(24)];             \
+    (dydy_sph_i)[SPH_IDX(47)] = -cast(sph_i, 26.73948391424188) * (sph_i)[SPH_IDX(23)];            \
+    (dydy_sph_i)[SPH_IDX(48)] = -cast(sph_i, 32.74904578762563) * (sph_i)[SPH_IDX(24)];            \
+                                                                                                   \
+    (dydz_sph_i)[SPH_IDX(36)] = (dzdy_sph_i)[SPH_IDX(36)] = cast(sph_i, 0.0);                      \
+    (dydz_sph_i)[SPH_IDX(37)] = (dzdy_sph_i)[SPH_IDX(37)] =                                        \
+        cast(sph_i, 18.90767040118904) * (sph_i)[SPH_IDX(24)];                                     \
+    (dydz_sph_i)[SPH_IDX(38)] = (dzdy_sph_i)[SPH_IDX(38)] =                                        \
+        cast(sph_i, 22.80350850198276) * (sph_i)[SPH_IDX(23)];                                     \
+    (dydz_sph_i)[SPH_IDX(39)] = (dzdy_sph_i)[SPH_IDX(39)] =                                        \
+        cast(sph_i, 23.36664289109585) * (sph_i)[SPH_IDX(22)] +                                    \
+        cast(sph_i, 4.415880433163924) * (sph_i)[SPH_IDX(24)];                                     \
+    (dydz_sph_i)[SPH_IDX(40)] = (dzdy_sph_i)[SPH_IDX(40)] =                                        \
+        cast(sph_i, 22.03028218914441) * (sph_i)[SPH_IDX(21)] +                                    \
+        cast(sph_i, 8.32666399786453) * (sph_i)[SPH_IDX(23)];                                      \
+    (dydz_sph_i)[SPH_IDX(41)] = (dzdy_sph_i)[SPH_IDX(41)] =                                        \
+        cast(sph_i, 27.53785273643051) * (sph_i)[SPH_IDX(20)] +                                    \
+        cast(sph_i, 12.31530213460744) * (sph_i)[SPH_IDX(22)];                                     \
+    (dydz_sph_i)[SPH_IDX(42)] = (dzdy_sph_i)[SPH_IDX(42)] =                                        \
+        -cast(sph_i, 22.80350850198276) * (sph_i)[SPH_IDX(19)];                                    \
+    (dydz_sph_i)[SPH_IDX(43)] = (dzdy_sph_i)[SPH_IDX(43)] =                                        \
+        -cast(sph_i, 12.31530213460744) * (sph_i)[SPH_IDX(18)];                                    \
+    (dydz_sph_i)[SPH_IDX(44)] = (dzdy_sph_i)[SPH_IDX(44)] =                                        \
+        -cast(sph_i, 8.32666399786453) * (sph_i)[SPH_IDX(17)] -                                    \
+        cast(sph_i, 22.03028218914441) * (sph_i)[SPH_IDX(19)];                                     \
+    (dydz_sph_i)[SPH_IDX(45)] = (dzdy_sph_i)[SPH_IDX(45)] =                                        \
+        -cast(sph_i, 4.415880433163924) * (sph_i)[SPH_IDX(16)] -                                   \
+        cast(sph_i, 23.36664289109585) * (sph_i)[SPH_IDX(18)];                                     \
+    (dydz_sph_i)[SPH_IDX(46)] = (dzdy_sph_i)[SPH_IDX(46)] =                                        \
+        -cast(sph_i, 22.80350850198276) * (sph_i)[SPH_IDX(17)];                                    \
+    (dydz_sph_i)[SPH_IDX(47)] = (dzdy_sph_i)[SPH_IDX(47)] =                                        \
+        -cast(sph_i, 18.90767040118904) * (sph_i)[SPH_IDX(16)];                                    \
+    (dydz_sph_i)[SPH_IDX(48)] = (dzdy_sph_i)[SPH_IDX(48)] = cast(sph_i, 0.0);                      \
+                                                                                                   \
+    (dzdz_sph_i)[SPH_IDX(36)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(37)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(38)] = cast(sph_i, 16.1245154965971) * (sph_i)[SPH_IDX(16)];              \
+    (dzdz_sph_i)[SPH_IDX(39)] = cast(sph_i, 24.97999199359359) * (sph_i)[SPH_IDX(17)];             \
+    (dzdz_sph_i)[SPH_IDX(40)] = cast(sph_i, 31.15552385479446) * (sph_i)[SPH_IDX(18)];             \
+    (dzdz_sph_i)[SPH_IDX(41)] = cast(sph_i, 34.83293460696835) * (sph_i)[SPH_IDX(19)];             \
+    (dzdz_sph_i)[SPH_IDX(42)] = cast(sph_i, 36.05551275463989) * (sph_i)[SPH_IDX(20)];             \
+    (dzdz_sph_i)[SPH_IDX(43)] = cast(sph_i, 34.83293460696835) * (sph_i)[SPH_IDX(21)];             \
+    (dzdz_sph_i)[SPH_IDX(44)] = cast(sph_i, 31.15552385479446) * (sph_i)[SPH_IDX(22)];             \
+    (dzdz_sph_i)[SPH_IDX(45)] = cast(sph_i, 24.97999199359359) * (sph_i)[SPH_IDX(23)];             \
+    (dzdz_sph_i)[SPH_IDX(46)] = cast(sph_i, 16.1245154965971) * (sph_i)[SPH_IDX(24)];              \
+    (dzdz_sph_i)[SPH_IDX(47)] = cast(sph_i, 0.0);                                                  \
+    (dzdz_sph_i)[SPH_IDX(48)] = cast(sph_i, 0.0);
+
+// BEGIN GENERATED CODE
+// The code below is generated by scripts/generate-hardcoded-macros.py, do not
+// modify it by hand.
+
 /*
 Combines the macro hard-coded Ylm calculators to get all the terms up to a
 given value. Macro version. This uses if constexpr to decide at compile time
@@ -568,6 +1098,83 @@ which macro(s) should be called
             dzdz_sph_i,                                                                            \
             SPH_IDX                                                                                \
         );                                                                                         \
+    }                                                                                              \
+    if constexpr (HARDCODED_LMAX > 1) {                                                            \
+        COMPUTE_SPH_SECOND_DERIVATIVE_L2(                                                          \
+            sph_i,                                                                                 \
+            dxdx_sph_i,                                                                            \
+            dxdy_sph_i,                                                                            \
+            dxdz_sph_i,                                                                            \
+            dydx_sph_i,                                                                            \
+            dydy_sph_i,                                                                            \
+            dydz_sph_i,                                                                            \
+            dzdx_sph_i,                                                                            \
+            dzdy_sph_i,                                                                            \
+            dzdz_sph_i,                                                                            \
+            SPH_IDX                                                                                \
+        );                                                                                         \
+    }                                                                                              \
+    if constexpr (HARDCODED_LMAX > 2) {                                                            \
+        COMPUTE_SPH_SECOND_DERIVATIVE_L3(                                                          \
+            sph_i,                                                                                 \
+            dxdx_sph_i,                                                                            \
+            dxdy_sph_i,                                                                            \
+            dxdz_sph_i,                                                                            \
+            dydx_sph_i,                                                                            \
+            dydy_sph_i,                                                                            \
+            dydz_sph_i,                                                                            \
+            dzdx_sph_i,                                                                            \
+            dzdy_sph_i,                                                                            \
+            dzdz_sph_i,                                                                            \
+            SPH_IDX                                                                                \
+        );                                                                                         \
+    }                                                                                              \
+    if constexpr (HARDCODED_LMAX > 3) {                                                            \
+        COMPUTE_SPH_SECOND_DERIVATIVE_L4(                                                          \
+            sph_i,                                                                                 \
+            dxdx_sph_i,                                                                            \
+            dxdy_sph_i,                                                                            \
+            dxdz_sph_i,                                                                            \
+            dydx_sph_i,                                                                            \
+            dydy_sph_i,                                                                            \
+            dydz_sph_i,                                                                            \
+            dzdx_sph_i,                                                                            \
+            dzdy_sph_i,                                                                            \
+            dzdz_sph_i,                                                                            \
+            SPH_IDX                                                                                \
+        );                                                                                         \
+    }                                                                                              \
+    if constexpr (HARDCODED_LMAX > 4) {                                                            \
+        COMPUTE_SPH_SECOND_DERIVATIVE_L5(                                                          \
+            sph_i,                                                                                 \
+            dxdx_sph_i,                                                                            \
+            dxdy_sph_i,                                                                            \
+            dxdz_sph_i,                                                                            \
+            dydx_sph_i,                                                                            \
+            dydy_sph_i,                                                                            \
+            dydz_sph_i,                                                                            \
+            dzdx_sph_i,                                                                            \
+            dzdy_sph_i,                                                                            \
+            dzdz_sph_i,                                                                            \
+            SPH_IDX                                                                                \
+        );                                                                                         \
+    }                                                                                              \
+    if constexpr (HARDCODED_LMAX > 5) {                                                            \
+        COMPUTE_SPH_SECOND_DERIVATIVE_L6(                                                          \
+            sph_i,                                                                                 \
+            dxdx_sph_i,                                                                            \
+            dxdy_sph_i,                                                                            \
+            dxdz_sph_i,                                                                            \
+            dydx_sph_i,                                                                            \
+            dydy_sph_i,                                                                            \
+            dydz_sph_i,                                                                            \
+            dzdx_sph_i,                                                                            \
+            dzdy_sph_i,                                                                            \
+            dzdz_sph_i,                                                                            \
+            SPH_IDX                                                                                \
+        );                                                                                         \
     }
 
+// END GENERATED CODE
+
 #endif
@@ -0,0 +1,187 @@
+#ifndef SPHERICART_PARALLEL_HPP
+#define SPHERICART_PARALLEL_HPP
+
+/*
+    Parallel backends, used by the CPU calculators to distribute the points
+    of an array over several threads. The calculators use OpenMP by default,
+    and a different backend can be given to their constructor to share the
+    cores with other threading runtimes used in the same process.
+
+    This header must be included outside of any namespace before the
+    templates, since the same types are shared by the kernels compiled for
+    all the instruction sets.
+*/
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace sphericart {
+
+/**
+ * A non-owning reference to the function executed by each worker of a
+ * `ParallelBackend`, which is called as `task(worker, n_workers)`.
+ */
+class ParallelTask {
+  public:
+    template <typename F>
+    ParallelTask(const F& function)
+        : data(&function), call([](const void* data, size_t worker, size_t n_workers) {
+              (*static_cast<const F*>(data))(worker, n_workers);
+          }) {}
+
+    void operator()(size_t worker, size_t n_workers) const {
+        this->call(this->data, worker, n_workers);
+    }
+
+  private:
+    const void* data;
+    void (*call)(const void*, size_t, size_t);
+};
+
+/**
+ * A way of running the work of a calculator on several threads.
+ *
+ * The calculators split their work in as many parts as there are workers,
+ * and each worker uses its own slice of the scratch buffers, identified by its
+ * index rather than by the thread running it. Backends are chosen when
+ * creating a calculator, and are shared with its clones.
+ */
+class ParallelBackend {
+  public:
+    virtual ~ParallelBackend() = default;
+
+    /**
+     * Returns the largest number of workers that `run()` can currently use.
+     * The calculators allocate scratch memory for this many workers when
+     * they are created, and never ask `run()` for more.
+     */
+    virtual size_t max_workers() const = 0;
+
+    /**
+     * Calls `task(worker, n_workers)` once for each `worker` in
+     * `[0, n_workers)`, where `n_workers` is chosen by the backend and is at
+     * most `max_workers` (and `max_workers()`), and returns when all the
+     * calls have finished. The calls can run at the same time on different
+     * threads.
+     */
+    virtual void run(size_t max_workers, ParallelTask task) = 0;
+};
+
+/**
+ * Controls how many workers the calculators use for a given array of points.
+ * Waking up the workers of a backend has a fixed cost, which is larger than
+ * the work itself for small arrays (e.g. the neighbours of a single atom), so
+ * the calculators only use several workers when each of them has enough work.
+ *
+ * The work of a call is counted as the number of values it computes, i.e.
+ * `n_samples x (l_max + 1)^2` times 1 for the spherical harmonics alone, 4
+ * with their gradients and 13 with their Hessians. The defaults are
+ * estimates which have not been calibrated: the "parallel crossover" section
+ * of the C++ benchmark (`benchmarks/cpp/benchmark.cpp`) reports the amount of
+ * work from which the parallel evaluation is faster on a given machine, and
+ * should be used to choose the thresholds.
+ *
+ * There is no separate chunk size. In the array calls, each worker computes
+ * a single contiguous range of points, so that
+ * `SphericalHarmonics::first_touch()` can place the outputs of each worker in
+ * its own memory, and `min_work_per_worker` bounds the size of these ranges
+ * from below by limiting the number of workers. Only `compute_density()`
+ * hands out small chunks of centres, since their number of neighbours
+ * varies.
+ */
+struct ParallelThresholds {
+    /** Calls with less work than this run serially on the calling thread,
+     * without going through the parallel backend. */
+    size_t serial_below = 16384;
+    /** Smallest amount of work given to each worker in parallel calls: the
+     * points are split in at most `work / min_work_per_worker` chunks, one
+     * for each worker. Set this to 0 (together with `serial_below`) to always
+     * use all the workers. */
+    size_t min_work_per_worker = 4096;
+};
+
+/**
+ * Returns true if the calling thread is running inside of a parallel region:
+ * an active OpenMP parallel region (e.g. when the calculators are used from
+ * the `#pragma omp parallel` loop of an application), or a task of a
+ * `thread_pool_backend()`, `tbb_backend()` or `caller_backend()`. The
+ * OpenMP and thread pool backends run serially in this case, and
+ * calls without a `Workspace` use memory private to the calling thread.
+ */
+bool in_parallel_region();
+
+/**
+ * Returns the default backend, which runs the workers in an OpenMP parallel
+ * region with up to `omp_get_max_threads()` threads. Without OpenMP, or when
+ * called from inside an active OpenMP parallel region, this runs all the work
+ * on the calling thread instead of starting a nested team.
+ */
+std::shared_ptr<ParallelBackend> openmp_backend();
+
+/**
+ * Returns a backend running all the work on the calling thread.
+ */
+std::shared_ptr<ParallelBackend> serial_backend();
+
+/**
+ * How the threads of a `thread_pool_backend()` are pinned to the CPUs
+ * available to the process. Consecutive workers, which compute consecutive
+ * ranges of points, are kept on the same socket, and the workers are spread
+ * evenly over the sockets. Pinning is only supported on Linux, and ignored
+ * elsewhere.
+ */
+enum class ThreadPinning {
+    /** The threads are not pinned, and can be moved by the operating system.
+     *  This is the default. */
+    NONE,
+    /** Each worker is pinned to a single CPU. */
+    CORES,
+    /** Each worker is pinned to all the CPUs of one socket, and can move
+     *  between them. */
+    SOCKETS,
+};
+
+/**
+ * Creates a backend with its own pool of `n_threads - 1` persistent threads,
+ * the calling thread acting as the first worker. Calls from different
+ * threads are run one after the other, and calls from inside a running
+ * task are run serially on the calling thread.
+ *
+ * With a `pinning` other than `ThreadPinning::NONE`, the calling thread is
+ * pinned to the CPUs of the first worker while it takes part in a call, and
+ * gets its previous affinity back afterwards. Together with
+ * `SphericalHarmonics::allocate_outputs()` or
+ * `SphericalHarmonics::first_touch()`, this keeps the outputs computed by
+ * each worker in the memory of its own socket on NUMA machines.
+ */
+std::shared_ptr<ParallelBackend> thread_pool_backend(
+    size_t n_threads, ThreadPinning pinning = ThreadPinning::NONE
+);
+
+/**
+ * Returns a backend running the workers as tasks of the oneTBB scheduler, so
+ * that they share the threads of the process-wide TBB arena. This is only
+ * available if sphericart was compiled with `SPHERICART_ENABLE_TBB`, and
+ * throws `std::runtime_error` otherwise.
+ */
+std::shared_ptr<ParallelBackend> tbb_backend();
+
+/**
+ * Function executing `n_tasks` independent tasks by calling `run_task(i)`
+ * for each `i` in `[0, n_tasks)`, in any order and on any threads, and
+ * returning once all of them have finished.
+ */
+using ParallelExecutor =
+    std::function<void(size_t n_tasks, const std::function<void(size_t)>& run_task)>;
+
+/**
+ * Creates a backend handing the work of the calculators to `executor` as
+ * `n_workers` independent chunks, so that they can be run by an external
+ * scheduler (e.g. the task system of a simulation engine).
+ */
+std::shared_ptr<ParallelBackend> caller_backend(size_t n_workers, ParallelExecutor executor);
+
+} // namespace sphericart
+
+#endif
@@ -28,6 +28,9 @@ using sphericart_spherical_harmonics_calculator_t = sphericart::SphericalHarmoni
 using sphericart_spherical_harmonics_calculator_f_t = sphericart::SphericalHarmonics<float>;
 using sphericart_solid_harmonics_calculator_t = sphericart::SolidHarmonics<double>;
 using sphericart_solid_harmonics_calculator_f_t = sphericart::SolidHarmonics<float>;
+using sphericart_workspace_t = sphericart::Workspace<double>;
+using sphericart_workspace_f_t = sphericart::Workspace<float>;
+using sphericart_future_t = std::future<void>;
 
 extern "C" {
 
@@ -80,8 +83,61 @@ struct sphericart_solid_harmonics_calculator_f_t;
  * A type referring to the `sphericart_solid_harmonics_calculator_f_t` struct.
  */
 typedef struct sphericart_solid_harmonics_calculator_f_t sphericart_solid_harmonics_calculator_f_t;
+
+/**
+ * Opaque type to hold the scratch memory used by one thread when calling the
+ * reentrant (`_r`) compute functions. See `sphericart::Workspace` in the C++
+ * API for a full description.
+ *
+ * The `sphericart_workspace_t` can be used with the `double` calculators.
+ */
+struct sphericart_workspace_t;
+
+/**
+ * A type referring to the `sphericart_workspace_t` struct.
+ */
+typedef struct sphericart_workspace_t sphericart_workspace_t;
+
+/**
+ * Similar to `sphericart_workspace_t`, but used with the `float` calculators.
+ */
+struct sphericart_workspace_f_t;
+
+/**
+ * A type referring to the `sphericart_workspace_f_t` struct.
+ */
+typedef struct sphericart_workspace_f_t sphericart_workspace_f_t;
+
+/**
+ * Opaque type referring to an asynchronous calculation started by one of the
+ * `_async` compute functions.
+ */
+struct sphericart_future_t;
+
+/**
+ * A type referring to the `sphericart_future_t` struct.
+ */
+typedef struct sphericart_future_t sphericart_future_t;
 #endif
 
+/**
+ * Memory layouts of the outputs of the calculators. See `sphericart::Layout`
+ * in the C++ API for a full description.
+ */
+typedef enum {
+    /** `sph`, `dsph` and `ddsph` have shapes `n_samples x (l_max + 1)^2`,
+     *  `n_samples x 3 x (l_max + 1)^2` and `n_samples x 9 x (l_max + 1)^2`.
+     *  This is the layout used by calculators created with the `_new`
+     *  functions. */
+    SPHERICART_LAYOUT_SAMPLE_MAJOR = 0,
+    /** `sph`, `dsph` and `ddsph` have shapes `(l_max + 1)^2 x n_samples`,
+     *  `3 x (l_max + 1)^2 x n_samples` and `9 x (l_max + 1)^2 x n_samples` */
+    SPHERICART_LAYOUT_LM_MAJOR = 1,
+    /** `sph`, `dsph` and `ddsph` have shapes `n_samples x (l_max + 1)^2`,
+     *  `n_samples x (l_max + 1)^2 x 3` and `n_samples x (l_max + 1)^2 x 9` */
+    SPHERICART_LAYOUT_XYZ_INNERMOST = 2,
+} sphericart_layout_t;
+
 /**
  * Initializes a spherical harmonics calculator and returns a pointer that
  * can then be used by functions that evaluate spherical harmonics over
@@ -90,7 +146,8 @@ typedef struct sphericart_solid_harmonics_calculator_f_t sphericart_solid_harmon
  *  @param l_max The maximum degree of the spherical harmonics to be
  * calculated.
  *
- *  @return A pointer to a `sphericart_spherical_harmonics_calculator_t` object
+ *  @return A pointer to a `sphericart_spherical_harmonics_calculator_t` object, or `NULL` if
+ *  the calculator could not be created
  *
  */
 SPHERICART_EXPORT sphericart_spherical_harmonics_calculator_t* sphericart_spherical_harmonics_new(
@@ -105,6 +162,29 @@ SPHERICART_EXPORT sphericart_spherical_harmonics_calculator_f_t* sphericart_sphe
     size_t l_max
 );
 
+/**
+ * Similar to `sphericart_spherical_harmonics_new`, but the calculator stores
+ * its outputs in the given memory layout instead of the default sample-major
+ * one. The `_length` parameters of the compute functions are unchanged.
+ *
+ *  @param l_max The maximum degree of the spherical harmonics to be
+ * calculated.
+ *  @param layout The memory layout of the outputs.
+ *
+ *  @return A pointer to a `sphericart_spherical_harmonics_calculator_t` object, or `NULL` if
+ *  the calculator could not be created
+ */
+SPHERICART_EXPORT sphericart_spherical_harmonics_calculator_t*
+sphericart_spherical_harmonics_new_with_layout(size_t l_max, sphericart_layout_t layout);
+
+/**
+ * Similar to `sphericart_spherical_harmonics_new_with_layout`, but it returns
+ * a `sphericart_spherical_harmonics_calculator_f_t`, which performs
+ * calculations on the `float` type.
+ */
+SPHERICART_EXPORT sphericart_spherical_harmonics_calculator_f_t*
+sphericart_spherical_harmonics_new_with_layout_f(size_t l_max, sphericart_layout_t layout);
+
 /**
  * Deletes a previously allocated `sphericart_spherical_harmonics_calculator_t` calculator.
  */
@@ -262,6 +342,330 @@ SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_with_hessian
     size_t ddsph_length
 );
 
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array`, but it
+ * stores the spherical harmonics of each degree l in a separate array, which
+ * can then be used without copies.
+ *
+ * @param calculator A pointer to a `sphericart_spherical_harmonics_calculator_t`
+ *        struct that holds prefactors and options to compute the spherical
+ *        harmonics.
+ * @param xyz An array of size `n_samples x 3` with the Cartesian coordinates
+ *        of the 3D points, as in :func:`sphericart_spherical_harmonics_compute_array`.
+ * @param xyz_length size of the xyz allocation, i.e, `3 x n_samples`
+ * @param sph an array of `l_max + 1` pointers. `sph[l]` should point to the
+ *        first element of an array containing `n_samples x (2 l + 1)`
+ *        elements. On exit, this array will contain the spherical harmonics
+ *        of degree l, with `m = -l, ..., l` along the inner dimension (or as
+ *        the full output would be arranged, for calculators created with a
+ *        non-default layout).
+ * @param n_blocks the number of pointers in `sph`, which should be `l_max + 1`
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_per_l(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* const* sph,
+    size_t n_blocks
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_gradients`,
+ * but it stores the outputs of each degree l in separate arrays, as in
+ * :func:`sphericart_spherical_harmonics_compute_array_per_l`. `dsph[l]` should
+ * point to an array of `n_samples x 3 x (2 l + 1)` elements.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_per_l_with_gradients(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* const* sph,
+    double* const* dsph,
+    size_t n_blocks
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_hessians`,
+ * but it stores the outputs of each degree l in separate arrays, as in
+ * :func:`sphericart_spherical_harmonics_compute_array_per_l`. `dsph[l]` should
+ * point to an array of `n_samples x 3 x (2 l + 1)` elements, and `ddsph[l]`
+ * to an array of `n_samples x 9 x (2 l + 1)` elements.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_per_l_with_hessians(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* const* sph,
+    double* const* dsph,
+    double* const* ddsph,
+    size_t n_blocks
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array`, but it reads
+ * the coordinates from a strided array and writes the spherical harmonics to
+ * an array with padded rows, e.g. to use an array of structures or a column
+ * slice of a larger array without copies.
+ *
+ * @param calculator A pointer to a `sphericart_spherical_harmonics_calculator_t`
+ *        struct that holds prefactors and options to compute the spherical
+ *        harmonics.
+ * @param xyz pointer to the x coordinate of the first point. The x, y and z
+ *        coordinates of point `i` are stored at `xyz[i * xyz_stride]`,
+ *        `xyz[i * xyz_stride + 1]` and `xyz[i * xyz_stride + 2]`.
+ * @param n_samples the number of points
+ * @param xyz_stride the distance (in number of elements) between the
+ *        coordinates of consecutive points, at least 3
+ * @param sph pointer to the first element of the output array. On exit, it
+ *        will contain the spherical harmonics as in
+ *        :func:`sphericart_spherical_harmonics_compute_array`, with
+ *        consecutive rows (samples, or spherical harmonics for calculators
+ *        using `SPHERICART_LAYOUT_LM_MAJOR`) starting `sph_stride` elements
+ *        apart.
+ * @param sph_stride the distance (in number of elements) between consecutive
+ *        rows of `sph`, at least as large as a row
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_strided(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_gradients`,
+ * but it uses strided arrays as in
+ * :func:`sphericart_spherical_harmonics_compute_array_strided`. Consecutive
+ * rows of `dsph` (samples, or pairs of a Cartesian direction and a spherical
+ * harmonic for `SPHERICART_LAYOUT_LM_MAJOR`) start `dsph_stride` elements
+ * apart.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_strided_with_gradients(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride,
+    double* dsph,
+    size_t dsph_stride
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_hessians`,
+ * but it uses strided arrays as in
+ * :func:`sphericart_spherical_harmonics_compute_array_strided_with_gradients`.
+ * Consecutive rows of `ddsph` start `ddsph_stride` elements apart.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_strided_with_hessians(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride,
+    double* dsph,
+    size_t dsph_stride,
+    double* ddsph,
+    size_t ddsph_stride
+);
+
+/**
+ * This function computes the coefficients of the expansion of atom-centred
+ * densities on the spherical harmonics, `c[i, n, lm] = sum_j R[j, n] Y_lm(r_ij)`,
+ * where the sum runs over the neighbours `j` of each centre `i`. The spherical
+ * harmonics of the pairs are never stored.
+ *
+ * @param calculator A pointer to a `sphericart_spherical_harmonics_calculator_t`
+ *        struct that holds prefactors and options to compute the spherical
+ *        harmonics.
+ * @param xyz An array of size `n_pairs x 3` with the vectors from each centre
+ *        to its neighbours. The pairs of each centre must be contiguous, and
+ *        stored in the same order as the centres.
+ * @param xyz_length size of the xyz allocation, i.e, `3 x n_pairs`
+ * @param radial An array of size `n_pairs x n_radial` with the radial weights
+ *        of each pair.
+ * @param n_radial the number of radial weights for each pair
+ * @param centre_offsets An array of `n_centres + 1` offsets, in compressed
+ *        sparse row format: the pairs of centre `i` go from
+ *        `centre_offsets[i]` to `centre_offsets[i + 1]` (excluded).
+ * @param n_centres the number of centres
+ * @param coefficients pointer to the first element of an array containing
+ *        `n_centres x n_radial x (l_max + 1)^2` elements. On exit, it will
+ *        contain the expansion coefficients of each centre, with the
+ *        spherical harmonics in lexicographic order along the last dimension.
+ * @param coefficients_length size of the coefficients allocation
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_density(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* radial,
+    size_t n_radial,
+    const size_t* centre_offsets,
+    size_t n_centres,
+    double* coefficients,
+    size_t coefficients_length
+);
+
+/**
+ * This function computes the vector-Jacobian product of the spherical
+ * harmonics, i.e. the gradient of a scalar function of the spherical harmonics
+ * with respect to `xyz`, from its gradient `sph_grad` with respect to the
+ * spherical harmonics. The derivatives of the spherical harmonics are never
+ * stored.
+ *
+ * @param calculator A pointer to a `sphericart_spherical_harmonics_calculator_t`
+ *        struct that holds prefactors and options to compute the spherical
+ *        harmonics.
+ * @param xyz An array of size `n_samples x 3`. It contains the Cartesian
+ *        coordinates of the 3D points.
+ * @param xyz_length size of the xyz allocation, i.e, `3 x n_samples`
+ * @param sph_grad An array of size `n_samples x (l_max + 1)^2`, containing the
+ *        gradient with respect to the spherical harmonics, in the same layout
+ *        as the `sph` output of
+ *        :func:`sphericart_spherical_harmonics_compute_array`.
+ * @param sph_grad_length size of the sph_grad allocation
+ * @param xyz_grad pointer to the first element of an array containing
+ *        `n_samples x 3` elements. On exit, it will contain the gradient with
+ *        respect to `xyz`.
+ * @param xyz_grad_length size of the xyz_grad allocation, i.e, `3 x n_samples`
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_vjp(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    double* xyz_grad,
+    size_t xyz_grad_length
+);
+
+/**
+ * This function computes the Hessian-vector product of the spherical
+ * harmonics, i.e. the derivative along `xyz_vector` of the vector-Jacobian
+ * product computed by :func:`sphericart_spherical_harmonics_compute_vjp`,
+ * `h[i, b] = sum_a v[i, a] sum_lm sph_grad[i, lm] d^2Y_lm(r_i)/dadb`. The
+ * Hessians of the spherical harmonics are never stored.
+ *
+ * @param calculator A pointer to a `sphericart_spherical_harmonics_calculator_t`
+ *        struct that holds prefactors and options to compute the spherical
+ *        harmonics.
+ * @param xyz An array of size `n_samples x 3`. It contains the Cartesian
+ *        coordinates of the 3D points.
+ * @param xyz_length size of the xyz allocation, i.e, `3 x n_samples`
+ * @param sph_grad An array of size `n_samples x (l_max + 1)^2`, as in
+ *        :func:`sphericart_spherical_harmonics_compute_vjp`.
+ * @param sph_grad_length size of the sph_grad allocation
+ * @param xyz_vector An array of size `n_samples x 3`, containing the vector
+ *        multiplying the Hessians of each point.
+ * @param xyz_vector_length size of the xyz_vector allocation, i.e, `3 x n_samples`
+ * @param xyz_hvp pointer to the first element of an array containing
+ *        `n_samples x 3` elements. On exit, it will contain the Hessian-vector
+ *        product.
+ * @param xyz_hvp_length size of the xyz_hvp allocation, i.e, `3 x n_samples`
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_hvp(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* xyz_vector,
+    size_t xyz_vector_length,
+    double* xyz_hvp,
+    size_t xyz_hvp_length
+);
+
+/**
+ * This function contracts gradients of the spherical harmonics that were
+ * already computed, e.g. by
+ * :func:`sphericart_spherical_harmonics_compute_array_with_gradients`, with the
+ * gradient `sph_grad` of a scalar function with respect to the spherical
+ * harmonics. This gives the same result as
+ * :func:`sphericart_spherical_harmonics_compute_vjp`, without evaluating the
+ * spherical harmonics again.
+ *
+ * @param calculator A pointer to a `sphericart_spherical_harmonics_calculator_t`
+ *        struct that holds prefactors and options to compute the spherical
+ *        harmonics.
+ * @param sph_grad An array of size `n_samples x (l_max + 1)^2`, containing the
+ *        gradient with respect to the spherical harmonics, in the same layout
+ *        as the `sph` output of
+ *        :func:`sphericart_spherical_harmonics_compute_array`.
+ * @param sph_grad_length size of the sph_grad allocation
+ * @param dsph An array of size `n_samples x 3 x (l_max + 1)^2`, containing the
+ *        gradients of the spherical harmonics, in the same layout as the `dsph`
+ *        output of
+ *        :func:`sphericart_spherical_harmonics_compute_array_with_gradients`.
+ * @param dsph_length size of the dsph allocation
+ * @param xyz_grad pointer to the first element of an array containing
+ *        `n_samples x 3` elements. On exit, it will contain the gradient with
+ *        respect to `xyz`.
+ * @param xyz_grad_length size of the xyz_grad allocation, i.e, `3 x n_samples`
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_contract_gradients(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* dsph,
+    size_t dsph_length,
+    double* xyz_grad,
+    size_t xyz_grad_length
+);
+
+/**
+ * This function computes the derivatives of the contraction done by
+ * :func:`sphericart_spherical_harmonics_contract_gradients` along the direction
+ * `xyz_vector`, from already computed gradients and Hessians of the spherical
+ * harmonics: `sph_jvp[i, lm] = sum_a v[i, a] dY_lm(r_i)/da` and
+ * `xyz_hvp[i, b] = sum_a v[i, a] sum_lm sph_grad[i, lm] d^2Y_lm(r_i)/dadb`.
+ * Either output can be skipped by passing `NULL` and a length of 0.
+ *
+ * @param calculator A pointer to a `sphericart_spherical_harmonics_calculator_t`
+ *        struct that holds prefactors and options to compute the spherical
+ *        harmonics.
+ * @param sph_grad An array of size `n_samples x (l_max + 1)^2`, as in
+ *        :func:`sphericart_spherical_harmonics_contract_gradients`.
+ * @param sph_grad_length size of the sph_grad allocation
+ * @param xyz_vector An array of size `n_samples x 3`, containing the direction
+ *        for each point.
+ * @param xyz_vector_length size of the xyz_vector allocation, i.e, `3 x n_samples`
+ * @param dsph An array of size `n_samples x 3 x (l_max + 1)^2`, as in
+ *        :func:`sphericart_spherical_harmonics_contract_gradients`.
+ * @param dsph_length size of the dsph allocation
+ * @param ddsph An array of size `n_samples x 3 x 3 x (l_max + 1)^2`, containing
+ *        the Hessians of the spherical harmonics, in the same layout as the
+ *        `ddsph` output of
+ *        :func:`sphericart_spherical_harmonics_compute_array_with_hessians`.
+ * @param ddsph_length size of the ddsph allocation
+ * @param sph_jvp pointer to the first element of an array containing
+ *        `n_samples x (l_max + 1)^2` elements. On exit, it will contain the
+ *        derivative of the spherical harmonics along `xyz_vector`.
+ * @param sph_jvp_length size of the sph_jvp allocation
+ * @param xyz_hvp pointer to the first element of an array containing
+ *        `n_samples x 3` elements. On exit, it will contain the Hessian-vector
+ *        product.
+ * @param xyz_hvp_length size of the xyz_hvp allocation, i.e, `3 x n_samples`
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_contract_gradients_backward(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* xyz_vector,
+    size_t xyz_vector_length,
+    const double* dsph,
+    size_t dsph_length,
+    const double* ddsph,
+    size_t ddsph_length,
+    double* sph_jvp,
+    size_t sph_jvp_length,
+    double* xyz_hvp,
+    size_t xyz_hvp_length
+);
+
 /**
  * Similar to :func:`sphericart_spherical_harmonics_compute_array`, but it computes the spherical
  * harmonics for a single 3D point in space.
@@ -346,6 +750,170 @@ SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_with_hessian
     size_t ddsph_length
 );
 
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_per_l`, but using the `float`
+ * data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_per_l_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* const* sph,
+    size_t n_blocks
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_per_l_with_gradients`, but using
+ * the `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_per_l_with_gradients_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* const* sph,
+    float* const* dsph,
+    size_t n_blocks
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_per_l_with_hessians`, but using
+ * the `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_per_l_with_hessians_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* const* sph,
+    float* const* dsph,
+    float* const* ddsph,
+    size_t n_blocks
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_strided`, but using
+ * the `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_strided_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    float* sph,
+    size_t sph_stride
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_strided_with_gradients`, but using
+ * the `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_strided_with_gradients_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    float* sph,
+    size_t sph_stride,
+    float* dsph,
+    size_t dsph_stride
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_strided_with_hessians`, but using
+ * the `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_strided_with_hessians_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    float* sph,
+    size_t sph_stride,
+    float* dsph,
+    size_t dsph_stride,
+    float* ddsph,
+    size_t ddsph_stride
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_density`, but using the `float`
+ * data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_density_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* radial,
+    size_t n_radial,
+    const size_t* centre_offsets,
+    size_t n_centres,
+    float* coefficients,
+    size_t coefficients_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_vjp`, but using the `float`
+ * data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_vjp_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    float* xyz_grad,
+    size_t xyz_grad_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_hvp`, but using the `float`
+ * data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_hvp_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* xyz_vector,
+    size_t xyz_vector_length,
+    float* xyz_hvp,
+    size_t xyz_hvp_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_contract_gradients`, but using the `float`
+ * data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_contract_gradients_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* dsph,
+    size_t dsph_length,
+    float* xyz_grad,
+    size_t xyz_grad_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_contract_gradients_backward`, but using the
+ * `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_contract_gradients_backward_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* xyz_vector,
+    size_t xyz_vector_length,
+    const float* dsph,
+    size_t dsph_length,
+    const float* ddsph,
+    size_t ddsph_length,
+    float* sph_jvp,
+    size_t sph_jvp_length,
+    float* xyz_hvp,
+    size_t xyz_hvp_length
+);
+
 /**
  * Get the number of OpenMP threads used by a calculator.
  * If `sphericart` is computed without OpenMP support returns 1.
@@ -418,6 +986,20 @@ SPHERICART_EXPORT sphericart_solid_harmonics_calculator_f_t* sphericart_solid_ha
     size_t l_max
 );
 
+/**
+ * Similar to `sphericart_spherical_harmonics_new_with_layout`, but it returns
+ * a `sphericart_solid_harmonics_calculator_t`, which perform solid harmonics calculations.
+ */
+SPHERICART_EXPORT sphericart_solid_harmonics_calculator_t*
+sphericart_solid_harmonics_new_with_layout(size_t l_max, sphericart_layout_t layout);
+
+/**
+ * Similar to `sphericart_solid_harmonics_new_with_layout`, but it returns a
+ * `sphericart_solid_harmonics_calculator_f_t`, which performs calculations on the `float` type.
+ */
+SPHERICART_EXPORT sphericart_solid_harmonics_calculator_f_t*
+sphericart_solid_harmonics_new_with_layout_f(size_t l_max, sphericart_layout_t layout);
+
 /**
  * Deletes a previously allocated `sphericart_solid_harmonics_calculator_t` calculator.
  */
@@ -475,64 +1057,228 @@ SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_with_hessians(
 );
 
 /**
- * Similar to :func:`sphericart_solid_harmonics_compute_array`, but it computes the solid
- * harmonics for a single 3D point in space.
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_per_l`, but it computes
+ * the solid harmonics.
  */
-SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample(
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_per_l(
     sphericart_solid_harmonics_calculator_t* calculator,
     const double* xyz,
     size_t xyz_length,
-    double* sph,
-    size_t sph_length
+    double* const* sph,
+    size_t n_blocks
 );
 
 /**
- * Similar to :func:`sphericart_solid_harmonics_compute_array_with_gradients`, but it
- * computes the solid harmonics for a single 3D point in space.
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_per_l_with_gradients`, but it
+ * computes the solid harmonics.
  */
-SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample_with_gradients(
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_per_l_with_gradients(
     sphericart_solid_harmonics_calculator_t* calculator,
     const double* xyz,
     size_t xyz_length,
-    double* sph,
-    size_t sph_length,
-    double* dsph,
-    size_t dsph_length
+    double* const* sph,
+    double* const* dsph,
+    size_t n_blocks
 );
 
 /**
- * Similar to :func:`sphericart_solid_harmonics_compute_array_with_hessians`, but it computes
- * the solid harmonics for a single 3D point in space.
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_per_l_with_hessians`, but it
+ * computes the solid harmonics.
  */
-SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample_with_hessians(
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_per_l_with_hessians(
     sphericart_solid_harmonics_calculator_t* calculator,
     const double* xyz,
     size_t xyz_length,
+    double* const* sph,
+    double* const* dsph,
+    double* const* ddsph,
+    size_t n_blocks
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_strided`, but it
+ * computes the solid harmonics.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_strided(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
     double* sph,
-    size_t sph_length,
-    double* dsph,
-    size_t dsph_length,
-    double* ddsph,
-    size_t ddsph_length
+    size_t sph_stride
 );
 
 /**
- * Similar to :func:`sphericart_solid_harmonics_compute_array`, but using the `float` data
- * type.
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_strided_with_gradients`, but it
+ * computes the solid harmonics.
  */
-SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_f(
-    sphericart_solid_harmonics_calculator_f_t* calculator,
-    const float* xyz,
-    size_t xyz_length,
-    float* sph,
-    size_t sph_length
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_strided_with_gradients(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride,
+    double* dsph,
+    size_t dsph_stride
 );
 
 /**
- * Similar to :func:`sphericart_solid_harmonics_compute_array_with_gradients`, but using the
- * `float` data type.
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_strided_with_hessians`, but it
+ * computes the solid harmonics.
  */
-SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_with_gradients_f(
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_strided_with_hessians(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride,
+    double* dsph,
+    size_t dsph_stride,
+    double* ddsph,
+    size_t ddsph_stride
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_density`, but it computes the
+ * expansion on the solid harmonics.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_density(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* radial,
+    size_t n_radial,
+    const size_t* centre_offsets,
+    size_t n_centres,
+    double* coefficients,
+    size_t coefficients_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_vjp`, but it computes the
+ * vector-Jacobian product of the solid harmonics.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_vjp(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    double* xyz_grad,
+    size_t xyz_grad_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_hvp`, but it computes the
+ * Hessian-vector product of the solid harmonics.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_hvp(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* xyz_vector,
+    size_t xyz_vector_length,
+    double* xyz_hvp,
+    size_t xyz_hvp_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_contract_gradients`, but it
+ * contracts the gradients of the solid harmonics.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_contract_gradients(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* dsph,
+    size_t dsph_length,
+    double* xyz_grad,
+    size_t xyz_grad_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_contract_gradients_backward`, but it
+ * uses the derivatives of the solid harmonics.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_contract_gradients_backward(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* xyz_vector,
+    size_t xyz_vector_length,
+    const double* dsph,
+    size_t dsph_length,
+    const double* ddsph,
+    size_t ddsph_length,
+    double* sph_jvp,
+    size_t sph_jvp_length,
+    double* xyz_hvp,
+    size_t xyz_hvp_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array`, but it computes the solid
+ * harmonics for a single 3D point in space.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_gradients`, but it
+ * computes the solid harmonics for a single 3D point in space.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample_with_gradients(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_hessians`, but it computes
+ * the solid harmonics for a single 3D point in space.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample_with_hessians(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array`, but using the `float` data
+ * type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_gradients`, but using the
+ * `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_with_gradients_f(
     sphericart_solid_harmonics_calculator_f_t* calculator,
     const float* xyz,
     size_t xyz_length,
@@ -558,6 +1304,170 @@ SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_with_hessians_f(
     size_t ddsph_length
 );
 
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_per_l`, but using the `float` data
+ * type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_per_l_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* const* sph,
+    size_t n_blocks
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_per_l_with_gradients`, but using the
+ * `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_per_l_with_gradients_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* const* sph,
+    float* const* dsph,
+    size_t n_blocks
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_per_l_with_hessians`, but using the
+ * `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_per_l_with_hessians_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* const* sph,
+    float* const* dsph,
+    float* const* ddsph,
+    size_t n_blocks
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_strided`, but using the
+ * `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_strided_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    float* sph,
+    size_t sph_stride
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_strided_with_gradients`, but using the
+ * `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_strided_with_gradients_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    float* sph,
+    size_t sph_stride,
+    float* dsph,
+    size_t dsph_stride
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_strided_with_hessians`, but using the
+ * `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_strided_with_hessians_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    float* sph,
+    size_t sph_stride,
+    float* dsph,
+    size_t dsph_stride,
+    float* ddsph,
+    size_t ddsph_stride
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_density`, but using the `float` data
+ * type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_density_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* radial,
+    size_t n_radial,
+    const size_t* centre_offsets,
+    size_t n_centres,
+    float* coefficients,
+    size_t coefficients_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_vjp`, but using the `float` data
+ * type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_vjp_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    float* xyz_grad,
+    size_t xyz_grad_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_hvp`, but using the `float` data
+ * type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_hvp_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* xyz_vector,
+    size_t xyz_vector_length,
+    float* xyz_hvp,
+    size_t xyz_hvp_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_contract_gradients`, but using the `float`
+ * data type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_contract_gradients_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* dsph,
+    size_t dsph_length,
+    float* xyz_grad,
+    size_t xyz_grad_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_contract_gradients_backward`, but using the
+ * `float` data type.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_contract_gradients_backward_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* xyz_vector,
+    size_t xyz_vector_length,
+    const float* dsph,
+    size_t dsph_length,
+    const float* ddsph,
+    size_t ddsph_length,
+    float* sph_jvp,
+    size_t sph_jvp_length,
+    float* xyz_hvp,
+    size_t xyz_hvp_length
+);
+
 /**
  * Similar to :func:`sphericart_solid_harmonics_compute_sample`, but using the `float` data
  * type.
@@ -616,6 +1526,594 @@ SPHERICART_EXPORT int sphericart_solid_harmonics_omp_num_threads_f(
     sphericart_solid_harmonics_calculator_f_t* calculator
 );
 
+/**
+ * Creates an empty workspace, which can then be passed to the reentrant
+ * (`_r`) compute functions of any `double` calculator. Each thread calling
+ * the same calculator at the same time should use its own workspace.
+ *
+ *  @return A pointer to a `sphericart_workspace_t` object
+ */
+SPHERICART_EXPORT sphericart_workspace_t* sphericart_workspace_new();
+
+/**
+ * Similar to `sphericart_workspace_new`, but it returns a
+ * `sphericart_workspace_f_t`, to be used with the `float` calculators.
+ */
+SPHERICART_EXPORT sphericart_workspace_f_t* sphericart_workspace_new_f();
+
+/**
+ * Deletes a previously allocated `sphericart_workspace_t`.
+ */
+SPHERICART_EXPORT void sphericart_workspace_delete(sphericart_workspace_t* workspace);
+
+/**
+ * Deletes a previously allocated `sphericart_workspace_f_t`.
+ */
+SPHERICART_EXPORT void sphericart_workspace_delete_f(sphericart_workspace_f_t* workspace);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array`, but it uses the scratch memory
+ * in `workspace` instead of the one stored in the calculator. Several threads can call this
+ * function with the same calculator at the same time, as long as they use different workspaces.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_gradients`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_with_gradients_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_hessians`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_with_hessians_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_sample`, but using a workspace as in
+ * :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_sample_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_sample_with_gradients`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_sample_with_gradients_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_sample_with_hessians`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_sample_with_hessians_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_f`, but using a workspace as in
+ * :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_gradients_f`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_with_gradients_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_hessians_f`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_array_with_hessians_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_sample_f`, but using a workspace as in
+ * :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_sample_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_sample_with_gradients_f`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_sample_with_gradients_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_sample_with_hessians_f`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_spherical_harmonics_compute_sample_with_hessians_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array`, but using a workspace as in
+ * :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_gradients`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_with_gradients_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_hessians`, but using a workspace
+ * as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_with_hessians_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_sample`, but using a workspace as in
+ * :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_sample_with_gradients`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample_with_gradients_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_sample_with_hessians`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample_with_hessians_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_f`, but using a workspace as in
+ * :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_gradients_f`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_with_gradients_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_hessians_f`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_array_with_hessians_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_sample_f`, but using a workspace as in
+ * :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_sample_with_gradients_f`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample_with_gradients_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_sample_with_hessians_f`, but using a
+ * workspace as in :func:`sphericart_spherical_harmonics_compute_array_r`.
+ */
+SPHERICART_EXPORT void sphericart_solid_harmonics_compute_sample_with_hessians_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_f_t* workspace
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array`, but it returns without waiting
+ * for the results. The calculation runs on a background thread, using scratch memory private to
+ * that thread, and the calculator can still be used while it runs. The calculator and the arrays
+ * must stay valid until :func:`sphericart_future_wait` or :func:`sphericart_future_delete` returns.
+ *
+ * Errors in the arguments are fatal, as in the synchronous compute functions.
+ *
+ *  @return A pointer to a `sphericart_future_t`, which must be released with
+ *  :func:`sphericart_future_delete`. This pointer is never `NULL`.
+ */
+SPHERICART_EXPORT sphericart_future_t* sphericart_spherical_harmonics_compute_array_async(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_gradients`, but asynchronous
+ * as :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t*
+sphericart_spherical_harmonics_compute_array_with_gradients_async(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_hessians`, but asynchronous
+ * as :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t*
+sphericart_spherical_harmonics_compute_array_with_hessians_async(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_f`, but asynchronous as
+ * :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t* sphericart_spherical_harmonics_compute_array_async_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_gradients_f`, but
+ * asynchronous as :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t*
+sphericart_spherical_harmonics_compute_array_with_gradients_async_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length
+);
+
+/**
+ * Similar to :func:`sphericart_spherical_harmonics_compute_array_with_hessians_f`, but asynchronous
+ * as :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t*
+sphericart_spherical_harmonics_compute_array_with_hessians_async_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array`, but asynchronous as
+ * :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t* sphericart_solid_harmonics_compute_array_async(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_gradients`, but asynchronous as
+ * :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t*
+sphericart_solid_harmonics_compute_array_with_gradients_async(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_hessians`, but asynchronous as
+ * :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t* sphericart_solid_harmonics_compute_array_with_hessians_async(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_f`, but asynchronous as
+ * :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t* sphericart_solid_harmonics_compute_array_async_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_gradients_f`, but asynchronous as
+ * :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t*
+sphericart_solid_harmonics_compute_array_with_gradients_async_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length
+);
+
+/**
+ * Similar to :func:`sphericart_solid_harmonics_compute_array_with_hessians_f`, but asynchronous as
+ * :func:`sphericart_spherical_harmonics_compute_array_async`.
+ */
+SPHERICART_EXPORT sphericart_future_t*
+sphericart_solid_harmonics_compute_array_with_hessians_async_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length
+);
+
+/**
+ * Waits for the calculation referred to by `future` to finish. Errors in the
+ * calculation are fatal, as in the synchronous compute functions. Passing
+ * `NULL` does nothing.
+ */
+SPHERICART_EXPORT void sphericart_future_wait(sphericart_future_t* future);
+
+/**
+ * Returns true if the calculation referred to by `future` has finished, in
+ * which case :func:`sphericart_future_wait` returns immediately. Returns true
+ * for `NULL`.
+ */
+SPHERICART_EXPORT bool sphericart_future_is_ready(sphericart_future_t* future);
+
+/**
+ * Waits for the calculation referred to by `future` to finish, if needed, and
+ * then deletes the `future`.
+ */
+SPHERICART_EXPORT void sphericart_future_delete(sphericart_future_t* future);
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,22 +11,127 @@
 #define SPHERICART_HPP
 
 #include <cstddef>
+#include <future>
+#include <memory>
 #include <tuple>
 #include <vector>
 
+#include "parallel.hpp"
+#include "strides.hpp"
+
 #ifdef _SPHERICART_INTERNAL_IMPLEMENTATION
 #include "macros.hpp"
 #include "templates.hpp"
+#include "templates_batched.hpp"
 #endif
 
 namespace sphericart {
 
+/**
+ * The algorithms that the calculators can use to evaluate arrays of points
+ * (the `compute_array` family of functions and the `std::vector`
+ * interfaces with more than one point). Both give the same results.
+ */
+enum class Engine {
+    /** Evaluates one point at a time. This is the default, and the fastest
+     *  choice for low `l_max` and small numbers of points. */
+    SAMPLE,
+    /** Evaluates blocks of points at once, storing intermediate quantities
+     *  in structure-of-arrays form so that the recursions are vectorized
+     *  across points. This is usually faster for large arrays of points,
+     *  especially at high `l_max`, at the price of a larger buffer. */
+    BATCHED,
+};
+
+/**
+ * The memory layouts in which the calculators can store the spherical
+ * harmonics and their derivatives. Outputs in a layout other than
+ * `SAMPLE_MAJOR` are not produced by transposing the full arrays afterwards:
+ * the kernels compute each sample (or batch of samples, with
+ * `Engine::BATCHED`) in thread-local scratch memory, and then scatter it to
+ * its place in the selected layout. In all cases, the spherical harmonics are
+ * in lexicographic order along their dimension, and the total number of
+ * elements of each output is the same.
+ */
+enum class Layout {
+    /** Sample-major: `sph` has shape `n_samples x (l_max + 1)^2`, `dsph`
+     *  has shape `n_samples x 3 x (l_max + 1)^2`, and `ddsph` has shape
+     *  `n_samples x 3 x 3 x (l_max + 1)^2`. This is the default. */
+    SAMPLE_MAJOR,
+    /** Feature-major: the samples are the innermost dimension, so that
+     *  `sph` has shape `(l_max + 1)^2 x n_samples`, `dsph` has shape
+     *  `3 x (l_max + 1)^2 x n_samples`, and `ddsph` has shape
+     *  `3 x 3 x (l_max + 1)^2 x n_samples`. This is the layout expected by
+     *  matrix multiplications that contract over the samples. */
+    LM_MAJOR,
+    /** The Cartesian directions are the innermost dimension: `sph` has shape
+     *  `n_samples x (l_max + 1)^2` (as in `SAMPLE_MAJOR`), `dsph` has shape
+     *  `n_samples x (l_max + 1)^2 x 3`, and `ddsph` has shape
+     *  `n_samples x (l_max + 1)^2 x 3 x 3`. */
+    XYZ_INNERMOST,
+};
+
+template <typename T> class SphericalHarmonics;
+
+/**
+ * Scratch memory for the compute functions of the calculators.
+ *
+ * By default, all the compute functions of a calculator use the buffers stored
+ * in the calculator itself, so that a calculator can not be used by several
+ * threads at the same time. All the compute functions also accept a pointer
+ * to a `Workspace`, in which case the calculator is only read: one
+ * calculator can then be shared by any number of threads, as long as each of
+ * them uses its own workspace.
+ *
+ * Calls without a workspace made from inside of a parallel region (see
+ * `in_parallel_region()`), e.g. from the threads of an OpenMP loop over
+ * independent structures, use memory private to the calling thread instead of
+ * the buffers of the calculator, and can share a calculator in the same way.
+ *
+ * A workspace is empty when created, and grows as needed the first time it is
+ * used. It can be reused with any calculator using the same floating-point
+ * type, and should not be used by two calls running at the same time.
+ */
+template <typename T> class Workspace {
+  public:
+    /** Creates an empty workspace */
+    Workspace() = default;
+
+    /**
+     * Returns the number of elements currently allocated by this workspace.
+     */
+    size_t size() const { return this->buffers.size(); }
+
+    /* @cond */
+  private:
+    template <typename U> friend class SphericalHarmonics;
+
+    std::vector<T> buffers;
+    /* @endcond */
+};
+
+/**
+ * Outputs of an array call, allocated by
+ * `SphericalHarmonics::allocate_outputs()`. Arrays which were not requested
+ * are null.
+ */
+template <typename T> struct ArrayOutputs {
+    /** Spherical harmonics, with `n_samples x (l_max + 1)^2` elements */
+    std::unique_ptr<T[]> sph;
+    /** Gradients, with `n_samples x 3 x (l_max + 1)^2` elements */
+    std::unique_ptr<T[]> dsph;
+    /** Hessians, with `n_samples x 9 x (l_max + 1)^2` elements */
+    std::unique_ptr<T[]> ddsph;
+};
+
 /**
  * A spherical harmonics calculator.
  *
  * It handles initialization of the prefactors upon initialization and it
  * stores the buffers that are necessary to compute the spherical harmonics
- * efficiently.
+ * efficiently. These buffers are shared by all the compute calls that do not
+ * receive a separate `Workspace`, and are only allocated by the first of
+ * these calls.
  */
 template <typename T> class SphericalHarmonics {
   public:
@@ -35,13 +140,45 @@ template <typename T> class SphericalHarmonics {
      *
      *  @param l_max
      *      The maximum degree of the spherical harmonics to be calculated.
+     *  @param engine
+     *      The algorithm used to evaluate arrays of points, see `Engine`.
+     *  @param layout
+     *      The memory layout of the outputs, see `Layout`. The shapes given
+     *      in the documentation of the `compute` functions below are those of
+     *      the default `Layout::SAMPLE_MAJOR`.
+     *  @param backend
+     *      How the calculator distributes arrays of points over threads, see
+     *      `ParallelBackend`. If null, `openmp_backend()` is used. The
+     *      buffers of the calculator and of the workspaces used with it hold
+     *      the data of `backend->max_workers()` workers.
      */
-    SphericalHarmonics(size_t l_max);
+    SphericalHarmonics(
+        size_t l_max,
+        Engine engine = Engine::SAMPLE,
+        Layout layout = Layout::SAMPLE_MAJOR,
+        std::shared_ptr<ParallelBackend> backend = nullptr
+    );
 
     /* @cond */
     ~SphericalHarmonics();
     /* @endcond */
 
+    /** Calculators can be moved, e.g. to store them in a `std::vector` or to
+     * hand them over to another thread. A moved-from calculator can only be
+     * destroyed or assigned to.
+     */
+    SphericalHarmonics(SphericalHarmonics&& other) noexcept = default;
+
+    /** See the move constructor. */
+    SphericalHarmonics& operator=(SphericalHarmonics&& other) noexcept = default;
+
+    /** Creates a new calculator that computes the same functions as this one.
+     * The prefactors, which are never modified after construction, are shared
+     * between the two calculators (and freed with the last of them), and the
+     * new calculator allocates its own buffers when first used. This is a
+     * cheap way of creating one calculator for each thread. */
+    SphericalHarmonics clone() const;
+
     /** Computes the spherical harmonics for one or more 3D points, using
      *  `std::vector`s.
      *
@@ -62,8 +199,9 @@ template <typename T> class SphericalHarmonics {
      *        These are laid out in lexicographic order. For example, if `l_max=2`, it
      *        will contain `(l, m) = (0, 0), (1, -1), (1, 0), (1, 1), (2, -2), (2, -1),
      *        (2, 0), (2, 1), (2, 2)`, in this order.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
      */
-    void compute(const std::vector<T>& xyz, std::vector<T>& sph);
+    void compute(const std::vector<T>& xyz, std::vector<T>& sph, Workspace<T>* workspace = nullptr);
 
     /** Computes the spherical harmonics and their derivatives with respect to
      *  the Cartesian coordinates of one or more 3D points, using
@@ -97,8 +235,14 @@ template <typename T> class SphericalHarmonics {
      *        organized in lexicographic order). The intermediate dimension
      *        corresponds to different spatial derivatives of the spherical
      *        harmonics: x, y, and z, respectively.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
      */
-    void compute_with_gradients(const std::vector<T>& xyz, std::vector<T>& sph, std::vector<T>& dsph);
+    void compute_with_gradients(
+        const std::vector<T>& xyz,
+        std::vector<T>& sph,
+        std::vector<T>& dsph,
+        Workspace<T>* workspace = nullptr
+    );
 
     /** Computes the spherical harmonics, their derivatives and second
      * derivatives with respect to the Cartesian coordinates of one or more 3D
@@ -143,9 +287,14 @@ template <typename T> class SphericalHarmonics {
      *        organized in lexicographic order). The intermediate dimensions
      *        correspond to the different spatial second derivatives of the
      *        spherical harmonics, i.e., to the dimensions of the Hessian matrix.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
      */
     void compute_with_hessians(
-        const std::vector<T>& xyz, std::vector<T>& sph, std::vector<T>& dsph, std::vector<T>& ddsph
+        const std::vector<T>& xyz,
+        std::vector<T>& sph,
+        std::vector<T>& dsph,
+        std::vector<T>& ddsph,
+        Workspace<T>* workspace = nullptr
     );
 
     /** Computes the spherical harmonics for a set of 3D points using bare
@@ -158,8 +307,15 @@ template <typename T> class SphericalHarmonics {
      *        samples, while the inner dimension has size 3 and it represents
      *        the x, y, and z coordinates respectively.
      * @param xyz_length Total length of the `xyz` array: `n_samples x 3`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
      */
-    void compute_array(const T* xyz, size_t xyz_length, T* sph, size_t sph_length);
+    void compute_array(
+        const T* xyz,
+        size_t xyz_length,
+        T* sph,
+        size_t sph_length,
+        Workspace<T>* workspace = nullptr
+    );
 
     /** Computes the spherical harmonics and their derivatives for a set of 3D
      * points using bare arrays.
@@ -193,9 +349,16 @@ template <typename T> class SphericalHarmonics {
      *        harmonics: x, y, and z, respectively.
      * @param dsph_length Total length of the `dsph` array: `n_samples x 3 x
      *        (l_max + 1)^2`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
      */
     void compute_array_with_gradients(
-        const T* xyz, size_t xyz_length, T* sph, size_t sph_length, T* dsph, size_t dsph_length
+        const T* xyz,
+        size_t xyz_length,
+        T* sph,
+        size_t sph_length,
+        T* dsph,
+        size_t dsph_length,
+        Workspace<T>* workspace = nullptr
     );
 
     /** Computes the spherical harmonics, their derivatives and second
@@ -242,8 +405,67 @@ template <typename T> class SphericalHarmonics {
      * spherical harmonics, i.e., to the dimensions of the Hessian matrix.
      * @param ddsph_length Total length of the `ddsph` array: `n_samples x 9 x
      * (l_max + 1)^2`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
      */
     void compute_array_with_hessians(
+        const T* xyz,
+        size_t xyz_length,
+        T* sph,
+        size_t sph_length,
+        T* dsph,
+        size_t dsph_length,
+        T* ddsph,
+        size_t ddsph_length,
+        Workspace<T>* workspace = nullptr
+    );
+
+    /** Starts computing the spherical harmonics for a set of 3D points, as
+     * `compute_array()`, and returns without waiting for the results.
+     *
+     * The asynchronous calls run one after the other, in the order they were
+     * made, on a background thread shared by all calculators, and each of
+     * them uses the parallel backend of the calculator. They use their own
+     * scratch memory, so the calculator can still be used (e.g. for a
+     * synchronous call) while they run. The calculator must not be destroyed,
+     * moved or modified, and the arrays must stay valid, until the returned
+     * future is ready.
+     *
+     * @param xyz An array of size `n_samples x 3`, see `compute_array()`.
+     * @param xyz_length Total length of the `xyz` array: `n_samples x 3`.
+     * @param sph On exit, the spherical harmonics, see `compute_array()`.
+     * @param sph_length Total length of the `sph` array: `n_samples x (l_max +
+     *        1)^2`.
+     *
+     * @return A future that becomes ready once `sph` has been filled, and
+     *     that re-throws the errors of the calculation, if any.
+     */
+    std::future<void> compute_array_async(
+        const T* xyz, size_t xyz_length, T* sph, size_t sph_length
+    );
+
+    /** Starts computing the spherical harmonics and their derivatives for a
+     * set of 3D points, as `compute_array_with_gradients()`, and returns
+     * without waiting for the results. See `compute_array_async()` for the
+     * requirements on the calculator and the arrays.
+     *
+     * @return A future that becomes ready once `sph` and `dsph` have been
+     *     filled, and that re-throws the errors of the calculation, if any.
+     */
+    std::future<void> compute_array_with_gradients_async(
+        const T* xyz, size_t xyz_length, T* sph, size_t sph_length, T* dsph, size_t dsph_length
+    );
+
+    /** Starts computing the spherical harmonics, their derivatives and second
+     * derivatives for a set of 3D points, as `compute_array_with_hessians()`,
+     * and returns without waiting for the results. See
+     * `compute_array_async()` for the requirements on the calculator and the
+     * arrays.
+     *
+     * @return A future that becomes ready once `sph`, `dsph` and `ddsph` have
+     *     been filled, and that re-throws the errors of the calculation, if
+     *     any.
+     */
+    std::future<void> compute_array_with_hessians_async(
         const T* xyz,
         size_t xyz_length,
         T* sph,
@@ -254,6 +476,422 @@ template <typename T> class SphericalHarmonics {
         size_t ddsph_length
     );
 
+    /** Writes zeros to the outputs of an array call for `n_samples` points,
+     * splitting them between the workers of the parallel backend in the same
+     * way as the `compute_array` functions do.
+     *
+     * On NUMA machines, memory pages are placed close to the thread that
+     * first writes to them. Calling this on freshly allocated (and not yet
+     * initialized) outputs, e.g. from `new T[size]`, `numpy.empty` or
+     * `torch.empty`, before computing into them places the outputs of each
+     * worker in its own memory. This is only effective if the workers always
+     * run on the same socket, see `ThreadPinning` or `OMP_PROC_BIND` with the
+     * default OpenMP backend.
+     *
+     * @param n_samples The number of points in the array calls.
+     * @param sph The array for the spherical harmonics, with
+     *        `n_samples x (l_max + 1)^2` elements.
+     * @param dsph Optional array for the gradients, with
+     *        `n_samples x 3 x (l_max + 1)^2` elements.
+     * @param ddsph Optional array for the Hessians, with
+     *        `n_samples x 9 x (l_max + 1)^2` elements.
+     */
+    void first_touch(size_t n_samples, T* sph, T* dsph = nullptr, T* ddsph = nullptr);
+
+    /** Allocates the outputs of an array call for `n_samples` points, and
+     * initializes them to zero with `first_touch()`.
+     *
+     * Containers such as `std::vector` write to their memory from the
+     * allocating thread, which places all of it close to this thread on NUMA
+     * machines. The arrays returned here are only written by the workers
+     * which will later compute into them.
+     *
+     * @param n_samples The number of points in the array calls.
+     * @param gradients Whether to also allocate the gradients.
+     * @param hessians Whether to also allocate the Hessians. This implies
+     *        `gradients`.
+     */
+    ArrayOutputs<T> allocate_outputs(
+        size_t n_samples, bool gradients = false, bool hessians = false
+    );
+
+    /** Computes the spherical harmonics for a set of 3D points, storing the
+     * spherical harmonics of each degree l in a separate array. Each of these
+     * arrays can then be used directly, e.g. as the block of an equivariant
+     * representation, without copying or slicing the full output.
+     *
+     * @param xyz An array of size `n_samples x 3`. It contains the
+     *        Cartesian coordinates of the 3D points for which the spherical
+     *        harmonics are to be computed, organized along two dimensions. The
+     *        outer dimension is `n_samples` long, accounting for different
+     *        samples, while the inner dimension has size 3 and it represents
+     *        the x, y, and z coordinates respectively.
+     * @param xyz_length Total length of the `xyz` array: `n_samples x 3`.
+     * @param sph An array of `l_max + 1` pointers. On entry, `sph[l]` should
+     *        point to an array of size `n_samples x (2 l + 1)`. On exit, this
+     *        array will contain the spherical harmonics of degree l, with
+     *        `m = -l, ..., l` along the inner dimension. If the calculator
+     *        uses a layout other than `Layout::SAMPLE_MAJOR`, each array is
+     *        organized as the full output would be in that layout, with
+     *        `2 l + 1` instead of `(l_max + 1)^2` spherical harmonics.
+     * @param n_blocks Number of pointers in `sph`: `l_max + 1`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
+     */
+    void compute_array_per_l(
+        const T* xyz,
+        size_t xyz_length,
+        T* const* sph,
+        size_t n_blocks,
+        Workspace<T>* workspace = nullptr
+    );
+
+    /** Computes the spherical harmonics and their derivatives for a set of
+     * 3D points, storing the outputs of each degree l in separate arrays.
+     *
+     * @param xyz An array of size `n_samples x 3`, see `compute_array_per_l`.
+     * @param xyz_length Total length of the `xyz` array: `n_samples x 3`.
+     * @param sph An array of `l_max + 1` pointers to the arrays that will
+     *        contain the spherical harmonics of each degree, see
+     *        `compute_array_per_l`.
+     * @param dsph An array of `l_max + 1` pointers. On entry, `dsph[l]`
+     *        should point to an array of size `n_samples x 3 x (2 l + 1)`. On
+     *        exit, this array will contain the derivatives of the spherical
+     *        harmonics of degree l, organized as the full `dsph` array of
+     *        `compute_array_with_gradients`.
+     * @param n_blocks Number of pointers in `sph` and `dsph`: `l_max + 1`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
+     */
+    void compute_array_per_l_with_gradients(
+        const T* xyz,
+        size_t xyz_length,
+        T* const* sph,
+        T* const* dsph,
+        size_t n_blocks,
+        Workspace<T>* workspace = nullptr
+    );
+
+    /** Computes the spherical harmonics, their derivatives and second
+     * derivatives for a set of 3D points, storing the outputs of each degree
+     * l in separate arrays.
+     *
+     * @param xyz An array of size `n_samples x 3`, see `compute_array_per_l`.
+     * @param xyz_length Total length of the `xyz` array: `n_samples x 3`.
+     * @param sph An array of `l_max + 1` pointers to the arrays that will
+     *        contain the spherical harmonics of each degree, see
+     *        `compute_array_per_l`.
+     * @param dsph An array of `l_max + 1` pointers to the arrays that will
+     *        contain the derivatives of each degree, see
+     *        `compute_array_per_l_with_gradients`.
+     * @param ddsph An array of `l_max + 1` pointers. On entry, `ddsph[l]`
+     *        should point to an array of size `n_samples x 3 x 3 x (2 l + 1)`.
+     *        On exit, this array will contain the second derivatives of the
+     *        spherical harmonics of degree l, organized as the full `ddsph`
+     *        array of `compute_array_with_hessians`.
+     * @param n_blocks Number of pointers in `sph`, `dsph` and `ddsph`:
+     *        `l_max + 1`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
+     */
+    void compute_array_per_l_with_hessians(
+        const T* xyz,
+        size_t xyz_length,
+        T* const* sph,
+        T* const* dsph,
+        T* const* ddsph,
+        size_t n_blocks,
+        Workspace<T>* workspace = nullptr
+    );
+
+    /** Computes the spherical harmonics for a set of 3D points that are not
+     * stored contiguously, e.g. in an array of structures or in a column slice
+     * of a larger array, and writes them to an output array whose rows may be
+     * padded. Both arrays are used in place, without copies.
+     *
+     * @param xyz Pointer to the x coordinate of the first point. The x, y and
+     *        z coordinates of point `i` are stored at `xyz[i * xyz_stride]`,
+     *        `xyz[i * xyz_stride + 1]` and `xyz[i * xyz_stride + 2]`.
+     * @param n_samples Number of points.
+     * @param xyz_stride Distance (in number of elements) between the
+     *        coordinates of consecutive points, at least 3.
+     * @param sph On exit, contains the spherical harmonics, organized as in
+     *        `compute_array` (or according to the layout of the calculator),
+     *        except that consecutive rows of the array start `sph_stride`
+     *        elements apart. Rows run over the samples for the
+     *        `Layout::SAMPLE_MAJOR` and `Layout::XYZ_INNERMOST` layouts, and
+     *        over the spherical harmonics for `Layout::LM_MAJOR`.
+     * @param sph_stride Distance (in number of elements) between consecutive
+     *        rows of `sph`, at least as large as the length of a row.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
+     */
+    void compute_array_strided(
+        const T* xyz,
+        size_t n_samples,
+        size_t xyz_stride,
+        T* sph,
+        size_t sph_stride,
+        Workspace<T>* workspace = nullptr
+    );
+
+    /** Computes the spherical harmonics and their derivatives for a set of
+     * 3D points, reading and writing strided arrays.
+     *
+     * @param xyz Coordinates of the points, see `compute_array_strided`.
+     * @param n_samples Number of points.
+     * @param xyz_stride Distance (in number of elements) between the
+     *        coordinates of consecutive points, at least 3.
+     * @param sph Spherical harmonics, see `compute_array_strided`.
+     * @param sph_stride Distance (in number of elements) between consecutive
+     *        rows of `sph`.
+     * @param dsph On exit, contains the derivatives of the spherical
+     *        harmonics, organized as in `compute_array_with_gradients`, with
+     *        rows starting `dsph_stride` elements apart. Rows run over the
+     *        samples, or over the (x, y, z) and (l, m) pairs for
+     *        `Layout::LM_MAJOR`.
+     * @param dsph_stride Distance (in number of elements) between consecutive
+     *        rows of `dsph`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
+     */
+    void compute_array_strided_with_gradients(
+        const T* xyz,
+        size_t n_samples,
+        size_t xyz_stride,
+        T* sph,
+        size_t sph_stride,
+        T* dsph,
+        size_t dsph_stride,
+        Workspace<T>* workspace = nullptr
+    );
+
+    /** Computes the spherical harmonics, their derivatives and second
+     * derivatives for a set of 3D points, reading and writing strided arrays.
+     *
+     * @param xyz Coordinates of the points, see `compute_array_strided`.
+     * @param n_samples Number of points.
+     * @param xyz_stride Distance (in number of elements) between the
+     *        coordinates of consecutive points, at least 3.
+     * @param sph Spherical harmonics, see `compute_array_strided`.
+     * @param sph_stride Distance (in number of elements) between consecutive
+     *        rows of `sph`.
+     * @param dsph Derivatives, see `compute_array_strided_with_gradients`.
+     * @param dsph_stride Distance (in number of elements) between consecutive
+     *        rows of `dsph`.
+     * @param ddsph On exit, contains the second derivatives of the spherical
+     *        harmonics, organized as in `compute_array_with_hessians`, with
+     *        rows starting `ddsph_stride` elements apart. Rows run over the
+     *        samples, or over the Hessian components and (l, m) pairs for
+     *        `Layout::LM_MAJOR`.
+     * @param ddsph_stride Distance (in number of elements) between
+     *        consecutive rows of `ddsph`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
+     */
+    void compute_array_strided_with_hessians(
+        const T* xyz,
+        size_t n_samples,
+        size_t xyz_stride,
+        T* sph,
+        size_t sph_stride,
+        T* dsph,
+        size_t dsph_stride,
+        T* ddsph,
+        size_t ddsph_stride,
+        Workspace<T>* workspace = nullptr
+    );
+
+    /** Computes the coefficients of the expansion of atom-centred densities on
+     * the spherical harmonics, \f$ c_{nlm}(i) = \sum_j R_n(r_{ij})
+     * Y^m_l(\hat{r}_{ij}) \f$, where the sum runs over the neighbours of
+     * each centre. The spherical harmonics of each pair are contracted with
+     * the radial weights as soon as they are computed, and are never stored.
+     *
+     * @param xyz An array of size `n_pairs x 3`, containing the vectors
+     *        \f$ r_{ij} \f$ from each centre to its neighbours. The pairs of
+     *        each centre must be stored contiguously, in the same order as the
+     *        centres.
+     * @param xyz_length Total length of the `xyz` array: `n_pairs x 3`.
+     * @param radial An array of size `n_pairs x n_radial`, containing the
+     *        radial weights \f$ R_n(r_{ij}) \f$ of each pair.
+     * @param n_radial The number of radial weights for each pair.
+     * @param centre_offsets An array of size `n_centres + 1`, in compressed
+     *        sparse row format: the pairs of centre `i` are the ones from
+     *        `centre_offsets[i]` (included) to `centre_offsets[i + 1]`
+     *        (excluded). `centre_offsets[0]` should be 0 and
+     *        `centre_offsets[n_centres]` should be `n_pairs`.
+     * @param n_centres The number of centres.
+     * @param coefficients On entry, an array of size
+     *        `n_centres x n_radial x (l_max + 1)^2`. On exit, it contains the
+     *        expansion coefficients of each centre, with the spherical
+     *        harmonics in lexicographic order along the last dimension. This
+     *        array does not depend on the layout of the calculator.
+     * @param coefficients_length Total length of the `coefficients` array.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
+     */
+    void compute_density(
+        const T* xyz,
+        size_t xyz_length,
+        const T* radial,
+        size_t n_radial,
+        const size_t* centre_offsets,
+        size_t n_centres,
+        T* coefficients,
+        size_t coefficients_length,
+        Workspace<T>* workspace = nullptr
+    );
+
+    /** Computes the vector-Jacobian product of the spherical harmonics, i.e.
+     * the gradient of a scalar function of the spherical harmonics with
+     * respect to the positions, \f$ \partial L / \partial r_{ia} =
+     * \sum_{lm} (\partial L / \partial Y^m_l(r_i)) \partial Y^m_l(r_i) /
+     * \partial r_{ia} \f$. The derivatives of the spherical harmonics are
+     * contracted as soon as they are computed, and are never stored.
+     *
+     * @param xyz An array of size `n_samples x 3`, containing the Cartesian
+     *        coordinates of the 3D points.
+     * @param xyz_length Total length of the `xyz` array: `n_samples x 3`.
+     * @param sph_grad An array of size `n_samples x (l_max + 1)^2`,
+     *        containing the gradient of the function with respect to the
+     *        spherical harmonics, in the same layout as the `sph` output of
+     *        `compute_array()`.
+     * @param sph_grad_length Total length of the `sph_grad` array.
+     * @param xyz_grad On entry, an array of size `n_samples x 3`. On exit, it
+     *        contains the gradient of the function with respect to `xyz`.
+     *        This array does not depend on the layout of the calculator.
+     * @param xyz_grad_length Total length of the `xyz_grad` array.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
+     */
+    void compute_vjp(
+        const T* xyz,
+        size_t xyz_length,
+        const T* sph_grad,
+        size_t sph_grad_length,
+        T* xyz_grad,
+        size_t xyz_grad_length,
+        Workspace<T>* workspace = nullptr
+    );
+
+    /** Computes the Hessian-vector product of the spherical harmonics, i.e.
+     * the derivative of the vector-Jacobian product computed by
+     * `compute_vjp()` along the direction `xyz_vector`,
+     * \f$ h_{ib} = \sum_a v_{ia} \sum_{lm} (\partial L / \partial
+     * Y^m_l(r_i)) \partial^2 Y^m_l(r_i) / \partial r_{ia} \partial r_{ib}
+     * \f$. This is the quantity needed to differentiate twice through the
+     * spherical harmonics. The Hessians of the spherical harmonics are
+     * contracted as soon as they are computed, and are never stored.
+     *
+     * @param xyz An array of size `n_samples x 3`, containing the Cartesian
+     *        coordinates of the 3D points.
+     * @param xyz_length Total length of the `xyz` array: `n_samples x 3`.
+     * @param sph_grad An array of size `n_samples x (l_max + 1)^2`, as in
+     *        `compute_vjp()`.
+     * @param sph_grad_length Total length of the `sph_grad` array.
+     * @param xyz_vector An array of size `n_samples x 3`, containing the
+     *        vector \f$ v \f$ multiplying the Hessians of each point.
+     * @param xyz_vector_length Total length of the `xyz_vector` array.
+     * @param xyz_hvp On entry, an array of size `n_samples x 3`. On exit, it
+     *        contains the Hessian-vector product. This array does not depend
+     *        on the layout of the calculator.
+     * @param xyz_hvp_length Total length of the `xyz_hvp` array.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
+     */
+    void compute_hvp(
+        const T* xyz,
+        size_t xyz_length,
+        const T* sph_grad,
+        size_t sph_grad_length,
+        const T* xyz_vector,
+        size_t xyz_vector_length,
+        T* xyz_hvp,
+        size_t xyz_hvp_length,
+        Workspace<T>* workspace = nullptr
+    );
+
+    /** Contracts gradients of the spherical harmonics that were already
+     * computed, e.g. by `compute_array_with_gradients()`, with the gradient
+     * of a scalar function with respect to the spherical harmonics, giving
+     * \f$ \partial L / \partial r_{ia} = \sum_{lm} (\partial L / \partial
+     * Y^m_l(r_i)) \partial Y^m_l(r_i) / \partial r_{ia} \f$. This gives
+     * the same result as `compute_vjp()`, without evaluating the spherical
+     * harmonics again, and is meant for backward passes that stored `dsph`
+     * during the forward pass.
+     *
+     * @param sph_grad An array of size `n_samples x (l_max + 1)^2`,
+     *        containing the gradient of the function with respect to the
+     *        spherical harmonics, in the same layout as the `sph` output of
+     *        `compute_array()`.
+     * @param sph_grad_length Total length of the `sph_grad` array.
+     * @param dsph An array of size `n_samples x 3 x (l_max + 1)^2`,
+     *        containing the gradients of the spherical harmonics, in the same
+     *        layout as the `dsph` output of `compute_array_with_gradients()`.
+     * @param dsph_length Total length of the `dsph` array.
+     * @param xyz_grad On entry, an array of size `n_samples x 3`. On exit, it
+     *        contains the gradient of the function with respect to the
+     *        positions. This array does not depend on the layout of the
+     *        calculator.
+     * @param xyz_grad_length Total length of the `xyz_grad` array:
+     *        `n_samples x 3`.
+     */
+    void contract_gradients(
+        const T* sph_grad,
+        size_t sph_grad_length,
+        const T* dsph,
+        size_t dsph_length,
+        T* xyz_grad,
+        size_t xyz_grad_length
+    );
+
+    /** Computes the derivatives of the contraction done by
+     * `contract_gradients()` along the direction `xyz_vector`, from already
+     * computed gradients and Hessians of the spherical harmonics. These are
+     * the two quantities needed to differentiate twice through the
+     * spherical harmonics:
+     * \f$ j_{i,lm} = \sum_a v_{ia} \partial Y^m_l(r_i) / \partial r_{ia} \f$,
+     * the derivative with respect to `sph_grad`, and
+     * \f$ h_{ib} = \sum_a v_{ia} \sum_{lm} (\partial L / \partial
+     * Y^m_l(r_i)) \partial^2 Y^m_l(r_i) / \partial r_{ia} \partial r_{ib}
+     * \f$, the derivative with respect to the positions (the same as
+     * `compute_hvp()`). Both are computed in a single pass over the samples,
+     * without temporary arrays.
+     *
+     * Either output can be skipped by passing a null pointer and a length of
+     * 0, in which case the inputs used only by that output can also be null.
+     *
+     * @param sph_grad An array of size `n_samples x (l_max + 1)^2`, as in
+     *        `contract_gradients()`. Only used for `xyz_hvp`.
+     * @param sph_grad_length Total length of the `sph_grad` array.
+     * @param xyz_vector An array of size `n_samples x 3`, containing the
+     *        direction \f$ v \f$ for each point.
+     * @param xyz_vector_length Total length of the `xyz_vector` array:
+     *        `n_samples x 3`.
+     * @param dsph An array of size `n_samples x 3 x (l_max + 1)^2`, as in
+     *        `contract_gradients()`. Only used for `sph_jvp`.
+     * @param dsph_length Total length of the `dsph` array.
+     * @param ddsph An array of size `n_samples x 3 x 3 x (l_max + 1)^2`,
+     *        containing the Hessians of the spherical harmonics, in the same
+     *        layout as the `ddsph` output of `compute_array_with_hessians()`.
+     *        Only used for `xyz_hvp`.
+     * @param ddsph_length Total length of the `ddsph` array.
+     * @param sph_jvp On entry, an array of size `n_samples x (l_max + 1)^2`.
+     *        On exit, it contains the derivative of the spherical harmonics
+     *        along `xyz_vector`, in the same layout as `sph_grad`.
+     * @param sph_jvp_length Total length of the `sph_jvp` array.
+     * @param xyz_hvp On entry, an array of size `n_samples x 3`. On exit, it
+     *        contains the Hessian-vector product. This array does not depend
+     *        on the layout of the calculator.
+     * @param xyz_hvp_length Total length of the `xyz_hvp` array.
+     */
+    void contract_gradients_backward(
+        const T* sph_grad,
+        size_t sph_grad_length,
+        const T* xyz_vector,
+        size_t xyz_vector_length,
+        const T* dsph,
+        size_t dsph_length,
+        const T* ddsph,
+        size_t ddsph_length,
+        T* sph_jvp,
+        size_t sph_jvp_length,
+        T* xyz_hvp,
+        size_t xyz_hvp_length
+    );
+
     /** Computes the spherical harmonics for a single 3D point using bare
      * arrays.
      *
@@ -269,8 +907,15 @@ template <typename T> class SphericalHarmonics {
      * following order: `(l, m) = (0, 0), (1, -1), (1, 0), (1, 1), (2, -2), (2,
      * -1), (2, 0), (2, 1), (2, 2)`.
      * @param sph_length Total length of the `sph` array: `(l_max + 1)^2`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
      */
-    void compute_sample(const T* xyz, size_t xyz_length, T* sph, size_t sph_length);
+    void compute_sample(
+        const T* xyz,
+        size_t xyz_length,
+        T* sph,
+        size_t sph_length,
+        Workspace<T>* workspace = nullptr
+    );
 
     /** Computes the spherical harmonics and their derivatives for a single 3D
      *  point using bare arrays.
@@ -296,9 +941,16 @@ template <typename T> class SphericalHarmonics {
      * first dimension corresponds to the different spatial derivatives of the
      * spherical harmonics: x, y, and z, respectively.
      * @param dsph_length Total length of the `dsph` array: `3 x (l_max + 1)^2`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
      */
     void compute_sample_with_gradients(
-        const T* xyz, size_t xyz_length, T* sph, size_t sph_length, T* dsph, size_t dsph_length
+        const T* xyz,
+        size_t xyz_length,
+        T* sph,
+        size_t sph_length,
+        T* dsph,
+        size_t dsph_length,
+        Workspace<T>* workspace = nullptr
     );
 
     /** Computes the spherical harmonics, their derivatives and second
@@ -335,6 +987,7 @@ template <typename T> class SphericalHarmonics {
      *        correspond to the different spatial second derivatives of the
      * spherical harmonics, i.e., to the dimensions of the Hessian matrix.
      * @param ddsph_length Total length of the `ddsph` array: `9 x (l_max + 1)^2`.
+     * @param workspace Optional scratch memory for this call, see `Workspace`.
      */
     void compute_sample_with_hessians(
         const T* xyz,
@@ -344,7 +997,8 @@ template <typename T> class SphericalHarmonics {
         T* dsph,
         size_t dsph_length,
         T* ddsph,
-        size_t ddsph_length
+        size_t ddsph_length,
+        Workspace<T>* workspace = nullptr
     );
 
     /**
@@ -354,32 +1008,208 @@ template <typename T> class SphericalHarmonics {
     size_t get_l_max() { return this->l_max; }
 
     /**
-    Returns the number of threads used in the calculation
+    Returns the number of threads used in the calculation, i.e. the number of
+    workers of the parallel backend when the calculator was created
     */
-    int get_omp_num_threads() { return this->omp_num_threads; }
+    int get_omp_num_threads() { return static_cast<int>(this->n_workers); }
+
+    /**
+     * Returns the parallel backend used by this calculator.
+     */
+    std::shared_ptr<ParallelBackend> get_backend() { return this->backend; }
+
+    /**
+     * Returns the thresholds used to choose between serial and parallel
+     * evaluation of arrays of points, see `ParallelThresholds`.
+     */
+    ParallelThresholds get_parallel_thresholds() { return this->thresholds; }
+
+    /**
+     * Sets the thresholds used to choose between serial and parallel
+     * evaluation of arrays of points, e.g. after calibrating them with the
+     * C++ benchmark. Clones created afterwards use the same thresholds.
+     */
+    void set_parallel_thresholds(ParallelThresholds thresholds) { this->thresholds = thresholds; }
+
+    /**
+     * Returns the algorithm used by this calculator to evaluate arrays of
+     * points.
+     */
+    Engine get_engine() { return this->engine; }
+
+    /**
+     * Returns the memory layout of the outputs of this calculator.
+     */
+    Layout get_layout() { return this->layout; }
 
     /* @cond */
   private:
     template <typename U> friend class SolidHarmonics;
 
+    // shares the prefactors of `other`, see clone()
+    SphericalHarmonics(const SphericalHarmonics& other);
+    SphericalHarmonics& operator=(const SphericalHarmonics& other) = delete;
+
     size_t l_max;        // maximum l value computed by this class
     size_t size_y;       // size of the Ylm rows (l_max+1)**2
     size_t size_q;       // size of the prefactor-like arrays (l_max+1)*(l_max+2)/2
-    int omp_num_threads; // number of openmp thread
-    T* prefactors;       // storage space for prefactor and buffers
-    T* buffers;
+    size_t n_workers;    // number of workers of the parallel backend
+    Engine engine;       // algorithm used for the array calls
+    Layout layout;       // memory layout of the outputs
+    size_t buffer_size;  // size of the buffers for each worker
+
+    // distributes the work of the array calls over threads, shared with the
+    // clones of this calculator
+    std::shared_ptr<ParallelBackend> backend;
+    // decides how many workers the array calls use
+    ParallelThresholds thresholds;
+
+    // the prefactors are never modified after construction, and are shared
+    // with the clones of this calculator
+    std::shared_ptr<const T[]> prefactors;
+    // scratch memory for the calls without a workspace, allocated by the
+    // first of them
+    std::unique_ptr<T[]> buffers;
 
     // function pointers are used to set up the right functions to be called
     // these are set in the constructor, so that the public compute functions
     // can be redirected to the right implementation
-    void (*_array_no_derivatives)(const T*, T*, T*, T*, size_t, int, const T*, T*);
-    void (*_array_with_derivatives)(const T*, T*, T*, T*, size_t, int, const T*, T*);
-    void (*_array_with_hessians)(const T*, T*, T*, T*, size_t, int, const T*, T*);
+    void (*_array_no_derivatives)(
+        const T*,
+        T*,
+        T*,
+        T*,
+        size_t,
+        int,
+        const T*,
+        T*,
+        const OutputBlocks<T>*,
+        size_t,
+        ParallelBackend*,
+        size_t
+    );
+    void (*_array_with_derivatives)(
+        const T*,
+        T*,
+        T*,
+        T*,
+        size_t,
+        int,
+        const T*,
+        T*,
+        const OutputBlocks<T>*,
+        size_t,
+        ParallelBackend*,
+        size_t
+    );
+    void (*_array_with_hessians)(
+        const T*,
+        T*,
+        T*,
+        T*,
+        size_t,
+        int,
+        const T*,
+        T*,
+        const OutputBlocks<T>*,
+        size_t,
+        ParallelBackend*,
+        size_t
+    );
+
+    // describes where the kernels should store the outputs for `n_samples`
+    // points in the selected layout: either in the full arrays `sph[0]`,
+    // `dsph[0]` and `ddsph[0]`, or (if `per_l` is true) in one array for each
+    // degree l. The rows of full arrays are `row_strides[0]`, `[1]` and `[2]`
+    // elements apart, or packed if `row_strides` is nullptr. `storage` holds
+    // the blocks pointed to by the result. Returns nullptr if the outputs are
+    // packed full arrays in the sample-major layout, which the kernels fill
+    // directly
+    const OutputBlocks<T>* output_blocks(
+        size_t n_samples,
+        T* const* sph,
+        T* const* dsph,
+        T* const* ddsph,
+        bool per_l,
+        const size_t* row_strides,
+        std::vector<OutputBlock<T>>& storage,
+        OutputBlocks<T>& blocks
+    );
+
+    // number of workers to use for a call computing `n_outputs` values (1, 4
+    // or 13, see ParallelThresholds) for each of the spherical harmonics of
+    // `n_samples` points
+    size_t parallel_workers(size_t n_samples, size_t n_outputs) const;
+
+    // returns the buffers that the compute functions should use: the ones in
+    // `workspace` (resized as needed) if given, or this calculator's own
+    T* workspace_buffers(Workspace<T>* workspace);
+
+    // converts the gradients and Hessians of a single point from the
+    // sample-major to the selected layout, using `buffers` as scratch
+    void transpose_sample(T* dsph, T* ddsph, T* buffers);
 
     // these compute a single sample
     void (*_sample_no_derivatives)(const T*, T*, T*, T*, int, int, const T*, const T*, T*, T*, T*);
     void (*_sample_with_derivatives)(const T*, T*, T*, T*, int, int, const T*, const T*, T*, T*, T*);
     void (*_sample_with_hessians)(const T*, T*, T*, T*, int, int, const T*, const T*, T*, T*, T*);
+
+    // this computes the density expansion coefficients
+    void (*_density)(
+        const T*,
+        const T*,
+        size_t,
+        const size_t*,
+        size_t,
+        T*,
+        int,
+        const T*,
+        T*,
+        ParallelBackend*,
+        size_t
+    );
+
+    // this computes the vector-Jacobian product
+    void (*_vjp)(
+        const T*, const T*, T*, size_t, ArrayStrides, int, const T*, T*, ParallelBackend*, size_t
+    );
+
+    // this computes the Hessian-vector product
+    void (*_hvp)(
+        const T*,
+        const T*,
+        const T*,
+        T*,
+        size_t,
+        ArrayStrides,
+        int,
+        const T*,
+        T*,
+        ParallelBackend*,
+        size_t
+    );
+
+    // this contracts the gradients computed by the other functions
+    void (*_contract)(
+        const T*, const T*, T*, size_t, ArrayStrides, ArrayStrides, int, ParallelBackend*, size_t
+    );
+
+    // this computes the derivatives of the contraction above
+    void (*_contract_backward)(
+        const T*,
+        const T*,
+        const T*,
+        const T*,
+        T*,
+        T*,
+        size_t,
+        ArrayStrides,
+        ArrayStrides,
+        ArrayStrides,
+        int,
+        ParallelBackend*,
+        size_t
+    );
     /* @endcond */
 };
 
@@ -396,8 +1226,34 @@ template <typename T> class SolidHarmonics : public SphericalHarmonics<T> {
      *
      *  @param l_max
      *      The maximum degree of the solid harmonics to be calculated.
+     *  @param engine
+     *      The algorithm used to evaluate arrays of points, see `Engine`.
+     *  @param layout
+     *      The memory layout of the outputs, see `Layout`.
+     *  @param backend
+     *      How the calculator distributes arrays of points over threads, see
+     *      `ParallelBackend`.
      */
-    SolidHarmonics(size_t l_max);
+    SolidHarmonics(
+        size_t l_max,
+        Engine engine = Engine::SAMPLE,
+        Layout layout = Layout::SAMPLE_MAJOR,
+        std::shared_ptr<ParallelBackend> backend = nullptr
+    );
+
+    /* @cond */
+    SolidHarmonics(SolidHarmonics&& other) noexcept = default;
+    SolidHarmonics& operator=(SolidHarmonics&& other) noexcept = default;
+    /* @endcond */
+
+    /** Creates a new calculator sharing the prefactors of this one, see
+     * `SphericalHarmonics::clone()`. */
+    SolidHarmonics clone() const;
+
+    /* @cond */
+  private:
+    SolidHarmonics(const SolidHarmonics& other) = default;
+    /* @endcond */
 };
 
 } // namespace sphericart
@@ -0,0 +1,48 @@
+#ifndef SPHERICART_STRIDES_HPP
+#define SPHERICART_STRIDES_HPP
+
+/*
+    Description of the memory layout of the outputs of the array
+    calculators. This is used to write the spherical harmonics and their
+    derivatives directly in the layout requested by the user, rather than in
+    the default sample-major one, and possibly in separate arrays for each
+    degree l.
+
+    This header must be included outside of any namespace before the
+    templates, since the same types are shared by the kernels compiled for
+    all the instruction sets.
+*/
+
+#include <cstddef>
+
+namespace sphericart {
+
+/** Strides (in number of elements) of an array holding one of the outputs of
+ * the array calculators */
+struct ArrayStrides {
+    size_t sample;
+    size_t component;
+    size_t lm;
+};
+
+/** Storage for the entries of degree `l` of one of the outputs of the array
+ * calculators. The entry for sample `i`, derivative component `a` (0 to 2 for
+ * the gradients, 0 to 8 for the Hessians) and order `m` (0 to 2l, i.e.
+ * shifted by l) is stored at
+ * `data[i * strides.sample + a * strides.component + m * strides.lm]` */
+template <typename T> struct OutputBlock {
+    T* data;
+    ArrayStrides strides;
+};
+
+/** Storage for the three outputs of the array calculators, as arrays of
+ * `l_max + 1` blocks, one for each degree l */
+template <typename T> struct OutputBlocks {
+    const OutputBlock<T>* sph;
+    const OutputBlock<T>* dsph;
+    const OutputBlock<T>* ddsph;
+};
+
+} // namespace sphericart
+
+#endif
@@ -14,8 +14,12 @@
     different numbers of terms computed with hard-coded expressions.
 */
 
+#include "parallel.hpp"
+#include "strides.hpp"
 #include "templates_core.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <vector>
@@ -36,6 +40,123 @@ static inline int omp_get_thread_num() { return 0; }
 // a SPH_IDX that does nothing
 #define DUMMY_SPH_IDX
 
+/** Size (in number of T elements) of the thread-local buffers needed by
+ * hardcoded_sph and generic_sph, for each worker of the parallel backend. The
+ * buffer holds the cosine, sine and 2mz terms, followed by the values,
+ * gradients and Hessians of one sample, which are needed to write outputs to
+ * non-default blocks.
+ */
+template <typename T> size_t sph_buffer_size(int l_max) {
+    const auto size_y = static_cast<size_t>((l_max + 1) * (l_max + 1));
+    const auto size_q = static_cast<size_t>((l_max + 1) * (l_max + 2) / 2);
+    return 3 * size_q + 13 * size_y;
+}
+
+/** Distributes the indices in [0, n) between the workers of `backend` (or of
+ * the default OpenMP backend if it is null), using at most `max_workers` of
+ * them (or all of them if it is 0), and calls `function(worker, begin, end)`
+ * for the ranges given to each worker. With `max_workers == 1`, the whole
+ * range is computed on the calling thread. `worker` selects the part of the
+ * thread-local buffers to use. If `chunk_size` is 0, each worker gets a
+ * single contiguous range; otherwise the workers take chunks of `chunk_size`
+ * indices as they become free, which balances uneven amounts of work.
+ */
+template <typename F>
+static inline void parallel_for_samples(
+    sphericart::ParallelBackend* backend,
+    size_t max_workers,
+    int64_t n,
+    int64_t chunk_size,
+    const F& function
+) {
+    if (n <= 0) {
+        return;
+    }
+    if (max_workers == 1) {
+        // serial execution, without waking up the other workers
+        function(0, 0, n);
+        return;
+    }
+    if (backend == nullptr) {
+        backend = sphericart::openmp_backend().get();
+    }
+    if (max_workers == 0) {
+        max_workers = backend->max_workers();
+    }
+
+    if (chunk_size == 0) {
+        auto run_range = [&](size_t worker, size_t n_workers) {
+            auto begin = static_cast<int64_t>(worker * static_cast<size_t>(n) / n_workers);
+            auto end = static_cast<int64_t>((worker + 1) * static_cast<size_t>(n) / n_workers);
+            if (begin < end) {
+                function(worker, begin, end);
+            }
+        };
+        backend->run(max_workers, run_range);
+    } else {
+        std::atomic<int64_t> next_chunk(0);
+        auto run_chunks = [&](size_t worker, size_t /*n_workers*/) {
+            while (true) {
+                auto begin = next_chunk.fetch_add(chunk_size, std::memory_order_relaxed);
+                if (begin >= n) {
+                    break;
+                }
+                function(worker, begin, std::min(begin + chunk_size, n));
+            }
+        };
+        backend->run(max_workers, run_chunks);
+    }
+}
+
+/**
+ * Copies one output (values, gradients or Hessians) of one sample, stored
+ * contiguously in `values` as computed by the _sample functions, to the
+ * entries of sample `i_sample` in the given per-l blocks.
+ */
+template <typename T>
+static inline void scatter_sph_output(
+    const T* values,
+    size_t i_sample,
+    int l_max,
+    int n_components,
+    const sphericart::OutputBlock<T>* blocks
+) {
+    const auto size_y = (l_max + 1) * (l_max + 1);
+    for (int l = 0; l <= l_max; ++l) {
+        const auto& strides = blocks[l].strides;
+        auto output = blocks[l].data + i_sample * strides.sample;
+        for (int a = 0; a < n_components; ++a) {
+            auto values_l = values + a * size_y + l * l;
+            for (int m = 0; m < 2 * l + 1; ++m) {
+                output[a * strides.component + m * strides.lm] = values_l[m];
+            }
+        }
+    }
+}
+
+/**
+ * Copies the outputs for one sample, stored contiguously in `sph_i`, `dsph_i`
+ * and `ddsph_i` as computed by the _sample functions, to the entries of
+ * sample `i_sample` in the given output blocks.
+ */
+template <typename T, bool DO_DERIVATIVES, bool DO_SECOND_DERIVATIVES>
+static inline void scatter_sph_sample(
+    const T* sph_i,
+    [[maybe_unused]] const T* dsph_i,
+    [[maybe_unused]] const T* ddsph_i,
+    size_t i_sample,
+    int l_max,
+    const sphericart::OutputBlocks<T>& blocks
+) {
+    scatter_sph_output(sph_i, i_sample, l_max, 1, blocks.sph);
+    if constexpr (DO_DERIVATIVES) {
+        scatter_sph_output(dsph_i, i_sample, l_max, 3, blocks.dsph);
+    }
+    if constexpr (DO_SECOND_DERIVATIVES) {
+        scatter_sph_output(ddsph_i, i_sample, l_max, 9, blocks.ddsph);
+    }
+}
+
 /**
  * This function calculates the prefactors needed for the computation of the
  * spherical harmonics.
@@ -148,11 +269,6 @@ inline void hardcoded_sph_sample(
         !(DO_SECOND_DERIVATIVES && !DO_DERIVATIVES),
         "Cannot calculate second derivatives without first derivatives"
     );
-    static_assert(
-        !(DO_SECOND_DERIVATIVES && HARDCODED_LMAX > 1),
-        "Hardcoded second derivatives are only implemented up to l=1."
-    );
-
     auto x = xyz_i[0];
     auto y = xyz_i[1];
     auto z = xyz_i[2];
@@ -163,7 +279,8 @@ inline void hardcoded_sph_sample(
                                  // normalize the input vector
 
     if constexpr (NORMALIZED) {
-        ir = 1 / std::sqrt(x2 + y2 + z2);
+        using std::sqrt; // allows overloads for the batched implementation
+        ir = 1 / sqrt(x2 + y2 + z2);
         x *= ir;
         y *= ir;
         z *= ir;
@@ -276,7 +393,11 @@ void hardcoded_sph(
     [[maybe_unused]] int l_max_dummy =
         0, // dummy variables to have a uniform interface with generic_sph
     [[maybe_unused]] const T* prefactors_dummy = nullptr,
-    [[maybe_unused]] T* buffers_dummy = nullptr
+    [[maybe_unused]] T* buffers = nullptr,
+    const sphericart::OutputBlocks<T>* blocks = nullptr,
+    size_t xyz_stride = 3,
+    sphericart::ParallelBackend* backend = nullptr,
+    size_t max_workers = 0
 ) {
     /*
         Cartesian Ylm calculator using the hardcoded expressions.
@@ -296,38 +417,61 @@ void hardcoded_sph(
        second derivatives. stored as for sph_i, with nine consecutive blocks
        associated to the nine possible second derivative combinations size_t
        n_samples: number of samples that have to be computed
+        T *buffers: thread-local storage, only needed (and then with
+       sph_buffer_size elements per thread) if blocks is not null
+        const OutputBlocks<T> *blocks: where to store the outputs. If null,
+       they are stored contiguously in the sample-major order described above,
+       in sph, dsph and ddsph (which are then ignored)
+        size_t xyz_stride: distance between the coordinates of consecutive
+       samples in xyz (3 for a contiguous n_samples x 3 array)
+        ParallelBackend *backend, size_t max_workers: how to distribute the
+       samples over threads, see parallel_for_samples. buffers must hold
+       storage for max_workers workers (or all the workers of the backend)
 
     */
-    static_assert(
-        !(DO_SECOND_DERIVATIVES && HARDCODED_LMAX > 1),
-        "Hardcoded second derivatives are not implemented for l>1."
-    );
-
     constexpr auto size_y = (HARDCODED_LMAX + 1) * (HARDCODED_LMAX + 1);
+    constexpr auto size_q = (HARDCODED_LMAX + 1) * (HARDCODED_LMAX + 2) / 2;
 
-#pragma omp parallel
-    {
+    auto compute_samples = [&](size_t worker, int64_t begin, int64_t end) {
         const T* xyz_i = nullptr;
         T* sph_i = nullptr;
         T* dsph_i = nullptr;
         T* ddsph_i = nullptr;
 
-#pragma omp for
-        for (int64_t i_sample = 0; i_sample < n_samples; i_sample++) {
+        // with non-default output blocks, each sample is computed in
+        // thread-local storage and then copied to the outputs
+        T* scratch = nullptr;
+        if (blocks != nullptr) {
+            scratch = buffers + worker * sph_buffer_size<T>(HARDCODED_LMAX) + 3 * size_q;
+        }
+
+        for (int64_t i_sample = begin; i_sample < end; i_sample++) {
             // gets pointers to the current sample input and output arrays
-            xyz_i = xyz + i_sample * 3;
-            sph_i = sph + i_sample * size_y;
-            if constexpr (DO_DERIVATIVES) {
-                dsph_i = dsph + i_sample * size_y * 3;
-            }
-            if constexpr (DO_SECOND_DERIVATIVES) {
-                ddsph_i = ddsph + i_sample * size_y * 9;
+            xyz_i = xyz + i_sample * xyz_stride;
+            if (blocks != nullptr) {
+                sph_i = scratch;
+                dsph_i = scratch + size_y;
+                ddsph_i = scratch + 4 * size_y;
+            } else {
+                sph_i = sph + i_sample * size_y;
+                if constexpr (DO_DERIVATIVES) {
+                    dsph_i = dsph + i_sample * size_y * 3;
+                }
+                if constexpr (DO_SECOND_DERIVATIVES) {
+                    ddsph_i = ddsph + i_sample * size_y * 9;
+                }
             }
             hardcoded_sph_sample<T, DO_DERIVATIVES, DO_SECOND_DERIVATIVES, NORMALIZED, HARDCODED_LMAX>(
                 xyz_i, sph_i, dsph_i, ddsph_i, HARDCODED_LMAX, size_y
             );
+            if (blocks != nullptr) {
+                scatter_sph_sample<T, DO_DERIVATIVES, DO_SECOND_DERIVATIVES>(
+                    sph_i, dsph_i, ddsph_i, i_sample, HARDCODED_LMAX, *blocks
+                );
+            }
         }
-    }
+    };
+    parallel_for_samples(backend, max_workers, static_cast<int64_t>(n_samples), 0, compute_samples);
 }
 
 template <typename T, bool DO_DERIVATIVES, bool DO_SECOND_DERIVATIVES, bool NORMALIZED, int HARDCODED_LMAX>
@@ -354,11 +498,6 @@ static inline void generic_sph_sample(
 
     The parameters correspond to those described in generic_sph_l_channel.
     */
-    static_assert(
-        !(DO_SECOND_DERIVATIVES && HARDCODED_LMAX > 1),
-        "Hardcoded second derivatives are not implemented for l>1."
-    );
-
     [[maybe_unused]] T ir = 0.0; // storage for computing 1/r, which is reused when NORMALIZED=true
 
     // pointers for first derivatives
@@ -390,7 +529,8 @@ static inline void generic_sph_sample(
     [[maybe_unused]] auto y2 = y * y;
     [[maybe_unused]] auto z2 = z * z;
     if constexpr (NORMALIZED) {
-        ir = 1 / std::sqrt(x2 + y2 + z2);
+        using std::sqrt; // allows overloads for the batched implementation
+        ir = 1 / sqrt(x2 + y2 + z2);
         x *= ir;
         y *= ir;
         z *= ir;
@@ -623,7 +763,11 @@ void generic_sph(
     size_t n_samples,
     int l_max,
     const T* prefactors,
-    T* buffers
+    T* buffers,
+    const sphericart::OutputBlocks<T>* blocks = nullptr,
+    size_t xyz_stride = 3,
+    sphericart::ParallelBackend* backend = nullptr,
+    size_t max_workers = 0
 ) {
     /*
         Implementation of the general Ylm calculator case. Starts at
@@ -663,7 +807,12 @@ void generic_sph(
        n_samples: number of samples that have to be computed int l_max: maximum
        l to compute prefactors: pointer to an array that contains the prefactors
        used for Ylm and Qlm calculation buffers: buffer space to compute cosine,
-       sine and 2*m*z terms
+       sine and 2*m*z terms (3 * size_q elements per worker, or sph_buffer_size
+       if blocks is not null) blocks: where to store the outputs, or null to
+       store them contiguously in sph, dsph and ddsph, as described above
+       xyz_stride: distance between the coordinates of consecutive samples in
+       xyz (3 for a contiguous n_samples x 3 array) backend, max_workers: see
+       hardcoded_sph
     */
 
     // implementation assumes to use hardcoded expressions for at least l=0,1
@@ -674,13 +823,18 @@ void generic_sph(
     const T* qlmfactors = prefactors + size_q; // the coeffs. used to compute Qlm are just stored
                                                // contiguously after the Ylm prefactors
 
-#pragma omp parallel
-    {
-        auto c = buffers + omp_get_thread_num() * size_q * 3;
+    auto compute_samples = [&](size_t worker, int64_t begin, int64_t end) {
+        auto c = buffers + worker * size_q * 3;
+        if (blocks != nullptr) {
+            c = buffers + worker * sph_buffer_size<T>(l_max);
+        }
         auto s = c + size_q;
         auto twomz = s + size_q;
         // ^^^ thread-local storage arrays for terms corresponding to (scaled)
-        // cosine and sine of the azimuth, and 2mz
+        // cosine and sine of the azimuth, and 2mz. With non-default output
+        // blocks, they are followed by storage for the outputs of one sample,
+        // which are then copied to the blocks
+        auto scratch = twomz + size_q;
 
         // pointers to the sections of the output arrays that hold Ylm and
         // derivatives for a given point
@@ -688,25 +842,37 @@ void generic_sph(
         T* dsph_i = nullptr;
         T* ddsph_i = nullptr;
 
-#pragma omp for
-        for (int64_t i_sample = 0; i_sample < n_samples; i_sample++) {
-            auto xyz_i = xyz + i_sample * 3;
-            // pointer to the segment that should store the i_sample sph
-            sph_i = sph + i_sample * size_y;
-            if constexpr (DO_DERIVATIVES) {
-                // updates the pointer to the derivative storage
-                dsph_i = dsph + i_sample * 3 * size_y;
-            }
-            if constexpr (DO_SECOND_DERIVATIVES) {
-                // updates the pointer to the second derivative storage
-                ddsph_i = ddsph + i_sample * 9 * size_y;
+        for (int64_t i_sample = begin; i_sample < end; i_sample++) {
+            auto xyz_i = xyz + i_sample * xyz_stride;
+            if (blocks != nullptr) {
+                sph_i = scratch;
+                dsph_i = scratch + size_y;
+                ddsph_i = scratch + 4 * size_y;
+            } else {
+                // pointer to the segment that should store the i_sample sph
+                sph_i = sph + i_sample * size_y;
+                if constexpr (DO_DERIVATIVES) {
+                    // updates the pointer to the derivative storage
+                    dsph_i = dsph + i_sample * 3 * size_y;
+                }
+                if constexpr (DO_SECOND_DERIVATIVES) {
+                    // updates the pointer to the second derivative storage
+                    ddsph_i = ddsph + i_sample * 9 * size_y;
+                }
             }
 
             generic_sph_sample<T, DO_DERIVATIVES, DO_SECOND_DERIVATIVES, NORMALIZED, HARDCODED_LMAX>(
                 xyz_i, sph_i, dsph_i, ddsph_i, l_max, size_y, prefactors, qlmfactors, c, s, twomz
             );
+
+            if (blocks != nullptr) {
+                scatter_sph_sample<T, DO_DERIVATIVES, DO_SECOND_DERIVATIVES>(
+                    sph_i, dsph_i, ddsph_i, i_sample, l_max, *blocks
+                );
+            }
         }
-    }
+    };
+    parallel_for_samples(backend, max_workers, static_cast<int64_t>(n_samples), 0, compute_samples);
 }
 
 #endif
@@ -0,0 +1,368 @@
+#ifndef SPHERICART_TEMPLATES_BATCHED_HPP
+#define SPHERICART_TEMPLATES_BATCHED_HPP
+
+/*
+    Cross-sample ("batched") implementation of the Cartesian Ylm calculators.
+
+    The scalar calculators in templates.hpp evaluate one point at a time, so
+    the recursions in generic_sph_l_channel are a serial chain of scalar
+    operations. Here we evaluate blocks of SPHERICART_BATCH_SIZE<T> points at
+    once, storing each quantity as a `simd_pack` that holds one value per
+    point (a structure-of-arrays layout). The very same templates that
+    implement the scalar kernels are instantiated with T = simd_pack, so that
+    every arithmetic operation is a fixed-length loop over the points of the
+    block, which compilers turn into SIMD instructions.
+*/
+
+#include "templates.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+/** Number of points evaluated together by the batched calculators. These
+ * values have been tuned empirically on AVX2 and AVX-512 hardware: larger
+ * blocks of double precision values increase register pressure to the
+ * point where the gain from vectorization is lost. */
+template <typename T> constexpr int SPHERICART_BATCH_SIZE = sizeof(T) >= 8 ? 4 : 16;
+
+/** A fixed-size pack of `N` values of type `T`, one for each of the points
+ * in a block, that supports the arithmetic used by the Ylm calculators.
+ */
+template <typename T, int N> struct simd_pack {
+    T v[N];
+
+    simd_pack() = default;
+
+    // implicit conversion from scalars (e.g. the literals in macros.hpp)
+    // broadcasts the value to all the lanes
+    template <typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>
+    inline simd_pack(U value) {
+        for (int i = 0; i < N; ++i) {
+            v[i] = static_cast<T>(value);
+        }
+    }
+
+    inline simd_pack operator+() const { return *this; }
+
+    inline simd_pack operator-() const {
+        simd_pack result;
+        for (int i = 0; i < N; ++i) {
+            result.v[i] = -v[i];
+        }
+        return result;
+    }
+
+#define _SPHERICART_SIMD_PACK_COMPOUND_OPERATOR(OP)                                                \
+    inline simd_pack& operator OP## = (const simd_pack & other) {                                  \
+        for (int i = 0; i < N; ++i) {                                                              \
+            v[i] OP## = other.v[i];                                                                \
+        }                                                                                          \
+        return *this;                                                                              \
+    }                                                                                              \
+    template <typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>                    \
+    inline simd_pack& operator OP## = (U other) {                                                  \
+        const auto value = static_cast<T>(other);                                                  \
+        for (int i = 0; i < N; ++i) {                                                              \
+            v[i] OP## = value;                                                                     \
+        }                                                                                          \
+        return *this;                                                                              \
+    }
+
+    _SPHERICART_SIMD_PACK_COMPOUND_OPERATOR(+)
+    _SPHERICART_SIMD_PACK_COMPOUND_OPERATOR(-)
+    _SPHERICART_SIMD_PACK_COMPOUND_OPERATOR(*)
+    _SPHERICART_SIMD_PACK_COMPOUND_OPERATOR(/)
+
+#undef _SPHERICART_SIMD_PACK_COMPOUND_OPERATOR
+};
+
+#define _SPHERICART_SIMD_PACK_BINARY_OPERATOR(OP)                                                  \
+    template <typename T, int N>                                                                   \
+    inline simd_pack<T, N> operator OP(const simd_pack<T, N>& a, const simd_pack<T, N>& b) {       \
+        simd_pack<T, N> result;                                                                    \
+        for (int i = 0; i < N; ++i) {                                                              \
+            result.v[i] = a.v[i] OP b.v[i];                                                        \
+        }                                                                                          \
+        return result;                                                                             \
+    }                                                                                              \
+    template <typename T, int N, typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>> \
+    inline simd_pack<T, N> operator OP(const simd_pack<T, N>& a, U b) {                            \
+        const auto value = static_cast<T>(b);                                                      \
+        simd_pack<T, N> result;                                                                    \
+        for (int i = 0; i < N; ++i) {                                                              \
+            result.v[i] = a.v[i] OP value;                                                         \
+        }                                                                                          \
+        return result;                                                                             \
+    }                                                                                              \
+    template <typename T, int N, typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>> \
+    inline simd_pack<T, N> operator OP(U a, const simd_pack<T, N>& b) {                            \
+        const auto value = static_cast<T>(a);                                                      \
+        simd_pack<T, N> result;                                                                    \
+        for (int i = 0; i < N; ++i) {                                                              \
+            result.v[i] = value OP b.v[i];                                                         \
+        }                                                                                          \
+        return result;                                                                             \
+    }
+
+_SPHERICART_SIMD_PACK_BINARY_OPERATOR(+)
+_SPHERICART_SIMD_PACK_BINARY_OPERATOR(-)
+_SPHERICART_SIMD_PACK_BINARY_OPERATOR(*)
+_SPHERICART_SIMD_PACK_BINARY_OPERATOR(/)
+
+#undef _SPHERICART_SIMD_PACK_BINARY_OPERATOR
+
+// found by argument-dependent lookup from the normalization code
+template <typename T, int N> inline simd_pack<T, N> sqrt(const simd_pack<T, N>& a) {
+    simd_pack<T, N> result;
+    for (int i = 0; i < N; ++i) {
+        result.v[i] = std::sqrt(a.v[i]);
+    }
+    return result;
+}
+
+/** Size (in number of T elements) of the thread-local buffers needed by the
+ * batched calculators, for each worker of the parallel backend. The buffer holds the broadcast
+ * prefactors, the cosine, sine and 2mz terms, and the block of outputs
+ * (values, gradients and Hessians), all stored as packs.
+ */
+template <typename T> size_t batched_sph_buffer_size(int l_max) {
+    const auto size_y = static_cast<size_t>((l_max + 1) * (l_max + 1));
+    const auto size_q = static_cast<size_t>((l_max + 1) * (l_max + 2) / 2);
+    return (2 * size_q + 3 * size_q + 13 * size_y) * SPHERICART_BATCH_SIZE<T>;
+}
+
+/**
+ * Copies the `n_components x size_y` packs computed for a block of points
+ * starting at `i_start` to the given per-l output blocks. The loops are
+ * ordered so that the innermost one runs along the smallest stride of each
+ * output block.
+ */
+template <typename T, int N>
+static inline void scatter_sph_block(
+    const simd_pack<T, N>* values,
+    size_t i_start,
+    int n_valid,
+    int l_max,
+    int n_components,
+    const sphericart::OutputBlock<T>* blocks
+) {
+    const auto size_y = (l_max + 1) * (l_max + 1);
+    for (int l = 0; l <= l_max; ++l) {
+        const auto& strides = blocks[l].strides;
+        auto output = blocks[l].data + i_start * strides.sample;
+        if (strides.sample < strides.lm) {
+            // e.g. lm-major outputs, where consecutive points are contiguous
+            for (int a = 0; a < n_components; ++a) {
+                for (int m = 0; m < 2 * l + 1; ++m) {
+                    auto output_am = output + a * strides.component + m * strides.lm;
+                    const auto& values_am = values[a * size_y + l * l + m];
+                    for (int b = 0; b < n_valid; ++b) {
+                        output_am[b * strides.sample] = values_am.v[b];
+                    }
+                }
+            }
+        } else {
+            for (int b = 0; b < n_valid; ++b) {
+                auto output_b = output + b * strides.sample;
+                for (int a = 0; a < n_components; ++a) {
+                    for (int m = 0; m < 2 * l + 1; ++m) {
+                        output_b[a * strides.component + m * strides.lm] =
+                            values[a * size_y + l * l + m].v[b];
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename T, bool DO_DERIVATIVES, bool DO_SECOND_DERIVATIVES, bool NORMALIZED, int HARDCODED_LMAX, bool GENERIC>
+void batched_sph(
+    const T* xyz,
+    T* sph,
+    [[maybe_unused]] T* dsph,
+    [[maybe_unused]] T* ddsph,
+    size_t n_samples,
+    int l_max,
+    const T* prefactors,
+    T* buffers,
+    const sphericart::OutputBlocks<T>* blocks,
+    size_t xyz_stride,
+    sphericart::ParallelBackend* backend,
+    size_t max_workers
+) {
+    /*
+        Cross-sample Ylm calculator. Points are processed in blocks of
+        N = SPHERICART_BATCH_SIZE<T>: each block is gathered from the xyz
+        array into packs, evaluated with hardcoded_sph_sample or
+        generic_sph_sample instantiated on packs, and scattered back to the
+        output arrays, either in the usual sample-major layout or in the
+        given output blocks. The last block is padded by repeating its last
+        point, and only the valid lanes are stored.
+
+        Template parameters: see generic_sph, with
+        bool GENERIC: use generic_sph_sample (otherwise, hardcoded_sph_sample
+        for l_max = HARDCODED_LMAX)
+
+        Actual parameters: see generic_sph. `buffers` should hold
+        batched_sph_buffer_size<T>(l_max) elements per worker.
+    */
+    constexpr int N = SPHERICART_BATCH_SIZE<T>;
+    using pack = simd_pack<T, N>;
+
+    const auto size_y = (l_max + 1) * (l_max + 1);
+    const auto size_q = (l_max + 1) * (l_max + 2) / 2;
+    const auto n_blocks = static_cast<int64_t>((n_samples + N - 1) / N);
+
+    auto compute_blocks = [&](size_t worker, int64_t begin, int64_t end) {
+        // thread-local storage, see batched_sph_buffer_size
+        auto thread_buffer =
+            reinterpret_cast<pack*>(buffers + worker * batched_sph_buffer_size<T>(l_max));
+        auto pylm = thread_buffer;
+        auto pqlm = pylm + size_q;
+        auto c = pqlm + size_q;
+        auto s = c + size_q;
+        auto twomz = s + size_q;
+        auto sph_block = twomz + size_q;
+        auto dsph_block = sph_block + size_y;
+        auto ddsph_block = dsph_block + 3 * size_y;
+
+        if constexpr (GENERIC) {
+            for (int k = 0; k < 2 * size_q; ++k) {
+                pylm[k] = prefactors[k];
+            }
+        }
+
+        pack xyz_block[3];
+
+        for (int64_t i_block = begin; i_block < end; i_block++) {
+            const auto i_start = static_cast<size_t>(i_block) * N;
+            const auto n_valid = static_cast<int>(
+                n_samples - i_start < static_cast<size_t>(N) ? n_samples - i_start : N
+            );
+
+            // gather the block in structure-of-arrays form
+            for (int b = 0; b < N; ++b) {
+                auto xyz_i = xyz + (i_start + (b < n_valid ? b : n_valid - 1)) * xyz_stride;
+                xyz_block[0].v[b] = xyz_i[0];
+                xyz_block[1].v[b] = xyz_i[1];
+                xyz_block[2].v[b] = xyz_i[2];
+            }
+
+            if constexpr (GENERIC) {
+                generic_sph_sample<pack, DO_DERIVATIVES, DO_SECOND_DERIVATIVES, NORMALIZED, HARDCODED_LMAX>(
+                    xyz_block, sph_block, dsph_block, ddsph_block, l_max, size_y, pylm, pqlm, c, s, twomz
+                );
+            } else {
+                hardcoded_sph_sample<pack, DO_DERIVATIVES, DO_SECOND_DERIVATIVES, NORMALIZED, HARDCODED_LMAX>(
+                    xyz_block, sph_block, dsph_block, ddsph_block, HARDCODED_LMAX, size_y
+                );
+            }
+
+            if (blocks != nullptr) {
+                scatter_sph_block(sph_block, i_start, n_valid, l_max, 1, blocks->sph);
+                if constexpr (DO_DERIVATIVES) {
+                    scatter_sph_block(dsph_block, i_start, n_valid, l_max, 3, blocks->dsph);
+                }
+                if constexpr (DO_SECOND_DERIVATIVES) {
+                    scatter_sph_block(ddsph_block, i_start, n_valid, l_max, 9, blocks->ddsph);
+                }
+                continue;
+            }
+
+            // scatter back to the sample-major outputs
+            for (int b = 0; b < n_valid; ++b) {
+                auto sph_i = sph + (i_start + b) * size_y;
+                for (int k = 0; k < size_y; ++k) {
+                    sph_i[k] = sph_block[k].v[b];
+                }
+                if constexpr (DO_DERIVATIVES) {
+                    auto dsph_i = dsph + (i_start + b) * 3 * size_y;
+                    for (int k = 0; k < 3 * size_y; ++k) {
+                        dsph_i[k] = dsph_block[k].v[b];
+                    }
+                }
+                if constexpr (DO_SECOND_DERIVATIVES) {
+                    auto ddsph_i = ddsph + (i_start + b) * 9 * size_y;
+                    for (int k = 0; k < 9 * size_y; ++k) {
+                        ddsph_i[k] = ddsph_block[k].v[b];
+                    }
+                }
+            }
+        }
+    };
+    parallel_for_samples(backend, max_workers, n_blocks, 0, compute_blocks);
+}
+
+template <typename T, bool DO_DERIVATIVES, bool DO_SECOND_DERIVATIVES, bool NORMALIZED, int HARDCODED_LMAX>
+void hardcoded_sph_batched(
+    const T* xyz,
+    T* sph,
+    T* dsph,
+    T* ddsph,
+    size_t n_samples,
+    int l_max,
+    const T* prefactors,
+    T* buffers,
+    const sphericart::OutputBlocks<T>* blocks = nullptr,
+    size_t xyz_stride = 3,
+    sphericart::ParallelBackend* backend = nullptr,
+    size_t max_workers = 0
+) {
+    /*
+        Batched version of hardcoded_sph, with the same interface. Unlike
+        hardcoded_sph, it needs the thread-local buffers.
+    */
+    batched_sph<T, DO_DERIVATIVES, DO_SECOND_DERIVATIVES, NORMALIZED, HARDCODED_LMAX, false>(
+        xyz,
+        sph,
+        dsph,
+        ddsph,
+        n_samples,
+        l_max,
+        prefactors,
+        buffers,
+        blocks,
+        xyz_stride,
+        backend,
+        max_workers
+    );
+}
+
+template <typename T, bool DO_DERIVATIVES, bool DO_SECOND_DERIVATIVES, bool NORMALIZED, int HARDCODED_LMAX>
+void generic_sph_batched(
+    const T* xyz,
+    T* sph,
+    T* dsph,
+    T* ddsph,
+    size_t n_samples,
+    int l_max,
+    const T* prefactors,
+    T* buffers,
+    const sphericart::OutputBlocks<T>* blocks = nullptr,
+    size_t xyz_stride = 3,
+    sphericart::ParallelBackend* backend = nullptr,
+    size_t max_workers = 0
+) {
+    /*
+        Batched version of generic_sph, with the same interface. `buffers`
+        must be sized with batched_sph_buffer_size.
+    */
+    static_assert(HARDCODED_LMAX >= 1, "Cannot call the generic Ylm calculator for l<=1.");
+    batched_sph<T, DO_DERIVATIVES, DO_SECOND_DERIVATIVES, NORMALIZED, HARDCODED_LMAX, true>(
+        xyz,
+        sph,
+        dsph,
+        ddsph,
+        n_samples,
+        l_max,
+        prefactors,
+        buffers,
+        blocks,
+        xyz_stride,
+        backend,
+        max_workers
+    );
+}
+
+#endif
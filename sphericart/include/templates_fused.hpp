@@ -0,0 +1,523 @@
+#ifndef SPHERICART_TEMPLATES_FUSED_HPP
+#define SPHERICART_TEMPLATES_FUSED_HPP
+
+/*
+    Fused calculators, which contract the spherical harmonics with other
+    arrays as soon as they are computed. Each point is evaluated with the
+    _sample functions into thread-local storage, so that the spherical
+    harmonics of individual points are never written to memory.
+
+    All of these use the same thread-local buffers as hardcoded_sph and
+    generic_sph with output blocks, i.e. sph_buffer_size elements per worker,
+    holding the cosine, sine and 2mz terms followed by the outputs for one
+    point, and distribute their work over the workers of `backend` as
+    described in parallel_for_samples.
+*/
+
+#include "templates.hpp"
+
+#include <cstdint>
+
+// evaluates a single point with generic_sph_sample or hardcoded_sph_sample,
+// using the cosine, sine and 2mz buffers `c`, `s` and `twomz`
+template <
+    typename T,
+    bool DO_DERIVATIVES,
+    bool DO_SECOND_DERIVATIVES,
+    bool NORMALIZED,
+    int HARDCODED_LMAX,
+    bool GENERIC>
+static inline void fused_sph_sample(
+    const T* xyz,
+    T* sph,
+    T* dsph,
+    T* ddsph,
+    int l_max,
+    int size_y,
+    const T* prefactors,
+    T* c,
+    T* s,
+    T* twomz
+) {
+    if constexpr (GENERIC) {
+        const auto size_q = (l_max + 1) * (l_max + 2) / 2;
+        generic_sph_sample<T, DO_DERIVATIVES, DO_SECOND_DERIVATIVES, NORMALIZED, HARDCODED_LMAX>(
+            xyz, sph, dsph, ddsph, l_max, size_y, prefactors, prefactors + size_q, c, s, twomz
+        );
+    } else {
+        hardcoded_sph_sample<T, DO_DERIVATIVES, DO_SECOND_DERIVATIVES, NORMALIZED, HARDCODED_LMAX>(
+            xyz, sph, dsph, ddsph, HARDCODED_LMAX, size_y
+        );
+    }
+}
+
+template <typename T, bool NORMALIZED, int HARDCODED_LMAX, bool GENERIC>
+void density_sph(
+    const T* xyz,
+    const T* radial,
+    size_t n_radial,
+    const size_t* centre_offsets,
+    size_t n_centres,
+    T* coefficients,
+    int l_max,
+    const T* prefactors,
+    T* buffers,
+    sphericart::ParallelBackend* backend = nullptr,
+    size_t max_workers = 0
+) {
+    /*
+        Density expansion calculator, computing
+
+            c[i, n, lm] = sum_{j in neighbours(i)} R[j, n] Y_lm(r_ij)
+
+        Template parameters: see generic_sph, with
+        bool GENERIC: use generic_sph_sample (otherwise, hardcoded_sph_sample
+        for l_max = HARDCODED_LMAX)
+
+        Actual parameters:
+        const T *xyz: n_pairs x 3 array with the vectors r_ij of all pairs,
+       grouped by centre
+        const T *radial: n_pairs x n_radial array with the radial weights
+       R[j, n] of each pair
+        const size_t *centre_offsets: n_centres + 1 offsets (in CSR format),
+       the pairs of centre i are the ones from centre_offsets[i] to
+       centre_offsets[i + 1] (excluded)
+        T *coefficients: n_centres x n_radial x (l_max + 1)^2 output array
+        int l_max, const T *prefactors: see generic_sph
+        T *buffers: thread-local storage, see above
+        ParallelBackend *backend, size_t max_workers: see hardcoded_sph
+    */
+    const auto size_y = (l_max + 1) * (l_max + 1);
+    const auto size_q = (l_max + 1) * (l_max + 2) / 2;
+    const auto n_coefficients = n_radial * static_cast<size_t>(size_y);
+
+    auto compute_centres = [&](size_t worker, int64_t begin, int64_t end) {
+        auto c = buffers + worker * sph_buffer_size<T>(l_max);
+        auto s = c + size_q;
+        auto twomz = s + size_q;
+        auto sph_j = twomz + size_q;
+
+        for (int64_t i_centre = begin; i_centre < end; i_centre++) {
+            auto coefficients_i = coefficients + i_centre * n_coefficients;
+            for (size_t k = 0; k < n_coefficients; k++) {
+                coefficients_i[k] = 0;
+            }
+
+            for (auto j = centre_offsets[i_centre]; j < centre_offsets[i_centre + 1]; j++) {
+                fused_sph_sample<T, false, false, NORMALIZED, HARDCODED_LMAX, GENERIC>(
+                    xyz + 3 * j, sph_j, nullptr, nullptr, l_max, size_y, prefactors, c, s, twomz
+                );
+
+                auto radial_j = radial + j * n_radial;
+                for (size_t n = 0; n < n_radial; n++) {
+                    const auto weight = radial_j[n];
+                    auto coefficients_in = coefficients_i + n * size_y;
+                    for (int k = 0; k < size_y; k++) {
+                        coefficients_in[k] += weight * sph_j[k];
+                    }
+                }
+            }
+        }
+    };
+    // centres can have very different numbers of neighbours, so they are
+    // distributed dynamically, in chunks of 8. Each centre is owned by a single
+    // worker, which accumulates its coefficients without synchronization
+    parallel_for_samples(backend, max_workers, static_cast<int64_t>(n_centres), 8, compute_centres);
+}
+
+template <typename T, bool NORMALIZED, int HARDCODED_LMAX, bool GENERIC>
+void vjp_sph(
+    const T* xyz,
+    const T* sph_grad,
+    T* xyz_grad,
+    size_t n_samples,
+    sphericart::ArrayStrides sph_grad_strides,
+    int l_max,
+    const T* prefactors,
+    T* buffers,
+    sphericart::ParallelBackend* backend = nullptr,
+    size_t max_workers = 0
+) {
+    /*
+        Vector-Jacobian product calculator, computing the gradient of a
+        function of the spherical harmonics with respect to the positions,
+
+            xyz_grad[i, a] = sum_lm sph_grad[i, lm] dY_lm(r_i)/da
+
+        from the gradient sph_grad with respect to the spherical harmonics.
+        The derivatives of the spherical harmonics are only stored for one
+        point at a time.
+
+        Template parameters: see density_sph
+
+        Actual parameters:
+        const T *xyz: n_samples x 3 array with the positions
+        const T *sph_grad: gradients with respect to the spherical harmonics,
+       with entry (i, lm) stored at i * sph_grad_strides.sample + lm *
+       sph_grad_strides.lm
+        T *xyz_grad: n_samples x 3 output array
+        int l_max, const T *prefactors: see generic_sph
+        T *buffers: thread-local storage, see above
+        ParallelBackend *backend, size_t max_workers: see hardcoded_sph
+    */
+    const auto size_y = (l_max + 1) * (l_max + 1);
+    const auto size_q = (l_max + 1) * (l_max + 2) / 2;
+
+    auto compute_samples = [&](size_t worker, int64_t begin, int64_t end) {
+        auto c = buffers + worker * sph_buffer_size<T>(l_max);
+        auto s = c + size_q;
+        auto twomz = s + size_q;
+        auto sph_i = twomz + size_q;
+        auto dsph_i = sph_i + size_y;
+
+        for (int64_t i_sample = begin; i_sample < end; i_sample++) {
+            fused_sph_sample<T, true, false, NORMALIZED, HARDCODED_LMAX, GENERIC>(
+                xyz + 3 * i_sample, sph_i, dsph_i, nullptr, l_max, size_y, prefactors, c, s, twomz
+            );
+
+            auto sph_grad_i = sph_grad + i_sample * sph_grad_strides.sample;
+            for (int a = 0; a < 3; a++) {
+                auto dsph_ia = dsph_i + a * size_y;
+                T accumulated = 0;
+                for (int k = 0; k < size_y; k++) {
+                    accumulated += sph_grad_i[k * sph_grad_strides.lm] * dsph_ia[k];
+                }
+                xyz_grad[3 * i_sample + a] = accumulated;
+            }
+        }
+    };
+    parallel_for_samples(backend, max_workers, static_cast<int64_t>(n_samples), 0, compute_samples);
+}
+
+template <typename T, bool NORMALIZED, int HARDCODED_LMAX, bool GENERIC>
+void hvp_sph(
+    const T* xyz,
+    const T* sph_grad,
+    const T* xyz_vector,
+    T* xyz_hvp,
+    size_t n_samples,
+    sphericart::ArrayStrides sph_grad_strides,
+    int l_max,
+    const T* prefactors,
+    T* buffers,
+    sphericart::ParallelBackend* backend = nullptr,
+    size_t max_workers = 0
+) {
+    /*
+        Hessian-vector product calculator, computing the derivative of the
+        vector-Jacobian product of vjp_sph along xyz_vector,
+
+            xyz_hvp[i, b] = sum_a xyz_vector[i, a] sum_lm sph_grad[i, lm]
+                            d^2Y_lm(r_i)/dadb
+
+        The Hessians of the spherical harmonics are only stored for one point
+        at a time.
+
+        Template parameters: see density_sph
+
+        Actual parameters:
+        const T *xyz: n_samples x 3 array with the positions
+        const T *sph_grad: see vjp_sph
+        const T *xyz_vector: n_samples x 3 array with the vector multiplying
+       the Hessians
+        T *xyz_hvp: n_samples x 3 output array
+        int l_max, const T *prefactors: see generic_sph
+        T *buffers: thread-local storage, see above
+        ParallelBackend *backend, size_t max_workers: see hardcoded_sph
+    */
+    const auto size_y = (l_max + 1) * (l_max + 1);
+    const auto size_q = (l_max + 1) * (l_max + 2) / 2;
+
+    auto compute_samples = [&](size_t worker, int64_t begin, int64_t end) {
+        auto c = buffers + worker * sph_buffer_size<T>(l_max);
+        auto s = c + size_q;
+        auto twomz = s + size_q;
+        auto sph_i = twomz + size_q;
+        auto dsph_i = sph_i + size_y;
+        auto ddsph_i = dsph_i + 3 * size_y;
+
+        for (int64_t i_sample = begin; i_sample < end; i_sample++) {
+            fused_sph_sample<T, true, true, NORMALIZED, HARDCODED_LMAX, GENERIC>(
+                xyz + 3 * i_sample, sph_i, dsph_i, ddsph_i, l_max, size_y, prefactors, c, s, twomz
+            );
+
+            // contracts the Hessians with the gradient first, giving the
+            // 3 x 3 matrix sum_lm sph_grad[i, lm] d^2Y_lm/dadb
+            auto sph_grad_i = sph_grad + i_sample * sph_grad_strides.sample;
+            T contracted[9];
+            for (int ab = 0; ab < 9; ab++) {
+                auto ddsph_iab = ddsph_i + ab * size_y;
+                T accumulated = 0;
+                for (int k = 0; k < size_y; k++) {
+                    accumulated += sph_grad_i[k * sph_grad_strides.lm] * ddsph_iab[k];
+                }
+                contracted[ab] = accumulated;
+            }
+
+            auto xyz_vector_i = xyz_vector + 3 * i_sample;
+            for (int b = 0; b < 3; b++) {
+                xyz_hvp[3 * i_sample + b] = xyz_vector_i[0] * contracted[b] +
+                                            xyz_vector_i[1] * contracted[3 + b] +
+                                            xyz_vector_i[2] * contracted[6 + b];
+            }
+        }
+    };
+    parallel_for_samples(backend, max_workers, static_cast<int64_t>(n_samples), 0, compute_samples);
+}
+
+template <typename T>
+void contract_gradients_sph(
+    const T* sph_grad,
+    const T* dsph,
+    T* xyz_grad,
+    size_t n_samples,
+    sphericart::ArrayStrides sph_grad_strides,
+    sphericart::ArrayStrides dsph_strides,
+    int size_y,
+    sphericart::ParallelBackend* backend = nullptr,
+    size_t max_workers = 0
+) {
+    /*
+        Contraction of already computed gradients of the spherical harmonics
+        with the gradient of a function with respect to them,
+
+            xyz_grad[i, a] = sum_lm sph_grad[i, lm] dsph[i, a, lm]
+
+        i.e. the same result as vjp_sph, for callers that stored dsph in the
+        forward pass. The three components are accumulated together, in a
+        single pass over the entries of each sample. Unlike the other fused
+        calculators, this does not use any buffers.
+
+        Actual parameters:
+        const T *sph_grad: gradients with respect to the spherical harmonics,
+       with entry (i, lm) stored at i * sph_grad_strides.sample + lm *
+       sph_grad_strides.lm
+        const T *dsph: gradients of the spherical harmonics, with entry
+       (i, a, lm) stored at i * dsph_strides.sample + a *
+       dsph_strides.component + lm * dsph_strides.lm
+        T *xyz_grad: n_samples x 3 output array
+        int size_y: number of spherical harmonics, (l_max + 1)^2
+        ParallelBackend *backend, size_t max_workers: see hardcoded_sph
+    */
+    // number of partial sums for each component. The partial sums of
+    // consecutive entries are independent, which lets the compiler keep them
+    // in SIMD registers without re-associating the additions
+    constexpr int LANES = 8;
+
+    auto contract_contiguous = [&](int64_t begin, int64_t end) {
+        // sample-major layout: the entries of each sample are contiguous
+        for (int64_t i_sample = begin; i_sample < end; i_sample++) {
+            auto sph_grad_i = sph_grad + i_sample * sph_grad_strides.sample;
+            auto dx = dsph + i_sample * dsph_strides.sample;
+            auto dy = dx + dsph_strides.component;
+            auto dz = dy + dsph_strides.component;
+
+            T partial[3][LANES] = {};
+            int k = 0;
+            for (; k + LANES <= size_y; k += LANES) {
+                for (int j = 0; j < LANES; j++) {
+                    auto g = sph_grad_i[k + j];
+                    partial[0][j] += g * dx[k + j];
+                    partial[1][j] += g * dy[k + j];
+                    partial[2][j] += g * dz[k + j];
+                }
+            }
+            for (int j = 0; k < size_y; k++, j++) {
+                auto g = sph_grad_i[k];
+                partial[0][j] += g * dx[k];
+                partial[1][j] += g * dy[k];
+                partial[2][j] += g * dz[k];
+            }
+
+            for (int a = 0; a < 3; a++) {
+                T accumulated = 0;
+                for (int j = 0; j < LANES; j++) {
+                    accumulated += partial[a][j];
+                }
+                xyz_grad[3 * i_sample + a] = accumulated;
+            }
+        }
+    };
+
+    auto contract_lm_major = [&](int64_t begin, int64_t end) {
+        // lm-major layout: the samples are contiguous, so a block of them is
+        // accumulated together for each (l, m)
+        constexpr int64_t BLOCK = 16 * LANES;
+        T accumulated[3][BLOCK];
+        for (int64_t block_begin = begin; block_begin < end; block_begin += BLOCK) {
+            auto block_size = std::min(BLOCK, end - block_begin);
+            for (int a = 0; a < 3; a++) {
+                std::fill(accumulated[a], accumulated[a] + block_size, T(0));
+            }
+            for (int k = 0; k < size_y; k++) {
+                auto g = sph_grad + k * sph_grad_strides.lm + block_begin;
+                for (int a = 0; a < 3; a++) {
+                    auto d = dsph + a * dsph_strides.component + k * dsph_strides.lm + block_begin;
+                    for (int64_t j = 0; j < block_size; j++) {
+                        accumulated[a][j] += g[j] * d[j];
+                    }
+                }
+            }
+            for (int64_t j = 0; j < block_size; j++) {
+                for (int a = 0; a < 3; a++) {
+                    xyz_grad[3 * (block_begin + j) + a] = accumulated[a][j];
+                }
+            }
+        }
+    };
+
+    auto contract_strided = [&](int64_t begin, int64_t end) {
+        // any other layout, e.g. xyz-innermost, still reading the three
+        // components of each entry together
+        for (int64_t i_sample = begin; i_sample < end; i_sample++) {
+            auto sph_grad_i = sph_grad + i_sample * sph_grad_strides.sample;
+            auto dsph_i = dsph + i_sample * dsph_strides.sample;
+            T x = 0, y = 0, z = 0;
+            for (int k = 0; k < size_y; k++) {
+                auto g = sph_grad_i[k * sph_grad_strides.lm];
+                auto d = dsph_i + k * dsph_strides.lm;
+                x += g * d[0];
+                y += g * d[dsph_strides.component];
+                z += g * d[2 * dsph_strides.component];
+            }
+            xyz_grad[3 * i_sample + 0] = x;
+            xyz_grad[3 * i_sample + 1] = y;
+            xyz_grad[3 * i_sample + 2] = z;
+        }
+    };
+
+    auto contract = [&](size_t /*worker*/, int64_t begin, int64_t end) {
+        if (sph_grad_strides.lm == 1 && dsph_strides.lm == 1) {
+            contract_contiguous(begin, end);
+        } else if (sph_grad_strides.sample == 1 && dsph_strides.sample == 1) {
+            contract_lm_major(begin, end);
+        } else {
+            contract_strided(begin, end);
+        }
+    };
+    parallel_for_samples(backend, max_workers, static_cast<int64_t>(n_samples), 0, contract);
+}
+
+template <typename T>
+void contract_gradients_backward_sph(
+    const T* sph_grad,
+    const T* xyz_vector,
+    const T* dsph,
+    const T* ddsph,
+    T* sph_jvp,
+    T* xyz_hvp,
+    size_t n_samples,
+    sphericart::ArrayStrides sph_strides,
+    sphericart::ArrayStrides dsph_strides,
+    sphericart::ArrayStrides ddsph_strides,
+    int size_y,
+    sphericart::ParallelBackend* backend = nullptr,
+    size_t max_workers = 0
+) {
+    /*
+        Derivatives of the contraction in contract_gradients_sph along
+        xyz_vector, from already computed gradients and Hessians of the
+        spherical harmonics,
+
+            sph_jvp[i, lm] = sum_a xyz_vector[i, a] dsph[i, a, lm]
+            xyz_hvp[i, b] = sum_a xyz_vector[i, a] sum_lm sph_grad[i, lm]
+                            ddsph[i, a, b, lm]
+
+        i.e. the derivatives needed to differentiate twice through the
+        spherical harmonics, with respect to sph_grad and to the positions.
+        Both are computed in the same pass over the samples, and either can
+        be skipped by giving a null pointer (ddsph and sph_grad are only used
+        for xyz_hvp).
+
+        Actual parameters:
+        const T *sph_grad: see contract_gradients_sph, using sph_strides
+        const T *xyz_vector: n_samples x 3 array with the direction
+        const T *dsph: see contract_gradients_sph
+        const T *ddsph: Hessians of the spherical harmonics, with entry
+       (i, ab, lm) stored at i * ddsph_strides.sample + ab *
+       ddsph_strides.component + lm * ddsph_strides.lm
+        T *sph_jvp: output with the same layout as sph_grad, or nullptr
+        T *xyz_hvp: n_samples x 3 output array, or nullptr
+        int size_y: number of spherical harmonics, (l_max + 1)^2
+        ParallelBackend *backend, size_t max_workers: see hardcoded_sph
+    */
+    // see contract_gradients_sph
+    constexpr int LANES = 8;
+
+    auto jvp_sample = [&](int64_t i_sample) {
+        auto v = xyz_vector + 3 * i_sample;
+        auto dsph_i = dsph + i_sample * dsph_strides.sample;
+        auto sph_jvp_i = sph_jvp + i_sample * sph_strides.sample;
+        auto component = dsph_strides.component;
+        if (sph_strides.lm == 1 && dsph_strides.lm == 1) {
+            for (int k = 0; k < size_y; k++) {
+                sph_jvp_i[k] = v[0] * dsph_i[k] + v[1] * dsph_i[component + k] +
+                               v[2] * dsph_i[2 * component + k];
+            }
+        } else {
+            for (int k = 0; k < size_y; k++) {
+                auto d = dsph_i + k * dsph_strides.lm;
+                sph_jvp_i[k * sph_strides.lm] =
+                    v[0] * d[0] + v[1] * d[component] + v[2] * d[2 * component];
+            }
+        }
+    };
+
+    auto hvp_sample = [&](int64_t i_sample) {
+        // contracts the Hessians with the direction first, the remaining
+        // contraction with sph_grad is the same as in contract_gradients_sph
+        auto v = xyz_vector + 3 * i_sample;
+        auto sph_grad_i = sph_grad + i_sample * sph_strides.sample;
+        auto ddsph_i = ddsph + i_sample * ddsph_strides.sample;
+        auto component = ddsph_strides.component;
+
+        T accumulated[3] = {0, 0, 0};
+        if (sph_strides.lm == 1 && ddsph_strides.lm == 1) {
+            T partial[3][LANES] = {};
+            for (int k_block = 0; k_block < size_y; k_block += LANES) {
+                auto block_size = std::min(LANES, size_y - k_block);
+                for (int j = 0; j < block_size; j++) {
+                    auto k = k_block + j;
+                    auto g = sph_grad_i[k];
+                    for (int b = 0; b < 3; b++) {
+                        auto directional = v[0] * ddsph_i[b * component + k] +
+                                           v[1] * ddsph_i[(3 + b) * component + k] +
+                                           v[2] * ddsph_i[(6 + b) * component + k];
+                        partial[b][j] += g * directional;
+                    }
+                }
+            }
+            for (int b = 0; b < 3; b++) {
+                for (int j = 0; j < LANES; j++) {
+                    accumulated[b] += partial[b][j];
+                }
+            }
+        } else {
+            for (int k = 0; k < size_y; k++) {
+                auto g = sph_grad_i[k * sph_strides.lm];
+                auto d = ddsph_i + k * ddsph_strides.lm;
+                for (int b = 0; b < 3; b++) {
+                    accumulated[b] += g * (v[0] * d[b * component] + v[1] * d[(3 + b) * component] +
+                                           v[2] * d[(6 + b) * component]);
+                }
+            }
+        }
+        for (int b = 0; b < 3; b++) {
+            xyz_hvp[3 * i_sample + b] = accumulated[b];
+        }
+    };
+
+    auto contract = [&](size_t /*worker*/, int64_t begin, int64_t end) {
+        for (int64_t i_sample = begin; i_sample < end; i_sample++) {
+            if (sph_jvp != nullptr) {
+                jvp_sample(i_sample);
+            }
+            if (xyz_hvp != nullptr) {
+                hvp_sample(i_sample);
+            }
+        }
+    };
+    parallel_for_samples(backend, max_workers, static_cast<int64_t>(n_samples), 0, contract);
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include "coalescer.hpp"
+
+using namespace sphericart;
+
+template <typename T>
+Coalescer<T>::Coalescer(const SphericalHarmonics<T>& calculator, CoalescerOptions options)
+    : calculator(calculator.clone()), options(options) {
+    if (this->calculator.get_layout() == Layout::LM_MAJOR) {
+        throw std::runtime_error(
+            "Coalescer: expected a calculator with the outputs of each sample stored "
+            "contiguously, got one with the LM_MAJOR layout"
+        );
+    }
+    auto l_max = this->calculator.get_l_max();
+    this->size_y = (l_max + 1) * (l_max + 1);
+    this->dispatcher = std::thread([this]() { this->dispatch(); });
+}
+
+template <typename T> Coalescer<T>::~Coalescer() {
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        this->stop = true;
+    }
+    this->submitted.notify_one();
+    this->dispatcher.join();
+}
+
+template <typename T>
+std::future<void> Coalescer<T>::submit(const T* xyz, size_t xyz_length, T* sph, size_t sph_length) {
+    if (xyz_length % 3 != 0) {
+        throw std::runtime_error(
+            "Coalescer::submit: expected xyz array with `n_samples x 3` elements"
+        );
+    }
+    auto n_samples = xyz_length / 3;
+    if (n_samples != 0 && (sph == nullptr || sph_length < n_samples * this->size_y)) {
+        throw std::runtime_error(
+            "Coalescer::submit: expected sph array with `n_samples x (l_max + 1)^2` elements"
+        );
+    }
+    return this->enqueue({xyz, n_samples, sph, nullptr, {}, {}});
+}
+
+template <typename T>
+std::future<void> Coalescer<T>::submit_with_gradients(
+    const T* xyz, size_t xyz_length, T* sph, size_t sph_length, T* dsph, size_t dsph_length
+) {
+    if (xyz_length % 3 != 0) {
+        throw std::runtime_error(
+            "Coalescer::submit_with_gradients: expected xyz array with `n_samples x 3` elements"
+        );
+    }
+    auto n_samples = xyz_length / 3;
+    if (n_samples != 0 && (sph == nullptr || sph_length < n_samples * this->size_y)) {
+        throw std::runtime_error(
+            "Coalescer::submit_with_gradients: expected sph array with "
+            "`n_samples x (l_max + 1)^2` elements"
+        );
+    }
+    if (n_samples != 0 && (dsph == nullptr || dsph_length < n_samples * 3 * this->size_y)) {
+        throw std::runtime_error(
+            "Coalescer::submit_with_gradients: expected dsph array with "
+            "`n_samples x 3 x (l_max + 1)^2` elements"
+        );
+    }
+    return this->enqueue({xyz, n_samples, sph, dsph, {}, {}});
+}
+
+template <typename T> std::future<void> Coalescer<T>::enqueue(Call call) {
+    auto future = call.promise.get_future();
+    if (call.n_samples == 0) {
+        call.promise.set_value();
+        return future;
+    }
+
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        call.submitted = std::chrono::steady_clock::now();
+        this->pending_samples += call.n_samples;
+        // the background thread only needs to wake up for the first call of a
+        // batch, and once the batch is full
+        notify = this->pending.empty() || this->pending_samples >= this->options.max_batch_samples;
+        this->pending.push_back(std::move(call));
+    }
+    if (notify) {
+        this->submitted.notify_one();
+    }
+    return future;
+}
+
+template <typename T> void Coalescer<T>::dispatch() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        this->submitted.wait(lock, [this]() { return this->stop || !this->pending.empty(); });
+        if (this->pending.empty()) {
+            // stop was requested, and all the calls have been run
+            return;
+        }
+
+        auto deadline = this->pending.front().submitted + this->options.max_delay;
+        this->submitted.wait_until(lock, deadline, [this]() {
+            return this->stop || this->pending_samples >= this->options.max_batch_samples;
+        });
+
+        auto calls = std::move(this->pending);
+        this->pending.clear();
+        this->pending_samples = 0;
+        lock.unlock();
+
+        auto without_gradients = std::vector<Call>();
+        auto with_gradients = std::vector<Call>();
+        for (auto& call : calls) {
+            if (call.dsph == nullptr) {
+                without_gradients.push_back(std::move(call));
+            } else {
+                with_gradients.push_back(std::move(call));
+            }
+        }
+        this->run_batch(without_gradients, false);
+        this->run_batch(with_gradients, true);
+
+        lock.lock();
+    }
+}
+
+template <typename T> void Coalescer<T>::run_batch(std::vector<Call>& calls, bool gradients) {
+    if (calls.empty()) {
+        return;
+    }
+
+    // first sample of each call in the batch
+    auto offsets = std::vector<size_t>(calls.size() + 1, 0);
+    for (size_t i = 0; i < calls.size(); i++) {
+        offsets[i + 1] = offsets[i] + calls[i].n_samples;
+    }
+    auto n_samples = offsets.back();
+
+    this->xyz_batch.resize(3 * n_samples);
+    for (size_t i = 0; i < calls.size(); i++) {
+        auto xyz = calls[i].xyz;
+        std::copy(xyz, xyz + 3 * calls[i].n_samples, this->xyz_batch.data() + 3 * offsets[i]);
+    }
+
+    auto size_y = this->size_y;
+    auto n_dsph = gradients ? 3 * size_y : 0;
+    this->sph_batch.resize(n_samples * size_y);
+    this->dsph_batch.resize(n_samples * n_dsph);
+    try {
+        if (gradients) {
+            this->calculator.compute_array_with_gradients(
+                this->xyz_batch.data(),
+                this->xyz_batch.size(),
+                this->sph_batch.data(),
+                this->sph_batch.size(),
+                this->dsph_batch.data(),
+                this->dsph_batch.size(),
+                &this->workspace
+            );
+        } else {
+            this->calculator.compute_array(
+                this->xyz_batch.data(),
+                this->xyz_batch.size(),
+                this->sph_batch.data(),
+                this->sph_batch.size(),
+                &this->workspace
+            );
+        }
+    } catch (...) {
+        for (auto& call : calls) {
+            call.promise.set_exception(std::current_exception());
+        }
+        return;
+    }
+
+    // the outputs of each call are contiguous in the batch, and are copied
+    // back in parallel, completing the calls as soon as their outputs are
+    // ready
+    auto copy_outputs = [&](size_t worker, size_t n_workers) {
+        for (size_t i = worker; i < calls.size(); i += n_workers) {
+            auto& call = calls[i];
+            auto sph = this->sph_batch.data() + offsets[i] * size_y;
+            std::copy(sph, sph + call.n_samples * size_y, call.sph);
+            if (gradients) {
+                auto dsph = this->dsph_batch.data() + offsets[i] * n_dsph;
+                std::copy(dsph, dsph + call.n_samples * n_dsph, call.dsph);
+            }
+            call.promise.set_value();
+        }
+    };
+    this->calculator.get_backend()->run(calls.size(), copy_outputs);
+}
+
+// instantiates the Coalescer class for basic floating point types
+template class sphericart::Coalescer<float>;
+template class sphericart::Coalescer<double>;
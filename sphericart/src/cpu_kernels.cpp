@@ -0,0 +1,74 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "cpu_kernels.hpp"
+
+using namespace sphericart::cpu;
+
+// SPHERICART_ISA_DISPATCH is defined by CMake when the cpu_kernels_<isa>.cpp
+// files for SSE4.2, AVX2 and AVX-512 are compiled and linked in the library.
+// This requires an x86_64 CPU and a compiler that supports
+// __builtin_cpu_supports (GCC or clang).
+
+static ISA detect_isa() {
+#ifdef SPHERICART_ISA_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+        __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512bw")) {
+        return ISA::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return ISA::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return ISA::SSE4_2;
+    }
+#endif
+    return ISA::GENERIC;
+}
+
+ISA sphericart::cpu::best_isa() {
+    // the CPU does not change during the lifetime of the process
+    static const ISA detected = detect_isa();
+
+    auto isa = detected;
+    const char* requested = std::getenv("SPHERICART_CPU_ISA");
+    if (requested != nullptr) {
+        auto limit = ISA::AVX512;
+        if (std::strcmp(requested, "generic") == 0) {
+            limit = ISA::GENERIC;
+        } else if (std::strcmp(requested, "sse4.2") == 0) {
+            limit = ISA::SSE4_2;
+        } else if (std::strcmp(requested, "avx2") == 0) {
+            limit = ISA::AVX2;
+        }
+        if (limit < isa) {
+            isa = limit;
+        }
+    }
+
+    return isa;
+}
+
+template <typename T>
+Kernels<T> sphericart::cpu::select_kernels(size_t l_max, bool normalized, Engine engine) {
+    switch (best_isa()) {
+#ifdef SPHERICART_ISA_DISPATCH
+    case ISA::AVX512:
+        return avx512::select_kernels<T>(l_max, normalized, engine);
+    case ISA::AVX2:
+        return avx2::select_kernels<T>(l_max, normalized, engine);
+    case ISA::SSE4_2:
+        return sse4_2::select_kernels<T>(l_max, normalized, engine);
+#endif
+    default:
+        return generic::select_kernels<T>(l_max, normalized, engine);
+    }
+}
+
+template Kernels<float> sphericart::cpu::select_kernels<float>(
+    size_t l_max, bool normalized, sphericart::Engine engine
+);
+template Kernels<double> sphericart::cpu::select_kernels<double>(
+    size_t l_max, bool normalized, sphericart::Engine engine
+);
@@ -0,0 +1,164 @@
+#ifndef SPHERICART_CPU_KERNELS_HPP
+#define SPHERICART_CPU_KERNELS_HPP
+
+/*
+    Selection of the CPU kernels used by SphericalHarmonics and
+    SolidHarmonics.
+
+    The kernels (hardcoded_sph, generic_sph, the corresponding _sample and
+    _batched functions, the fused density_sph, vjp_sph and hvp_sph, and the
+    contract_gradients_sph and contract_gradients_backward_sph contractions)
+    are compiled several times, once for each of the instruction sets listed
+    in `ISA`, by the cpu_kernels_<isa>.cpp files.
+    Each copy lives in its own namespace, and the calculators pick the most
+    capable one supported by the current CPU when they are constructed.
+*/
+
+#include <cstddef>
+
+#include "parallel.hpp"
+#include "sphericart.hpp"
+#include "strides.hpp"
+
+namespace sphericart {
+namespace cpu {
+
+/** The set of function pointers that a calculator needs, together with the
+ * size (in number of T elements) of the buffers they need for each worker of
+ * the parallel backend */
+template <typename T> struct Kernels {
+    void (*array_no_derivatives)(
+        const T*,
+        T*,
+        T*,
+        T*,
+        size_t,
+        int,
+        const T*,
+        T*,
+        const OutputBlocks<T>*,
+        size_t,
+        ParallelBackend*,
+        size_t
+    );
+    void (*array_with_derivatives)(
+        const T*,
+        T*,
+        T*,
+        T*,
+        size_t,
+        int,
+        const T*,
+        T*,
+        const OutputBlocks<T>*,
+        size_t,
+        ParallelBackend*,
+        size_t
+    );
+    void (*array_with_hessians)(
+        const T*,
+        T*,
+        T*,
+        T*,
+        size_t,
+        int,
+        const T*,
+        T*,
+        const OutputBlocks<T>*,
+        size_t,
+        ParallelBackend*,
+        size_t
+    );
+
+    void (*sample_no_derivatives)(const T*, T*, T*, T*, int, int, const T*, const T*, T*, T*, T*);
+    void (*sample_with_derivatives)(const T*, T*, T*, T*, int, int, const T*, const T*, T*, T*, T*);
+    void (*sample_with_hessians)(const T*, T*, T*, T*, int, int, const T*, const T*, T*, T*, T*);
+
+    void (*density)(
+        const T*,
+        const T*,
+        size_t,
+        const size_t*,
+        size_t,
+        T*,
+        int,
+        const T*,
+        T*,
+        ParallelBackend*,
+        size_t
+    );
+    void (*vjp)(
+        const T*, const T*, T*, size_t, ArrayStrides, int, const T*, T*, ParallelBackend*, size_t
+    );
+    void (*hvp)(
+        const T*,
+        const T*,
+        const T*,
+        T*,
+        size_t,
+        ArrayStrides,
+        int,
+        const T*,
+        T*,
+        ParallelBackend*,
+        size_t
+    );
+    void (*contract)(
+        const T*, const T*, T*, size_t, ArrayStrides, ArrayStrides, int, ParallelBackend*, size_t
+    );
+    void (*contract_backward)(
+        const T*,
+        const T*,
+        const T*,
+        const T*,
+        T*,
+        T*,
+        size_t,
+        ArrayStrides,
+        ArrayStrides,
+        ArrayStrides,
+        int,
+        ParallelBackend*,
+        size_t
+    );
+
+    size_t buffer_size;
+};
+
+/** Instruction sets for which the kernels are compiled, from the least to
+ * the most capable */
+enum class ISA {
+    GENERIC,
+    SSE4_2,
+    AVX2,
+    AVX512,
+};
+
+// declares the selection function for each instruction set. These are
+// defined in cpu_kernels_<isa>.cpp, by including cpu_kernels_impl.hpp
+#define _SPHERICART_DECLARE_SELECT_KERNELS(NAMESPACE)                                              \
+    namespace NAMESPACE {                                                                          \
+    template <typename T> Kernels<T> select_kernels(size_t l_max, bool normalized, Engine engine); \
+    }
+
+_SPHERICART_DECLARE_SELECT_KERNELS(generic)
+_SPHERICART_DECLARE_SELECT_KERNELS(sse4_2)
+_SPHERICART_DECLARE_SELECT_KERNELS(avx2)
+_SPHERICART_DECLARE_SELECT_KERNELS(avx512)
+
+#undef _SPHERICART_DECLARE_SELECT_KERNELS
+
+/** Returns the most capable instruction set that is both available in this
+ * build of the library and supported by the current CPU. The environment
+ * variable SPHERICART_CPU_ISA (one of "generic", "sse4.2", "avx2",
+ * "avx512") can be used to restrict the choice to a less capable set. */
+ISA best_isa();
+
+/** Returns the kernels compiled for the instruction set given by
+ * `best_isa()`, for a calculator with the given parameters */
+template <typename T> Kernels<T> select_kernels(size_t l_max, bool normalized, Engine engine);
+
+} // namespace cpu
+} // namespace sphericart
+
+#endif
@@ -0,0 +1,4 @@
+// CPU kernels compiled with AVX2 and FMA instructions, see
+// sphericart/CMakeLists.txt for the corresponding flags
+#define SPHERICART_CPU_KERNELS_NAMESPACE avx2
+#include "cpu_kernels_impl.hpp"
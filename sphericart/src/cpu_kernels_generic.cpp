@@ -0,0 +1,5 @@
+// CPU kernels compiled with the default code generation flags. This is the
+// only variant used when SPHERICART_ARCH_NATIVE is ON, or when runtime
+// instruction set dispatch is not available, see sphericart/CMakeLists.txt
+#define SPHERICART_CPU_KERNELS_NAMESPACE generic
+#include "cpu_kernels_impl.hpp"
@@ -0,0 +1,137 @@
+/*
+    Definition of the kernel selection for one instruction set. This file is
+    included by each of the cpu_kernels_<isa>.cpp files, which are compiled
+    with different code generation flags, after defining
+    SPHERICART_CPU_KERNELS_NAMESPACE.
+*/
+
+#ifndef SPHERICART_CPU_KERNELS_NAMESPACE
+#error "SPHERICART_CPU_KERNELS_NAMESPACE must be defined before including this file"
+#endif
+
+// headers used by the templates must be included here, since including them
+// inside the namespace below would not work
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "cpu_kernels.hpp"
+
+namespace sphericart {
+namespace cpu {
+namespace SPHERICART_CPU_KERNELS_NAMESPACE {
+
+// The templates are instantiated inside a namespace specific to this
+// instruction set. Otherwise, the linker would be free to merge the
+// instantiations compiled with different code generation flags, and we could
+// end up running e.g. AVX-512 code on a CPU that does not support it.
+#include "macros.hpp"
+#include "templates.hpp"
+#include "templates_batched.hpp"
+#include "templates_fused.hpp"
+
+// This macro defines the different possible hardcoded function calls. It is
+// used to initialize the function pointers that are used by the `compute_`
+// calls in the SphericalHarmonics class
+#define _HARDCODED_SWITCH_CASE(L_MAX)                                                              \
+    if (engine == Engine::BATCHED) {                                                               \
+        kernels.array_no_derivatives = &hardcoded_sph_batched<T, false, false, NORMALIZED, L_MAX>; \
+        kernels.array_with_derivatives =                                                           \
+            &hardcoded_sph_batched<T, true, false, NORMALIZED, L_MAX>;                             \
+        kernels.array_with_hessians = &hardcoded_sph_batched<T, true, true, NORMALIZED, L_MAX>;    \
+    } else {                                                                                       \
+        kernels.array_no_derivatives = &hardcoded_sph<T, false, false, NORMALIZED, L_MAX>;         \
+        kernels.array_with_derivatives = &hardcoded_sph<T, true, false, NORMALIZED, L_MAX>;        \
+        kernels.array_with_hessians = &hardcoded_sph<T, true, true, NORMALIZED, L_MAX>;            \
+    }                                                                                              \
+    kernels.sample_no_derivatives = &hardcoded_sph_sample<T, false, false, NORMALIZED, L_MAX>;     \
+    kernels.sample_with_derivatives = &hardcoded_sph_sample<T, true, false, NORMALIZED, L_MAX>;    \
+    kernels.sample_with_hessians = &hardcoded_sph_sample<T, true, true, NORMALIZED, L_MAX>;        \
+    kernels.density = &density_sph<T, NORMALIZED, L_MAX, false>;                                   \
+    kernels.vjp = &vjp_sph<T, NORMALIZED, L_MAX, false>;                                           \
+    kernels.hvp = &hvp_sph<T, NORMALIZED, L_MAX, false>;
+
+// Sets the hardcoded kernels for the given l_max, trying all the values from
+// L_MAX down to 0. This covers all the hardcoded macros, whatever the value of
+// SPHERICART_LMAX_HARDCODED
+template <typename T, bool NORMALIZED, int L_MAX>
+static void set_hardcoded_kernels(size_t l_max, Engine engine, Kernels<T>& kernels) {
+    if (l_max == L_MAX) {
+        _HARDCODED_SWITCH_CASE(L_MAX);
+    } else if constexpr (L_MAX > 0) {
+        set_hardcoded_kernels<T, NORMALIZED, L_MAX - 1>(l_max, engine, kernels);
+    }
+}
+
+template <typename T, bool NORMALIZED>
+static Kernels<T> select_kernels_impl(size_t l_max, Engine engine) {
+    auto kernels = Kernels<T>();
+
+    // buffers for cos, sin, 2mz arrays and the outputs of one sample. The
+    // batched engine also stores prefactors and outputs for a block of points
+    if (engine == Engine::BATCHED) {
+        kernels.buffer_size = batched_sph_buffer_size<T>(static_cast<int>(l_max));
+    } else {
+        kernels.buffer_size = sph_buffer_size<T>(static_cast<int>(l_max));
+    }
+
+    // sets the correct function pointers for the compute functions
+    if (l_max <= SPHERICART_LMAX_HARDCODED) {
+        // If we only need hard-coded calls, we set them up at this point
+        set_hardcoded_kernels<T, NORMALIZED, SPHERICART_LMAX_HARDCODED>(l_max, engine, kernels);
+    } else {
+        if (engine == Engine::BATCHED) {
+            kernels.array_no_derivatives =
+                &generic_sph_batched<T, false, false, NORMALIZED, SPHERICART_LMAX_HARDCODED>;
+            kernels.array_with_derivatives =
+                &generic_sph_batched<T, true, false, NORMALIZED, SPHERICART_LMAX_HARDCODED>;
+            kernels.array_with_hessians =
+                &generic_sph_batched<T, true, true, NORMALIZED, SPHERICART_LMAX_HARDCODED>;
+        } else {
+            kernels.array_no_derivatives =
+                &generic_sph<T, false, false, NORMALIZED, SPHERICART_LMAX_HARDCODED>;
+            kernels.array_with_derivatives =
+                &generic_sph<T, true, false, NORMALIZED, SPHERICART_LMAX_HARDCODED>;
+            kernels.array_with_hessians =
+                &generic_sph<T, true, true, NORMALIZED, SPHERICART_LMAX_HARDCODED>;
+        }
+        kernels.sample_no_derivatives =
+            &generic_sph_sample<T, false, false, NORMALIZED, SPHERICART_LMAX_HARDCODED>;
+        kernels.sample_with_derivatives =
+            &generic_sph_sample<T, true, false, NORMALIZED, SPHERICART_LMAX_HARDCODED>;
+        kernels.sample_with_hessians =
+            &generic_sph_sample<T, true, true, NORMALIZED, SPHERICART_LMAX_HARDCODED>;
+        kernels.density = &density_sph<T, NORMALIZED, SPHERICART_LMAX_HARDCODED, true>;
+        kernels.vjp = &vjp_sph<T, NORMALIZED, SPHERICART_LMAX_HARDCODED, true>;
+        kernels.hvp = &hvp_sph<T, NORMALIZED, SPHERICART_LMAX_HARDCODED, true>;
+    }
+    // the contractions only depend on the number of spherical harmonics
+    kernels.contract = &contract_gradients_sph<T>;
+    kernels.contract_backward = &contract_gradients_backward_sph<T>;
+
+    return kernels;
+}
+
+#undef _HARDCODED_SWITCH_CASE
+
+template <typename T> Kernels<T> select_kernels(size_t l_max, bool normalized, Engine engine) {
+    if (normalized) {
+        return select_kernels_impl<T, true>(l_max, engine);
+    } else {
+        return select_kernels_impl<T, false>(l_max, engine);
+    }
+}
+
+template Kernels<float> select_kernels<float>(size_t l_max, bool normalized, Engine engine);
+template Kernels<double> select_kernels<double>(size_t l_max, bool normalized, Engine engine);
+
+} // namespace SPHERICART_CPU_KERNELS_NAMESPACE
+} // namespace cpu
+} // namespace sphericart
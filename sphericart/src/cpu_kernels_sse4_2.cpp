@@ -0,0 +1,4 @@
+// CPU kernels compiled with SSE4.2 instructions, see
+// sphericart/CMakeLists.txt for the corresponding flags
+#define SPHERICART_CPU_KERNELS_NAMESPACE sse4_2
+#include "cpu_kernels_impl.hpp"
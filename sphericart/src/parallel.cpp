@@ -0,0 +1,395 @@
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+
+#include <fstream>
+#include <string>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef SPHERICART_ENABLE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
+#include "parallel.hpp"
+
+using namespace sphericart;
+
+namespace {
+
+#ifdef __linux__
+using CpuSet = cpu_set_t;
+
+// returns the CPUs the process can run on, grouped by socket
+std::vector<std::vector<int>> available_sockets() {
+    cpu_set_t available;
+    CPU_ZERO(&available);
+    if (sched_getaffinity(0, sizeof(available), &available) != 0) {
+        return {};
+    }
+
+    auto sockets = std::map<int, std::vector<int>>();
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &available)) {
+            continue;
+        }
+        auto path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                    "/topology/physical_package_id";
+        auto file = std::ifstream(path);
+        int socket = 0;
+        if (!(file >> socket)) {
+            socket = 0;
+        }
+        sockets[socket].push_back(cpu);
+    }
+
+    auto result = std::vector<std::vector<int>>();
+    for (auto& socket : sockets) {
+        result.push_back(std::move(socket.second));
+    }
+    return result;
+}
+
+// returns the CPUs each of `n_workers` workers should be pinned to, or an
+// empty vector if they should not be pinned
+std::vector<CpuSet> worker_affinities(size_t n_workers, ThreadPinning pinning) {
+    if (pinning == ThreadPinning::NONE) {
+        return {};
+    }
+    auto sockets = available_sockets();
+    if (sockets.empty()) {
+        return {};
+    }
+
+    auto n_sockets = sockets.size();
+    auto affinities = std::vector<CpuSet>(n_workers);
+    for (size_t worker = 0; worker < n_workers; worker++) {
+        // consecutive workers are on the same socket, and the first worker on
+        // socket s is ceil(s * n_workers / n_sockets)
+        auto socket = worker * n_sockets / n_workers;
+        auto first_worker = (socket * n_workers + n_sockets - 1) / n_sockets;
+        const auto& cpus = sockets[socket];
+
+        CPU_ZERO(&affinities[worker]);
+        if (pinning == ThreadPinning::CORES) {
+            CPU_SET(cpus[(worker - first_worker) % cpus.size()], &affinities[worker]);
+        } else {
+            for (auto cpu : cpus) {
+                CPU_SET(cpu, &affinities[worker]);
+            }
+        }
+    }
+    return affinities;
+}
+
+bool get_thread_affinity(CpuSet& cpus) {
+    return pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+}
+
+bool set_thread_affinity(const CpuSet& cpus) {
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+}
+#else
+struct CpuSet {};
+
+std::vector<CpuSet> worker_affinities(size_t /*n_workers*/, ThreadPinning /*pinning*/) {
+    return {};
+}
+
+bool get_thread_affinity(CpuSet& /*cpus*/) { return false; }
+
+bool set_thread_affinity(const CpuSet& /*cpus*/) { return false; }
+#endif
+
+// true on the threads currently executing a task of the thread pool, TBB or
+// caller backends, so that nested calls do not wait for the pool they are
+// running on, and do not share the buffers of the calculators
+thread_local bool RUNNING_PARALLEL_TASK = false;
+
+// runs one worker of a parallel task, setting RUNNING_PARALLEL_TASK while it
+// runs (and resetting it even if the task throws)
+void run_task(const ParallelTask& task, size_t worker, size_t n_workers) {
+    struct RunningGuard {
+        bool previous = RUNNING_PARALLEL_TASK;
+        RunningGuard() { RUNNING_PARALLEL_TASK = true; }
+        ~RunningGuard() { RUNNING_PARALLEL_TASK = previous; }
+    } guard;
+    task(worker, n_workers);
+}
+
+class OpenMPBackend final : public ParallelBackend {
+  public:
+    size_t max_workers() const override {
+#ifdef _OPENMP
+        return static_cast<size_t>(omp_get_max_threads());
+#else
+        return 1;
+#endif
+    }
+
+    void run(size_t max_workers, ParallelTask task) override {
+        auto n_workers = std::min(max_workers, this->max_workers());
+        // a nested team would either be serialized by the OpenMP runtime or
+        // oversubscribe the cores already used by the enclosing region
+        if (n_workers <= 1 || in_parallel_region()) {
+            task(0, 1);
+            return;
+        }
+#ifdef _OPENMP
+#pragma omp parallel num_threads(static_cast<int>(n_workers))
+        {
+            task(
+                static_cast<size_t>(omp_get_thread_num()),
+                static_cast<size_t>(omp_get_num_threads())
+            );
+        }
+#endif
+    }
+};
+
+class SerialBackend final : public ParallelBackend {
+  public:
+    size_t max_workers() const override { return 1; }
+
+    void run(size_t /*max_workers*/, ParallelTask task) override { task(0, 1); }
+};
+
+class ThreadPoolBackend final : public ParallelBackend {
+  public:
+    ThreadPoolBackend(size_t n_threads, ThreadPinning pinning)
+        : affinities(worker_affinities(n_threads, pinning)) {
+        for (size_t worker = 1; worker < n_threads; worker++) {
+            this->threads.emplace_back([this, worker]() { this->work(worker); });
+        }
+    }
+
+    ~ThreadPoolBackend() override {
+        {
+            std::lock_guard<std::mutex> guard(this->mutex);
+            this->stop = true;
+        }
+        this->start.notify_all();
+        for (auto& thread : this->threads) {
+            thread.join();
+        }
+    }
+
+    size_t max_workers() const override { return this->threads.size() + 1; }
+
+    void run(size_t max_workers, ParallelTask task) override {
+        auto n_workers = std::min(max_workers, this->max_workers());
+        if (n_workers <= 1 || RUNNING_PARALLEL_TASK) {
+            run_task(task, 0, 1);
+            return;
+        }
+
+        // only one call at a time can use the threads of the pool
+        std::lock_guard<std::mutex> run_guard(this->run_mutex);
+        {
+            std::lock_guard<std::mutex> guard(this->mutex);
+            this->task = &task;
+            this->n_workers = n_workers;
+            this->remaining = n_workers - 1;
+            this->generation += 1;
+        }
+        this->start.notify_all();
+
+        // the calling thread is the first worker, running on the CPUs of the
+        // first worker for the duration of the call
+        auto previous_affinity = CpuSet();
+        bool restore_affinity = !this->affinities.empty() &&
+                                get_thread_affinity(previous_affinity) &&
+                                set_thread_affinity(this->affinities[0]);
+        auto error = std::exception_ptr();
+        try {
+            run_task(task, 0, n_workers);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        if (restore_affinity) {
+            set_thread_affinity(previous_affinity);
+        }
+
+        // the other workers use `task` until they are done, even if the
+        // calling thread failed
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->done.wait(lock, [this]() { return this->remaining == 0; });
+        this->task = nullptr;
+        if (!error) {
+            error = this->error;
+        }
+        this->error = nullptr;
+        lock.unlock();
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+  private:
+    void work(size_t worker) {
+        if (!this->affinities.empty()) {
+            set_thread_affinity(this->affinities[worker]);
+        }
+
+        size_t last_generation = 0;
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true) {
+            this->start.wait(lock, [&]() {
+                return this->stop || this->generation != last_generation;
+            });
+            if (this->stop) {
+                return;
+            }
+            last_generation = this->generation;
+            if (worker >= this->n_workers) {
+                continue;
+            }
+
+            auto task = this->task;
+            auto n_workers = this->n_workers;
+            lock.unlock();
+            auto error = std::exception_ptr();
+            try {
+                run_task(*task, worker, n_workers);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
+
+            // only the first error is given back to the caller of `run`
+            if (error && !this->error) {
+                this->error = error;
+            }
+            this->remaining -= 1;
+            if (this->remaining == 0) {
+                this->done.notify_one();
+            }
+        }
+    }
+
+    // CPUs of each worker, empty if the threads are not pinned
+    std::vector<CpuSet> affinities;
+    std::vector<std::thread> threads;
+    std::mutex run_mutex;
+    // protects all the members below
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    const ParallelTask* task = nullptr;
+    size_t n_workers = 0;
+    size_t remaining = 0;
+    size_t generation = 0;
+    bool stop = false;
+    // first error thrown by one of the pool threads during the current call
+    std::exception_ptr error;
+};
+
+#ifdef SPHERICART_ENABLE_TBB
+class TBBBackend final : public ParallelBackend {
+  public:
+    size_t max_workers() const override {
+        return static_cast<size_t>(tbb::this_task_arena::max_concurrency());
+    }
+
+    void run(size_t max_workers, ParallelTask task) override {
+        auto n_workers = std::min(max_workers, this->max_workers());
+        if (n_workers <= 1) {
+            run_task(task, 0, 1);
+            return;
+        }
+        tbb::parallel_for(size_t(0), n_workers, [&](size_t worker) {
+            run_task(task, worker, n_workers);
+        });
+    }
+};
+#endif
+
+class CallerBackend final : public ParallelBackend {
+  public:
+    CallerBackend(size_t n_workers, ParallelExecutor executor)
+        : n_workers(n_workers), executor(std::move(executor)) {}
+
+    size_t max_workers() const override { return this->n_workers; }
+
+    void run(size_t max_workers, ParallelTask task) override {
+        auto n_workers = std::min(max_workers, this->n_workers);
+        if (n_workers <= 1) {
+            run_task(task, 0, 1);
+            return;
+        }
+        this->executor(n_workers, [&](size_t worker) { run_task(task, worker, n_workers); });
+    }
+
+  private:
+    size_t n_workers;
+    ParallelExecutor executor;
+};
+
+} // namespace
+
+bool sphericart::in_parallel_region() {
+#ifdef _OPENMP
+    if (omp_in_parallel()) {
+        return true;
+    }
+#endif
+    return RUNNING_PARALLEL_TASK;
+}
+
+std::shared_ptr<ParallelBackend> sphericart::openmp_backend() {
+    // the backend has no state, so the same one is shared by all calculators
+    static auto backend = std::make_shared<OpenMPBackend>();
+    return backend;
+}
+
+std::shared_ptr<ParallelBackend> sphericart::serial_backend() {
+    static auto backend = std::make_shared<SerialBackend>();
+    return backend;
+}
+
+std::shared_ptr<ParallelBackend> sphericart::thread_pool_backend(
+    size_t n_threads, ThreadPinning pinning
+) {
+    if (n_threads == 0) {
+        throw std::runtime_error("sphericart::thread_pool_backend: expected at least one thread");
+    }
+    return std::make_shared<ThreadPoolBackend>(n_threads, pinning);
+}
+
+std::shared_ptr<ParallelBackend> sphericart::tbb_backend() {
+#ifdef SPHERICART_ENABLE_TBB
+    static auto backend = std::make_shared<TBBBackend>();
+    return backend;
+#else
+    throw std::runtime_error(
+        "sphericart::tbb_backend: sphericart was compiled without TBB support, "
+        "reconfigure it with -DSPHERICART_ENABLE_TBB=ON"
+    );
+#endif
+}
+
+std::shared_ptr<ParallelBackend> sphericart::caller_backend(
+    size_t n_workers, ParallelExecutor executor
+) {
+    if (n_workers == 0) {
+        throw std::runtime_error("sphericart::caller_backend: expected at least one worker");
+    }
+    if (!executor) {
+        throw std::runtime_error("sphericart::caller_backend: expected a valid executor");
+    }
+    return std::make_shared<CallerBackend>(n_workers, std::move(executor));
+}
@@ -1,15 +1,55 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
 #include <stdexcept>
 
 #include "sphericart.h"
 #include "sphericart.hpp"
 
+/// Exceptions can not cross the C API, so errors in `function` print a message
+/// and abort the program
+template <typename Function> static auto fatal_on_error(Function function) -> decltype(function()) {
+    try {
+        return function();
+    } catch (const std::exception& e) {
+        printf("fatal error: %s\n", e.what());
+        abort();
+    } catch (...) {
+        printf("fatal error: unknown exception type\n");
+        abort();
+    }
+}
+
+static sphericart::Layout to_cpp_layout(sphericart_layout_t layout) {
+    switch (layout) {
+    case SPHERICART_LAYOUT_SAMPLE_MAJOR:
+        return sphericart::Layout::SAMPLE_MAJOR;
+    case SPHERICART_LAYOUT_LM_MAJOR:
+        return sphericart::Layout::LM_MAJOR;
+    case SPHERICART_LAYOUT_XYZ_INNERMOST:
+        return sphericart::Layout::XYZ_INNERMOST;
+    default:
+        throw std::runtime_error("sphericart: invalid layout");
+    }
+}
+
 extern "C" sphericart_spherical_harmonics_calculator_t* sphericart_spherical_harmonics_new(
     size_t l_max
 ) {
     try {
         return new sphericart::SphericalHarmonics<double>(l_max);
     } catch (...) {
-        // TODO: better error handling
+        return nullptr;
+    }
+}
+
+extern "C" sphericart_spherical_harmonics_calculator_t*
+sphericart_spherical_harmonics_new_with_layout(size_t l_max, sphericart_layout_t layout) {
+    try {
+        auto engine = sphericart::Engine::SAMPLE;
+        return new sphericart::SphericalHarmonics<double>(l_max, engine, to_cpp_layout(layout));
+    } catch (...) {
         return nullptr;
     }
 }
@@ -31,16 +71,9 @@ extern "C" void sphericart_spherical_harmonics_compute_array(
     double* sph,
     size_t sph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array(xyz, xyz_length, sph, sph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_spherical_harmonics_compute_array_with_gradients(
@@ -52,16 +85,9 @@ extern "C" void sphericart_spherical_harmonics_compute_array_with_gradients(
     double* dsph,
     size_t dsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array_with_gradients(xyz, xyz_length, sph, sph_length, dsph, dsph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_spherical_harmonics_compute_array_with_hessians(
@@ -75,18 +101,214 @@ extern "C" void sphericart_spherical_harmonics_compute_array_with_hessians(
     double* ddsph,
     size_t ddsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array_with_hessians(
             xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_per_l(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* const* sph,
+    size_t n_blocks
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l(xyz, xyz_length, sph, n_blocks);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_per_l_with_gradients(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* const* sph,
+    double* const* dsph,
+    size_t n_blocks
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l_with_gradients(xyz, xyz_length, sph, dsph, n_blocks);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_per_l_with_hessians(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* const* sph,
+    double* const* dsph,
+    double* const* ddsph,
+    size_t n_blocks
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l_with_hessians(xyz, xyz_length, sph, dsph, ddsph, n_blocks);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_strided(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_strided(xyz, n_samples, xyz_stride, sph, sph_stride);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_strided_with_gradients(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride,
+    double* dsph,
+    size_t dsph_stride
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_strided_with_gradients(
+            xyz, n_samples, xyz_stride, sph, sph_stride, dsph, dsph_stride
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_strided_with_hessians(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride,
+    double* dsph,
+    size_t dsph_stride,
+    double* ddsph,
+    size_t ddsph_stride
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_strided_with_hessians(
+            xyz, n_samples, xyz_stride, sph, sph_stride, dsph, dsph_stride, ddsph, ddsph_stride
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_density(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* radial,
+    size_t n_radial,
+    const size_t* centre_offsets,
+    size_t n_centres,
+    double* coefficients,
+    size_t coefficients_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_density(
+            xyz,
+            xyz_length,
+            radial,
+            n_radial,
+            centre_offsets,
+            n_centres,
+            coefficients,
+            coefficients_length
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_vjp(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    double* xyz_grad,
+    size_t xyz_grad_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_vjp(
+            xyz, xyz_length, sph_grad, sph_grad_length, xyz_grad, xyz_grad_length
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_hvp(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* xyz_vector,
+    size_t xyz_vector_length,
+    double* xyz_hvp,
+    size_t xyz_hvp_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_hvp(
+            xyz,
+            xyz_length,
+            sph_grad,
+            sph_grad_length,
+            xyz_vector,
+            xyz_vector_length,
+            xyz_hvp,
+            xyz_hvp_length
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_contract_gradients(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* dsph,
+    size_t dsph_length,
+    double* xyz_grad,
+    size_t xyz_grad_length
+) {
+    fatal_on_error([&]() {
+        calculator->contract_gradients(
+            sph_grad, sph_grad_length, dsph, dsph_length, xyz_grad, xyz_grad_length
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_contract_gradients_backward(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* xyz_vector,
+    size_t xyz_vector_length,
+    const double* dsph,
+    size_t dsph_length,
+    const double* ddsph,
+    size_t ddsph_length,
+    double* sph_jvp,
+    size_t sph_jvp_length,
+    double* xyz_hvp,
+    size_t xyz_hvp_length
+) {
+    fatal_on_error([&]() {
+        calculator->contract_gradients_backward(
+            sph_grad,
+            sph_grad_length,
+            xyz_vector,
+            xyz_vector_length,
+            dsph,
+            dsph_length,
+            ddsph,
+            ddsph_length,
+            sph_jvp,
+            sph_jvp_length,
+            xyz_hvp,
+            xyz_hvp_length
+        );
+    });
 }
 
 extern "C" void sphericart_spherical_harmonics_compute_sample(
@@ -96,16 +318,9 @@ extern "C" void sphericart_spherical_harmonics_compute_sample(
     double* sph,
     size_t sph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_sample(xyz, xyz_length, sph, sph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_spherical_harmonics_compute_sample_with_gradients(
@@ -117,18 +332,11 @@ extern "C" void sphericart_spherical_harmonics_compute_sample_with_gradients(
     double* dsph,
     size_t dsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_sample_with_gradients(
             xyz, xyz_length, sph, sph_length, dsph, dsph_length
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_spherical_harmonics_compute_sample_with_hessians(
@@ -142,18 +350,11 @@ extern "C" void sphericart_spherical_harmonics_compute_sample_with_hessians(
     double* ddsph,
     size_t ddsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_sample_with_hessians(
             xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" sphericart_spherical_harmonics_calculator_f_t* sphericart_spherical_harmonics_new_f(
@@ -162,7 +363,16 @@ extern "C" sphericart_spherical_harmonics_calculator_f_t* sphericart_spherical_h
     try {
         return new sphericart::SphericalHarmonics<float>(l_max);
     } catch (...) {
-        // TODO: better error handling
+        return nullptr;
+    }
+}
+
+extern "C" sphericart_spherical_harmonics_calculator_f_t*
+sphericart_spherical_harmonics_new_with_layout_f(size_t l_max, sphericart_layout_t layout) {
+    try {
+        auto engine = sphericart::Engine::SAMPLE;
+        return new sphericart::SphericalHarmonics<float>(l_max, engine, to_cpp_layout(layout));
+    } catch (...) {
         return nullptr;
     }
 }
@@ -184,16 +394,9 @@ extern "C" void sphericart_spherical_harmonics_compute_array_f(
     float* sph,
     size_t sph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array(xyz, xyz_length, sph, sph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_spherical_harmonics_compute_array_with_gradients_f(
@@ -205,16 +408,9 @@ extern "C" void sphericart_spherical_harmonics_compute_array_with_gradients_f(
     float* dsph,
     size_t dsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array_with_gradients(xyz, xyz_length, sph, sph_length, dsph, dsph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_spherical_harmonics_compute_array_with_hessians_f(
@@ -228,111 +424,295 @@ extern "C" void sphericart_spherical_harmonics_compute_array_with_hessians_f(
     float* ddsph,
     size_t ddsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array_with_hessians(
             xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
-extern "C" void sphericart_spherical_harmonics_compute_sample_f(
+extern "C" void sphericart_spherical_harmonics_compute_array_per_l_f(
     sphericart_spherical_harmonics_calculator_f_t* calculator,
     const float* xyz,
     size_t xyz_length,
-    float* sph,
-    size_t sph_length
+    float* const* sph,
+    size_t n_blocks
 ) {
-    try {
-        calculator->compute_sample(xyz, xyz_length, sph, sph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l(xyz, xyz_length, sph, n_blocks);
+    });
 }
 
-extern "C" void sphericart_spherical_harmonics_compute_sample_with_gradients_f(
+extern "C" void sphericart_spherical_harmonics_compute_array_per_l_with_gradients_f(
     sphericart_spherical_harmonics_calculator_f_t* calculator,
     const float* xyz,
     size_t xyz_length,
+    float* const* sph,
+    float* const* dsph,
+    size_t n_blocks
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l_with_gradients(xyz, xyz_length, sph, dsph, n_blocks);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_per_l_with_hessians_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* const* sph,
+    float* const* dsph,
+    float* const* ddsph,
+    size_t n_blocks
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l_with_hessians(xyz, xyz_length, sph, dsph, ddsph, n_blocks);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_strided_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
     float* sph,
-    size_t sph_length,
+    size_t sph_stride
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_strided(xyz, n_samples, xyz_stride, sph, sph_stride);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_strided_with_gradients_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    float* sph,
+    size_t sph_stride,
     float* dsph,
-    size_t dsph_length
+    size_t dsph_stride
 ) {
-    try {
-        calculator->compute_sample_with_gradients(
-            xyz, xyz_length, sph, sph_length, dsph, dsph_length
+    fatal_on_error([&]() {
+        calculator->compute_array_strided_with_gradients(
+            xyz, n_samples, xyz_stride, sph, sph_stride, dsph, dsph_stride
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
-extern "C" void sphericart_spherical_harmonics_compute_sample_with_hessians_f(
+extern "C" void sphericart_spherical_harmonics_compute_array_strided_with_hessians_f(
     sphericart_spherical_harmonics_calculator_f_t* calculator,
     const float* xyz,
-    size_t xyz_length,
+    size_t n_samples,
+    size_t xyz_stride,
     float* sph,
-    size_t sph_length,
+    size_t sph_stride,
     float* dsph,
-    size_t dsph_length,
+    size_t dsph_stride,
     float* ddsph,
-    size_t ddsph_length
+    size_t ddsph_stride
 ) {
-    try {
-        calculator->compute_sample_with_hessians(
-            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
+    fatal_on_error([&]() {
+        calculator->compute_array_strided_with_hessians(
+            xyz, n_samples, xyz_stride, sph, sph_stride, dsph, dsph_stride, ddsph, ddsph_stride
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
-extern "C" int sphericart_spherical_harmonics_omp_num_threads(
-    sphericart_spherical_harmonics_calculator_t* calculator
+extern "C" void sphericart_spherical_harmonics_compute_density_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* radial,
+    size_t n_radial,
+    const size_t* centre_offsets,
+    size_t n_centres,
+    float* coefficients,
+    size_t coefficients_length
 ) {
-    return calculator->get_omp_num_threads();
+    fatal_on_error([&]() {
+        calculator->compute_density(
+            xyz,
+            xyz_length,
+            radial,
+            n_radial,
+            centre_offsets,
+            n_centres,
+            coefficients,
+            coefficients_length
+        );
+    });
 }
 
-extern "C" int sphericart_spherical_harmonics_omp_num_threads_f(
-    sphericart_spherical_harmonics_calculator_f_t* calculator
+extern "C" void sphericart_spherical_harmonics_compute_vjp_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    float* xyz_grad,
+    size_t xyz_grad_length
 ) {
-    return calculator->get_omp_num_threads();
+    fatal_on_error([&]() {
+        calculator->compute_vjp(
+            xyz, xyz_length, sph_grad, sph_grad_length, xyz_grad, xyz_grad_length
+        );
+    });
 }
 
-extern "C" sphericart_solid_harmonics_calculator_t* sphericart_solid_harmonics_new(size_t l_max) {
-    try {
-        return new sphericart::SolidHarmonics<double>(l_max);
-    } catch (...) {
-        // TODO: better error handling
-        return nullptr;
-    }
+extern "C" void sphericart_spherical_harmonics_compute_hvp_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* xyz_vector,
+    size_t xyz_vector_length,
+    float* xyz_hvp,
+    size_t xyz_hvp_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_hvp(
+            xyz,
+            xyz_length,
+            sph_grad,
+            sph_grad_length,
+            xyz_vector,
+            xyz_vector_length,
+            xyz_hvp,
+            xyz_hvp_length
+        );
+    });
 }
 
-extern "C" void sphericart_solid_harmonics_delete(sphericart_solid_harmonics_calculator_t* calculator) {
-    try {
-        delete calculator;
+extern "C" void sphericart_spherical_harmonics_contract_gradients_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* dsph,
+    size_t dsph_length,
+    float* xyz_grad,
+    size_t xyz_grad_length
+) {
+    fatal_on_error([&]() {
+        calculator->contract_gradients(
+            sph_grad, sph_grad_length, dsph, dsph_length, xyz_grad, xyz_grad_length
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_contract_gradients_backward_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* xyz_vector,
+    size_t xyz_vector_length,
+    const float* dsph,
+    size_t dsph_length,
+    const float* ddsph,
+    size_t ddsph_length,
+    float* sph_jvp,
+    size_t sph_jvp_length,
+    float* xyz_hvp,
+    size_t xyz_hvp_length
+) {
+    fatal_on_error([&]() {
+        calculator->contract_gradients_backward(
+            sph_grad,
+            sph_grad_length,
+            xyz_vector,
+            xyz_vector_length,
+            dsph,
+            dsph_length,
+            ddsph,
+            ddsph_length,
+            sph_jvp,
+            sph_jvp_length,
+            xyz_hvp,
+            xyz_hvp_length
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_sample_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample(xyz, xyz_length, sph, sph_length);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_sample_with_gradients_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_sample_with_hessians_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_hessians(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
+        );
+    });
+}
+
+extern "C" int sphericart_spherical_harmonics_omp_num_threads(
+    sphericart_spherical_harmonics_calculator_t* calculator
+) {
+    return calculator->get_omp_num_threads();
+}
+
+extern "C" int sphericart_spherical_harmonics_omp_num_threads_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator
+) {
+    return calculator->get_omp_num_threads();
+}
+
+extern "C" sphericart_solid_harmonics_calculator_t* sphericart_solid_harmonics_new(size_t l_max) {
+    try {
+        return new sphericart::SolidHarmonics<double>(l_max);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+extern "C" sphericart_solid_harmonics_calculator_t*
+sphericart_solid_harmonics_new_with_layout(size_t l_max, sphericart_layout_t layout) {
+    try {
+        auto engine = sphericart::Engine::SAMPLE;
+        return new sphericart::SolidHarmonics<double>(l_max, engine, to_cpp_layout(layout));
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+extern "C" void sphericart_solid_harmonics_delete(sphericart_solid_harmonics_calculator_t* calculator) {
+    try {
+        delete calculator;
     } catch (...) {
         // nothing to do
     }
@@ -345,16 +725,9 @@ extern "C" void sphericart_solid_harmonics_compute_array(
     double* sph,
     size_t sph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array(xyz, xyz_length, sph, sph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_solid_harmonics_compute_array_with_gradients(
@@ -366,16 +739,9 @@ extern "C" void sphericart_solid_harmonics_compute_array_with_gradients(
     double* dsph,
     size_t dsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array_with_gradients(xyz, xyz_length, sph, sph_length, dsph, dsph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_solid_harmonics_compute_array_with_hessians(
@@ -389,18 +755,214 @@ extern "C" void sphericart_solid_harmonics_compute_array_with_hessians(
     double* ddsph,
     size_t ddsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array_with_hessians(
             xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_per_l(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* const* sph,
+    size_t n_blocks
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l(xyz, xyz_length, sph, n_blocks);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_per_l_with_gradients(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* const* sph,
+    double* const* dsph,
+    size_t n_blocks
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l_with_gradients(xyz, xyz_length, sph, dsph, n_blocks);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_per_l_with_hessians(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* const* sph,
+    double* const* dsph,
+    double* const* ddsph,
+    size_t n_blocks
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l_with_hessians(xyz, xyz_length, sph, dsph, ddsph, n_blocks);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_strided(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_strided(xyz, n_samples, xyz_stride, sph, sph_stride);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_strided_with_gradients(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride,
+    double* dsph,
+    size_t dsph_stride
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_strided_with_gradients(
+            xyz, n_samples, xyz_stride, sph, sph_stride, dsph, dsph_stride
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_strided_with_hessians(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    double* sph,
+    size_t sph_stride,
+    double* dsph,
+    size_t dsph_stride,
+    double* ddsph,
+    size_t ddsph_stride
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_strided_with_hessians(
+            xyz, n_samples, xyz_stride, sph, sph_stride, dsph, dsph_stride, ddsph, ddsph_stride
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_density(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* radial,
+    size_t n_radial,
+    const size_t* centre_offsets,
+    size_t n_centres,
+    double* coefficients,
+    size_t coefficients_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_density(
+            xyz,
+            xyz_length,
+            radial,
+            n_radial,
+            centre_offsets,
+            n_centres,
+            coefficients,
+            coefficients_length
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_vjp(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    double* xyz_grad,
+    size_t xyz_grad_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_vjp(
+            xyz, xyz_length, sph_grad, sph_grad_length, xyz_grad, xyz_grad_length
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_hvp(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* xyz_vector,
+    size_t xyz_vector_length,
+    double* xyz_hvp,
+    size_t xyz_hvp_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_hvp(
+            xyz,
+            xyz_length,
+            sph_grad,
+            sph_grad_length,
+            xyz_vector,
+            xyz_vector_length,
+            xyz_hvp,
+            xyz_hvp_length
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_contract_gradients(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* dsph,
+    size_t dsph_length,
+    double* xyz_grad,
+    size_t xyz_grad_length
+) {
+    fatal_on_error([&]() {
+        calculator->contract_gradients(
+            sph_grad, sph_grad_length, dsph, dsph_length, xyz_grad, xyz_grad_length
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_contract_gradients_backward(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* sph_grad,
+    size_t sph_grad_length,
+    const double* xyz_vector,
+    size_t xyz_vector_length,
+    const double* dsph,
+    size_t dsph_length,
+    const double* ddsph,
+    size_t ddsph_length,
+    double* sph_jvp,
+    size_t sph_jvp_length,
+    double* xyz_hvp,
+    size_t xyz_hvp_length
+) {
+    fatal_on_error([&]() {
+        calculator->contract_gradients_backward(
+            sph_grad,
+            sph_grad_length,
+            xyz_vector,
+            xyz_vector_length,
+            dsph,
+            dsph_length,
+            ddsph,
+            ddsph_length,
+            sph_jvp,
+            sph_jvp_length,
+            xyz_hvp,
+            xyz_hvp_length
+        );
+    });
 }
 
 extern "C" void sphericart_solid_harmonics_compute_sample(
@@ -410,16 +972,9 @@ extern "C" void sphericart_solid_harmonics_compute_sample(
     double* sph,
     size_t sph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_sample(xyz, xyz_length, sph, sph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_solid_harmonics_compute_sample_with_gradients(
@@ -431,18 +986,11 @@ extern "C" void sphericart_solid_harmonics_compute_sample_with_gradients(
     double* dsph,
     size_t dsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_sample_with_gradients(
             xyz, xyz_length, sph, sph_length, dsph, dsph_length
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_solid_harmonics_compute_sample_with_hessians(
@@ -456,25 +1004,27 @@ extern "C" void sphericart_solid_harmonics_compute_sample_with_hessians(
     double* ddsph,
     size_t ddsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_sample_with_hessians(
             xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" sphericart_solid_harmonics_calculator_f_t* sphericart_solid_harmonics_new_f(size_t l_max) {
     try {
         return new sphericart::SolidHarmonics<float>(l_max);
     } catch (...) {
-        // TODO: better error handling
+        return nullptr;
+    }
+}
+
+extern "C" sphericart_solid_harmonics_calculator_f_t*
+sphericart_solid_harmonics_new_with_layout_f(size_t l_max, sphericart_layout_t layout) {
+    try {
+        auto engine = sphericart::Engine::SAMPLE;
+        return new sphericart::SolidHarmonics<float>(l_max, engine, to_cpp_layout(layout));
+    } catch (...) {
         return nullptr;
     }
 }
@@ -496,16 +1046,9 @@ extern "C" void sphericart_solid_harmonics_compute_array_f(
     float* sph,
     size_t sph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array(xyz, xyz_length, sph, sph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_solid_harmonics_compute_array_with_gradients_f(
@@ -517,16 +1060,9 @@ extern "C" void sphericart_solid_harmonics_compute_array_with_gradients_f(
     float* dsph,
     size_t dsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array_with_gradients(xyz, xyz_length, sph, sph_length, dsph, dsph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" void sphericart_solid_harmonics_compute_array_with_hessians_f(
@@ -540,60 +1076,242 @@ extern "C" void sphericart_solid_harmonics_compute_array_with_hessians_f(
     float* ddsph,
     size_t ddsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_array_with_hessians(
             xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
-extern "C" void sphericart_solid_harmonics_compute_sample_f(
+extern "C" void sphericart_solid_harmonics_compute_array_per_l_f(
     sphericart_solid_harmonics_calculator_f_t* calculator,
     const float* xyz,
     size_t xyz_length,
-    float* sph,
-    size_t sph_length
+    float* const* sph,
+    size_t n_blocks
 ) {
-    try {
-        calculator->compute_sample(xyz, xyz_length, sph, sph_length);
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l(xyz, xyz_length, sph, n_blocks);
+    });
 }
 
-extern "C" void sphericart_solid_harmonics_compute_sample_with_gradients_f(
+extern "C" void sphericart_solid_harmonics_compute_array_per_l_with_gradients_f(
     sphericart_solid_harmonics_calculator_f_t* calculator,
     const float* xyz,
     size_t xyz_length,
-    float* sph,
-    size_t sph_length,
-    float* dsph,
-    size_t dsph_length
+    float* const* sph,
+    float* const* dsph,
+    size_t n_blocks
 ) {
-    try {
-        calculator->compute_sample_with_gradients(
-            xyz, xyz_length, sph, sph_length, dsph, dsph_length
-        );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l_with_gradients(xyz, xyz_length, sph, dsph, n_blocks);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_per_l_with_hessians_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* const* sph,
+    float* const* dsph,
+    float* const* ddsph,
+    size_t n_blocks
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_per_l_with_hessians(xyz, xyz_length, sph, dsph, ddsph, n_blocks);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_strided_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    float* sph,
+    size_t sph_stride
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_strided(xyz, n_samples, xyz_stride, sph, sph_stride);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_strided_with_gradients_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    float* sph,
+    size_t sph_stride,
+    float* dsph,
+    size_t dsph_stride
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_strided_with_gradients(
+            xyz, n_samples, xyz_stride, sph, sph_stride, dsph, dsph_stride
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_strided_with_hessians_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    float* sph,
+    size_t sph_stride,
+    float* dsph,
+    size_t dsph_stride,
+    float* ddsph,
+    size_t ddsph_stride
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_strided_with_hessians(
+            xyz, n_samples, xyz_stride, sph, sph_stride, dsph, dsph_stride, ddsph, ddsph_stride
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_density_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* radial,
+    size_t n_radial,
+    const size_t* centre_offsets,
+    size_t n_centres,
+    float* coefficients,
+    size_t coefficients_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_density(
+            xyz,
+            xyz_length,
+            radial,
+            n_radial,
+            centre_offsets,
+            n_centres,
+            coefficients,
+            coefficients_length
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_vjp_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    float* xyz_grad,
+    size_t xyz_grad_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_vjp(
+            xyz, xyz_length, sph_grad, sph_grad_length, xyz_grad, xyz_grad_length
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_hvp_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* xyz_vector,
+    size_t xyz_vector_length,
+    float* xyz_hvp,
+    size_t xyz_hvp_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_hvp(
+            xyz,
+            xyz_length,
+            sph_grad,
+            sph_grad_length,
+            xyz_vector,
+            xyz_vector_length,
+            xyz_hvp,
+            xyz_hvp_length
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_contract_gradients_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* dsph,
+    size_t dsph_length,
+    float* xyz_grad,
+    size_t xyz_grad_length
+) {
+    fatal_on_error([&]() {
+        calculator->contract_gradients(
+            sph_grad, sph_grad_length, dsph, dsph_length, xyz_grad, xyz_grad_length
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_contract_gradients_backward_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* sph_grad,
+    size_t sph_grad_length,
+    const float* xyz_vector,
+    size_t xyz_vector_length,
+    const float* dsph,
+    size_t dsph_length,
+    const float* ddsph,
+    size_t ddsph_length,
+    float* sph_jvp,
+    size_t sph_jvp_length,
+    float* xyz_hvp,
+    size_t xyz_hvp_length
+) {
+    fatal_on_error([&]() {
+        calculator->contract_gradients_backward(
+            sph_grad,
+            sph_grad_length,
+            xyz_vector,
+            xyz_vector_length,
+            dsph,
+            dsph_length,
+            ddsph,
+            ddsph_length,
+            sph_jvp,
+            sph_jvp_length,
+            xyz_hvp,
+            xyz_hvp_length
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_sample_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample(xyz, xyz_length, sph, sph_length);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_sample_with_gradients_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length
+        );
+    });
 }
 
 extern "C" void sphericart_solid_harmonics_compute_sample_with_hessians_f(
@@ -607,18 +1325,11 @@ extern "C" void sphericart_solid_harmonics_compute_sample_with_hessians_f(
     float* ddsph,
     size_t ddsph_length
 ) {
-    try {
+    fatal_on_error([&]() {
         calculator->compute_sample_with_hessians(
             xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
         );
-    } catch (const std::exception& e) {
-        // TODO: better error handling
-        printf("fatal error: %s\n", e.what());
-        abort();
-    } catch (...) {
-        printf("fatal error: unknown exception type\n");
-        abort();
-    }
+    });
 }
 
 extern "C" int sphericart_solid_harmonics_omp_num_threads(
@@ -632,3 +1343,644 @@ extern "C" int sphericart_solid_harmonics_omp_num_threads_f(
 ) {
     return calculator->get_omp_num_threads();
 }
+
+extern "C" sphericart_workspace_t* sphericart_workspace_new() {
+    try {
+        return new sphericart::Workspace<double>();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+extern "C" sphericart_workspace_f_t* sphericart_workspace_new_f() {
+    try {
+        return new sphericart::Workspace<float>();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+extern "C" void sphericart_workspace_delete(sphericart_workspace_t* workspace) {
+    try {
+        delete workspace;
+    } catch (...) {
+        // nothing to do
+    }
+}
+
+extern "C" void sphericart_workspace_delete_f(sphericart_workspace_f_t* workspace) {
+    try {
+        delete workspace;
+    } catch (...) {
+        // nothing to do
+    }
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array(xyz, xyz_length, sph, sph_length, workspace);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_with_gradients_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_with_hessians_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_with_hessians(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_sample_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample(xyz, xyz_length, sph, sph_length, workspace);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_sample_with_gradients_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_sample_with_hessians_r(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_hessians(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array(xyz, xyz_length, sph, sph_length, workspace);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_with_gradients_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_array_with_hessians_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_with_hessians(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_sample_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample(xyz, xyz_length, sph, sph_length, workspace);
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_sample_with_gradients_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_spherical_harmonics_compute_sample_with_hessians_r_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_hessians(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array(xyz, xyz_length, sph, sph_length, workspace);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_with_gradients_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_with_hessians_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_with_hessians(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_sample_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample(xyz, xyz_length, sph, sph_length, workspace);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_sample_with_gradients_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_sample_with_hessians_r(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_hessians(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array(xyz, xyz_length, sph, sph_length, workspace);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_with_gradients_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_array_with_hessians_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_array_with_hessians(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_sample_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample(xyz, xyz_length, sph, sph_length, workspace);
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_sample_with_gradients_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, workspace
+        );
+    });
+}
+
+extern "C" void sphericart_solid_harmonics_compute_sample_with_hessians_r_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length,
+    sphericart_workspace_f_t* workspace
+) {
+    fatal_on_error([&]() {
+        calculator->compute_sample_with_hessians(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length, workspace
+        );
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_spherical_harmonics_compute_array_async(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_async(
+            xyz, xyz_length, sph, sph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_spherical_harmonics_compute_array_with_gradients_async(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_with_gradients_async(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_spherical_harmonics_compute_array_with_hessians_async(
+    sphericart_spherical_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_with_hessians_async(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_spherical_harmonics_compute_array_async_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_async(
+            xyz, xyz_length, sph, sph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_spherical_harmonics_compute_array_with_gradients_async_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_with_gradients_async(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_spherical_harmonics_compute_array_with_hessians_async_f(
+    sphericart_spherical_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_with_hessians_async(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_solid_harmonics_compute_array_async(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_async(
+            xyz, xyz_length, sph, sph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_solid_harmonics_compute_array_with_gradients_async(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_with_gradients_async(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_solid_harmonics_compute_array_with_hessians_async(
+    sphericart_solid_harmonics_calculator_t* calculator,
+    const double* xyz,
+    size_t xyz_length,
+    double* sph,
+    size_t sph_length,
+    double* dsph,
+    size_t dsph_length,
+    double* ddsph,
+    size_t ddsph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_with_hessians_async(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_solid_harmonics_compute_array_async_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_async(
+            xyz, xyz_length, sph, sph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_solid_harmonics_compute_array_with_gradients_async_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_with_gradients_async(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length
+        ));
+    });
+}
+
+extern "C" sphericart_future_t* sphericart_solid_harmonics_compute_array_with_hessians_async_f(
+    sphericart_solid_harmonics_calculator_f_t* calculator,
+    const float* xyz,
+    size_t xyz_length,
+    float* sph,
+    size_t sph_length,
+    float* dsph,
+    size_t dsph_length,
+    float* ddsph,
+    size_t ddsph_length
+) {
+    return fatal_on_error([&]() {
+        return new std::future<void>(calculator->compute_array_with_hessians_async(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length
+        ));
+    });
+}
+
+extern "C" void sphericart_future_wait(sphericart_future_t* future) {
+    fatal_on_error([&]() {
+        if (future != nullptr && future->valid()) {
+            future->get();
+        }
+    });
+}
+
+extern "C" bool sphericart_future_is_ready(sphericart_future_t* future) {
+    if (future == nullptr || !future->valid()) {
+        // there is nothing to wait for, or the result was already retrieved
+        // by sphericart_future_wait
+        return true;
+    }
+    return future->wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+extern "C" void sphericart_future_delete(sphericart_future_t* future) {
+    if (future == nullptr) {
+        return;
+    }
+    sphericart_future_wait(future);
+    delete future;
+}
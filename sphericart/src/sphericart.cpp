@@ -1,28 +1,95 @@
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <utility>
 
 #define _SPHERICART_INTERNAL_IMPLEMENTATION
 #include "sphericart.hpp"
 
+#include "cpu_kernels.hpp"
+
 using namespace sphericart;
 
-// This macro defines the different possible hardcoded function calls. It is
-// used to initialize the function pointers that are used by the `compute_`
-// calls in the SphericalHarmonics class
-#define _HARDCODED_SWITCH_CASE_SPHERICAL_HARMONICS(L_MAX)                                          \
-    this->_array_no_derivatives = &hardcoded_sph<T, false, false, true, L_MAX>;                    \
-    this->_array_with_derivatives = &hardcoded_sph<T, true, false, true, L_MAX>;                   \
-    this->_sample_no_derivatives = &hardcoded_sph_sample<T, false, false, true, L_MAX>;            \
-    this->_sample_with_derivatives = &hardcoded_sph_sample<T, true, false, true, L_MAX>;
-
-// Same, but for SolidHarmonics
-#define _HARDCODED_SWITCH_CASE_SOLID_HARMONICS(L_MAX)                                              \
-    this->_array_no_derivatives = &hardcoded_sph<T, false, false, false, L_MAX>;                   \
-    this->_array_with_derivatives = &hardcoded_sph<T, true, false, false, L_MAX>;                  \
-    this->_sample_no_derivatives = &hardcoded_sph_sample<T, false, false, false, L_MAX>;           \
-    this->_sample_with_derivatives = &hardcoded_sph_sample<T, true, false, false, L_MAX>;
-
-template <typename T> SphericalHarmonics<T>::SphericalHarmonics(size_t l_max) {
+namespace {
+
+// Runs the asynchronous compute calls of all the calculators on a background
+// thread, one after the other and in the order they were made. The calls are
+// parallel themselves, so running several of them at the same time would
+// only compete for the same cores
+class AsyncQueue {
+  public:
+    AsyncQueue() {
+        this->thread = std::thread([this]() { this->work(); });
+    }
+
+    ~AsyncQueue() {
+        {
+            std::lock_guard<std::mutex> guard(this->mutex);
+            this->stop = true;
+        }
+        this->available.notify_one();
+        this->thread.join();
+    }
+
+    std::future<void> submit(std::function<void()> function) {
+        auto task = std::packaged_task<void()>(std::move(function));
+        auto future = task.get_future();
+        {
+            std::lock_guard<std::mutex> guard(this->mutex);
+            this->tasks.push_back(std::move(task));
+        }
+        this->available.notify_one();
+        return future;
+    }
+
+  private:
+    void work() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true) {
+            this->available.wait(lock, [this]() { return this->stop || !this->tasks.empty(); });
+            if (this->tasks.empty()) {
+                return;
+            }
+            auto task = std::move(this->tasks.front());
+            this->tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<std::packaged_task<void()>> tasks;
+    bool stop = false;
+    std::thread thread;
+};
+
+AsyncQueue& async_queue() {
+    static AsyncQueue queue;
+    return queue;
+}
+
+// scratch memory for the asynchronous calls, so that they do not use the
+// buffers of the calculator
+template <typename T> Workspace<T>* async_workspace() {
+    static thread_local Workspace<T> workspace;
+    return &workspace;
+}
+
+} // namespace
+
+template <typename T>
+SphericalHarmonics<T>::SphericalHarmonics(
+    size_t l_max, Engine engine, Layout layout, std::shared_ptr<ParallelBackend> backend
+) {
     /*
         This is the constructor of the SphericalHarmonics class. It initizlizes
        buffer space, compute prefactors, and sets the function pointers that are
@@ -32,90 +99,247 @@ template <typename T> SphericalHarmonics<T>::SphericalHarmonics(size_t l_max) {
     this->l_max = (int)l_max;
     this->size_y = (int)(l_max + 1) * (l_max + 1);
     this->size_q = (int)(l_max + 1) * (l_max + 2) / 2;
-    this->prefactors = new T[this->size_q * 2];
-    this->omp_num_threads = omp_get_max_threads();
-
-    // buffers for cos, sin, 2mz arrays
-    // allocates buffers that are large enough to store thread-local data
-    this->buffers = new T[this->size_q * 3 * this->omp_num_threads];
-
-    compute_sph_prefactors<T>((int)l_max, this->prefactors);
-
-    // sets the correct function pointers for the compute functions
-    if (this->l_max <= SPHERICART_LMAX_HARDCODED) {
-        // If we only need hard-coded calls, we set them up at this point
-        // using a macro to avoid even more code duplication.
-        switch (this->l_max) {
-        case 0:
-            _HARDCODED_SWITCH_CASE_SPHERICAL_HARMONICS(0);
-            break;
-        case 1:
-            _HARDCODED_SWITCH_CASE_SPHERICAL_HARMONICS(1);
-            break;
-        case 2:
-            _HARDCODED_SWITCH_CASE_SPHERICAL_HARMONICS(2);
-            break;
-        case 3:
-            _HARDCODED_SWITCH_CASE_SPHERICAL_HARMONICS(3);
-            break;
-        case 4:
-            _HARDCODED_SWITCH_CASE_SPHERICAL_HARMONICS(4);
-            break;
-        case 5:
-            _HARDCODED_SWITCH_CASE_SPHERICAL_HARMONICS(5);
-            break;
-        case 6:
-            _HARDCODED_SWITCH_CASE_SPHERICAL_HARMONICS(6);
-            break;
-        }
+    this->engine = engine;
+    this->layout = layout;
+
+    if (backend == nullptr) {
+        backend = openmp_backend();
+    }
+    this->backend = std::move(backend);
+    this->n_workers = std::max<size_t>(this->backend->max_workers(), 1);
+
+    auto prefactors = std::shared_ptr<T[]>(new T[this->size_q * 2]);
+    compute_sph_prefactors<T>((int)l_max, prefactors.get());
+    this->prefactors = prefactors;
+
+    // sets the correct function pointers for the compute functions, using
+    // the kernels compiled for the best instruction set supported by this CPU
+    auto kernels = cpu::select_kernels<T>(l_max, true, engine);
+    this->_array_no_derivatives = kernels.array_no_derivatives;
+    this->_array_with_derivatives = kernels.array_with_derivatives;
+    this->_array_with_hessians = kernels.array_with_hessians;
+    this->_sample_no_derivatives = kernels.sample_no_derivatives;
+    this->_sample_with_derivatives = kernels.sample_with_derivatives;
+    this->_sample_with_hessians = kernels.sample_with_hessians;
+    this->_density = kernels.density;
+    this->_vjp = kernels.vjp;
+    this->_hvp = kernels.hvp;
+    this->_contract = kernels.contract;
+    this->_contract_backward = kernels.contract_backward;
+
+    // the buffers are only allocated when needed, since calculators which
+    // are always given a workspace never use them
+    this->buffer_size = kernels.buffer_size;
+}
+
+template <typename T>
+SphericalHarmonics<T>::SphericalHarmonics(const SphericalHarmonics<T>& other)
+    : l_max(other.l_max),
+      size_y(other.size_y),
+      size_q(other.size_q),
+      n_workers(other.n_workers),
+      engine(other.engine),
+      layout(other.layout),
+      buffer_size(other.buffer_size),
+      backend(other.backend),
+      thresholds(other.thresholds),
+      prefactors(other.prefactors),
+      _array_no_derivatives(other._array_no_derivatives),
+      _array_with_derivatives(other._array_with_derivatives),
+      _array_with_hessians(other._array_with_hessians),
+      _sample_no_derivatives(other._sample_no_derivatives),
+      _sample_with_derivatives(other._sample_with_derivatives),
+      _sample_with_hessians(other._sample_with_hessians),
+      _density(other._density),
+      _vjp(other._vjp),
+      _hvp(other._hvp),
+      _contract(other._contract),
+      _contract_backward(other._contract_backward) {
+    // this is only used by clone(): the prefactors, the kernels and the
+    // parallel backend are shared with `other`, and the buffers are
+    // allocated when first used
+}
+
+template <typename T> SphericalHarmonics<T>::~SphericalHarmonics() = default;
+
+template <typename T> SphericalHarmonics<T> SphericalHarmonics<T>::clone() const {
+    return SphericalHarmonics<T>(*this);
+}
+
+// distance between consecutive rows of a packed output array with
+// `n_components` entries for each sample and spherical harmonic, when the
+// spherical harmonics dimension has `size_lm` entries
+static size_t packed_row_stride(
+    Layout layout, size_t n_samples, size_t n_components, size_t size_lm
+) {
+    if (layout == Layout::LM_MAJOR) {
+        return n_samples;
     } else {
-        // if (this->normalized) {
-        this->_array_no_derivatives = &generic_sph<T, false, false, true, SPHERICART_LMAX_HARDCODED>;
-        this->_array_with_derivatives =
-            &generic_sph<T, true, false, true, SPHERICART_LMAX_HARDCODED>;
-        this->_sample_no_derivatives =
-            &generic_sph_sample<T, false, false, true, SPHERICART_LMAX_HARDCODED>;
-        this->_sample_with_derivatives =
-            &generic_sph_sample<T, true, false, true, SPHERICART_LMAX_HARDCODED>;
+        return n_components * size_lm;
+    }
+}
+
+// strides of the same output array, with rows starting `row_stride` elements
+// apart
+static ArrayStrides layout_strides(
+    Layout layout, size_t n_components, size_t size_lm, size_t row_stride
+) {
+    switch (layout) {
+    case Layout::LM_MAJOR:
+        return {1, size_lm * row_stride, row_stride};
+    case Layout::XYZ_INNERMOST:
+        return {row_stride, 1, n_components};
+    default:
+        return {row_stride, size_lm, 1};
+    }
+}
+
+template <typename T>
+const OutputBlocks<T>* SphericalHarmonics<T>::output_blocks(
+    size_t n_samples,
+    T* const* sph,
+    T* const* dsph,
+    T* const* ddsph,
+    bool per_l,
+    const size_t* row_strides,
+    std::vector<OutputBlock<T>>& storage,
+    OutputBlocks<T>& blocks
+) {
+    T* const* outputs[3] = {sph, dsph, ddsph};
+    const size_t n_components[3] = {1, 3, 9};
+
+    // packed full arrays in layouts that are equivalent to the sample-major
+    // one are filled directly by the kernels
+    auto packed = true;
+    for (size_t i_output = 0; i_output < 3 && row_strides != nullptr; i_output++) {
+        if (outputs[i_output] != nullptr &&
+            row_strides[i_output] !=
+                packed_row_stride(this->layout, n_samples, n_components[i_output], this->size_y)) {
+            packed = false;
+        }
+    }
+    if (!per_l && packed &&
+        (this->layout == Layout::SAMPLE_MAJOR ||
+         (this->layout == Layout::LM_MAJOR && n_samples == 1) ||
+         (this->layout == Layout::XYZ_INNERMOST && dsph == nullptr))) {
+        return nullptr;
+    }
+
+    const auto n_blocks = this->l_max + 1;
+    storage.resize(3 * n_blocks);
+    blocks.sph = storage.data();
+    blocks.dsph = storage.data() + n_blocks;
+    blocks.ddsph = storage.data() + 2 * n_blocks;
+
+    for (size_t i_output = 0; i_output < 3; i_output++) {
+        if (outputs[i_output] == nullptr) {
+            continue;
+        }
+        for (size_t l = 0; l < n_blocks; l++) {
+            auto size_lm = per_l ? 2 * l + 1 : this->size_y;
+            auto row_stride =
+                row_strides != nullptr
+                    ? row_strides[i_output]
+                    : packed_row_stride(this->layout, n_samples, n_components[i_output], size_lm);
+            auto strides =
+                layout_strides(this->layout, n_components[i_output], size_lm, row_stride);
+            // in full arrays, the entries of degree l start at (l, m) = (l, -l)
+            auto data = per_l ? outputs[i_output][l] : outputs[i_output][0] + l * l * strides.lm;
+            storage[i_output * n_blocks + l] = OutputBlock<T>{data, strides};
+        }
+    }
+
+    return &blocks;
+}
+
+template <typename T>
+size_t SphericalHarmonics<T>::parallel_workers(size_t n_samples, size_t n_outputs) const {
+    auto work = n_samples * this->size_y * n_outputs;
+    if (work < this->thresholds.serial_below) {
+        return 1;
+    }
+    if (this->thresholds.min_work_per_worker == 0) {
+        return this->n_workers;
+    }
+    auto n_workers = work / this->thresholds.min_work_per_worker;
+    return std::max<size_t>(1, std::min(n_workers, this->n_workers));
+}
+
+template <typename T> T* SphericalHarmonics<T>::workspace_buffers(Workspace<T>* workspace) {
+    if (workspace == nullptr) {
+        if (!in_parallel_region()) {
+            // allocates buffers that are large enough to store the data of
+            // each worker of the backend
+            if (this->buffers == nullptr) {
+                this->buffers.reset(new T[this->buffer_size * this->n_workers]);
+            }
+            return this->buffers.get();
+        }
+        // the application is running several calls at the same time, likely
+        // with the same calculator (e.g. one frame per thread of an OpenMP
+        // loop), so each thread uses its own memory instead of the buffers
+        // of the calculator
+        static thread_local Workspace<T> private_workspace;
+        workspace = &private_workspace;
     }
 
-    // set up the second derivative functions
-    if (this->l_max == 0) {
-        this->_array_with_hessians = &hardcoded_sph<T, true, true, true, 0>;
-        this->_sample_with_hessians = &hardcoded_sph_sample<T, true, true, true, 0>;
-    } else if (this->l_max == 1) {
-        this->_array_with_hessians = &hardcoded_sph<T, true, true, true, 1>;
-        this->_sample_with_hessians = &hardcoded_sph_sample<T, true, true, true, 1>;
-    } else { // second derivatives are not hardcoded past l = 1. Call generic implementations
-        this->_array_with_hessians = &generic_sph<T, true, true, true, 1>;
-        this->_sample_with_hessians = &generic_sph_sample<T, true, true, true, 1>;
+    // the kernels index the buffers with the worker number, so the workspace
+    // needs one slot for each worker of the backend
+    auto size = this->buffer_size * this->n_workers;
+    if (workspace->buffers.size() < size) {
+        workspace->buffers.resize(size);
     }
+    return workspace->buffers.data();
 }
 
-template <typename T> SphericalHarmonics<T>::~SphericalHarmonics() {
-    // Destructor, simply frees buffers
-    delete[] this->prefactors;
-    delete[] this->buffers;
+template <typename T>
+void SphericalHarmonics<T>::transpose_sample(T* dsph, T* ddsph, T* buffers) {
+    // the only layout that differs from the sample-major one for a single
+    // point is XYZ_INNERMOST. The buffers after the cos, sin, 2mz arrays are
+    // large enough to hold a copy of the Hessians
+    if (this->layout != Layout::XYZ_INNERMOST) {
+        return;
+    }
+
+    auto copy = buffers + 3 * this->size_q;
+    if (dsph != nullptr) {
+        std::copy(dsph, dsph + 3 * this->size_y, copy);
+        for (size_t k = 0; k < this->size_y; k++) {
+            for (size_t a = 0; a < 3; a++) {
+                dsph[k * 3 + a] = copy[a * this->size_y + k];
+            }
+        }
+    }
+    if (ddsph != nullptr) {
+        std::copy(ddsph, ddsph + 9 * this->size_y, copy);
+        for (size_t k = 0; k < this->size_y; k++) {
+            for (size_t a = 0; a < 9; a++) {
+                ddsph[k * 9 + a] = copy[a * this->size_y + k];
+            }
+        }
+    }
 }
 
 // The compute/compute_with_gradient functions decide which function to call
 // based on the size of the input vectors
 
 template <typename T>
-void SphericalHarmonics<T>::compute(const std::vector<T>& xyz, std::vector<T>& sph) {
+void SphericalHarmonics<T>::compute(
+    const std::vector<T>& xyz, std::vector<T>& sph, Workspace<T>* workspace
+) {
     auto n_samples = xyz.size() / 3;
     sph.resize(n_samples * (l_max + 1) * (l_max + 1));
 
     if (xyz.size() == 3) {
-        this->compute_sample(xyz.data(), xyz.size(), sph.data(), sph.size());
+        this->compute_sample(xyz.data(), xyz.size(), sph.data(), sph.size(), workspace);
     } else {
-        this->compute_array(xyz.data(), xyz.size(), sph.data(), sph.size());
+        this->compute_array(xyz.data(), xyz.size(), sph.data(), sph.size(), workspace);
     }
 }
 
 template <typename T>
 void SphericalHarmonics<T>::compute_with_gradients(
-    const std::vector<T>& xyz, std::vector<T>& sph, std::vector<T>& dsph
+    const std::vector<T>& xyz, std::vector<T>& sph, std::vector<T>& dsph, Workspace<T>* workspace
 ) {
     auto n_samples = xyz.size() / 3;
     sph.resize(n_samples * (l_max + 1) * (l_max + 1));
@@ -123,11 +347,11 @@ void SphericalHarmonics<T>::compute_with_gradients(
 
     if (xyz.size() == 3) {
         this->compute_sample_with_gradients(
-            xyz.data(), xyz.size(), sph.data(), sph.size(), dsph.data(), dsph.size()
+            xyz.data(), xyz.size(), sph.data(), sph.size(), dsph.data(), dsph.size(), workspace
         );
     } else {
         this->compute_array_with_gradients(
-            xyz.data(), xyz.size(), sph.data(), sph.size(), dsph.data(), dsph.size()
+            xyz.data(), xyz.size(), sph.data(), sph.size(), dsph.data(), dsph.size(), workspace
         );
     }
 }
@@ -136,7 +360,11 @@ void SphericalHarmonics<T>::compute_with_gradients(
 // that invoke the right (hardcoded or generic) C++-library call
 template <typename T>
 void SphericalHarmonics<T>::compute_with_hessians(
-    const std::vector<T>& xyz, std::vector<T>& sph, std::vector<T>& dsph, std::vector<T>& ddsph
+    const std::vector<T>& xyz,
+    std::vector<T>& sph,
+    std::vector<T>& dsph,
+    std::vector<T>& ddsph,
+    Workspace<T>* workspace
 ) {
     auto n_samples = xyz.size() / 3;
     sph.resize(n_samples * (l_max + 1) * (l_max + 1));
@@ -152,7 +380,8 @@ void SphericalHarmonics<T>::compute_with_hessians(
             dsph.data(),
             dsph.size(),
             ddsph.data(),
-            ddsph.size()
+            ddsph.size(),
+            workspace
         );
     } else {
         this->compute_array_with_hessians(
@@ -163,13 +392,16 @@ void SphericalHarmonics<T>::compute_with_hessians(
             dsph.data(),
             dsph.size(),
             ddsph.data(),
-            ddsph.size()
+            ddsph.size(),
+            workspace
         );
     }
 }
 
 template <typename T>
-void SphericalHarmonics<T>::compute_array(const T* xyz, size_t xyz_length, T* sph, size_t sph_length) {
+void SphericalHarmonics<T>::compute_array(
+    const T* xyz, size_t xyz_length, T* sph, size_t sph_length, Workspace<T>* workspace
+) {
     if (xyz_length % 3 != 0) {
         throw std::runtime_error(
             "SphericalHarmonics::compute_array: expected "
@@ -192,14 +424,34 @@ void SphericalHarmonics<T>::compute_array(const T* xyz, size_t xyz_length, T* sp
         );
     }
 
+    auto buffers = this->workspace_buffers(workspace);
+    std::vector<OutputBlock<T>> storage;
+    OutputBlocks<T> blocks;
     this->_array_no_derivatives(
-        xyz, sph, nullptr, nullptr, n_samples, this->l_max, this->prefactors, this->buffers
+        xyz,
+        sph,
+        nullptr,
+        nullptr,
+        n_samples,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->output_blocks(n_samples, &sph, nullptr, nullptr, false, nullptr, storage, blocks),
+        3,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 1)
     );
 }
 
 template <typename T>
 void SphericalHarmonics<T>::compute_array_with_gradients(
-    const T* xyz, size_t xyz_length, T* sph, size_t sph_length, T* dsph, size_t dsph_length
+    const T* xyz,
+    size_t xyz_length,
+    T* sph,
+    size_t sph_length,
+    T* dsph,
+    size_t dsph_length,
+    Workspace<T>* workspace
 ) {
     if (xyz_length % 3 != 0) {
         throw std::runtime_error(
@@ -230,8 +482,22 @@ void SphericalHarmonics<T>::compute_array_with_gradients(
         );
     }
 
+    auto buffers = this->workspace_buffers(workspace);
+    std::vector<OutputBlock<T>> storage;
+    OutputBlocks<T> blocks;
     this->_array_with_derivatives(
-        xyz, sph, dsph, nullptr, n_samples, this->l_max, this->prefactors, this->buffers
+        xyz,
+        sph,
+        dsph,
+        nullptr,
+        n_samples,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->output_blocks(n_samples, &sph, &dsph, nullptr, false, nullptr, storage, blocks),
+        3,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 4)
     );
 }
 
@@ -244,7 +510,8 @@ void SphericalHarmonics<T>::compute_array_with_hessians(
     T* dsph,
     size_t dsph_length,
     T* ddsph,
-    size_t ddsph_length
+    size_t ddsph_length,
+    Workspace<T>* workspace
 ) {
     if (xyz_length % 3 != 0) {
         throw std::runtime_error(
@@ -282,13 +549,818 @@ void SphericalHarmonics<T>::compute_array_with_hessians(
         );
     }
 
+    auto buffers = this->workspace_buffers(workspace);
+    std::vector<OutputBlock<T>> storage;
+    OutputBlocks<T> blocks;
+    this->_array_with_hessians(
+        xyz,
+        sph,
+        dsph,
+        ddsph,
+        n_samples,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->output_blocks(n_samples, &sph, &dsph, &ddsph, false, nullptr, storage, blocks),
+        3,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 13)
+    );
+}
+
+template <typename T>
+std::future<void> SphericalHarmonics<T>::compute_array_async(
+    const T* xyz, size_t xyz_length, T* sph, size_t sph_length
+) {
+    return async_queue().submit([this, xyz, xyz_length, sph, sph_length]() {
+        this->compute_array(xyz, xyz_length, sph, sph_length, async_workspace<T>());
+    });
+}
+
+template <typename T>
+std::future<void> SphericalHarmonics<T>::compute_array_with_gradients_async(
+    const T* xyz, size_t xyz_length, T* sph, size_t sph_length, T* dsph, size_t dsph_length
+) {
+    return async_queue().submit([this, xyz, xyz_length, sph, sph_length, dsph, dsph_length]() {
+        this->compute_array_with_gradients(
+            xyz, xyz_length, sph, sph_length, dsph, dsph_length, async_workspace<T>()
+        );
+    });
+}
+
+template <typename T>
+std::future<void> SphericalHarmonics<T>::compute_array_with_hessians_async(
+    const T* xyz,
+    size_t xyz_length,
+    T* sph,
+    size_t sph_length,
+    T* dsph,
+    size_t dsph_length,
+    T* ddsph,
+    size_t ddsph_length
+) {
+    auto compute =
+        [this, xyz, xyz_length, sph, sph_length, dsph, dsph_length, ddsph, ddsph_length]() {
+            this->compute_array_with_hessians(
+                xyz,
+                xyz_length,
+                sph,
+                sph_length,
+                dsph,
+                dsph_length,
+                ddsph,
+                ddsph_length,
+                async_workspace<T>()
+            );
+        };
+    return async_queue().submit(compute);
+}
+
+template <typename T>
+void SphericalHarmonics<T>::first_touch(size_t n_samples, T* sph, T* dsph, T* ddsph) {
+    if (n_samples == 0) {
+        return;
+    }
+    if (sph == nullptr) {
+        throw std::runtime_error("SphericalHarmonics::first_touch: expected a sph array");
+    }
+
+    // the number of workers depends on the call that will use these outputs,
+    // identified by the largest derivative requested
+    auto n_outputs = ddsph != nullptr ? 13 : (dsph != nullptr ? 4 : 1);
+    auto n_workers = this->parallel_workers(n_samples, n_outputs);
+
+    // each output holds 1, 3 or 9 arrays of size_y values for each sample
+    const std::pair<T*, size_t> outputs[3] = {{sph, 1}, {dsph, 3}, {ddsph, 9}};
+    auto size_y = static_cast<size_t>(this->size_y);
+    auto lm_major = this->layout == Layout::LM_MAJOR;
+    auto touch = [&](size_t worker, size_t n_workers) {
+        // the same split as parallel_for_samples
+        auto begin = worker * n_samples / n_workers;
+        auto end = (worker + 1) * n_samples / n_workers;
+        for (const auto& output : outputs) {
+            auto data = output.first;
+            if (data == nullptr) {
+                continue;
+            }
+            if (lm_major) {
+                // the samples are the innermost dimension of each row
+                for (size_t row = 0; row < output.second * size_y; row++) {
+                    std::fill(data + row * n_samples + begin, data + row * n_samples + end, T(0));
+                }
+            } else {
+                auto sample_size = output.second * size_y;
+                std::fill(data + begin * sample_size, data + end * sample_size, T(0));
+            }
+        }
+    };
+
+    if (n_workers == 1) {
+        touch(0, 1);
+    } else {
+        this->backend->run(n_workers, touch);
+    }
+}
+
+template <typename T>
+ArrayOutputs<T> SphericalHarmonics<T>::allocate_outputs(
+    size_t n_samples, bool gradients, bool hessians
+) {
+    // `new T[]` does not initialize the memory, leaving it to first_touch
+    auto size_y = static_cast<size_t>(this->size_y);
+    auto outputs = ArrayOutputs<T>();
+    outputs.sph.reset(new T[n_samples * size_y]);
+    if (gradients || hessians) {
+        outputs.dsph.reset(new T[n_samples * 3 * size_y]);
+    }
+    if (hessians) {
+        outputs.ddsph.reset(new T[n_samples * 9 * size_y]);
+    }
+    this->first_touch(n_samples, outputs.sph.get(), outputs.dsph.get(), outputs.ddsph.get());
+    return outputs;
+}
+
+// checks that the per-l outputs contain one non-null pointer for each l
+template <typename T> static bool valid_blocks(T* const* blocks, size_t n_blocks) {
+    if (blocks == nullptr) {
+        return false;
+    }
+    for (size_t l = 0; l < n_blocks; l++) {
+        if (blocks[l] == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+void SphericalHarmonics<T>::compute_array_per_l(
+    const T* xyz, size_t xyz_length, T* const* sph, size_t n_blocks, Workspace<T>* workspace
+) {
+    if (xyz_length % 3 != 0) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected "
+            "xyz array with `n_samples x 3` elements"
+        );
+    }
+
+    if (n_blocks != l_max + 1) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected `l_max + 1` output blocks"
+        );
+    }
+
+    auto n_samples = xyz_length / 3;
+    if (n_samples == 0) {
+        return;
+    }
+    if (!valid_blocks(sph, n_blocks)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected non-null sph blocks"
+        );
+    }
+
+    auto buffers = this->workspace_buffers(workspace);
+    std::vector<OutputBlock<T>> storage;
+    OutputBlocks<T> blocks;
+    this->_array_no_derivatives(
+        xyz,
+        nullptr,
+        nullptr,
+        nullptr,
+        n_samples,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->output_blocks(n_samples, sph, nullptr, nullptr, true, nullptr, storage, blocks),
+        3,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 1)
+    );
+}
+
+template <typename T>
+void SphericalHarmonics<T>::compute_array_per_l_with_gradients(
+    const T* xyz,
+    size_t xyz_length,
+    T* const* sph,
+    T* const* dsph,
+    size_t n_blocks,
+    Workspace<T>* workspace
+) {
+    if (xyz_length % 3 != 0) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected "
+            "xyz array with `n_samples x 3` elements"
+        );
+    }
+
+    if (n_blocks != l_max + 1) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected `l_max + 1` output blocks"
+        );
+    }
+
+    auto n_samples = xyz_length / 3;
+    if (n_samples == 0) {
+        return;
+    }
+    if (!valid_blocks(sph, n_blocks)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected non-null sph blocks"
+        );
+    }
+    if (!valid_blocks(dsph, n_blocks)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected non-null dsph blocks"
+        );
+    }
+
+    auto buffers = this->workspace_buffers(workspace);
+    std::vector<OutputBlock<T>> storage;
+    OutputBlocks<T> blocks;
+    this->_array_with_derivatives(
+        xyz,
+        nullptr,
+        nullptr,
+        nullptr,
+        n_samples,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->output_blocks(n_samples, sph, dsph, nullptr, true, nullptr, storage, blocks),
+        3,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 4)
+    );
+}
+
+template <typename T>
+void SphericalHarmonics<T>::compute_array_per_l_with_hessians(
+    const T* xyz,
+    size_t xyz_length,
+    T* const* sph,
+    T* const* dsph,
+    T* const* ddsph,
+    size_t n_blocks,
+    Workspace<T>* workspace
+) {
+    if (xyz_length % 3 != 0) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected "
+            "xyz array with `n_samples x 3` elements"
+        );
+    }
+
+    if (n_blocks != l_max + 1) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected `l_max + 1` output blocks"
+        );
+    }
+
+    auto n_samples = xyz_length / 3;
+    if (n_samples == 0) {
+        return;
+    }
+    if (!valid_blocks(sph, n_blocks)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected non-null sph blocks"
+        );
+    }
+    if (!valid_blocks(dsph, n_blocks)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected non-null dsph blocks"
+        );
+    }
+    if (!valid_blocks(ddsph, n_blocks)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_per_l: expected non-null ddsph blocks"
+        );
+    }
+
+    auto buffers = this->workspace_buffers(workspace);
+    std::vector<OutputBlock<T>> storage;
+    OutputBlocks<T> blocks;
+    this->_array_with_hessians(
+        xyz,
+        nullptr,
+        nullptr,
+        nullptr,
+        n_samples,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->output_blocks(n_samples, sph, dsph, ddsph, true, nullptr, storage, blocks),
+        3,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 13)
+    );
+}
+
+template <typename T>
+void SphericalHarmonics<T>::compute_array_strided(
+    const T* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    T* sph,
+    size_t sph_stride,
+    Workspace<T>* workspace
+) {
+    if (xyz_stride < 3) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_strided: expected xyz_stride of at least 3"
+        );
+    }
+
+    if (n_samples == 0) {
+        return;
+    }
+    if (sph == nullptr ||
+        sph_stride < packed_row_stride(this->layout, n_samples, 1, this->size_y)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_strided: expected "
+            "sph array with sph_stride at least as large as its rows"
+        );
+    }
+
+    const size_t row_strides[3] = {sph_stride, 0, 0};
+    auto buffers = this->workspace_buffers(workspace);
+    std::vector<OutputBlock<T>> storage;
+    OutputBlocks<T> blocks;
+    this->_array_no_derivatives(
+        xyz,
+        sph,
+        nullptr,
+        nullptr,
+        n_samples,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->output_blocks(n_samples, &sph, nullptr, nullptr, false, row_strides, storage, blocks),
+        xyz_stride,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 1)
+    );
+}
+
+template <typename T>
+void SphericalHarmonics<T>::compute_array_strided_with_gradients(
+    const T* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    T* sph,
+    size_t sph_stride,
+    T* dsph,
+    size_t dsph_stride,
+    Workspace<T>* workspace
+) {
+    if (xyz_stride < 3) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_strided: expected xyz_stride of at least 3"
+        );
+    }
+
+    if (n_samples == 0) {
+        return;
+    }
+    if (sph == nullptr ||
+        sph_stride < packed_row_stride(this->layout, n_samples, 1, this->size_y)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_strided: expected "
+            "sph array with sph_stride at least as large as its rows"
+        );
+    }
+    if (dsph == nullptr ||
+        dsph_stride < packed_row_stride(this->layout, n_samples, 3, this->size_y)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_strided: expected "
+            "dsph array with dsph_stride at least as large as its rows"
+        );
+    }
+
+    const size_t row_strides[3] = {sph_stride, dsph_stride, 0};
+    auto buffers = this->workspace_buffers(workspace);
+    std::vector<OutputBlock<T>> storage;
+    OutputBlocks<T> blocks;
+    this->_array_with_derivatives(
+        xyz,
+        sph,
+        dsph,
+        nullptr,
+        n_samples,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->output_blocks(n_samples, &sph, &dsph, nullptr, false, row_strides, storage, blocks),
+        xyz_stride,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 4)
+    );
+}
+
+template <typename T>
+void SphericalHarmonics<T>::compute_array_strided_with_hessians(
+    const T* xyz,
+    size_t n_samples,
+    size_t xyz_stride,
+    T* sph,
+    size_t sph_stride,
+    T* dsph,
+    size_t dsph_stride,
+    T* ddsph,
+    size_t ddsph_stride,
+    Workspace<T>* workspace
+) {
+    if (xyz_stride < 3) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_strided: expected xyz_stride of at least 3"
+        );
+    }
+
+    if (n_samples == 0) {
+        return;
+    }
+    if (sph == nullptr ||
+        sph_stride < packed_row_stride(this->layout, n_samples, 1, this->size_y)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_strided: expected "
+            "sph array with sph_stride at least as large as its rows"
+        );
+    }
+    if (dsph == nullptr ||
+        dsph_stride < packed_row_stride(this->layout, n_samples, 3, this->size_y)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_strided: expected "
+            "dsph array with dsph_stride at least as large as its rows"
+        );
+    }
+    if (ddsph == nullptr ||
+        ddsph_stride < packed_row_stride(this->layout, n_samples, 9, this->size_y)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_array_strided: expected "
+            "ddsph array with ddsph_stride at least as large as its rows"
+        );
+    }
+
+    const size_t row_strides[3] = {sph_stride, dsph_stride, ddsph_stride};
+    auto buffers = this->workspace_buffers(workspace);
+    std::vector<OutputBlock<T>> storage;
+    OutputBlocks<T> blocks;
     this->_array_with_hessians(
-        xyz, sph, dsph, ddsph, n_samples, this->l_max, this->prefactors, this->buffers
+        xyz,
+        sph,
+        dsph,
+        ddsph,
+        n_samples,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->output_blocks(n_samples, &sph, &dsph, &ddsph, false, row_strides, storage, blocks),
+        xyz_stride,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 13)
+    );
+}
+
+template <typename T>
+void SphericalHarmonics<T>::compute_density(
+    const T* xyz,
+    size_t xyz_length,
+    const T* radial,
+    size_t n_radial,
+    const size_t* centre_offsets,
+    size_t n_centres,
+    T* coefficients,
+    size_t coefficients_length,
+    Workspace<T>* workspace
+) {
+    if (xyz_length % 3 != 0) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_density: expected "
+            "xyz array with `n_pairs x 3` elements"
+        );
+    }
+
+    auto n_pairs = xyz_length / 3;
+    if (centre_offsets == nullptr || centre_offsets[0] != 0 ||
+        centre_offsets[n_centres] != n_pairs) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_density: expected centre_offsets "
+            "array with `n_centres + 1` elements, from 0 to `n_pairs`"
+        );
+    }
+    for (size_t i = 0; i < n_centres; i++) {
+        if (centre_offsets[i + 1] < centre_offsets[i]) {
+            throw std::runtime_error(
+                "SphericalHarmonics::compute_density: expected sorted centre_offsets"
+            );
+        }
+    }
+
+    if (n_centres == 0 || n_radial == 0) {
+        return;
+    }
+    if (n_pairs != 0 && radial == nullptr) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_density: expected "
+            "radial array with `n_pairs x n_radial` elements"
+        );
+    }
+    if (coefficients == nullptr ||
+        coefficients_length < n_centres * n_radial * this->size_y) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_density: expected coefficients "
+            "array with `n_centres x n_radial x (l_max + 1)^2` elements"
+        );
+    }
+
+    auto buffers = this->workspace_buffers(workspace);
+    this->_density(
+        xyz,
+        radial,
+        n_radial,
+        centre_offsets,
+        n_centres,
+        coefficients,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->backend.get(),
+        this->parallel_workers(n_pairs, 1 + n_radial)
+    );
+}
+
+template <typename T>
+void SphericalHarmonics<T>::compute_vjp(
+    const T* xyz,
+    size_t xyz_length,
+    const T* sph_grad,
+    size_t sph_grad_length,
+    T* xyz_grad,
+    size_t xyz_grad_length,
+    Workspace<T>* workspace
+) {
+    if (xyz_length % 3 != 0) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_vjp: expected "
+            "xyz array with `n_samples x 3` elements"
+        );
+    }
+
+    auto n_samples = xyz_length / 3;
+    if (sph_grad_length < n_samples * this->size_y || (n_samples != 0 && sph_grad == nullptr)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_vjp: expected "
+            "sph_grad array with `n_samples x (l_max + 1)^2` elements"
+        );
+    }
+
+    if (xyz_grad_length < xyz_length || (n_samples != 0 && xyz_grad == nullptr)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_vjp: expected "
+            "xyz_grad array with `n_samples x 3` elements"
+        );
+    }
+
+    if (n_samples == 0) {
+        return;
+    }
+
+    // only the sample and lm strides of the gradient are used
+    auto row_stride = packed_row_stride(this->layout, n_samples, 1, this->size_y);
+    auto sph_grad_strides = layout_strides(this->layout, 1, this->size_y, row_stride);
+    auto buffers = this->workspace_buffers(workspace);
+    this->_vjp(
+        xyz,
+        sph_grad,
+        xyz_grad,
+        n_samples,
+        sph_grad_strides,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 4)
+    );
+}
+
+template <typename T>
+void SphericalHarmonics<T>::compute_hvp(
+    const T* xyz,
+    size_t xyz_length,
+    const T* sph_grad,
+    size_t sph_grad_length,
+    const T* xyz_vector,
+    size_t xyz_vector_length,
+    T* xyz_hvp,
+    size_t xyz_hvp_length,
+    Workspace<T>* workspace
+) {
+    if (xyz_length % 3 != 0) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_hvp: expected "
+            "xyz array with `n_samples x 3` elements"
+        );
+    }
+
+    auto n_samples = xyz_length / 3;
+    if (sph_grad_length < n_samples * this->size_y || (n_samples != 0 && sph_grad == nullptr)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_hvp: expected "
+            "sph_grad array with `n_samples x (l_max + 1)^2` elements"
+        );
+    }
+
+    if (xyz_vector_length < xyz_length || (n_samples != 0 && xyz_vector == nullptr)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_hvp: expected "
+            "xyz_vector array with `n_samples x 3` elements"
+        );
+    }
+
+    if (xyz_hvp_length < xyz_length || (n_samples != 0 && xyz_hvp == nullptr)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::compute_hvp: expected "
+            "xyz_hvp array with `n_samples x 3` elements"
+        );
+    }
+
+    if (n_samples == 0) {
+        return;
+    }
+
+    auto row_stride = packed_row_stride(this->layout, n_samples, 1, this->size_y);
+    auto sph_grad_strides = layout_strides(this->layout, 1, this->size_y, row_stride);
+    auto buffers = this->workspace_buffers(workspace);
+    this->_hvp(
+        xyz,
+        sph_grad,
+        xyz_vector,
+        xyz_hvp,
+        n_samples,
+        sph_grad_strides,
+        this->l_max,
+        this->prefactors.get(),
+        buffers,
+        this->backend.get(),
+        this->parallel_workers(n_samples, 13)
+    );
+}
+
+template <typename T>
+void SphericalHarmonics<T>::contract_gradients(
+    const T* sph_grad,
+    size_t sph_grad_length,
+    const T* dsph,
+    size_t dsph_length,
+    T* xyz_grad,
+    size_t xyz_grad_length
+) {
+    if (xyz_grad_length % 3 != 0) {
+        throw std::runtime_error(
+            "SphericalHarmonics::contract_gradients: expected "
+            "xyz_grad array with `n_samples x 3` elements"
+        );
+    }
+
+    auto n_samples = xyz_grad_length / 3;
+    if (n_samples != 0 && xyz_grad == nullptr) {
+        throw std::runtime_error(
+            "SphericalHarmonics::contract_gradients: expected "
+            "xyz_grad array with `n_samples x 3` elements"
+        );
+    }
+
+    if (sph_grad_length < n_samples * this->size_y || (n_samples != 0 && sph_grad == nullptr)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::contract_gradients: expected "
+            "sph_grad array with `n_samples x (l_max + 1)^2` elements"
+        );
+    }
+
+    if (dsph_length < n_samples * 3 * this->size_y || (n_samples != 0 && dsph == nullptr)) {
+        throw std::runtime_error(
+            "SphericalHarmonics::contract_gradients: expected "
+            "dsph array with `n_samples x 3 x (l_max + 1)^2` elements"
+        );
+    }
+
+    auto sph_grad_strides = layout_strides(
+        this->layout, 1, this->size_y, packed_row_stride(this->layout, n_samples, 1, this->size_y)
+    );
+    auto dsph_strides = layout_strides(
+        this->layout, 3, this->size_y, packed_row_stride(this->layout, n_samples, 3, this->size_y)
+    );
+    this->_contract(
+        sph_grad,
+        dsph,
+        xyz_grad,
+        n_samples,
+        sph_grad_strides,
+        dsph_strides,
+        static_cast<int>(this->size_y),
+        this->backend.get(),
+        this->parallel_workers(n_samples, 4)
+    );
+}
+
+template <typename T>
+void SphericalHarmonics<T>::contract_gradients_backward(
+    const T* sph_grad,
+    size_t sph_grad_length,
+    const T* xyz_vector,
+    size_t xyz_vector_length,
+    const T* dsph,
+    size_t dsph_length,
+    const T* ddsph,
+    size_t ddsph_length,
+    T* sph_jvp,
+    size_t sph_jvp_length,
+    T* xyz_hvp,
+    size_t xyz_hvp_length
+) {
+    if (xyz_vector_length % 3 != 0) {
+        throw std::runtime_error(
+            "SphericalHarmonics::contract_gradients_backward: expected "
+            "xyz_vector array with `n_samples x 3` elements"
+        );
+    }
+
+    auto n_samples = xyz_vector_length / 3;
+    if (n_samples == 0) {
+        return;
+    }
+
+    if (xyz_vector == nullptr) {
+        throw std::runtime_error(
+            "SphericalHarmonics::contract_gradients_backward: expected "
+            "xyz_vector array with `n_samples x 3` elements"
+        );
+    }
+
+    if (sph_jvp != nullptr) {
+        if (sph_jvp_length < n_samples * this->size_y) {
+            throw std::runtime_error(
+                "SphericalHarmonics::contract_gradients_backward: expected "
+                "sph_jvp array with `n_samples x (l_max + 1)^2` elements"
+            );
+        }
+        if (dsph == nullptr || dsph_length < n_samples * 3 * this->size_y) {
+            throw std::runtime_error(
+                "SphericalHarmonics::contract_gradients_backward: expected "
+                "dsph array with `n_samples x 3 x (l_max + 1)^2` elements"
+            );
+        }
+    }
+
+    if (xyz_hvp != nullptr) {
+        if (xyz_hvp_length < xyz_vector_length) {
+            throw std::runtime_error(
+                "SphericalHarmonics::contract_gradients_backward: expected "
+                "xyz_hvp array with `n_samples x 3` elements"
+            );
+        }
+        if (sph_grad == nullptr || sph_grad_length < n_samples * this->size_y) {
+            throw std::runtime_error(
+                "SphericalHarmonics::contract_gradients_backward: expected "
+                "sph_grad array with `n_samples x (l_max + 1)^2` elements"
+            );
+        }
+        if (ddsph == nullptr || ddsph_length < n_samples * 9 * this->size_y) {
+            throw std::runtime_error(
+                "SphericalHarmonics::contract_gradients_backward: expected "
+                "ddsph array with `n_samples x 3 x 3 x (l_max + 1)^2` elements"
+            );
+        }
+    }
+
+    ArrayStrides strides[3];
+    const size_t n_components[3] = {1, 3, 9};
+    for (size_t i = 0; i < 3; i++) {
+        auto row_stride = packed_row_stride(this->layout, n_samples, n_components[i], this->size_y);
+        strides[i] = layout_strides(this->layout, n_components[i], this->size_y, row_stride);
+    }
+    this->_contract_backward(
+        sph_grad,
+        xyz_vector,
+        dsph,
+        ddsph,
+        sph_jvp,
+        xyz_hvp,
+        n_samples,
+        strides[0],
+        strides[1],
+        strides[2],
+        static_cast<int>(this->size_y),
+        this->backend.get(),
+        this->parallel_workers(n_samples, 13)
     );
 }
 
 template <typename T>
-void SphericalHarmonics<T>::compute_sample(const T* xyz, size_t xyz_length, T* sph, size_t sph_length) {
+void SphericalHarmonics<T>::compute_sample(
+    const T* xyz, size_t xyz_length, T* sph, size_t sph_length, Workspace<T>* workspace
+) {
     if (xyz_length != 3) {
         throw std::runtime_error(
             "SphericalHarmonics::compute_sample: expected xyz array with 3 "
@@ -304,6 +1376,7 @@ void SphericalHarmonics<T>::compute_sample(const T* xyz, size_t xyz_length, T* s
         );
     }
 
+    auto buffers = this->workspace_buffers(workspace);
     this->_sample_no_derivatives(
         xyz,
         sph,
@@ -311,17 +1384,23 @@ void SphericalHarmonics<T>::compute_sample(const T* xyz, size_t xyz_length, T* s
         nullptr,
         this->l_max,
         this->size_y,
-        this->prefactors,
-        this->prefactors + this->size_q,
-        this->buffers,
-        this->buffers + this->size_q,
-        this->buffers + 2 * this->size_q
+        this->prefactors.get(),
+        this->prefactors.get() + this->size_q,
+        buffers,
+        buffers + this->size_q,
+        buffers + 2 * this->size_q
     );
 }
 
 template <typename T>
 void SphericalHarmonics<T>::compute_sample_with_gradients(
-    const T* xyz, size_t xyz_length, T* sph, size_t sph_length, T* dsph, size_t dsph_length
+    const T* xyz,
+    size_t xyz_length,
+    T* sph,
+    size_t sph_length,
+    T* dsph,
+    size_t dsph_length,
+    Workspace<T>* workspace
 ) {
     if (xyz_length != 3) {
         throw std::runtime_error(
@@ -345,6 +1424,7 @@ void SphericalHarmonics<T>::compute_sample_with_gradients(
         );
     }
 
+    auto buffers = this->workspace_buffers(workspace);
     this->_sample_with_derivatives(
         xyz,
         sph,
@@ -352,12 +1432,13 @@ void SphericalHarmonics<T>::compute_sample_with_gradients(
         nullptr,
         this->l_max,
         this->size_y,
-        this->prefactors,
-        this->prefactors + this->size_q,
-        this->buffers,
-        this->buffers + this->size_q,
-        this->buffers + 2 * this->size_q
+        this->prefactors.get(),
+        this->prefactors.get() + this->size_q,
+        buffers,
+        buffers + this->size_q,
+        buffers + 2 * this->size_q
     );
+    this->transpose_sample(dsph, nullptr, buffers);
 }
 
 template <typename T>
@@ -369,7 +1450,8 @@ void SphericalHarmonics<T>::compute_sample_with_hessians(
     T* dsph,
     size_t dsph_length,
     T* ddsph,
-    size_t ddsph_length
+    size_t ddsph_length,
+    Workspace<T>* workspace
 ) {
     if (xyz_length != 3) {
         throw std::runtime_error(
@@ -401,6 +1483,7 @@ void SphericalHarmonics<T>::compute_sample_with_hessians(
         );
     }
 
+    auto buffers = this->workspace_buffers(workspace);
     this->_sample_with_hessians(
         xyz,
         sph,
@@ -408,71 +1491,42 @@ void SphericalHarmonics<T>::compute_sample_with_hessians(
         ddsph,
         this->l_max,
         this->size_y,
-        this->prefactors,
-        this->prefactors + this->size_q,
-        this->buffers,
-        this->buffers + this->size_q,
-        this->buffers + 2 * this->size_q
+        this->prefactors.get(),
+        this->prefactors.get() + this->size_q,
+        buffers,
+        buffers + this->size_q,
+        buffers + 2 * this->size_q
     );
+    this->transpose_sample(dsph, ddsph, buffers);
 }
 
 template <typename T>
-SolidHarmonics<T>::SolidHarmonics(size_t l_max) : SphericalHarmonics<T>(l_max) {
+SolidHarmonics<T>::SolidHarmonics(
+    size_t l_max, Engine engine, Layout layout, std::shared_ptr<ParallelBackend> backend
+)
+    : SphericalHarmonics<T>(l_max, engine, layout, std::move(backend)) {
     /*
         This is the constructor of the SolidHarmonics class. It initizlizes
        buffer space, compute prefactors, and sets the function pointers that are
        used for the actual calls
     */
 
-    // Just override the function pointers with the SolidHarmonics versions
-    if (this->l_max <= SPHERICART_LMAX_HARDCODED) {
-        // If we only need hard-coded calls, we set them up at this point
-        // using a macro to avoid even more code duplication.
-        switch (this->l_max) {
-        case 0:
-            _HARDCODED_SWITCH_CASE_SOLID_HARMONICS(0);
-            break;
-        case 1:
-            _HARDCODED_SWITCH_CASE_SOLID_HARMONICS(1);
-            break;
-        case 2:
-            _HARDCODED_SWITCH_CASE_SOLID_HARMONICS(2);
-            break;
-        case 3:
-            _HARDCODED_SWITCH_CASE_SOLID_HARMONICS(3);
-            break;
-        case 4:
-            _HARDCODED_SWITCH_CASE_SOLID_HARMONICS(4);
-            break;
-        case 5:
-            _HARDCODED_SWITCH_CASE_SOLID_HARMONICS(5);
-            break;
-        case 6:
-            _HARDCODED_SWITCH_CASE_SOLID_HARMONICS(6);
-            break;
-        }
-    } else {
-        this->_array_no_derivatives =
-            &generic_sph<T, false, false, false, SPHERICART_LMAX_HARDCODED>;
-        this->_array_with_derivatives =
-            &generic_sph<T, true, false, false, SPHERICART_LMAX_HARDCODED>;
-        this->_sample_no_derivatives =
-            &generic_sph_sample<T, false, false, false, SPHERICART_LMAX_HARDCODED>;
-        this->_sample_with_derivatives =
-            &generic_sph_sample<T, true, false, false, SPHERICART_LMAX_HARDCODED>;
-    }
-
-    // set up the second derivative functions
-    if (this->l_max == 0) {
-        this->_array_with_hessians = &hardcoded_sph<T, true, true, false, 0>;
-        this->_sample_with_hessians = &hardcoded_sph_sample<T, true, true, false, 0>;
-    } else if (this->l_max == 1) {
-        this->_array_with_hessians = &hardcoded_sph<T, true, true, false, 1>;
-        this->_sample_with_hessians = &hardcoded_sph_sample<T, true, true, false, 1>;
-    } else { // second derivatives are not hardcoded past l = 1. Call generic implementations
-        this->_array_with_hessians = &generic_sph<T, true, true, false, 1>;
-        this->_sample_with_hessians = &generic_sph_sample<T, true, true, false, 1>;
-    }
+    // Just override the function pointers with the SolidHarmonics versions.
+    // These use the same buffers as the SphericalHarmonics ones.
+    auto kernels = cpu::select_kernels<T>(l_max, false, engine);
+    this->_array_no_derivatives = kernels.array_no_derivatives;
+    this->_array_with_derivatives = kernels.array_with_derivatives;
+    this->_array_with_hessians = kernels.array_with_hessians;
+    this->_sample_no_derivatives = kernels.sample_no_derivatives;
+    this->_sample_with_derivatives = kernels.sample_with_derivatives;
+    this->_sample_with_hessians = kernels.sample_with_hessians;
+    this->_density = kernels.density;
+    this->_vjp = kernels.vjp;
+    this->_hvp = kernels.hvp;
+}
+
+template <typename T> SolidHarmonics<T> SolidHarmonics<T>::clone() const {
+    return SolidHarmonics<T>(*this);
 }
 
 // instantiates the SphericalHarmonics and SolidHarmonics classes
@@ -0,0 +1,170 @@
+/** @file test_async.cpp
+ *  @brief Checks that the asynchronous compute functions (from the C++ and
+ *  the C API) give the same results as the synchronous ones, including while
+ *  the calculator is used by synchronous calls
+ */
+
+#include <cstdio>
+#include <future>
+#include <random>
+
+#include "sphericart.h"
+#include "sphericart.hpp"
+#include "test_utils.hpp"
+
+using namespace sphericart;
+
+#define N_CALLS 6
+
+template <template <typename> class C>
+bool check_async(size_t l_max, Engine engine, const std::vector<DTYPE>& xyz) {
+    auto n_samples = xyz.size() / 3;
+    auto size_y = (l_max + 1) * (l_max + 1);
+
+    C<DTYPE> calculator(l_max, engine);
+    auto sph = std::vector<DTYPE>(n_samples * size_y);
+    auto dsph = std::vector<DTYPE>(n_samples * 3 * size_y);
+    auto ddsph = std::vector<DTYPE>(n_samples * 9 * size_y);
+    calculator.compute_array_with_hessians(
+        xyz.data(),
+        xyz.size(),
+        sph.data(),
+        sph.size(),
+        dsph.data(),
+        dsph.size(),
+        ddsph.data(),
+        ddsph.size()
+    );
+
+    // several calls are in flight at the same time, while the calculator is
+    // also used synchronously
+    auto async_sph = std::vector<std::vector<DTYPE>>(N_CALLS, std::vector<DTYPE>(sph.size()));
+    auto async_dsph = std::vector<std::vector<DTYPE>>(N_CALLS, std::vector<DTYPE>(dsph.size()));
+    auto async_ddsph = std::vector<std::vector<DTYPE>>(N_CALLS, std::vector<DTYPE>(ddsph.size()));
+    auto futures = std::vector<std::future<void>>();
+    for (size_t i = 0; i < N_CALLS; i++) {
+        if (i % 3 == 0) {
+            futures.push_back(calculator.compute_array_async(
+                xyz.data(), xyz.size(), async_sph[i].data(), async_sph[i].size()
+            ));
+        } else if (i % 3 == 1) {
+            futures.push_back(calculator.compute_array_with_gradients_async(
+                xyz.data(),
+                xyz.size(),
+                async_sph[i].data(),
+                async_sph[i].size(),
+                async_dsph[i].data(),
+                async_dsph[i].size()
+            ));
+        } else {
+            futures.push_back(calculator.compute_array_with_hessians_async(
+                xyz.data(),
+                xyz.size(),
+                async_sph[i].data(),
+                async_sph[i].size(),
+                async_dsph[i].data(),
+                async_dsph[i].size(),
+                async_ddsph[i].data(),
+                async_ddsph[i].size()
+            ));
+        }
+    }
+
+    auto sync_sph = std::vector<DTYPE>(sph.size());
+    calculator.compute_array(xyz.data(), xyz.size(), sync_sph.data(), sync_sph.size());
+
+    bool passed = check_close(sph, sync_sph);
+    for (size_t i = 0; i < N_CALLS; i++) {
+        futures[i].get();
+        passed &= check_close(sph, async_sph[i]);
+        if (i % 3 >= 1) {
+            passed &= check_close(dsph, async_dsph[i]);
+        }
+        if (i % 3 == 2) {
+            passed &= check_close(ddsph, async_ddsph[i]);
+        }
+    }
+    if (!passed) {
+        printf("Mismatch detected for asynchronous calls at l_max = %zu\n", l_max);
+    }
+
+    // errors are reported when waiting for the results
+    auto bad_length = xyz.size() - 1;
+    auto future = calculator.compute_array_async(xyz.data(), bad_length, sph.data(), sph.size());
+    try {
+        future.get();
+        printf("Expected an error for an invalid asynchronous call\n");
+        passed = false;
+    } catch (const std::runtime_error&) {
+    }
+
+    return passed;
+}
+
+static bool check_c_api(size_t l_max, const std::vector<double>& xyz) {
+    auto n_samples = xyz.size() / 3;
+    auto size_y = (l_max + 1) * (l_max + 1);
+
+    auto* calculator = sphericart_spherical_harmonics_new(l_max);
+    auto sph = std::vector<double>(n_samples * size_y);
+    auto dsph = std::vector<double>(n_samples * 3 * size_y);
+    sphericart_spherical_harmonics_compute_array_with_gradients(
+        calculator, xyz.data(), xyz.size(), sph.data(), sph.size(), dsph.data(), dsph.size()
+    );
+
+    auto async_sph = std::vector<double>(sph.size());
+    auto async_dsph = std::vector<double>(dsph.size());
+    auto* future = sphericart_spherical_harmonics_compute_array_with_gradients_async(
+        calculator,
+        xyz.data(),
+        xyz.size(),
+        async_sph.data(),
+        async_sph.size(),
+        async_dsph.data(),
+        async_dsph.size()
+    );
+    sphericart_future_wait(future);
+    bool passed = sphericart_future_is_ready(future);
+    sphericart_future_delete(future);
+
+    // NULL futures are accepted everywhere
+    sphericart_future_wait(nullptr);
+    passed &= sphericart_future_is_ready(nullptr);
+    sphericart_future_delete(nullptr);
+
+    passed &= check_close(sph, async_sph) && check_close(dsph, async_dsph);
+    if (!passed) {
+        printf("Mismatch detected for the C API at l_max = %zu\n", l_max);
+    }
+    sphericart_spherical_harmonics_delete(calculator);
+    return passed;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 10;
+    size_t n_samples = 200;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz = std::vector<DTYPE>(3 * n_samples);
+    for (auto& value : xyz) {
+        value = distribution(rng);
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto engine : {Engine::SAMPLE, Engine::BATCHED}) {
+            test_passed &= check_async<SphericalHarmonics>(l_max, engine, xyz);
+            test_passed &= check_async<SolidHarmonics>(l_max, engine, xyz);
+        }
+        test_passed &= check_c_api(l_max, std::vector<double>(xyz.begin(), xyz.end()));
+    }
+
+    if (test_passed) {
+        printf("Async test passed\n");
+        return 0;
+    } else {
+        printf("Async test failed\n");
+        return -1;
+    }
+}
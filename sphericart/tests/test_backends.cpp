@@ -0,0 +1,277 @@
+/** @file test_backends.cpp
+ *  @brief Checks that all the parallel backends give the same results as the
+ *  default OpenMP one, for the array calculators and the fused kernels, and
+ *  that parallel and serial evaluations agree. Also checks that errors in
+ *  the tasks of the thread pool are given back to the caller, that
+ *  `first_touch` zeroes the outputs in all layouts, and that
+ *  `allocate_outputs` returns usable outputs
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include "sphericart.hpp"
+#include "test_utils.hpp"
+
+using namespace sphericart;
+
+#define N_WORKERS 4
+
+// runs each task of the caller backend on its own std::thread, as an external
+// scheduler would
+static void thread_executor(size_t n_tasks, const std::function<void(size_t)>& run_task) {
+    auto threads = std::vector<std::thread>();
+    for (size_t i = 0; i < n_tasks; i++) {
+        threads.emplace_back([&run_task, i]() { run_task(i); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+template <template <typename> class C>
+bool check_backend(
+    std::shared_ptr<ParallelBackend> backend,
+    const char* name,
+    size_t l_max,
+    Engine engine,
+    const std::vector<DTYPE>& xyz,
+    const std::vector<DTYPE>& sph_grad
+) {
+    auto n_samples = xyz.size() / 3;
+    auto size_y = (l_max + 1) * (l_max + 1);
+
+    // every sample is its own centre, with a single radial weight
+    auto centre_offsets = std::vector<size_t>(n_samples + 1);
+    for (size_t i = 0; i <= n_samples; i++) {
+        centre_offsets[i] = i;
+    }
+    auto radial = std::vector<DTYPE>(n_samples, 1.0);
+
+    auto compute_all = [&](C<DTYPE>& calculator,
+                           std::vector<DTYPE>& sph,
+                           std::vector<DTYPE>& dsph,
+                           std::vector<DTYPE>& ddsph,
+                           std::vector<DTYPE>& density,
+                           std::vector<DTYPE>& xyz_grad) {
+        calculator.compute_with_hessians(xyz, sph, dsph, ddsph);
+        density.resize(n_samples * size_y);
+        calculator.compute_density(
+            xyz.data(),
+            xyz.size(),
+            radial.data(),
+            1,
+            centre_offsets.data(),
+            n_samples,
+            density.data(),
+            density.size()
+        );
+        xyz_grad.resize(3 * n_samples);
+        calculator.compute_vjp(
+            xyz.data(),
+            xyz.size(),
+            sph_grad.data(),
+            sph_grad.size(),
+            xyz_grad.data(),
+            xyz_grad.size()
+        );
+    };
+
+    std::vector<DTYPE> sph, dsph, ddsph, density, xyz_grad;
+    C<DTYPE> reference(l_max, engine);
+    compute_all(reference, sph, dsph, ddsph, density, xyz_grad);
+
+    std::vector<DTYPE> backend_sph, backend_dsph, backend_ddsph, backend_density, backend_xyz_grad;
+    // the arrays are small, so the calculators would compute them serially
+    // with the default thresholds. The clone uses the same thresholds
+    C<DTYPE> calculator(l_max, engine, Layout::SAMPLE_MAJOR, backend);
+    calculator.set_parallel_thresholds({0, 0});
+    auto clone = calculator.clone();
+    compute_all(clone, backend_sph, backend_dsph, backend_ddsph, backend_density, backend_xyz_grad);
+
+    if (!check_close(sph, backend_sph) || !check_close(dsph, backend_dsph) ||
+        !check_close(ddsph, backend_ddsph) || !check_close(density, backend_density) ||
+        !check_close(xyz_grad, backend_xyz_grad)) {
+        printf("Mismatch detected for the %s backend at l_max = %zu\n", name, l_max);
+        return false;
+    }
+    return true;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 10;
+    size_t n_samples = 53;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz = std::vector<DTYPE>(3 * n_samples);
+    for (auto& value : xyz) {
+        value = distribution(rng);
+    }
+
+    auto backends = std::vector<std::pair<std::shared_ptr<ParallelBackend>, const char*>>({
+        {serial_backend(), "serial"},
+        {thread_pool_backend(N_WORKERS), "thread pool"},
+        {thread_pool_backend(N_WORKERS, ThreadPinning::CORES), "thread pool pinned to cores"},
+        {thread_pool_backend(N_WORKERS, ThreadPinning::SOCKETS), "thread pool pinned to sockets"},
+        {caller_backend(N_WORKERS, thread_executor), "caller"},
+    });
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        auto sph_grad = std::vector<DTYPE>(n_samples * (l_max + 1) * (l_max + 1));
+        for (auto& value : sph_grad) {
+            value = distribution(rng);
+        }
+        for (auto engine : {Engine::SAMPLE, Engine::BATCHED}) {
+            for (const auto& backend : backends) {
+                test_passed &= check_backend<SphericalHarmonics>(
+                    backend.first, backend.second, l_max, engine, xyz, sph_grad
+                );
+                test_passed &= check_backend<SolidHarmonics>(
+                    backend.first, backend.second, l_max, engine, xyz, sph_grad
+                );
+            }
+        }
+    }
+
+    // the thread pool can be used from several threads at the same time, and
+    // by a calculator running inside one of its own tasks
+    auto pool = thread_pool_backend(N_WORKERS);
+    auto calculator = SphericalHarmonics<DTYPE>(8, Engine::SAMPLE, Layout::SAMPLE_MAJOR, pool);
+    calculator.set_parallel_thresholds({0, 0});
+    auto reference = std::vector<DTYPE>();
+    calculator.compute(xyz, reference);
+    bool results[N_WORKERS];
+    auto run_nested = [&](size_t worker, size_t /*n_workers*/) {
+        auto nested = calculator.clone();
+        auto sph = std::vector<DTYPE>();
+        nested.compute(xyz, sph);
+        results[worker] = check_close(reference, sph);
+    };
+    for (auto& result : results) {
+        result = true;
+    }
+    pool->run(N_WORKERS, run_nested);
+    for (size_t i = 0; i < N_WORKERS; i++) {
+        if (!results[i]) {
+            printf("Mismatch detected for a nested call on worker %zu\n", i);
+            test_passed = false;
+        }
+    }
+
+    auto threads = std::vector<std::thread>();
+    for (size_t i = 0; i < N_WORKERS; i++) {
+        threads.emplace_back([&, i]() {
+            auto workspace = Workspace<DTYPE>();
+            auto sph = std::vector<DTYPE>();
+            calculator.compute(xyz, sph, &workspace);
+            results[i] = check_close(reference, sph);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < N_WORKERS; i++) {
+        if (!results[i]) {
+            printf("Mismatch detected for concurrent calls on thread %zu\n", i);
+            test_passed = false;
+        }
+    }
+
+    // errors thrown by the calling thread or by a pool thread are given back
+    // to the caller once all the workers are done, and the pool is still
+    // usable afterwards
+    for (size_t failing = 0; failing < 2; failing++) {
+        bool finished[N_WORKERS] = {};
+        auto failing_task = [&](size_t worker, size_t /*n_workers*/) {
+            if (worker == failing) {
+                throw std::runtime_error("failing task");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            finished[worker] = true;
+        };
+        bool thrown = false;
+        try {
+            pool->run(N_WORKERS, failing_task);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        for (size_t i = 0; i < N_WORKERS; i++) {
+            if (i != failing && !finished[i]) {
+                thrown = false;
+            }
+        }
+        if (!thrown || in_parallel_region()) {
+            printf("Error in the task of worker %zu was not propagated\n", failing);
+            test_passed = false;
+        }
+    }
+    auto sph = std::vector<DTYPE>();
+    calculator.compute(xyz, sph);
+    if (!check_close(reference, sph)) {
+        printf("Mismatch detected after an error in the thread pool\n");
+        test_passed = false;
+    }
+
+    // first_touch zeroes all the outputs, in all layouts
+    for (auto layout : {Layout::SAMPLE_MAJOR, Layout::XYZ_INNERMOST, Layout::LM_MAJOR}) {
+        auto touched = SphericalHarmonics<DTYPE>(4, Engine::SAMPLE, layout, pool);
+        touched.set_parallel_thresholds({0, 0});
+        auto sph = std::vector<DTYPE>(n_samples * 25, 1.0);
+        auto dsph = std::vector<DTYPE>(n_samples * 3 * 25, 1.0);
+        auto ddsph = std::vector<DTYPE>(n_samples * 9 * 25, 1.0);
+        touched.first_touch(n_samples, sph.data());
+        touched.first_touch(n_samples, sph.data(), dsph.data(), ddsph.data());
+        for (const auto* output : {&sph, &dsph, &ddsph}) {
+            for (auto value : *output) {
+                if (value != 0.0) {
+                    printf("first_touch did not zero all the outputs\n");
+                    test_passed = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    // allocate_outputs gives zeroed outputs, which can be computed into
+    auto allocated = SphericalHarmonics<DTYPE>(4, Engine::SAMPLE, Layout::SAMPLE_MAJOR, pool);
+    allocated.set_parallel_thresholds({0, 0});
+    auto outputs = allocated.allocate_outputs(n_samples, true, true);
+    if (outputs.sph == nullptr || outputs.dsph == nullptr || outputs.ddsph == nullptr) {
+        printf("allocate_outputs did not allocate all the outputs\n");
+        test_passed = false;
+    } else {
+        for (size_t i = 0; i < n_samples * 9 * 25; i++) {
+            if (outputs.ddsph[i] != 0.0 || (i < n_samples * 25 && outputs.sph[i] != 0.0)) {
+                printf("allocate_outputs did not zero all the outputs\n");
+                test_passed = false;
+                break;
+            }
+        }
+    }
+    auto gradients = allocated.allocate_outputs(n_samples, true);
+    if (gradients.dsph == nullptr || gradients.ddsph != nullptr) {
+        printf("allocate_outputs allocated the wrong outputs\n");
+        test_passed = false;
+    }
+    allocated.compute_array(xyz.data(), xyz.size(), outputs.sph.get(), n_samples * 25);
+    auto expected = std::vector<DTYPE>();
+    allocated.compute(xyz, expected);
+    auto computed = std::vector<DTYPE>(outputs.sph.get(), outputs.sph.get() + n_samples * 25);
+    if (!check_close(expected, computed)) {
+        printf("Mismatch detected when computing into allocate_outputs\n");
+        test_passed = false;
+    }
+
+    if (test_passed) {
+        printf("Backends test passed\n");
+        return 0;
+    } else {
+        printf("Backends test failed\n");
+        return -1;
+    }
+}
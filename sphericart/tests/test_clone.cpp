@@ -0,0 +1,99 @@
+/** @file test_clone.cpp
+ *  @brief Checks that calculators can be moved, and that their clones give
+ *  the same results as the original, including after it has been destroyed
+ *  and when they are used by different threads at the same time
+ */
+
+#include <cstdio>
+#include <random>
+#include <thread>
+
+#include "sphericart.hpp"
+#include "test_utils.hpp"
+
+using namespace sphericart;
+
+#define N_THREADS 4
+
+template <template <typename> class C>
+bool check_clone(size_t l_max, Engine engine, const std::vector<DTYPE>& xyz) {
+    auto sph = std::vector<DTYPE>();
+    auto dsph = std::vector<DTYPE>();
+    auto ddsph = std::vector<DTYPE>();
+    C<DTYPE> reference(l_max, engine);
+    reference.compute_with_hessians(xyz, sph, dsph, ddsph);
+
+    // the clones are moved into a vector, and outlive the calculator they
+    // were created from
+    auto calculators = std::vector<C<DTYPE>>();
+    {
+        auto original = C<DTYPE>(l_max, engine);
+        for (size_t i = 0; i < N_THREADS; i++) {
+            calculators.push_back(original.clone());
+        }
+    }
+
+    bool results[N_THREADS];
+    auto threads = std::vector<std::thread>();
+    for (size_t i = 0; i < N_THREADS; i++) {
+        threads.emplace_back([&, i]() {
+            auto thread_sph = std::vector<DTYPE>();
+            auto thread_dsph = std::vector<DTYPE>();
+            auto thread_ddsph = std::vector<DTYPE>();
+            calculators[i].compute_with_hessians(xyz, thread_sph, thread_dsph, thread_ddsph);
+            results[i] = check_close(sph, thread_sph) && check_close(dsph, thread_dsph) &&
+                         check_close(ddsph, thread_ddsph);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    bool passed = true;
+    for (size_t i = 0; i < N_THREADS; i++) {
+        if (!results[i]) {
+            printf("Mismatch detected for clone %zu at l_max = %zu\n", i, l_max);
+            passed = false;
+        }
+    }
+
+    // move assignment
+    auto moved = C<DTYPE>(0, engine);
+    moved = std::move(calculators.back());
+    auto moved_sph = std::vector<DTYPE>();
+    moved.compute(xyz, moved_sph);
+    if (moved.get_l_max() != l_max || !check_close(sph, moved_sph)) {
+        printf("Mismatch detected for a moved calculator at l_max = %zu\n", l_max);
+        passed = false;
+    }
+
+    return passed;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 10;
+    size_t n_samples = 37;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz = std::vector<DTYPE>(3 * n_samples);
+    for (auto& value : xyz) {
+        value = distribution(rng);
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto engine : {Engine::SAMPLE, Engine::BATCHED}) {
+            test_passed &= check_clone<SphericalHarmonics>(l_max, engine, xyz);
+            test_passed &= check_clone<SolidHarmonics>(l_max, engine, xyz);
+        }
+    }
+
+    if (test_passed) {
+        printf("Clone test passed\n");
+        return 0;
+    } else {
+        printf("Clone test failed\n");
+        return -1;
+    }
+}
@@ -0,0 +1,135 @@
+/** @file test_coalescer.cpp
+ *  @brief Checks that the calls submitted to a Coalescer from several
+ *  threads give the same results as calling the calculator directly
+ */
+
+#include <cstdio>
+#include <future>
+#include <random>
+#include <thread>
+
+#include "coalescer.hpp"
+#include "test_utils.hpp"
+
+using namespace sphericart;
+
+#define N_THREADS 4
+#define N_CALLS 25
+
+template <template <typename> class C>
+bool check_coalescer(size_t l_max, Layout layout, const std::vector<std::vector<DTYPE>>& xyz) {
+    auto size_y = (l_max + 1) * (l_max + 1);
+    C<DTYPE> calculator(l_max, Engine::SAMPLE, layout);
+
+    auto sph = std::vector<std::vector<DTYPE>>(N_CALLS);
+    auto dsph = std::vector<std::vector<DTYPE>>(N_CALLS);
+    for (size_t i = 0; i < N_CALLS; i++) {
+        auto n_samples = xyz[i].size() / 3;
+        sph[i].resize(n_samples * size_y);
+        dsph[i].resize(n_samples * 3 * size_y);
+        calculator.compute_array_with_gradients(
+            xyz[i].data(),
+            xyz[i].size(),
+            sph[i].data(),
+            sph[i].size(),
+            dsph[i].data(),
+            dsph[i].size()
+        );
+    }
+
+    // each thread submits some of the calls, half of them without gradients,
+    // and waits for all of them at the end
+    auto coalescer = Coalescer<DTYPE>(calculator, {std::chrono::microseconds(500), 1000});
+    bool results[N_THREADS];
+    auto threads = std::vector<std::thread>();
+    for (size_t t = 0; t < N_THREADS; t++) {
+        threads.emplace_back([&, t]() {
+            auto call_sph = std::vector<std::vector<DTYPE>>(N_CALLS);
+            auto call_dsph = std::vector<std::vector<DTYPE>>(N_CALLS);
+            auto futures = std::vector<std::future<void>>();
+            for (size_t i = t; i < N_CALLS; i += N_THREADS) {
+                call_sph[i].resize(sph[i].size());
+                if (i % 2 == 0) {
+                    call_dsph[i].resize(dsph[i].size());
+                    futures.push_back(coalescer.submit_with_gradients(
+                        xyz[i].data(),
+                        xyz[i].size(),
+                        call_sph[i].data(),
+                        call_sph[i].size(),
+                        call_dsph[i].data(),
+                        call_dsph[i].size()
+                    ));
+                } else {
+                    futures.push_back(coalescer.submit(
+                        xyz[i].data(), xyz[i].size(), call_sph[i].data(), call_sph[i].size()
+                    ));
+                }
+            }
+            for (auto& future : futures) {
+                future.get();
+            }
+
+            bool passed = true;
+            for (size_t i = t; i < N_CALLS; i += N_THREADS) {
+                passed &= check_close(sph[i], call_sph[i]);
+                if (i % 2 == 0) {
+                    passed &= check_close(dsph[i], call_dsph[i]);
+                }
+            }
+            results[t] = passed;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    bool passed = true;
+    for (size_t t = 0; t < N_THREADS; t++) {
+        if (!results[t]) {
+            printf("Mismatch detected for thread %zu at l_max = %zu\n", t, l_max);
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 8;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz = std::vector<std::vector<DTYPE>>();
+    for (size_t i = 0; i < N_CALLS; i++) {
+        // some calls have no points at all
+        auto n_samples = i % 7 == 0 ? 0 : 10 * i + 1;
+        xyz.emplace_back(3 * n_samples);
+        for (auto& value : xyz.back()) {
+            value = distribution(rng);
+        }
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto layout : {Layout::SAMPLE_MAJOR, Layout::XYZ_INNERMOST}) {
+            test_passed &= check_coalescer<SphericalHarmonics>(l_max, layout, xyz);
+            test_passed &= check_coalescer<SolidHarmonics>(l_max, layout, xyz);
+        }
+    }
+
+    // the outputs of different calls can not be separated in this layout
+    try {
+        auto calculator = SphericalHarmonics<DTYPE>(4, Engine::SAMPLE, Layout::LM_MAJOR);
+        auto coalescer = Coalescer<DTYPE>(calculator);
+        printf("Expected an error for a calculator with the LM_MAJOR layout\n");
+        test_passed = false;
+    } catch (const std::runtime_error&) {
+    }
+
+    if (test_passed) {
+        printf("Coalescer test passed\n");
+        return 0;
+    } else {
+        printf("Coalescer test failed\n");
+        return -1;
+    }
+}
@@ -0,0 +1,116 @@
+/** @file test_density.cpp
+ *  @brief Checks that the fused density expansion gives the same results as
+ *  summing the products of the spherical harmonics and radial weights of all
+ *  the pairs of each centre
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "sphericart.hpp"
+
+#define _SPH_TOL 1e-10
+#ifndef DTYPE
+#define DTYPE double
+#endif
+using namespace sphericart;
+
+template <template <typename> class C>
+bool check_density(
+    size_t l_max,
+    Engine engine,
+    const std::vector<DTYPE>& xyz,
+    const std::vector<DTYPE>& radial,
+    size_t n_radial,
+    const std::vector<size_t>& centre_offsets
+) {
+    auto size_y = (l_max + 1) * (l_max + 1);
+    auto n_pairs = xyz.size() / 3;
+    auto n_centres = centre_offsets.size() - 1;
+
+    C<DTYPE> calculator(l_max, engine);
+    auto sph = std::vector<DTYPE>(n_pairs * size_y);
+    calculator.compute_array(xyz.data(), xyz.size(), sph.data(), sph.size());
+
+    auto reference = std::vector<DTYPE>(n_centres * n_radial * size_y, 0.0);
+    for (size_t i = 0; i < n_centres; i++) {
+        for (auto j = centre_offsets[i]; j < centre_offsets[i + 1]; j++) {
+            for (size_t n = 0; n < n_radial; n++) {
+                for (size_t k = 0; k < size_y; k++) {
+                    reference[(i * n_radial + n) * size_y + k] +=
+                        radial[j * n_radial + n] * sph[j * size_y + k];
+                }
+            }
+        }
+    }
+
+    // the outputs should be overwritten, including for centres without
+    // neighbours
+    auto coefficients = std::vector<DTYPE>(n_centres * n_radial * size_y, 1234.5);
+    calculator.compute_density(
+        xyz.data(),
+        xyz.size(),
+        radial.data(),
+        n_radial,
+        centre_offsets.data(),
+        n_centres,
+        coefficients.data(),
+        coefficients.size()
+    );
+
+    for (size_t k = 0; k < reference.size(); k++) {
+        if (std::fabs(reference[k] - coefficients[k]) >
+            _SPH_TOL * (1.0 + std::fabs(reference[k]))) {
+            printf("Mismatch detected for the density expansion at l_max = %zu\n", l_max);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 10;
+    size_t n_centres = 23;
+    size_t n_radial = 5;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    std::uniform_int_distribution<size_t> n_neighbours(0, 12);
+
+    // some centres have no neighbours
+    auto centre_offsets = std::vector<size_t>({0});
+    for (size_t i = 0; i < n_centres; i++) {
+        auto count = i % 7 == 3 ? 0 : n_neighbours(rng);
+        centre_offsets.push_back(centre_offsets.back() + count);
+    }
+    auto n_pairs = centre_offsets.back();
+
+    auto xyz = std::vector<DTYPE>(3 * n_pairs);
+    for (auto& value : xyz) {
+        value = distribution(rng);
+    }
+    auto radial = std::vector<DTYPE>(n_radial * n_pairs);
+    for (auto& value : radial) {
+        value = distribution(rng);
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto engine : {Engine::SAMPLE, Engine::BATCHED}) {
+            test_passed &= check_density<SphericalHarmonics>(
+                l_max, engine, xyz, radial, n_radial, centre_offsets
+            );
+            test_passed &=
+                check_density<SolidHarmonics>(l_max, engine, xyz, radial, n_radial, centre_offsets);
+        }
+    }
+
+    if (test_passed) {
+        printf("Density test passed\n");
+        return 0;
+    } else {
+        printf("Density test failed\n");
+        return -1;
+    }
+}
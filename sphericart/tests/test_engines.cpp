@@ -0,0 +1,131 @@
+/** @file test_engines.cpp
+ *  @brief Checks consistency of the different engines for array calls, and
+ *  of the kernels compiled for different instruction sets
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "sphericart.hpp"
+
+#define _SPH_TOL 1e-10
+#ifndef DTYPE
+#define DTYPE double
+#endif
+using namespace sphericart;
+
+static bool all_close(const std::vector<DTYPE>& reference, const std::vector<DTYPE>& value) {
+    for (size_t i = 0; i < reference.size(); i++) {
+        if (std::fabs(reference[i] - value[i]) > _SPH_TOL * (1.0 + std::fabs(reference[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <template <typename> class C>
+bool check_engines(size_t l_max, size_t n_samples, const std::vector<DTYPE>& xyz_all) {
+    auto xyz = std::vector<DTYPE>(xyz_all.begin(), xyz_all.begin() + 3 * n_samples);
+
+    auto sph = std::vector<DTYPE>();
+    auto dsph = std::vector<DTYPE>();
+    auto ddsph = std::vector<DTYPE>();
+    C<DTYPE> reference(l_max, Engine::SAMPLE);
+    reference.compute_with_hessians(xyz, sph, dsph, ddsph);
+
+    auto sph_batched = std::vector<DTYPE>();
+    auto dsph_batched = std::vector<DTYPE>();
+    auto ddsph_batched = std::vector<DTYPE>();
+    auto sph_batched_only = std::vector<DTYPE>();
+    auto sph_batched_grad = std::vector<DTYPE>();
+    C<DTYPE> batched(l_max, Engine::BATCHED);
+    batched.compute_with_hessians(xyz, sph_batched, dsph_batched, ddsph_batched);
+    batched.compute_with_gradients(xyz, sph_batched_grad, dsph_batched);
+    batched.compute(xyz, sph_batched_only);
+
+    bool passed = true;
+    if (!all_close(sph, sph_batched) || !all_close(dsph, dsph_batched) ||
+        !all_close(ddsph, ddsph_batched) || !all_close(sph, sph_batched_grad) ||
+        !all_close(sph, sph_batched_only)) {
+        printf("Mismatch detected at l_max = %zu, n_samples = %zu\n", l_max, n_samples);
+        passed = false;
+    }
+
+    return passed;
+}
+
+static void set_cpu_isa(const char* isa) {
+#ifdef _WIN32
+    _putenv_s("SPHERICART_CPU_ISA", isa);
+#else
+    setenv("SPHERICART_CPU_ISA", isa, 1);
+#endif
+}
+
+template <template <typename> class C>
+bool check_isas(size_t l_max, size_t n_samples, const std::vector<DTYPE>& xyz_all) {
+    // the kernels compiled for all the instruction sets supported by the CPU
+    // (or just the generic ones, if the library was compiled without runtime
+    // dispatch) should give the same results
+    auto xyz = std::vector<DTYPE>(xyz_all.begin(), xyz_all.begin() + 3 * n_samples);
+
+    auto sph = std::vector<DTYPE>();
+    auto dsph = std::vector<DTYPE>();
+    auto ddsph = std::vector<DTYPE>();
+    set_cpu_isa("generic");
+    C<DTYPE> reference(l_max);
+    reference.compute_with_hessians(xyz, sph, dsph, ddsph);
+
+    bool passed = true;
+    for (auto isa : {"sse4.2", "avx2", "avx512"}) {
+        set_cpu_isa(isa);
+        auto isa_sph = std::vector<DTYPE>();
+        auto isa_dsph = std::vector<DTYPE>();
+        auto isa_ddsph = std::vector<DTYPE>();
+        C<DTYPE> calculator(l_max);
+        calculator.compute_with_hessians(xyz, isa_sph, isa_dsph, isa_ddsph);
+
+        if (!all_close(sph, isa_sph) || !all_close(dsph, isa_dsph) ||
+            !all_close(ddsph, isa_ddsph)) {
+            printf("Mismatch detected for ISA %s at l_max = %zu\n", isa, l_max);
+            passed = false;
+        }
+    }
+    set_cpu_isa("avx512");
+
+    return passed;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 15;
+
+    // n_samples values that exercise full and partial blocks of points
+    auto n_samples_list = std::vector<size_t>({2, 7, 8, 16, 37});
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz_all = std::vector<DTYPE>(3 * 37);
+    for (auto& value : xyz_all) {
+        value = distribution(rng);
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto n_samples : n_samples_list) {
+            test_passed &= check_engines<SphericalHarmonics>(l_max, n_samples, xyz_all);
+            test_passed &= check_engines<SolidHarmonics>(l_max, n_samples, xyz_all);
+        }
+        test_passed &= check_isas<SphericalHarmonics>(l_max, 37, xyz_all);
+        test_passed &= check_isas<SolidHarmonics>(l_max, 37, xyz_all);
+    }
+
+    if (test_passed) {
+        printf("Engine consistency test passed\n");
+        return 0;
+    } else {
+        printf("Engine consistency test failed\n");
+        return -1;
+    }
+}
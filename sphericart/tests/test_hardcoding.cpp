@@ -169,6 +169,46 @@ int main(int argc, char* argv[]) {
             }
         }
     }
+
+    // second derivatives, which can be zero, are compared with an absolute
+    // tolerance
+    auto ddsph = std::vector<DTYPE>(n_samples * 9 * (l_max + 1) * (l_max + 1), 0.0);
+    generic_sph<DTYPE, true, true, false, 1>(
+        xyz.data(),
+        sph.data(),
+        dsph.data(),
+        ddsph.data(),
+        n_samples,
+        l_max,
+        prefactors.data(),
+        buffers
+    );
+
+    auto ddsph1 = std::vector<DTYPE>(n_samples * 9 * (l_max + 1) * (l_max + 1), 0.0);
+    SH.compute_with_hessians(xyz, sph1, dsph1, ddsph1);
+
+    for (size_t i_sample = 0; i_sample < n_samples; i_sample++) {
+        for (int alpha = 0; alpha < 9; alpha++) {
+            for (size_t l = 0; l < (l_max + 1); l++) {
+                for (int m = -static_cast<int>(l); m <= static_cast<int>(l); m++) {
+                    auto index = 9 * size2 * i_sample + size2 * alpha + l * l + l + m;
+                    auto tolerance = _SPH_TOL * (1.0 + fabs(ddsph[index]));
+                    if (fabs(ddsph[index] - ddsph1[index]) > tolerance) {
+                        printf(
+                            "Mismatch detected at i_sample = %zu, L = %zu, m = "
+                            "%d \n",
+                            i_sample,
+                            l,
+                            m
+                        );
+                        printf("DDSPH[%d]: %e, %e\n", alpha, ddsph[index], ddsph1[index]);
+                        test_passed = false;
+                    }
+                }
+            }
+        }
+    }
+
     if (test_passed) {
         printf("Consistency test passed\n");
         return 0;
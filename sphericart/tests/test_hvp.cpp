@@ -0,0 +1,237 @@
+/** @file test_hvp.cpp
+ *  @brief Checks that the Hessian-vector product gives the same results as
+ *  contracting the Hessians of the spherical harmonics with the gradient with
+ *  respect to the spherical harmonics and with the vector, in all the layouts,
+ *  and that `contract_gradients_backward` gives the same results (and the
+ *  derivative of the spherical harmonics along the vector) from the stored
+ *  derivatives
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+#include "sphericart.hpp"
+
+#define _SPH_TOL 1e-10
+#ifndef DTYPE
+#define DTYPE double
+#endif
+using namespace sphericart;
+
+template <template <typename> class C>
+bool check_hvp(
+    size_t l_max,
+    size_t n_samples,
+    Engine engine,
+    const std::vector<DTYPE>& xyz_all,
+    const std::vector<DTYPE>& sph_grad_all,
+    const std::vector<DTYPE>& xyz_vector_all
+) {
+    auto xyz = std::vector<DTYPE>(xyz_all.begin(), xyz_all.begin() + 3 * n_samples);
+    auto xyz_vector =
+        std::vector<DTYPE>(xyz_vector_all.begin(), xyz_vector_all.begin() + 3 * n_samples);
+    auto size_y = (l_max + 1) * (l_max + 1);
+    auto sph_grad =
+        std::vector<DTYPE>(sph_grad_all.begin(), sph_grad_all.begin() + n_samples * size_y);
+
+    auto sph = std::vector<DTYPE>();
+    auto dsph = std::vector<DTYPE>();
+    auto ddsph = std::vector<DTYPE>();
+    C<DTYPE> reference_calculator(l_max, engine);
+    reference_calculator.compute_with_hessians(xyz, sph, dsph, ddsph);
+
+    auto reference = std::vector<DTYPE>(3 * n_samples, 0.0);
+    for (size_t i = 0; i < n_samples; i++) {
+        for (size_t a = 0; a < 3; a++) {
+            for (size_t b = 0; b < 3; b++) {
+                for (size_t k = 0; k < size_y; k++) {
+                    reference[3 * i + b] += xyz_vector[3 * i + a] * sph_grad[i * size_y + k] *
+                                            ddsph[((i * 3 + a) * 3 + b) * size_y + k];
+                }
+            }
+        }
+    }
+
+    auto reference_jvp = std::vector<DTYPE>(n_samples * size_y, 0.0);
+    for (size_t i = 0; i < n_samples; i++) {
+        for (size_t a = 0; a < 3; a++) {
+            for (size_t k = 0; k < size_y; k++) {
+                reference_jvp[i * size_y + k] +=
+                    xyz_vector[3 * i + a] * dsph[(i * 3 + a) * size_y + k];
+            }
+        }
+    }
+
+    bool passed = true;
+    for (auto layout : {Layout::SAMPLE_MAJOR, Layout::LM_MAJOR, Layout::XYZ_INNERMOST}) {
+        // the gradient with respect to the spherical harmonics is stored in
+        // the same layout as the spherical harmonics
+        auto layout_sph_grad = sph_grad;
+        if (layout == Layout::LM_MAJOR) {
+            for (size_t i = 0; i < n_samples; i++) {
+                for (size_t k = 0; k < size_y; k++) {
+                    layout_sph_grad[k * n_samples + i] = sph_grad[i * size_y + k];
+                }
+            }
+        }
+
+        C<DTYPE> calculator(l_max, engine, layout);
+        auto xyz_hvp = std::vector<DTYPE>(3 * n_samples, 1234.5);
+        calculator.compute_hvp(
+            xyz.data(),
+            xyz.size(),
+            layout_sph_grad.data(),
+            layout_sph_grad.size(),
+            xyz_vector.data(),
+            xyz_vector.size(),
+            xyz_hvp.data(),
+            xyz_hvp.size()
+        );
+
+        // the same from the derivatives computed in this layout, together
+        // with the derivative along the vector
+        auto layout_sph = std::vector<DTYPE>(n_samples * size_y);
+        auto layout_dsph = std::vector<DTYPE>(n_samples * 3 * size_y);
+        auto layout_ddsph = std::vector<DTYPE>(n_samples * 9 * size_y);
+        calculator.compute_array_with_hessians(
+            xyz.data(),
+            xyz.size(),
+            layout_sph.data(),
+            layout_sph.size(),
+            layout_dsph.data(),
+            layout_dsph.size(),
+            layout_ddsph.data(),
+            layout_ddsph.size()
+        );
+        auto contracted_hvp = std::vector<DTYPE>(3 * n_samples, 1234.5);
+        auto sph_jvp = std::vector<DTYPE>(n_samples * size_y, 1234.5);
+        calculator.contract_gradients_backward(
+            layout_sph_grad.data(),
+            layout_sph_grad.size(),
+            xyz_vector.data(),
+            xyz_vector.size(),
+            layout_dsph.data(),
+            layout_dsph.size(),
+            layout_ddsph.data(),
+            layout_ddsph.size(),
+            sph_jvp.data(),
+            sph_jvp.size(),
+            contracted_hvp.data(),
+            contracted_hvp.size()
+        );
+        // the outputs can also be computed one at a time
+        auto hvp_only = std::vector<DTYPE>(3 * n_samples, 1234.5);
+        calculator.contract_gradients_backward(
+            layout_sph_grad.data(),
+            layout_sph_grad.size(),
+            xyz_vector.data(),
+            xyz_vector.size(),
+            nullptr,
+            0,
+            layout_ddsph.data(),
+            layout_ddsph.size(),
+            nullptr,
+            0,
+            hvp_only.data(),
+            hvp_only.size()
+        );
+
+        auto expected_jvp = reference_jvp;
+        if (layout == Layout::LM_MAJOR) {
+            for (size_t i = 0; i < n_samples; i++) {
+                for (size_t k = 0; k < size_y; k++) {
+                    expected_jvp[k * n_samples + i] = reference_jvp[i * size_y + k];
+                }
+            }
+        }
+
+        const std::vector<DTYPE>* expected[4] = {&reference, &reference, &reference, &expected_jvp};
+        const std::vector<DTYPE>* results[4] = {&xyz_hvp, &contracted_hvp, &hvp_only, &sph_jvp};
+        const char* names[4] = {"compute_hvp", "xyz_hvp", "xyz_hvp alone", "sph_jvp"};
+        for (size_t i_result = 0; i_result < 4; i_result++) {
+            const auto& values = *results[i_result];
+            const auto& expected_values = *expected[i_result];
+            for (size_t k = 0; k < expected_values.size(); k++) {
+                if (std::fabs(expected_values[k] - values[k]) >
+                    _SPH_TOL * (1.0 + std::fabs(expected_values[k]))) {
+                    printf(
+                        "Mismatch detected for %s in layout %d at l_max = %zu, n_samples = %zu\n",
+                        names[i_result],
+                        static_cast<int>(layout),
+                        l_max,
+                        n_samples
+                    );
+                    passed = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    return passed;
+}
+
+// calls without any sample can use null pointers, as given e.g. by empty
+// torch tensors
+template <template <typename> class C> bool check_no_samples(size_t l_max) {
+    bool passed = true;
+    for (auto layout : {Layout::SAMPLE_MAJOR, Layout::XYZ_INNERMOST, Layout::LM_MAJOR}) {
+        C<DTYPE> calculator(l_max, Engine::SAMPLE, layout);
+        try {
+            calculator.compute_hvp(nullptr, 0, nullptr, 0, nullptr, 0, nullptr, 0);
+            calculator.contract_gradients_backward(
+                nullptr, 0, nullptr, 0, nullptr, 0, nullptr, 0, nullptr, 0, nullptr, 0
+            );
+        } catch (const std::runtime_error& e) {
+            printf("Unexpected error without samples: %s\n", e.what());
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 10;
+    auto n_samples_list = std::vector<size_t>({1, 2, 7, 37});
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz_all = std::vector<DTYPE>(3 * 37);
+    for (auto& value : xyz_all) {
+        value = distribution(rng);
+    }
+    auto sph_grad_all = std::vector<DTYPE>(37 * (MAX_L_VALUE + 1) * (MAX_L_VALUE + 1));
+    for (auto& value : sph_grad_all) {
+        value = distribution(rng);
+    }
+    auto xyz_vector_all = std::vector<DTYPE>(3 * 37);
+    for (auto& value : xyz_vector_all) {
+        value = distribution(rng);
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto n_samples : n_samples_list) {
+            for (auto engine : {Engine::SAMPLE, Engine::BATCHED}) {
+                test_passed &= check_hvp<SphericalHarmonics>(
+                    l_max, n_samples, engine, xyz_all, sph_grad_all, xyz_vector_all
+                );
+                test_passed &= check_hvp<SolidHarmonics>(
+                    l_max, n_samples, engine, xyz_all, sph_grad_all, xyz_vector_all
+                );
+            }
+        }
+        test_passed &= check_no_samples<SphericalHarmonics>(l_max);
+        test_passed &= check_no_samples<SolidHarmonics>(l_max);
+    }
+
+    if (test_passed) {
+        printf("HVP test passed\n");
+        return 0;
+    } else {
+        printf("HVP test failed\n");
+        return -1;
+    }
+}
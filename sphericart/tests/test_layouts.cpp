@@ -0,0 +1,226 @@
+/** @file test_layouts.cpp
+ *  @brief Checks that the outputs computed in the different memory layouts,
+ *  and in separate arrays for each l, are transpositions of the default,
+ *  sample-major ones
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "sphericart.hpp"
+
+#define _SPH_TOL 1e-10
+#ifndef DTYPE
+#define DTYPE double
+#endif
+using namespace sphericart;
+
+// index of the entry for sample `i`, component `a` and spherical harmonic
+// `k` in an array stored according to `layout`, with `size_lm` spherical
+// harmonics
+static size_t layout_index(
+    Layout layout,
+    size_t i,
+    size_t a,
+    size_t k,
+    size_t n_samples,
+    size_t n_components,
+    size_t size_lm
+) {
+    if (layout == Layout::LM_MAJOR) {
+        return (a * size_lm + k) * n_samples + i;
+    } else if (layout == Layout::XYZ_INNERMOST) {
+        return (i * size_lm + k) * n_components + a;
+    } else {
+        return (i * n_components + a) * size_lm + k;
+    }
+}
+
+// checks that `value[i, a, k]` (stored according to `layout`) is the same as
+// `reference[i, a, k]` (stored in sample-major order), where `i` runs over
+// the samples, `a` over the derivative components and `k` over the (l, m)
+static bool check_transposed(
+    const std::vector<DTYPE>& reference,
+    const std::vector<DTYPE>& value,
+    size_t n_samples,
+    size_t n_components,
+    size_t size_y,
+    Layout layout
+) {
+    for (size_t i = 0; i < n_samples; i++) {
+        for (size_t a = 0; a < n_components; a++) {
+            for (size_t k = 0; k < size_y; k++) {
+                auto expected = reference[(i * n_components + a) * size_y + k];
+                auto index = layout_index(layout, i, a, k, n_samples, n_components, size_y);
+                if (std::fabs(expected - value[index]) > _SPH_TOL * (1.0 + std::fabs(expected))) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// same as check_transposed, for outputs stored in one array per l
+static bool check_per_l(
+    const std::vector<DTYPE>& reference,
+    const std::vector<std::vector<DTYPE>>& value,
+    size_t n_samples,
+    size_t n_components,
+    size_t l_max,
+    Layout layout
+) {
+    auto size_y = (l_max + 1) * (l_max + 1);
+    for (size_t l = 0; l <= l_max; l++) {
+        for (size_t i = 0; i < n_samples; i++) {
+            for (size_t a = 0; a < n_components; a++) {
+                for (size_t m = 0; m < 2 * l + 1; m++) {
+                    auto expected = reference[(i * n_components + a) * size_y + l * l + m];
+                    auto index = layout_index(layout, i, a, m, n_samples, n_components, 2 * l + 1);
+                    if (std::fabs(expected - value[l][index]) >
+                        _SPH_TOL * (1.0 + std::fabs(expected))) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// allocates one array per l for an output with `n_components` components
+static std::vector<std::vector<DTYPE>> allocate_per_l(
+    size_t l_max, size_t n_samples, size_t n_components, std::vector<DTYPE*>& pointers
+) {
+    auto blocks = std::vector<std::vector<DTYPE>>();
+    for (size_t l = 0; l <= l_max; l++) {
+        blocks.emplace_back(n_samples * n_components * (2 * l + 1));
+    }
+    pointers.clear();
+    for (auto& block : blocks) {
+        pointers.push_back(block.data());
+    }
+    return blocks;
+}
+
+template <template <typename> class C>
+bool check_layouts(
+    size_t l_max, size_t n_samples, Engine engine, const std::vector<DTYPE>& xyz_all
+) {
+    auto xyz = std::vector<DTYPE>(xyz_all.begin(), xyz_all.begin() + 3 * n_samples);
+    auto size_y = (l_max + 1) * (l_max + 1);
+
+    auto sph = std::vector<DTYPE>();
+    auto dsph = std::vector<DTYPE>();
+    auto ddsph = std::vector<DTYPE>();
+    C<DTYPE> reference(l_max, engine);
+    reference.compute_with_hessians(xyz, sph, dsph, ddsph);
+
+    bool passed = true;
+    for (auto layout : {Layout::LM_MAJOR, Layout::XYZ_INNERMOST}) {
+        C<DTYPE> calculator(l_max, engine, layout);
+
+        auto layout_sph = std::vector<DTYPE>();
+        auto layout_dsph = std::vector<DTYPE>();
+        auto layout_ddsph = std::vector<DTYPE>();
+        calculator.compute_with_hessians(xyz, layout_sph, layout_dsph, layout_ddsph);
+        bool hessians_ok = check_transposed(sph, layout_sph, n_samples, 1, size_y, layout) &&
+                           check_transposed(dsph, layout_dsph, n_samples, 3, size_y, layout) &&
+                           check_transposed(ddsph, layout_ddsph, n_samples, 9, size_y, layout);
+
+        calculator.compute_with_gradients(xyz, layout_sph, layout_dsph);
+        bool gradients_ok = check_transposed(sph, layout_sph, n_samples, 1, size_y, layout) &&
+                            check_transposed(dsph, layout_dsph, n_samples, 3, size_y, layout);
+
+        calculator.compute(xyz, layout_sph);
+        bool values_ok = check_transposed(sph, layout_sph, n_samples, 1, size_y, layout);
+
+        if (!hessians_ok || !gradients_ok || !values_ok) {
+            printf(
+                "Mismatch detected for layout %d at l_max = %zu, n_samples = %zu\n",
+                static_cast<int>(layout),
+                l_max,
+                n_samples
+            );
+            passed = false;
+        }
+    }
+
+    for (auto layout : {Layout::SAMPLE_MAJOR, Layout::LM_MAJOR, Layout::XYZ_INNERMOST}) {
+        C<DTYPE> calculator(l_max, engine, layout);
+
+        auto sph_pointers = std::vector<DTYPE*>();
+        auto dsph_pointers = std::vector<DTYPE*>();
+        auto ddsph_pointers = std::vector<DTYPE*>();
+        auto sph_l = allocate_per_l(l_max, n_samples, 1, sph_pointers);
+        auto dsph_l = allocate_per_l(l_max, n_samples, 3, dsph_pointers);
+        auto ddsph_l = allocate_per_l(l_max, n_samples, 9, ddsph_pointers);
+
+        calculator.compute_array_per_l_with_hessians(
+            xyz.data(),
+            xyz.size(),
+            sph_pointers.data(),
+            dsph_pointers.data(),
+            ddsph_pointers.data(),
+            l_max + 1
+        );
+        bool hessians_ok = check_per_l(sph, sph_l, n_samples, 1, l_max, layout) &&
+                           check_per_l(dsph, dsph_l, n_samples, 3, l_max, layout) &&
+                           check_per_l(ddsph, ddsph_l, n_samples, 9, l_max, layout);
+
+        calculator.compute_array_per_l_with_gradients(
+            xyz.data(), xyz.size(), sph_pointers.data(), dsph_pointers.data(), l_max + 1
+        );
+        bool gradients_ok = check_per_l(sph, sph_l, n_samples, 1, l_max, layout) &&
+                            check_per_l(dsph, dsph_l, n_samples, 3, l_max, layout);
+
+        calculator.compute_array_per_l(xyz.data(), xyz.size(), sph_pointers.data(), l_max + 1);
+        bool values_ok = check_per_l(sph, sph_l, n_samples, 1, l_max, layout);
+
+        if (!hessians_ok || !gradients_ok || !values_ok) {
+            printf(
+                "Mismatch detected for per-l outputs in layout %d at l_max = %zu, "
+                "n_samples = %zu\n",
+                static_cast<int>(layout),
+                l_max,
+                n_samples
+            );
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 10;
+
+    // a single sample goes through the compute_sample functions
+    auto n_samples_list = std::vector<size_t>({1, 2, 7, 37});
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz_all = std::vector<DTYPE>(3 * 37);
+    for (auto& value : xyz_all) {
+        value = distribution(rng);
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto n_samples : n_samples_list) {
+            for (auto engine : {Engine::SAMPLE, Engine::BATCHED}) {
+                test_passed &= check_layouts<SphericalHarmonics>(l_max, n_samples, engine, xyz_all);
+                test_passed &= check_layouts<SolidHarmonics>(l_max, n_samples, engine, xyz_all);
+            }
+        }
+    }
+
+    if (test_passed) {
+        printf("Layout test passed\n");
+        return 0;
+    } else {
+        printf("Layout test failed\n");
+        return -1;
+    }
+}
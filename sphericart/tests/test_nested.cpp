@@ -0,0 +1,142 @@
+/** @file test_nested.cpp
+ *  @brief Checks that a single calculator can be used without workspace from
+ *  the threads of an OpenMP parallel loop, of a thread pool or of the caller
+ *  and TBB backends, and that the calls nested in these parallel regions give
+ *  the same results as the parallel ones
+ */
+
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sphericart.hpp"
+#include "test_utils.hpp"
+
+using namespace sphericart;
+
+#define N_FRAMES 16
+#define N_THREADS 4
+
+// runs each task of the caller backend on its own std::thread, as an external
+// scheduler would
+static void thread_executor(size_t n_tasks, const std::function<void(size_t)>& run_task) {
+    auto threads = std::vector<std::thread>();
+    for (size_t i = 0; i < n_tasks; i++) {
+        threads.emplace_back([&run_task, i]() { run_task(i); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+template <template <typename> class C>
+bool check_nested(size_t l_max, Engine engine, const std::vector<std::vector<DTYPE>>& xyz) {
+    C<DTYPE> calculator(l_max, engine);
+    // the frames are small, this makes sure the outer calls are parallel
+    calculator.set_parallel_thresholds({0, 0});
+
+    auto sph = std::vector<std::vector<DTYPE>>(N_FRAMES);
+    auto dsph = std::vector<std::vector<DTYPE>>(N_FRAMES);
+    auto ddsph = std::vector<std::vector<DTYPE>>(N_FRAMES);
+    for (size_t i = 0; i < N_FRAMES; i++) {
+        calculator.compute_with_hessians(xyz[i], sph[i], dsph[i], ddsph[i]);
+    }
+
+    // one frame per thread of the application, all using the same calculator
+    // and its own buffers
+    bool results[N_FRAMES];
+#pragma omp parallel for num_threads(N_THREADS) schedule(dynamic, 1)
+    for (size_t i = 0; i < N_FRAMES; i++) {
+        auto frame_sph = std::vector<DTYPE>();
+        auto frame_dsph = std::vector<DTYPE>();
+        auto frame_ddsph = std::vector<DTYPE>();
+        calculator.compute_with_hessians(xyz[i], frame_sph, frame_dsph, frame_ddsph);
+        results[i] = check_close(sph[i], frame_sph) && check_close(dsph[i], frame_dsph) &&
+                     check_close(ddsph[i], frame_ddsph);
+    }
+
+    bool passed = true;
+    for (size_t i = 0; i < N_FRAMES; i++) {
+        if (!results[i]) {
+            printf("Mismatch detected for frame %zu in OpenMP loop at l_max = %zu\n", i, l_max);
+            passed = false;
+        }
+    }
+
+    // the same with the tasks of a thread pool, and of an external scheduler
+    auto backends = std::vector<std::pair<std::shared_ptr<ParallelBackend>, const char*>>({
+        {thread_pool_backend(N_THREADS), "thread pool"},
+        {caller_backend(N_THREADS, thread_executor), "caller backend"},
+    });
+    try {
+        backends.emplace_back(tbb_backend(), "TBB backend");
+    } catch (const std::runtime_error&) {
+        // sphericart was compiled without TBB
+    }
+    auto run_frames = [&](size_t worker, size_t n_workers) {
+        for (size_t i = worker; i < N_FRAMES; i += n_workers) {
+            auto frame_sph = std::vector<DTYPE>();
+            calculator.compute(xyz[i], frame_sph);
+            // the calls must know that they run in a parallel region to
+            // avoid sharing the buffers of the calculator
+            results[i] = in_parallel_region() && check_close(sph[i], frame_sph);
+        }
+    };
+    for (const auto& backend : backends) {
+        for (auto& result : results) {
+            result = false;
+        }
+        backend.first->run(N_THREADS, run_frames);
+
+        for (size_t i = 0; i < N_FRAMES; i++) {
+            if (!results[i]) {
+                auto name = backend.second;
+                printf("Mismatch detected for frame %zu in %s at l_max = %zu\n", i, name, l_max);
+                passed = false;
+            }
+        }
+    }
+    return passed;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 10;
+
+#ifdef _OPENMP
+    // nested parallelism enabled in the runtime must not start inner teams
+    omp_set_max_active_levels(2);
+#endif
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz = std::vector<std::vector<DTYPE>>();
+    for (size_t i = 0; i < N_FRAMES; i++) {
+        // some frames contain a single point, going through compute_sample
+        auto n_samples = i % 5 == 0 ? 1 : 10 * i;
+        xyz.emplace_back(3 * n_samples);
+        for (auto& value : xyz.back()) {
+            value = distribution(rng);
+        }
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto engine : {Engine::SAMPLE, Engine::BATCHED}) {
+            test_passed &= check_nested<SphericalHarmonics>(l_max, engine, xyz);
+            test_passed &= check_nested<SolidHarmonics>(l_max, engine, xyz);
+        }
+    }
+
+    if (test_passed) {
+        printf("Nested test passed\n");
+        return 0;
+    } else {
+        printf("Nested test failed\n");
+        return -1;
+    }
+}
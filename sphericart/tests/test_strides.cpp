@@ -0,0 +1,198 @@
+/** @file test_strides.cpp
+ *  @brief Checks that the strided array calls read the coordinates and write
+ *  the outputs in place, with the same results as the packed calls
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "sphericart.hpp"
+
+#define _SPH_TOL 1e-10
+#ifndef DTYPE
+#define DTYPE double
+#endif
+using namespace sphericart;
+
+// extra elements between the coordinates of consecutive points, and at the
+// end of each row of the outputs
+#define XYZ_PADDING 2
+#define ROW_PADDING 3
+#define SENTINEL 1234.5
+
+// checks that the rows of `value`, which start `row_stride` elements apart,
+// contain the rows of the packed `reference`, and that the padding at the end
+// of each row was not touched
+static bool check_rows(
+    const std::vector<DTYPE>& reference,
+    const std::vector<DTYPE>& value,
+    size_t n_rows,
+    size_t row_length,
+    size_t row_stride
+) {
+    for (size_t i = 0; i < n_rows; i++) {
+        for (size_t j = 0; j < row_stride; j++) {
+            auto actual = value[i * row_stride + j];
+            if (j >= row_length) {
+                if (actual != SENTINEL) {
+                    return false;
+                }
+                continue;
+            }
+            auto expected = reference[i * row_length + j];
+            if (std::fabs(expected - actual) > _SPH_TOL * (1.0 + std::fabs(expected))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <template <typename> class C>
+bool check_strides(
+    size_t l_max, size_t n_samples, Engine engine, Layout layout, const std::vector<DTYPE>& xyz_all
+) {
+    auto xyz = std::vector<DTYPE>(xyz_all.begin(), xyz_all.begin() + 3 * n_samples);
+    auto size_y = (l_max + 1) * (l_max + 1);
+
+    C<DTYPE> calculator(l_max, engine, layout);
+    auto sph = std::vector<DTYPE>(n_samples * size_y);
+    auto dsph = std::vector<DTYPE>(n_samples * 3 * size_y);
+    auto ddsph = std::vector<DTYPE>(n_samples * 9 * size_y);
+    calculator.compute_array_with_hessians(
+        xyz.data(),
+        xyz.size(),
+        sph.data(),
+        sph.size(),
+        dsph.data(),
+        dsph.size(),
+        ddsph.data(),
+        ddsph.size()
+    );
+
+    // the coordinates are stored in an array of structures, with some other
+    // data after each point
+    auto xyz_stride = 3 + XYZ_PADDING;
+    auto xyz_strided = std::vector<DTYPE>(n_samples * xyz_stride, -SENTINEL);
+    for (size_t i = 0; i < n_samples; i++) {
+        for (size_t a = 0; a < 3; a++) {
+            xyz_strided[i * xyz_stride + a] = xyz[i * 3 + a];
+        }
+    }
+
+    // rows run over the samples, except for LM_MAJOR where they run over the
+    // derivative components and spherical harmonics
+    size_t n_rows[3];
+    size_t row_length[3];
+    const size_t n_components[3] = {1, 3, 9};
+    for (size_t i_output = 0; i_output < 3; i_output++) {
+        if (layout == Layout::LM_MAJOR) {
+            n_rows[i_output] = n_components[i_output] * size_y;
+            row_length[i_output] = n_samples;
+        } else {
+            n_rows[i_output] = n_samples;
+            row_length[i_output] = n_components[i_output] * size_y;
+        }
+    }
+
+    bool passed = true;
+    for (auto padding : {0, ROW_PADDING}) {
+        size_t row_stride[3];
+        std::vector<DTYPE> outputs[3];
+        for (size_t i_output = 0; i_output < 3; i_output++) {
+            row_stride[i_output] = row_length[i_output] + padding;
+            outputs[i_output] =
+                std::vector<DTYPE>(n_rows[i_output] * row_stride[i_output], SENTINEL);
+        }
+
+        calculator.compute_array_strided_with_hessians(
+            xyz_strided.data(),
+            n_samples,
+            xyz_stride,
+            outputs[0].data(),
+            row_stride[0],
+            outputs[1].data(),
+            row_stride[1],
+            outputs[2].data(),
+            row_stride[2]
+        );
+        bool hessians_ok =
+            check_rows(sph, outputs[0], n_rows[0], row_length[0], row_stride[0]) &&
+            check_rows(dsph, outputs[1], n_rows[1], row_length[1], row_stride[1]) &&
+            check_rows(ddsph, outputs[2], n_rows[2], row_length[2], row_stride[2]);
+
+        for (size_t i_output = 0; i_output < 3; i_output++) {
+            std::fill(outputs[i_output].begin(), outputs[i_output].end(), SENTINEL);
+        }
+        calculator.compute_array_strided_with_gradients(
+            xyz_strided.data(),
+            n_samples,
+            xyz_stride,
+            outputs[0].data(),
+            row_stride[0],
+            outputs[1].data(),
+            row_stride[1]
+        );
+        bool gradients_ok =
+            check_rows(sph, outputs[0], n_rows[0], row_length[0], row_stride[0]) &&
+            check_rows(dsph, outputs[1], n_rows[1], row_length[1], row_stride[1]);
+
+        std::fill(outputs[0].begin(), outputs[0].end(), SENTINEL);
+        calculator.compute_array_strided(
+            xyz_strided.data(), n_samples, xyz_stride, outputs[0].data(), row_stride[0]
+        );
+        bool values_ok = check_rows(sph, outputs[0], n_rows[0], row_length[0], row_stride[0]);
+
+        if (!hessians_ok || !gradients_ok || !values_ok) {
+            printf(
+                "Mismatch detected for layout %d and row padding %d at l_max = %zu, "
+                "n_samples = %zu\n",
+                static_cast<int>(layout),
+                padding,
+                l_max,
+                n_samples
+            );
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 10;
+    auto n_samples_list = std::vector<size_t>({1, 2, 7, 37});
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz_all = std::vector<DTYPE>(3 * 37);
+    for (auto& value : xyz_all) {
+        value = distribution(rng);
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto n_samples : n_samples_list) {
+            for (auto engine : {Engine::SAMPLE, Engine::BATCHED}) {
+                for (auto layout :
+                     {Layout::SAMPLE_MAJOR, Layout::LM_MAJOR, Layout::XYZ_INNERMOST}) {
+                    test_passed &= check_strides<SphericalHarmonics>(
+                        l_max, n_samples, engine, layout, xyz_all
+                    );
+                    test_passed &=
+                        check_strides<SolidHarmonics>(l_max, n_samples, engine, layout, xyz_all);
+                }
+            }
+        }
+    }
+
+    if (test_passed) {
+        printf("Strides test passed\n");
+        return 0;
+    } else {
+        printf("Strides test failed\n");
+        return -1;
+    }
+}
@@ -0,0 +1,32 @@
+/** @file test_utils.hpp
+ *  @brief Helpers shared by the tests comparing the results of different
+ *  ways of calling the calculators
+ */
+
+#ifndef SPHERICART_TEST_UTILS_HPP
+#define SPHERICART_TEST_UTILS_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#define _SPH_TOL 1e-10
+#ifndef DTYPE
+#define DTYPE double
+#endif
+
+// checks that two arrays have the same size and values, up to _SPH_TOL
+template <typename T>
+bool check_close(const std::vector<T>& reference, const std::vector<T>& value) {
+    if (reference.size() != value.size()) {
+        return false;
+    }
+    for (size_t k = 0; k < reference.size(); k++) {
+        if (std::fabs(reference[k] - value[k]) > _SPH_TOL * (1.0 + std::fabs(reference[k]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
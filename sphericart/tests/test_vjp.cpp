@@ -0,0 +1,169 @@
+/** @file test_vjp.cpp
+ *  @brief Checks that the vector-Jacobian product gives the same results as
+ *  contracting the gradients of the spherical harmonics with the gradient
+ *  with respect to the spherical harmonics, in all the layouts, and that
+ *  `contract_gradients` gives the same results from the stored gradients
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+#include "sphericart.hpp"
+
+#define _SPH_TOL 1e-10
+#ifndef DTYPE
+#define DTYPE double
+#endif
+using namespace sphericart;
+
+template <template <typename> class C>
+bool check_vjp(
+    size_t l_max,
+    size_t n_samples,
+    Engine engine,
+    const std::vector<DTYPE>& xyz_all,
+    const std::vector<DTYPE>& sph_grad_all
+) {
+    auto xyz = std::vector<DTYPE>(xyz_all.begin(), xyz_all.begin() + 3 * n_samples);
+    auto size_y = (l_max + 1) * (l_max + 1);
+    auto sph_grad =
+        std::vector<DTYPE>(sph_grad_all.begin(), sph_grad_all.begin() + n_samples * size_y);
+
+    auto sph = std::vector<DTYPE>();
+    auto dsph = std::vector<DTYPE>();
+    C<DTYPE> reference_calculator(l_max, engine);
+    reference_calculator.compute_with_gradients(xyz, sph, dsph);
+
+    auto reference = std::vector<DTYPE>(3 * n_samples, 0.0);
+    for (size_t i = 0; i < n_samples; i++) {
+        for (size_t a = 0; a < 3; a++) {
+            for (size_t k = 0; k < size_y; k++) {
+                reference[3 * i + a] += sph_grad[i * size_y + k] * dsph[(i * 3 + a) * size_y + k];
+            }
+        }
+    }
+
+    bool passed = true;
+    for (auto layout : {Layout::SAMPLE_MAJOR, Layout::LM_MAJOR, Layout::XYZ_INNERMOST}) {
+        // the gradient with respect to the spherical harmonics is stored in
+        // the same layout as the spherical harmonics
+        auto layout_sph_grad = sph_grad;
+        if (layout == Layout::LM_MAJOR) {
+            for (size_t i = 0; i < n_samples; i++) {
+                for (size_t k = 0; k < size_y; k++) {
+                    layout_sph_grad[k * n_samples + i] = sph_grad[i * size_y + k];
+                }
+            }
+        }
+
+        C<DTYPE> calculator(l_max, engine, layout);
+        auto xyz_grad = std::vector<DTYPE>(3 * n_samples, 1234.5);
+        calculator.compute_vjp(
+            xyz.data(),
+            xyz.size(),
+            layout_sph_grad.data(),
+            layout_sph_grad.size(),
+            xyz_grad.data(),
+            xyz_grad.size()
+        );
+
+        // the same from the gradients computed in this layout
+        auto layout_sph = std::vector<DTYPE>(n_samples * size_y);
+        auto layout_dsph = std::vector<DTYPE>(n_samples * 3 * size_y);
+        calculator.compute_array_with_gradients(
+            xyz.data(),
+            xyz.size(),
+            layout_sph.data(),
+            layout_sph.size(),
+            layout_dsph.data(),
+            layout_dsph.size()
+        );
+        auto contracted = std::vector<DTYPE>(3 * n_samples, 1234.5);
+        calculator.contract_gradients(
+            layout_sph_grad.data(),
+            layout_sph_grad.size(),
+            layout_dsph.data(),
+            layout_dsph.size(),
+            contracted.data(),
+            contracted.size()
+        );
+
+        for (const auto* result : {&xyz_grad, &contracted}) {
+            for (size_t k = 0; k < reference.size(); k++) {
+                if (std::fabs(reference[k] - (*result)[k]) >
+                    _SPH_TOL * (1.0 + std::fabs(reference[k]))) {
+                    printf(
+                        "Mismatch detected for %s in layout %d at l_max = %zu, n_samples = %zu\n",
+                        result == &xyz_grad ? "compute_vjp" : "contract_gradients",
+                        static_cast<int>(layout),
+                        l_max,
+                        n_samples
+                    );
+                    passed = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    return passed;
+}
+
+// calls without any sample can use null pointers, as given e.g. by empty
+// torch tensors
+template <template <typename> class C> bool check_no_samples(size_t l_max) {
+    bool passed = true;
+    for (auto layout : {Layout::SAMPLE_MAJOR, Layout::XYZ_INNERMOST, Layout::LM_MAJOR}) {
+        C<DTYPE> calculator(l_max, Engine::SAMPLE, layout);
+        try {
+            calculator.compute_vjp(nullptr, 0, nullptr, 0, nullptr, 0);
+            calculator.contract_gradients(nullptr, 0, nullptr, 0, nullptr, 0);
+        } catch (const std::runtime_error& e) {
+            printf("Unexpected error without samples: %s\n", e.what());
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 10;
+    // 300 samples covers several of the blocks used by contract_gradients
+    // in the LM_MAJOR layout
+    auto n_samples_list = std::vector<size_t>({1, 2, 7, 37, 300});
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz_all = std::vector<DTYPE>(3 * 300);
+    for (auto& value : xyz_all) {
+        value = distribution(rng);
+    }
+    auto sph_grad_all = std::vector<DTYPE>(300 * (MAX_L_VALUE + 1) * (MAX_L_VALUE + 1));
+    for (auto& value : sph_grad_all) {
+        value = distribution(rng);
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto n_samples : n_samples_list) {
+            for (auto engine : {Engine::SAMPLE, Engine::BATCHED}) {
+                test_passed &=
+                    check_vjp<SphericalHarmonics>(l_max, n_samples, engine, xyz_all, sph_grad_all);
+                test_passed &=
+                    check_vjp<SolidHarmonics>(l_max, n_samples, engine, xyz_all, sph_grad_all);
+            }
+        }
+        test_passed &= check_no_samples<SphericalHarmonics>(l_max);
+        test_passed &= check_no_samples<SolidHarmonics>(l_max);
+    }
+
+    if (test_passed) {
+        printf("VJP test passed\n");
+        return 0;
+    } else {
+        printf("VJP test failed\n");
+        return -1;
+    }
+}
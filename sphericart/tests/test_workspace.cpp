@@ -0,0 +1,98 @@
+/** @file test_workspace.cpp
+ *  @brief Checks that a single calculator can be used by several threads at
+ *  the same time, when each of them uses its own workspace
+ */
+
+#include <cstdio>
+#include <random>
+#include <thread>
+
+#include "sphericart.hpp"
+#include "test_utils.hpp"
+
+using namespace sphericart;
+
+#define N_THREADS 4
+#define N_REPEATS 20
+
+template <template <typename> class C>
+bool check_workspace(size_t l_max, Engine engine, const std::vector<std::vector<DTYPE>>& xyz) {
+    C<DTYPE> calculator(l_max, engine);
+
+    // reference values, computed by one thread at a time
+    auto sph = std::vector<std::vector<DTYPE>>(N_THREADS);
+    auto dsph = std::vector<std::vector<DTYPE>>(N_THREADS);
+    auto ddsph = std::vector<std::vector<DTYPE>>(N_THREADS);
+    for (size_t i = 0; i < N_THREADS; i++) {
+        calculator.compute_with_hessians(xyz[i], sph[i], dsph[i], ddsph[i]);
+    }
+
+    // each thread uses the same calculator, with different points (some of
+    // them a single point, going through compute_sample) and its own
+    // workspace
+    bool results[N_THREADS];
+    auto threads = std::vector<std::thread>();
+    for (size_t i = 0; i < N_THREADS; i++) {
+        threads.emplace_back([&, i]() {
+            auto workspace = Workspace<DTYPE>();
+            auto thread_sph = std::vector<DTYPE>();
+            auto thread_dsph = std::vector<DTYPE>();
+            auto thread_ddsph = std::vector<DTYPE>();
+            bool passed = true;
+            for (size_t repeat = 0; repeat < N_REPEATS; repeat++) {
+                calculator.compute_with_hessians(
+                    xyz[i], thread_sph, thread_dsph, thread_ddsph, &workspace
+                );
+                passed &= check_close(sph[i], thread_sph) && check_close(dsph[i], thread_dsph) &&
+                          check_close(ddsph[i], thread_ddsph);
+
+                calculator.compute(xyz[i], thread_sph, &workspace);
+                passed &= check_close(sph[i], thread_sph);
+            }
+            results[i] = passed;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    bool passed = true;
+    for (size_t i = 0; i < N_THREADS; i++) {
+        if (!results[i]) {
+            printf("Mismatch detected for thread %zu at l_max = %zu\n", i, l_max);
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    size_t MAX_L_VALUE = 10;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<DTYPE> distribution(-1.0, 1.0);
+    auto xyz = std::vector<std::vector<DTYPE>>();
+    for (size_t i = 0; i < N_THREADS; i++) {
+        auto n_samples = i == 0 ? 1 : 50 * i;
+        xyz.emplace_back(3 * n_samples);
+        for (auto& value : xyz.back()) {
+            value = distribution(rng);
+        }
+    }
+
+    bool test_passed = true;
+    for (size_t l_max = 0; l_max <= MAX_L_VALUE; l_max++) {
+        for (auto engine : {Engine::SAMPLE, Engine::BATCHED}) {
+            test_passed &= check_workspace<SphericalHarmonics>(l_max, engine, xyz);
+            test_passed &= check_workspace<SolidHarmonics>(l_max, engine, xyz);
+        }
+    }
+
+    if (test_passed) {
+        printf("Workspace test passed\n");
+        return 0;
+    } else {
+        printf("Workspace test failed\n");
+        return -1;
+    }
+}